@@ -627,7 +627,11 @@ class NODE_PT_quality(bpy.types.Panel):
         col.prop(tree, "use_opencl")
         col.prop(tree, "use_groupnode_buffer")
         col.prop(tree, "use_two_pass")
+        col.prop(tree, "use_buffer_execution")
+        col.prop(tree, "use_half_buffers")
+        col.prop(tree, "use_parallel_frames")
         col.prop(tree, "use_viewer_border")
+        col.prop(tree, "use_profile")
         col.separator()
         col.prop(snode, "use_auto_render")
 
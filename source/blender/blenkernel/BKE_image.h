@@ -214,6 +214,10 @@ void BKE_imageuser_default(struct ImageUser *iuser);
 void BKE_image_init_imageuser(struct Image *ima, struct ImageUser *iuser);
 void BKE_image_signal(struct Main *bmain, struct Image *ima, struct ImageUser *iuser, int signal);
 
+/* Called after an image is reloaded, to free results computed from its old pixels. */
+typedef void (*BKE_image_reload_cb)(void);
+void BKE_image_callback_reload_set(BKE_image_reload_cb func);
+
 void BKE_image_walk_all_users(const struct Main *mainp,
                               void *customdata,
                               void callback(struct Image *ima,
@@ -320,6 +324,7 @@ float *BKE_image_get_float_pixels_for_frame(struct Image *image, int frame);
 /* Image modifications */
 bool BKE_image_is_dirty(struct Image *image);
 void BKE_image_mark_dirty(struct Image *image, struct ImBuf *ibuf);
+int BKE_image_update_count_next(void);
 
 /* Guess offset for the first frame in the sequence */
 int BKE_image_sequence_guess_offset(struct Image *image);
@@ -0,0 +1,93 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BKE_MESH_EVAL_CACHE_H__
+#define __BKE_MESH_EVAL_CACHE_H__
+
+/** \file
+ * \ingroup bke
+ *
+ * Cache of evaluated modifier stack results, shared across frames.
+ *
+ * Entries are keyed by a hash of everything the modifier stack reads (input mesh, shape keys,
+ * modifier settings, requested data layers), so a stack which produces the same result on
+ * several frames is only evaluated once. The cache is bounded by #UserDef.mesh_eval_cache_limit
+ * and evicts least recently used entries first.
+ */
+
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct CustomData_MeshMasks;
+struct Depsgraph;
+struct Mesh;
+struct Object;
+struct Scene;
+
+typedef struct MeshEvalCacheStats {
+  /** Number of lookups which found an entry. */
+  uint64_t hits;
+  /** Number of lookups which did not find an entry. */
+  uint64_t misses;
+  /** Number of evaluated meshes added to the cache. */
+  uint64_t stores;
+  /** Number of entries removed to stay within the memory limit. */
+  uint64_t evictions;
+
+  int entries_len;
+  size_t memory_used;
+  size_t memory_limit;
+} MeshEvalCacheStats;
+
+/* Calculate the cache key of the modifier stack of the given object.
+ * Returns false when the stack result can not be cached (time dependent modifiers, modifiers
+ * referencing other data-blocks, edit or paint modes, ...). */
+bool BKE_mesh_eval_cache_key_calc(const struct Depsgraph *depsgraph,
+                                  const struct Scene *scene,
+                                  struct Object *ob,
+                                  const struct CustomData_MeshMasks *dataMask,
+                                  const bool need_mapping,
+                                  uint64_t *r_key);
+
+/* Get copies of the cached final and deformed meshes, owned by the caller.
+ * ID pointers (materials, shape keys) of the copies are cleared and need to be restored from the
+ * input mesh. */
+bool BKE_mesh_eval_cache_lookup(const uint64_t key,
+                                struct Mesh **r_mesh_final,
+                                struct Mesh **r_mesh_deform);
+/* Store copies of an evaluated result. `eval_time` is the time it took to evaluate the stack in
+ * seconds, cheap stacks are not worth the memory. */
+void BKE_mesh_eval_cache_store(const uint64_t key,
+                               const struct Mesh *mesh_final,
+                               const struct Mesh *mesh_deform,
+                               const double eval_time);
+
+/* Evict entries until the cache fits into the current memory limit. */
+void BKE_mesh_eval_cache_limit_update(void);
+void BKE_mesh_eval_cache_clear(void);
+void BKE_mesh_eval_cache_free(void);
+
+void BKE_mesh_eval_cache_stats_get(MeshEvalCacheStats *r_stats);
+void BKE_mesh_eval_cache_stats_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BKE_MESH_EVAL_CACHE_H__ */
@@ -55,6 +55,7 @@ struct ListBase;
 struct MTex;
 struct Main;
 struct PointerRNA;
+struct Render;
 struct RenderData;
 struct Scene;
 struct SpaceNode;
@@ -1155,7 +1156,8 @@ void ntreeGPUMaterialNodes(struct bNodeTree *localtree,
 #define CMP_TRACKPOS_ABSOLUTE_FRAME 3
 
 /* API */
-void ntreeCompositExecTree(struct Scene *scene,
+void ntreeCompositExecTree(struct Render *render,
+                           struct Scene *scene,
                            struct bNodeTree *ntree,
                            struct RenderData *rd,
                            int rendering,
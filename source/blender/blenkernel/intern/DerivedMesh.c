@@ -52,6 +52,7 @@
 #include "BKE_material.h"
 #include "BKE_modifier.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_eval_cache.h"
 #include "BKE_mesh_iterators.h"
 #include "BKE_mesh_mapping.h"
 #include "BKE_mesh_runtime.h"
@@ -69,6 +70,8 @@
 #include "DEG_depsgraph_query.h"
 #include "BKE_shrinkwrap.h"
 
+#include "PIL_time.h"
+
 #include "CLG_log.h"
 
 #ifdef WITH_OPENSUBDIV
@@ -2022,6 +2025,40 @@ static void mesh_runtime_check_normals_valid(const Mesh *mesh)
   BLI_assert(!(mesh->runtime.cd_dirty_poly & CD_MASK_NORMAL));
 }
 
+/* Use the result of an earlier evaluation of the same modifier stack, see
+ * #BKE_mesh_eval_cache_key_calc for what is considered the same. */
+static bool mesh_eval_cache_restore(Object *ob,
+                                    const CustomData_MeshMasks *dataMask,
+                                    const uint64_t key,
+                                    /* return args */
+                                    Mesh **r_deform,
+                                    Mesh **r_final)
+{
+  Mesh *mesh_input = ob->data;
+  Mesh *mesh_final, *mesh_deform;
+
+  if (!BKE_mesh_eval_cache_lookup(key, &mesh_final, &mesh_deform)) {
+    return false;
+  }
+
+  /* The cache does not keep references to data-blocks, they might have been freed since. */
+  mesh_final->key = mesh_input->key;
+  mesh_final->texcomesh = mesh_input->texcomesh;
+  /* Cached meshes don't keep derived normals, see #mesh_calc_modifier_final_normals. */
+  mesh_calc_modifier_final_normals(mesh_input, dataMask, false, mesh_final);
+  mesh_calc_finalize(mesh_input, mesh_final);
+
+  if (mesh_deform) {
+    mesh_deform->key = mesh_input->key;
+    mesh_deform->texcomesh = mesh_input->texcomesh;
+    mesh_calc_finalize(mesh_input, mesh_deform);
+  }
+
+  *r_final = mesh_final;
+  *r_deform = mesh_deform;
+  return true;
+}
+
 static void mesh_build_data(struct Depsgraph *depsgraph,
                             Scene *scene,
                             Object *ob,
@@ -2048,17 +2085,34 @@ static void mesh_build_data(struct Depsgraph *depsgraph,
   }
 #endif
 
-  mesh_calc_modifiers(depsgraph,
-                      scene,
-                      ob,
-                      1,
-                      need_mapping,
-                      dataMask,
-                      -1,
-                      true,
-                      true,
-                      &ob->runtime.mesh_deform_eval,
-                      &ob->runtime.mesh_eval);
+  uint64_t eval_cache_key;
+  const bool use_eval_cache = BKE_mesh_eval_cache_key_calc(
+      depsgraph, scene, ob, dataMask, need_mapping, &eval_cache_key);
+
+  if (!(use_eval_cache &&
+        mesh_eval_cache_restore(ob, dataMask, eval_cache_key, &ob->runtime.mesh_deform_eval,
+                                &ob->runtime.mesh_eval))) {
+    const double start_time = use_eval_cache ? PIL_check_seconds_timer() : 0.0;
+
+    mesh_calc_modifiers(depsgraph,
+                        scene,
+                        ob,
+                        1,
+                        need_mapping,
+                        dataMask,
+                        -1,
+                        true,
+                        true,
+                        &ob->runtime.mesh_deform_eval,
+                        &ob->runtime.mesh_eval);
+
+    if (use_eval_cache && ob->runtime.mesh_eval != ob->data) {
+      BKE_mesh_eval_cache_store(eval_cache_key,
+                                ob->runtime.mesh_eval,
+                                ob->runtime.mesh_deform_eval,
+                                PIL_check_seconds_timer() - start_time);
+    }
+  }
 
   BKE_object_boundbox_calc_from_mesh(ob, ob->runtime.mesh_eval);
   /* Only copy texspace from orig mesh if some modifier (hint: smoke sim, see T58492)
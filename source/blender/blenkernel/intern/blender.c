@@ -49,6 +49,7 @@
 #include "BKE_image.h"
 #include "BKE_layer.h"
 #include "BKE_main.h"
+#include "BKE_mesh_eval_cache.h"
 #include "BKE_node.h"
 #include "BKE_report.h"
 #include "BKE_scene.h"
@@ -90,6 +91,7 @@ void BKE_blender_free(void)
   IMB_exit();
   BKE_cachefiles_exit();
   BKE_images_exit();
+  BKE_mesh_eval_cache_free();
   DEG_free_node_types();
 
   BKE_brush_system_exit();
@@ -170,6 +172,9 @@ void BKE_blender_userdef_data_set(UserDef *userdef)
 {
   BKE_blender_userdef_data_swap(&U, userdef);
   BKE_blender_userdef_data_free(userdef, true);
+
+  /* The new preferences might use a different limit, or disable the cache. */
+  BKE_mesh_eval_cache_clear();
 }
 
 void BKE_blender_userdef_data_set_and_free(UserDef *userdef)
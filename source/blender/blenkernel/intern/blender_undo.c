@@ -34,10 +34,13 @@
 #include <fcntl.h> /* for open */
 #include <errno.h>
 
+#include "CLG_log.h"
+
 #include "MEM_guardedalloc.h"
 
 #include "DNA_scene_types.h"
 
+#include "BLI_listbase.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
 #include "BLI_utildefines.h"
@@ -55,6 +58,10 @@
 
 #include "DEG_depsgraph.h"
 
+#include "PIL_time.h"
+
+static CLG_LogRef LOG = {"bke.blender_undo"};
+
 /* -------------------------------------------------------------------- */
 /** \name Global Undo
  * \{ */
@@ -117,8 +124,28 @@ MemFileUndoData *BKE_memfile_undo_encode(Main *bmain, MemFileUndoData *mfu_prev)
   }
   else {
     MemFile *prevfile = (mfu_prev) ? &(mfu_prev->memfile) : NULL;
+    const double time_start = PIL_check_seconds_timer();
     /* success = */ /* UNUSED */ BLO_write_file_mem(bmain, prevfile, &mfu->memfile, G.fileflags);
     mfu->undo_size = mfu->memfile.size;
+
+    const double time_end = PIL_check_seconds_timer();
+
+    /* Only the size of chunks which are not shared with the previous step is stored. */
+    size_t size_total = 0;
+    int chunks_len = 0, chunks_shared_len = 0;
+    LISTBASE_FOREACH (MemFileChunk *, chunk, &mfu->memfile.chunks) {
+      size_total += chunk->size;
+      chunks_len++;
+      chunks_shared_len += chunk->is_identical;
+    }
+    CLOG_INFO(&LOG,
+              1,
+              "memfile push in %.4fs: %.2f MB stored, %.2f MB shared (%d of %d chunks)",
+              time_end - time_start,
+              (double)mfu->memfile.size / (1024.0 * 1024.0),
+              (double)(size_total - mfu->memfile.size) / (1024.0 * 1024.0),
+              chunks_shared_len,
+              chunks_len);
   }
 
   bmain->is_memfile_undo_written = true;
@@ -48,6 +48,7 @@
 #include "BKE_layer.h"
 #include "BKE_library.h"
 #include "BKE_main.h"
+#include "BKE_mesh_eval_cache.h"
 #include "BKE_report.h"
 #include "BKE_scene.h"
 #include "BKE_screen.h"
@@ -159,6 +160,8 @@ static void setup_app_data(bContext *C,
   /* Free all render results, without this stale data gets displayed after loading files */
   if (mode != LOAD_UNDO) {
     RE_FreeAllRenderResults();
+    /* Results of the previous file will not be used again. */
+    BKE_mesh_eval_cache_clear();
   }
 
   /* Only make filepaths compatible when loading for real (not undo) */
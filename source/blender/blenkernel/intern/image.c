@@ -37,6 +37,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "IMB_colormanagement.h"
 #include "IMB_imbuf_types.h"
 #include "IMB_imbuf.h"
@@ -98,6 +100,8 @@
 
 static CLG_LogRef LOG = {"bke.image"};
 static SpinLock image_spin;
+/* Last value given out to #Image.update_count. */
+static int image_update_count = 0;
 
 /* prototypes */
 static int image_num_files(struct Image *ima);
@@ -3144,6 +3148,13 @@ void BKE_image_init_imageuser(Image *ima, ImageUser *iuser)
   }
 }
 
+static BKE_image_reload_cb image_reload_cb = NULL;
+
+void BKE_image_callback_reload_set(BKE_image_reload_cb func)
+{
+  image_reload_cb = func;
+}
+
 void BKE_image_signal(Main *bmain, Image *ima, ImageUser *iuser, int signal)
 {
   if (ima == NULL) {
@@ -3244,6 +3255,7 @@ void BKE_image_signal(Main *bmain, Image *ima, ImageUser *iuser, int signal)
         image_tag_reload(ima, iuser, ima);
       }
       BKE_image_walk_all_users(bmain, ima, image_tag_reload);
+      ima->update_count = BKE_image_update_count_next();
       break;
     case IMA_SIGNAL_USER_NEW_IMAGE:
       if (iuser) {
@@ -3269,6 +3281,10 @@ void BKE_image_signal(Main *bmain, Image *ima, ImageUser *iuser, int signal)
 
   BLI_spin_unlock(&image_spin);
 
+  if (signal == IMA_SIGNAL_RELOAD && image_reload_cb) {
+    image_reload_cb();
+  }
+
   /* don't use notifiers because they are not 100% sure to succeeded
    * this also makes sure all scenes are accounted for. */
   {
@@ -5125,9 +5141,20 @@ bool BKE_image_is_dirty(Image *image)
   return is_dirty;
 }
 
-void BKE_image_mark_dirty(Image *UNUSED(image), ImBuf *ibuf)
+void BKE_image_mark_dirty(Image *image, ImBuf *ibuf)
 {
   ibuf->userflags |= IB_BITMAPDIRTY;
+  image->update_count = BKE_image_update_count_next();
+}
+
+/**
+ * New value for #Image.update_count. Values are unique for the whole session, so an image read
+ * from a file or an undo step never gets back the value of pixels it had before.
+ */
+int BKE_image_update_count_next(void)
+{
+  /* Painting marks tiles dirty from multiple threads. */
+  return atomic_add_and_fetch_int32(&image_update_count, 1);
 }
 
 void BKE_image_file_format_set(Image *image, int ftype, const ImbFormatOptions *options)
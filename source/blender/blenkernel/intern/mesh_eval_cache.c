@@ -0,0 +1,598 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bke
+ *
+ * Cache of evaluated modifier stack results: #MeshEvalCacheEntry.
+ *
+ * Design notes:
+ *
+ * - The key is a content hash of all the inputs of the modifier stack, not of the data-block
+ *   pointers. This way a result stays valid when copy-on-write re-creates the evaluated input
+ *   mesh, and objects sharing the same mesh and modifier settings share the same entry.
+ * - DNA structs are hashed member by member using the SDNA of the running Blender, skipping
+ *   pointers. This avoids hashing runtime caches which modifiers store in their DNA.
+ * - Only modifier types known to read nothing but their settings and the input mesh are cached,
+ *   see #cache_modifier_type_is_supported. Stacks containing any other modifier, or linking
+ *   other objects and textures, are not cached at all.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_threads.h"
+
+#include "DNA_customdata_types.h"
+#include "DNA_key_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+#include "DNA_sdna_types.h"
+#include "DNA_userdef_types.h"
+#include "DNA_genfile.h"
+
+#include "BKE_customdata.h"
+#include "BKE_library.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_eval_cache.h" /* own include */
+#include "BKE_modifier.h"
+
+#include "DEG_depsgraph_query.h"
+
+#include "CLG_log.h"
+
+static CLG_LogRef LOG = {"bke.mesh_eval_cache"};
+
+/* Stacks which evaluate faster than this (in seconds) are not stored. */
+#define MESH_EVAL_CACHE_MIN_EVAL_TIME 0.002
+
+typedef struct MeshEvalCacheEntry {
+  struct MeshEvalCacheEntry *next, *prev;
+  uint64_t key;
+  struct Mesh *mesh_final;
+  struct Mesh *mesh_deform;
+  size_t memory_size;
+} MeshEvalCacheEntry;
+
+static struct {
+  ThreadMutex mutex;
+  /** Maps #MeshEvalCacheEntry.key to the entry. */
+  GHash *entries;
+  /** Entries ordered from most to least recently used. */
+  ListBase lru;
+  size_t memory_used;
+  MeshEvalCacheStats stats;
+} g_cache = {BLI_MUTEX_INITIALIZER};
+
+/* -------------------------------------------------------------------- */
+/** \name Key Hashing
+ * \{ */
+
+/* Two independent 32 bit hashes, combined into the 64 bit key. */
+typedef struct MeshEvalCacheHash {
+  BLI_HashMurmur2A mm2[2];
+} MeshEvalCacheHash;
+
+static void cache_hash_init(MeshEvalCacheHash *hash)
+{
+  BLI_hash_mm2a_init(&hash->mm2[0], 0);
+  BLI_hash_mm2a_init(&hash->mm2[1], 0x9e3779b9);
+}
+
+static void cache_hash_add(MeshEvalCacheHash *hash, const void *data, const size_t len)
+{
+  BLI_hash_mm2a_add(&hash->mm2[0], data, len);
+  BLI_hash_mm2a_add(&hash->mm2[1], data, len);
+}
+
+static void cache_hash_add_int(MeshEvalCacheHash *hash, const int data)
+{
+  BLI_hash_mm2a_add_int(&hash->mm2[0], data);
+  BLI_hash_mm2a_add_int(&hash->mm2[1], data);
+}
+
+static uint64_t cache_hash_end(MeshEvalCacheHash *hash)
+{
+  return ((uint64_t)BLI_hash_mm2a_end(&hash->mm2[0]) << 32) |
+         (uint64_t)BLI_hash_mm2a_end(&hash->mm2[1]);
+}
+
+/* Hash all non-pointer members of a DNA struct, recursing into nested structs.
+ * Members named `skip_member_a` or `skip_member_b` (top level only) are ignored. */
+static void cache_hash_add_dna_struct(MeshEvalCacheHash *hash,
+                                      const SDNA *sdna,
+                                      const int struct_nr,
+                                      const char *data,
+                                      const char *skip_member_a,
+                                      const char *skip_member_b)
+{
+  const short *sp = sdna->structs[struct_nr];
+  const int members_len = sp[1];
+  sp += 2;
+
+  for (int a = 0; a < members_len; a++, sp += 2) {
+    const int type_nr = sp[0];
+    const char *name = sdna->names[sp[1]];
+    const int array_len = sdna->names_array_len[sp[1]];
+    const bool is_pointer = ELEM(name[0], '*', '(');
+    const int size = (is_pointer ? sdna->pointer_size : sdna->types_size[type_nr]) * array_len;
+
+    const bool is_skipped = (skip_member_a && STREQ(name, skip_member_a)) ||
+                            (skip_member_b && STREQ(name, skip_member_b));
+
+    if (!is_pointer && !is_skipped) {
+      const int member_struct_nr = DNA_struct_find_nr(sdna, sdna->types[type_nr]);
+      if (member_struct_nr != -1) {
+        const int member_size = sdna->types_size[type_nr];
+        for (int i = 0; i < array_len; i++) {
+          cache_hash_add_dna_struct(
+              hash, sdna, member_struct_nr, data + i * member_size, NULL, NULL);
+        }
+      }
+      else {
+        cache_hash_add(hash, data, (size_t)size);
+      }
+    }
+    data += size;
+  }
+}
+
+static void cache_hash_add_dna(MeshEvalCacheHash *hash,
+                               const char *struct_name,
+                               const void *data,
+                               const char *skip_member_a,
+                               const char *skip_member_b)
+{
+  const SDNA *sdna = DNA_sdna_current_get();
+  const int struct_nr = DNA_struct_find_nr(sdna, struct_name);
+  BLI_assert(struct_nr != -1);
+  cache_hash_add_dna_struct(hash, sdna, struct_nr, data, skip_member_a, skip_member_b);
+}
+
+/* Returns false for layers whose data can not be hashed by value. */
+static bool cache_hash_add_customdata(MeshEvalCacheHash *hash,
+                                      const CustomData *data,
+                                      const int totelem)
+{
+  for (int i = 0; i < data->totlayer; i++) {
+    const CustomDataLayer *layer = &data->layers[i];
+
+    if (ELEM(layer->type, CD_MDISPS, CD_GRID_PAINT_MASK, CD_BM_ELEM_PYPTR)) {
+      return false;
+    }
+
+    cache_hash_add_dna(hash, "CustomDataLayer", layer, NULL, NULL);
+    if (layer->data == NULL) {
+      continue;
+    }
+
+    if (layer->type == CD_MDEFORMVERT) {
+      const MDeformVert *dvert = layer->data;
+      for (int j = 0; j < totelem; j++, dvert++) {
+        cache_hash_add_int(hash, dvert->totweight);
+        if (dvert->totweight) {
+          cache_hash_add(hash, dvert->dw, sizeof(*dvert->dw) * (size_t)dvert->totweight);
+        }
+      }
+    }
+    else {
+      cache_hash_add(hash, layer->data, (size_t)CustomData_sizeof(layer->type) * totelem);
+    }
+  }
+  return true;
+}
+
+static void cache_hash_add_key(MeshEvalCacheHash *hash, const Key *key)
+{
+  cache_hash_add_dna(hash, "Key", key, "id", NULL);
+  for (const KeyBlock *kb = key->block.first; kb; kb = kb->next) {
+    cache_hash_add_dna(hash, "KeyBlock", kb, NULL, NULL);
+    if (kb->data) {
+      cache_hash_add(hash, kb->data, (size_t)kb->totelem * key->elemsize);
+    }
+  }
+}
+
+static void cache_id_walk(void *user_data,
+                          Object *UNUSED(ob),
+                          ID **idpoin,
+                          int UNUSED(cb_flag))
+{
+  bool *r_has_id_links = user_data;
+  if (*idpoin != NULL) {
+    *r_has_id_links = true;
+  }
+}
+
+/* The result of a modifier can only be cached when it depends on nothing but its own settings
+ * and the mesh it is applied on. This is an explicit list rather than a check of the type info:
+ * simulations and modifiers reading the scene time (particles, ocean, ...) do not always declare
+ * it with `dependsOnTime`, and modifiers which keep bind data or curve mappings behind pointers
+ * (corrective smooth, laplacian deform, warp, ...) would not have those in the key. */
+static bool cache_modifier_type_is_supported(const ModifierType type)
+{
+  switch (type) {
+    case eModifierType_Subsurf:
+    case eModifierType_Mirror:
+    case eModifierType_Decimate:
+    case eModifierType_Array:
+    case eModifierType_EdgeSplit:
+    case eModifierType_Displace:
+    case eModifierType_Smooth:
+    case eModifierType_Cast:
+    case eModifierType_Bevel:
+    case eModifierType_Mask:
+    case eModifierType_SimpleDeform:
+    case eModifierType_ShapeKey:
+    case eModifierType_Solidify:
+    case eModifierType_Screw:
+    case eModifierType_WeightVGMix:
+    case eModifierType_WeightVGProximity:
+    case eModifierType_Remesh:
+    case eModifierType_Skin:
+    case eModifierType_LaplacianSmooth:
+    case eModifierType_Triangulate:
+    case eModifierType_UVWarp:
+    case eModifierType_Wireframe:
+    case eModifierType_NormalEdit:
+    case eModifierType_WeightedNormal:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool cache_modifier_is_supported(ModifierData *md, Object *ob)
+{
+  if (!cache_modifier_type_is_supported(md->type)) {
+    return false;
+  }
+
+  const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+
+  /* Textures might be animated. */
+  if (mti->dependsOnTime && mti->dependsOnTime(md)) {
+    return false;
+  }
+
+  /* Optional links to other objects and textures (mirror object, displace texture, ...). */
+  bool has_id_links = false;
+  if (mti->foreachIDLink) {
+    mti->foreachIDLink(md, ob, cache_id_walk, &has_id_links);
+  }
+  else if (mti->foreachObjectLink) {
+    mti->foreachObjectLink(md, ob, (ObjectWalkFunc)cache_id_walk, &has_id_links);
+  }
+  return !has_id_links;
+}
+
+bool BKE_mesh_eval_cache_key_calc(const Depsgraph *depsgraph,
+                                  const Scene *scene,
+                                  Object *ob,
+                                  const CustomData_MeshMasks *dataMask,
+                                  const bool need_mapping,
+                                  uint64_t *r_key)
+{
+  if (U.mesh_eval_cache_limit <= 0) {
+    return false;
+  }
+
+  Mesh *mesh_input = ob->data;
+
+  /* Edit and paint modes read data which is not part of the key (selection, sculpt session),
+   * and change the mesh on every update anyway. */
+  if (ob->mode != OB_MODE_OBJECT || mesh_input->edit_mesh != NULL) {
+    return false;
+  }
+
+  const bool use_render = (DEG_get_mode(depsgraph) == DAG_EVAL_RENDER);
+  const int required_mode = use_render ? eModifierMode_Render : eModifierMode_Realtime;
+
+  MeshEvalCacheHash hash;
+  cache_hash_init(&hash);
+
+  /* Modifiers. */
+  VirtualModifierData virtualModifierData;
+  int modifiers_len = 0;
+  for (ModifierData *md = modifiers_getVirtualModifierList(ob, &virtualModifierData); md;
+       md = md->next) {
+    if (!modifier_isEnabled(scene, md, required_mode)) {
+      continue;
+    }
+    if (!cache_modifier_is_supported(md, ob)) {
+      return false;
+    }
+    const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+    cache_hash_add_dna(&hash, mti->structName, md, NULL, NULL);
+    modifiers_len++;
+  }
+
+  /* Without modifiers the input mesh is used directly, nothing to cache. */
+  if (modifiers_len == 0) {
+    return false;
+  }
+
+  /* Input mesh. */
+  cache_hash_add_dna(&hash, "Mesh", mesh_input, "id", "runtime");
+  if (!cache_hash_add_customdata(&hash, &mesh_input->vdata, mesh_input->totvert) ||
+      !cache_hash_add_customdata(&hash, &mesh_input->edata, mesh_input->totedge) ||
+      !cache_hash_add_customdata(&hash, &mesh_input->fdata, mesh_input->totface) ||
+      !cache_hash_add_customdata(&hash, &mesh_input->ldata, mesh_input->totloop) ||
+      !cache_hash_add_customdata(&hash, &mesh_input->pdata, mesh_input->totpoly)) {
+    return false;
+  }
+  if (mesh_input->key) {
+    cache_hash_add_key(&hash, mesh_input->key);
+  }
+
+  /* Object level settings read by modifiers. */
+  for (const bDeformGroup *dg = ob->defbase.first; dg; dg = dg->next) {
+    cache_hash_add_dna(&hash, "bDeformGroup", dg, NULL, NULL);
+  }
+  cache_hash_add_int(&hash, ob->shapeflag);
+  cache_hash_add_int(&hash, ob->shapenr);
+
+  /* Scene level settings read by modifiers. */
+  cache_hash_add_int(&hash, scene->r.mode & R_SIMPLIFY);
+  cache_hash_add_int(&hash, scene->r.simplify_subsurf);
+  cache_hash_add_int(&hash, scene->r.simplify_subsurf_render);
+
+  /* Evaluation request. */
+  cache_hash_add(&hash, dataMask, sizeof(*dataMask));
+  cache_hash_add_int(&hash, need_mapping);
+  cache_hash_add_int(&hash, use_render);
+
+  *r_key = cache_hash_end(&hash);
+  return true;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Cache Storage
+ * \{ */
+
+static uint cache_key_hash(const void *ptr)
+{
+  const uint64_t key = *(const uint64_t *)ptr;
+  return (uint)(key ^ (key >> 32));
+}
+
+static bool cache_key_cmp(const void *a, const void *b)
+{
+  return *(const uint64_t *)a != *(const uint64_t *)b;
+}
+
+static size_t cache_customdata_memory_size(const CustomData *data, const int totelem)
+{
+  size_t size = 0;
+  for (int i = 0; i < data->totlayer; i++) {
+    const CustomDataLayer *layer = &data->layers[i];
+    size += (size_t)CustomData_sizeof(layer->type) * totelem;
+    if (layer->type == CD_MDEFORMVERT && layer->data) {
+      const MDeformVert *dvert = layer->data;
+      for (int j = 0; j < totelem; j++) {
+        size += sizeof(MDeformWeight) * (size_t)dvert[j].totweight;
+      }
+    }
+  }
+  return size;
+}
+
+static size_t cache_mesh_memory_size(const Mesh *mesh)
+{
+  if (mesh == NULL) {
+    return 0;
+  }
+  return sizeof(*mesh) + cache_customdata_memory_size(&mesh->vdata, mesh->totvert) +
+         cache_customdata_memory_size(&mesh->edata, mesh->totedge) +
+         cache_customdata_memory_size(&mesh->fdata, mesh->totface) +
+         cache_customdata_memory_size(&mesh->ldata, mesh->totloop) +
+         cache_customdata_memory_size(&mesh->pdata, mesh->totpoly);
+}
+
+/* Copy of an evaluated mesh that does not reference any data-block. */
+static Mesh *cache_mesh_copy(const Mesh *mesh)
+{
+  if (mesh == NULL) {
+    return NULL;
+  }
+  Mesh *mesh_copy = BKE_mesh_copy_for_eval((Mesh *)mesh, false);
+  MEM_SAFE_FREE(mesh_copy->mat);
+  mesh_copy->totcol = 0;
+  mesh_copy->key = NULL;
+  mesh_copy->texcomesh = NULL;
+  mesh_copy->edit_mesh = NULL;
+  return mesh_copy;
+}
+
+static void cache_entry_free(MeshEvalCacheEntry *entry)
+{
+  BKE_id_free(NULL, entry->mesh_final);
+  if (entry->mesh_deform) {
+    BKE_id_free(NULL, entry->mesh_deform);
+  }
+  MEM_freeN(entry);
+}
+
+static void cache_entry_remove(MeshEvalCacheEntry *entry)
+{
+  BLI_ghash_remove(g_cache.entries, &entry->key, NULL, NULL);
+  BLI_remlink(&g_cache.lru, entry);
+  g_cache.memory_used -= entry->memory_size;
+  cache_entry_free(entry);
+}
+
+static size_t cache_memory_limit(void)
+{
+  return (size_t)max_ii(U.mesh_eval_cache_limit, 0) * 1024 * 1024;
+}
+
+/* Must be called with the cache locked. */
+static void cache_evict_to_fit(const size_t memory_limit)
+{
+  while (g_cache.memory_used > memory_limit && g_cache.lru.last) {
+    cache_entry_remove(g_cache.lru.last);
+    g_cache.stats.evictions++;
+  }
+}
+
+bool BKE_mesh_eval_cache_lookup(const uint64_t key, Mesh **r_mesh_final, Mesh **r_mesh_deform)
+{
+  bool found = false;
+
+  BLI_mutex_lock(&g_cache.mutex);
+  MeshEvalCacheEntry *entry = g_cache.entries ? BLI_ghash_lookup(g_cache.entries, &key) : NULL;
+  if (entry) {
+    /* Copy while locked, the entry might get evicted by another thread otherwise. */
+    *r_mesh_final = cache_mesh_copy(entry->mesh_final);
+    *r_mesh_deform = cache_mesh_copy(entry->mesh_deform);
+    BLI_remlink(&g_cache.lru, entry);
+    BLI_addhead(&g_cache.lru, entry);
+    g_cache.stats.hits++;
+    found = true;
+  }
+  else {
+    g_cache.stats.misses++;
+  }
+  BLI_mutex_unlock(&g_cache.mutex);
+
+  CLOG_INFO(&LOG, 2, "%s %016llx", found ? "hit" : "miss", (unsigned long long)key);
+  return found;
+}
+
+void BKE_mesh_eval_cache_store(const uint64_t key,
+                               const Mesh *mesh_final,
+                               const Mesh *mesh_deform,
+                               const double eval_time)
+{
+  if (eval_time < MESH_EVAL_CACHE_MIN_EVAL_TIME) {
+    return;
+  }
+
+  const size_t memory_limit = cache_memory_limit();
+  const size_t memory_size = cache_mesh_memory_size(mesh_final) +
+                             cache_mesh_memory_size(mesh_deform);
+  if (memory_size > memory_limit) {
+    return;
+  }
+
+  /* Copy outside of the lock, this is the expensive part. */
+  MeshEvalCacheEntry *entry = MEM_callocN(sizeof(*entry), __func__);
+  entry->key = key;
+  entry->mesh_final = cache_mesh_copy(mesh_final);
+  entry->mesh_deform = cache_mesh_copy(mesh_deform);
+  entry->memory_size = memory_size;
+
+  BLI_mutex_lock(&g_cache.mutex);
+  if (g_cache.entries == NULL) {
+    g_cache.entries = BLI_ghash_new(cache_key_hash, cache_key_cmp, __func__);
+  }
+  if (BLI_ghash_haskey(g_cache.entries, &key)) {
+    /* Another thread evaluated the same stack concurrently. */
+    BLI_mutex_unlock(&g_cache.mutex);
+    cache_entry_free(entry);
+    return;
+  }
+  cache_evict_to_fit(memory_limit - memory_size);
+  BLI_ghash_insert(g_cache.entries, &entry->key, entry);
+  BLI_addhead(&g_cache.lru, entry);
+  g_cache.memory_used += memory_size;
+  g_cache.stats.stores++;
+  BLI_mutex_unlock(&g_cache.mutex);
+
+  CLOG_INFO(&LOG,
+            2,
+            "store %016llx, %.2f MB, evaluated in %.3f s",
+            (unsigned long long)key,
+            (double)memory_size / (1024.0 * 1024.0),
+            eval_time);
+}
+
+void BKE_mesh_eval_cache_limit_update(void)
+{
+  BLI_mutex_lock(&g_cache.mutex);
+  cache_evict_to_fit(cache_memory_limit());
+  BLI_mutex_unlock(&g_cache.mutex);
+}
+
+void BKE_mesh_eval_cache_clear(void)
+{
+  BLI_mutex_lock(&g_cache.mutex);
+  cache_evict_to_fit(0);
+  BLI_mutex_unlock(&g_cache.mutex);
+}
+
+void BKE_mesh_eval_cache_free(void)
+{
+  BKE_mesh_eval_cache_stats_print();
+
+  BLI_mutex_lock(&g_cache.mutex);
+  while (g_cache.lru.first) {
+    cache_entry_remove(g_cache.lru.first);
+  }
+  if (g_cache.entries) {
+    BLI_ghash_free(g_cache.entries, NULL, NULL);
+    g_cache.entries = NULL;
+  }
+  BLI_mutex_unlock(&g_cache.mutex);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Statistics
+ * \{ */
+
+void BKE_mesh_eval_cache_stats_get(MeshEvalCacheStats *r_stats)
+{
+  BLI_mutex_lock(&g_cache.mutex);
+  *r_stats = g_cache.stats;
+  r_stats->entries_len = g_cache.entries ? (int)BLI_ghash_len(g_cache.entries) : 0;
+  r_stats->memory_used = g_cache.memory_used;
+  r_stats->memory_limit = cache_memory_limit();
+  BLI_mutex_unlock(&g_cache.mutex);
+}
+
+void BKE_mesh_eval_cache_stats_print(void)
+{
+  MeshEvalCacheStats stats;
+  BKE_mesh_eval_cache_stats_get(&stats);
+
+  const uint64_t lookups = stats.hits + stats.misses;
+  CLOG_INFO(&LOG,
+            1,
+            "%llu/%llu hits (%.1f%%), %llu stores, %llu evictions, %d entries, %.2f/%.2f MB",
+            (unsigned long long)stats.hits,
+            (unsigned long long)lookups,
+            lookups ? 100.0 * (double)stats.hits / (double)lookups : 0.0,
+            (unsigned long long)stats.stores,
+            (unsigned long long)stats.evictions,
+            stats.entries_len,
+            (double)stats.memory_used / (1024.0 * 1024.0),
+            (double)stats.memory_limit / (1024.0 * 1024.0));
+}
+
+/** \} */
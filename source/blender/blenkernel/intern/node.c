@@ -1084,6 +1084,11 @@ bNode *BKE_node_copy_ex(bNodeTree *ntree, const bNode *node_src, const int flag)
 
   node_dst->new_node = NULL;
 
+  /* Profiling statistics are only valid for the node which was executed. */
+  node_dst->profile_pixels = 0;
+  node_dst->profile_memory = 0;
+  node_dst->profile_time = 0.0f;
+
   bool do_copy_api = !((flag & LIB_ID_CREATE_NO_MAIN) || (flag & LIB_ID_COPY_LOCALIZE));
   if (node_dst->typeinfo->copyfunc_api && do_copy_api) {
     PointerRNA ptr;
@@ -119,6 +119,7 @@ char *BLI_file_ungzip_to_mem(const char *from_file, int *r_size) ATTR_WARN_UNUSE
     ATTR_NONNULL();
 
 size_t BLI_file_descriptor_size(int file) ATTR_WARN_UNUSED_RESULT;
+bool BLI_file_descriptor_is_local(int file) ATTR_WARN_UNUSED_RESULT;
 size_t BLI_file_size(const char *file) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
 
 /* compare if one was last modified before the other */
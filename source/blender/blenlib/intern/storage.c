@@ -187,6 +187,81 @@ size_t BLI_file_descriptor_size(int file)
   return st.st_size;
 }
 
+/**
+ * Returns false for files on network or removable file systems, which can go away or change size
+ * while the file is open (a memory mapping of such a file faults on access instead of reporting
+ * an error). Also false when the file system can't be queried.
+ */
+bool BLI_file_descriptor_is_local(int file)
+{
+  if (file < 0) {
+    return false;
+  }
+#ifdef WIN32
+  HANDLE handle = (HANDLE)_get_osfhandle(file);
+  wchar_t path[MAX_PATH + 8];
+  const DWORD path_len = GetFinalPathNameByHandleW(
+      handle, path, ARRAY_SIZE(path), FILE_NAME_NORMALIZED | VOLUME_NAME_DOS);
+  if (path_len == 0 || path_len >= ARRAY_SIZE(path)) {
+    return false;
+  }
+  /* Paths are returned as "\\?\C:\..." or "\\?\UNC\server\share\..." for network shares. */
+  if (wcsncmp(path, L"\\\\?\\UNC\\", 8) == 0 || wcsncmp(path, L"\\\\?\\", 4) != 0) {
+    return false;
+  }
+  const wchar_t root[4] = {path[4], L':', L'\\', 0};
+  switch (GetDriveTypeW(root)) {
+    case DRIVE_FIXED:
+    case DRIVE_RAMDISK:
+      return true;
+    default:
+      /* Remote, removable, CD-ROM or unknown. */
+      return false;
+  }
+#elif defined(__linux__)
+  struct statfs disk;
+  if (fstatfs(file, &disk) == -1) {
+    return false;
+  }
+  switch ((unsigned int)disk.f_type) {
+    case 0x6969:     /* NFS */
+    case 0x517B:     /* SMB */
+    case 0xFF534D42: /* CIFS */
+    case 0xFE534D42: /* SMB2 */
+    case 0x73757245: /* Coda */
+    case 0x5346414F: /* AFS */
+    case 0x00C36400: /* Ceph */
+    case 0x01021997: /* 9P */
+    case 0x65735546: /* FUSE, used for SSHFS and others. */
+    case 0x4D44:     /* FAT, as on USB drives and memory cards. */
+    case 0x2011BAB0: /* exFAT */
+    case 0x9660:     /* ISO 9660 */
+    case 0x15013346: /* UDF */
+      return false;
+    default:
+      return true;
+  }
+#elif defined(USE_STATFS_STATVFS)
+  struct statvfs disk;
+  if (fstatvfs(file, &disk) == -1) {
+    return false;
+  }
+#  ifdef ST_LOCAL
+  return (disk.f_flag & ST_LOCAL) != 0;
+#  else
+  return true;
+#  endif
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__)
+  struct statfs disk;
+  if (fstatfs(file, &disk) == -1) {
+    return false;
+  }
+  return (disk.f_flags & MNT_LOCAL) != 0;
+#else
+  return true;
+#endif
+}
+
 /**
  * Returns the size of a file.
  */
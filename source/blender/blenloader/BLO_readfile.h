@@ -172,6 +172,26 @@ void BLO_version_defaults_userpref_blend(struct Main *mainvar, struct UserDef *u
 
 struct BlendThumbnail *BLO_thumbnail_from_file(const char *filepath);
 
+/** Data-block or library listed in the index of a file. */
+typedef struct BlendFileIndexItem {
+  /** ID code, #ID_LI for libraries or #ID_LINK_PLACEHOLDER for linked data-blocks. */
+  int code;
+  /** Item of the library of linked data-blocks, -1 for local ones. */
+  int library;
+  char name[66]; /* MAX_ID_NAME */
+  /** File path of libraries, NULL for other items. */
+  const char *filepath;
+} BlendFileIndexItem;
+
+typedef struct BlendFileIndex {
+  BlendFileIndexItem *items;
+  int items_len;
+  bool has_thumbnail;
+} BlendFileIndex;
+
+BlendFileIndex *BLO_blendfile_index_from_file(const char *filepath);
+void BLO_blendfile_index_free(BlendFileIndex *index);
+
 /* datafiles (generated theme) */
 extern const struct bTheme U_theme_default;
 
@@ -25,6 +25,9 @@
  * \ingroup blenloader
  */
 
+struct GSet;
+struct ID;
+struct MemFileChunkIndex;
 struct Scene;
 
 typedef struct {
@@ -32,6 +35,8 @@ typedef struct {
   const char *buf;
   /** Size in bytes. */
   unsigned int size;
+  /** Hash of the contents of #buf, used to find identical chunks in the next undo step. */
+  unsigned int hash;
   /** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk */
   bool is_identical;
 } MemFileChunk;
@@ -41,6 +46,15 @@ typedef struct MemFile {
   size_t size;
 } MemFile;
 
+/** Location of a local data-block in a #MemFile, see #BLO_write_file_mem_ex. */
+typedef struct MemFileIDRange {
+  struct ID *id;
+  /** Offset of the ID block header from the start of the file. */
+  size_t offset;
+  /** Size of the ID block and all its data blocks, including headers. */
+  size_t size;
+} MemFileIDRange;
+
 typedef struct MemFileUndoData {
   char filename[1024]; /* FILE_MAX */
   MemFile memfile;
@@ -51,16 +65,34 @@ typedef struct MemFileUndoData {
 extern void memfile_chunk_add(MemFile *memfile,
                               const char *buf,
                               unsigned int size,
-                              MemFileChunk **compchunk_step);
+                              MemFileChunk **compchunk_step,
+                              struct GSet *compchunk_set);
+extern struct GSet *memfile_chunk_set_new(MemFile *memfile);
+extern void memfile_chunk_set_free(struct GSet *compchunk_set);
+
+/* actually only used readfile.c */
+extern struct MemFileChunkIndex *memfile_chunk_index_new(const MemFile *memfile);
+extern void memfile_chunk_index_free(struct MemFileChunkIndex *index);
+extern bool memfile_chunk_index_range_equals(const struct MemFileChunkIndex *index_a,
+                                             size_t offset_a,
+                                             const struct MemFileChunkIndex *index_b,
+                                             size_t offset_b,
+                                             size_t size);
 
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
 extern void BLO_memfile_merge(MemFile *first, MemFile *second);
+extern MemFile *BLO_memfile_copy(const MemFile *memfile);
 
 /* utilities */
 extern struct Main *BLO_memfile_main_get(struct MemFile *memfile,
                                          struct Main *bmain,
                                          struct Scene **r_scene);
 extern bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename);
+extern bool BLO_memfile_write_file_ex(struct MemFile *memfile,
+                                      const char *filename,
+                                      const bool use_compress,
+                                      float *r_progress,
+                                      const short *stop);
 
 #endif /* __BLO_UNDOFILE_H__ */
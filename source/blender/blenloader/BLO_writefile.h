@@ -26,6 +26,7 @@
  */
 
 struct BlendThumbnail;
+struct GHash;
 struct Main;
 struct MemFile;
 struct ReportList;
@@ -39,5 +40,10 @@ extern bool BLO_write_file_mem(struct Main *mainvar,
                                struct MemFile *compare,
                                struct MemFile *current,
                                int write_flags);
+extern bool BLO_write_file_mem_ex(struct Main *mainvar,
+                                  struct MemFile *compare,
+                                  struct MemFile *current,
+                                  int write_flags,
+                                  struct GHash *r_id_ranges);
 
 #endif
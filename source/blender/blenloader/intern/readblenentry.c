@@ -144,6 +144,18 @@ LinkNode *BLO_blendhandle_get_datablock_names(BlendHandle *bh, int ofblocktype,
   BHead *bhead;
   int tot = 0;
 
+  if (fd->file_index) {
+    const BlendFileIndexEntry *entries = blo_file_index_entries(fd->file_index);
+    for (int i = 0; i < fd->file_index->entries_len; i++) {
+      if (entries[i].code == ofblocktype) {
+        BLI_linklist_prepend(&names, strdup(entries[i].name + 2));
+        tot++;
+      }
+    }
+    *tot_names = tot;
+    return names;
+  }
+
   for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
     if (bhead->code == ofblocktype) {
       const char *idname = blo_bhead_id_name(fd, bhead);
@@ -264,6 +276,22 @@ LinkNode *BLO_blendhandle_get_linkable_groups(BlendHandle *bh)
   LinkNode *names = NULL;
   BHead *bhead;
 
+  if (fd->file_index) {
+    const BlendFileIndexEntry *entries = blo_file_index_entries(fd->file_index);
+    for (int i = 0; i < fd->file_index->entries_len; i++) {
+      const int code = entries[i].code;
+      if (BKE_idcode_is_valid(code) && BKE_idcode_is_linkable(code)) {
+        const char *str = BKE_idcode_to_name(code);
+
+        if (BLI_gset_add(gathered, (void *)str)) {
+          BLI_linklist_prepend(&names, strdup(str));
+        }
+      }
+    }
+    BLI_gset_free(gathered, NULL);
+    return names;
+  }
+
   for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
     if (bhead->code == ENDB) {
       break;
@@ -376,6 +404,9 @@ BlendFileData *BLO_read_from_memfile(Main *oldmain,
     fd->skip_flags = skip_flags;
     BLI_strncpy(fd->relabase, filename, sizeof(fd->relabase));
 
+    /* makes lookup of data-blocks in old main which didn't change, before it's modified */
+    blo_make_undo_reuse_map(fd, oldmain);
+
     /* clear ob->proxy_from pointers in old main */
     blo_clear_proxy_pointers_from_lib(oldmain);
 
@@ -412,6 +443,9 @@ BlendFileData *BLO_read_from_memfile(Main *oldmain,
     /* ensures relinked sounds are not freed */
     blo_end_sound_pointer_map(fd, oldmain);
 
+    /* kept data-blocks were already moved out of old main */
+    blo_end_undo_reuse_map(fd);
+
     /* Still in-use libraries have already been moved from oldmain to new mainlist,
      * but oldmain itself shall *never* be 'transferred' to new mainlist! */
     BLI_assert(old_mainlist.first == oldmain);
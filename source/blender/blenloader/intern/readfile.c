@@ -36,11 +36,13 @@
 
 #include "BLI_utildefines.h"
 #ifndef WIN32
-#  include <unistd.h>  // for read close
+#  include <unistd.h>    // for read close
+#  include <sys/mman.h>  // for mmap munmap
 #else
 #  include <io.h>  // for open close read
 #  include "winsock2.h"
 #  include "BLI_winstuff.h"
+#  include "mmap_win.h"
 #endif
 
 /* allow readfile to use deprecated functionality */
@@ -102,6 +104,7 @@
 #include "BLI_endian_switch.h"
 #include "BLI_blenlib.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_mempool.h"
 #include "BLI_ghash.h"
@@ -124,6 +127,7 @@
 #include "BKE_gpencil_modifier.h"
 #include "BKE_idcode.h"
 #include "BKE_idprop.h"
+#include "BKE_image.h"
 #include "BKE_layer.h"
 #include "BKE_library.h"
 #include "BKE_library_idmap.h"
@@ -160,6 +164,7 @@
 #include "BLO_blend_validate.h"
 #include "BLO_readfile.h"
 #include "BLO_undofile.h"
+#include "BLO_writefile.h"
 
 #include "RE_engine.h"
 
@@ -226,12 +231,52 @@
  */
 #define USE_BHEAD_READ_ON_DEMAND
 
+/**
+ * Map uncompressed files into memory instead of reading them through the file descriptor.
+ *
+ * Only the pages of the blocks which are actually used get loaded,
+ * which makes a big difference when linking a few data-blocks out of large libraries.
+ * Data of delayed blocks (see #USE_BHEAD_READ_ON_DEMAND) is then copied
+ * (or reconstructed) straight out of the mapping, without any seeking or system calls.
+ *
+ * Note that files are saved into a temporary file which is then renamed,
+ * so a file which is mapped is never truncated underneath us by Blender itself.
+ * Other programs can still do so, files on network and removable file systems are not mapped
+ * for that reason, see #fd_mmap_file.
+ */
+#ifdef USE_BHEAD_READ_ON_DEMAND
+#  define USE_BHEAD_READ_MMAP
+#endif
+
 /* use GHash for BHead name-based lookups (speeds up linking) */
 #define USE_GHASH_BHEAD
 
 /* Use GHash for restoring pointers by name */
 #define USE_GHASH_RESTORE_POINTER
 
+/**
+ * Direct link data-blocks which only reference their own data on worker threads,
+ * once all blocks of the file have been walked over (see #direct_link_queue_flush).
+ *
+ * Reading their data (including DNA reconstruction and endian switching)
+ * is done by the workers as well, which is where most of the time goes for heavy files.
+ */
+#define USE_PARALLEL_DIRECT_LINK
+
+/**
+ * On undo, keep data-blocks of the current main which did not change since the step being read
+ * was written, instead of freeing them along with the old main and reading them again.
+ *
+ * The current main is written the same way as an undo step, a data-block is unchanged when its
+ * bytes are identical to the ones in the step. Most of them are shared chunks which don't need
+ * to be compared byte per byte, see #memfile_chunk_index_range_equals.
+ *
+ * Needs the offsets of blocks in the file, only stored with #USE_BHEAD_READ_ON_DEMAND.
+ */
+#ifdef USE_BHEAD_READ_ON_DEMAND
+#  define USE_UNDO_REUSE_UNCHANGED_ID
+#endif
+
 /* Define this to have verbose debug prints. */
 #define USE_DEBUG_PRINT
 
@@ -247,6 +292,12 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname);
 static void direct_link_modifiers(FileData *fd, ListBase *lb);
 static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const char *name);
 static BHead *find_bhead_from_idname(FileData *fd, const char *idname);
+#ifdef USE_PARALLEL_DIRECT_LINK
+static void direct_link_queue_free(struct DirectLinkQueue *queue);
+#endif
+#ifdef USE_UNDO_REUSE_UNCHANGED_ID
+static void undo_reuse_free(struct UndoReuse *undo_reuse);
+#endif
 
 #ifdef USE_COLLECTION_COMPAT_28
 static void expand_scene_collection(FileData *fd, Main *mainvar, SceneCollection *sc);
@@ -873,7 +924,8 @@ static BHeadN *get_bhead(FileData *fd)
         if (new_bhead) {
           new_bhead->next = new_bhead->prev = NULL;
 #ifdef USE_BHEAD_READ_ON_DEMAND
-          new_bhead->file_offset = 0; /* don't seek. */
+          /* Data is read along, the offset is only used to locate the block (not for seeking). */
+          new_bhead->file_offset = fd->file_offset;
           new_bhead->has_data = true;
 #endif
           new_bhead->bhead = bhead;
@@ -958,11 +1010,31 @@ BHead *blo_bhead_next(FileData *fd, BHead *thisblock)
 }
 
 #ifdef USE_BHEAD_READ_ON_DEMAND
+#  ifdef USE_BHEAD_READ_MMAP
+/**
+ * Data of a block which was not read yet, directly from the file mapping.
+ * Bounds were checked when the block was added (see #get_bhead).
+ */
+static const void *blo_bhead_data_mapped(FileData *fd, BHead *thisblock)
+{
+  BHeadN *new_bhead = BHEADN_FROM_BHEAD(thisblock);
+  BLI_assert(new_bhead->has_data == false && (fd->flags & FD_FLAGS_FILE_MMAP));
+  BLI_assert(new_bhead->file_offset + new_bhead->bhead.len <= (off64_t)fd->mmap_size);
+  return fd->buffer + new_bhead->file_offset;
+}
+#  endif
+
 static bool blo_bhead_read_data(FileData *fd, BHead *thisblock, void *buf)
 {
   bool success = true;
   BHeadN *new_bhead = BHEADN_FROM_BHEAD(thisblock);
   BLI_assert(new_bhead->has_data == false && new_bhead->file_offset != 0);
+#  ifdef USE_BHEAD_READ_MMAP
+  if (fd->flags & FD_FLAGS_FILE_MMAP) {
+    memcpy(buf, blo_bhead_data_mapped(fd, thisblock), new_bhead->bhead.len);
+    return success;
+  }
+#  endif
   off64_t offset_backup = fd->file_offset;
   if (UNLIKELY(fd->seek(fd, new_bhead->file_offset, SEEK_SET) == -1)) {
     success = false;
@@ -1039,6 +1111,244 @@ static void decode_blender_header(FileData *fd)
   }
 }
 
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name File Index
+ * \{ */
+
+/**
+ * Read the block at \a offset with its data, without adding it to the list of blocks.
+ * The position in the file is kept, the caller owns the result.
+ */
+static BHeadN *get_bhead_at_offset(FileData *fd, const off64_t offset)
+{
+  const off64_t offset_backup = fd->file_offset;
+  const bool is_eof_backup = fd->is_eof;
+  BHeadN *new_bhead = NULL;
+
+  if (fd->seek(fd, offset, SEEK_SET) != -1) {
+    new_bhead = get_bhead(fd);
+    if (new_bhead) {
+      BLI_remlink(&fd->bhead_list, new_bhead);
+#ifdef USE_BHEAD_READ_ON_DEMAND
+      if (new_bhead->has_data == false) {
+        BHead *bhead_full = blo_bhead_read_full(fd, &new_bhead->bhead);
+        MEM_freeN(new_bhead);
+        new_bhead = bhead_full ? BHEADN_FROM_BHEAD(bhead_full) : NULL;
+      }
+#endif
+    }
+  }
+
+  fd->seek(fd, offset_backup, SEEK_SET);
+  fd->is_eof = is_eof_backup;
+  return new_bhead;
+}
+
+static void switch_endian_file_index(BlendFileIndexHeader *header)
+{
+  BlendFileIndexEntry *entries = blo_file_index_entries(header);
+
+  for (int i = 0; i < header->entries_len; i++) {
+    /* Codes are stored as in #BHead, they don't need switching. */
+    BLI_endian_switch_int32(&entries[i].library);
+    BLI_endian_switch_int64(&entries[i].offset);
+    BLI_endian_switch_int32(&entries[i].filepath);
+  }
+}
+
+/**
+ * Read the index stored at the end of the file into #FileData.file_index.
+ * \return false when the file has no index or it can't be used.
+ */
+static bool read_file_index(FileData *fd)
+{
+  BlendFileIndexTrailer trailer;
+  bool has_trailer = false;
+
+  /* The index can only be located in files which can seek. */
+  if (fd->seek == NULL) {
+    return false;
+  }
+
+  const off64_t offset_backup = fd->file_offset;
+  if (fd->seek(fd, -(off64_t)sizeof(trailer), SEEK_END) != -1 &&
+      fd->read(fd, &trailer, sizeof(trailer)) == sizeof(trailer)) {
+    has_trailer = memcmp(trailer.magic, BLEND_FILE_INDEX_MAGIC, sizeof(trailer.magic)) == 0;
+  }
+  fd->seek(fd, offset_backup, SEEK_SET);
+
+  if (!has_trailer) {
+    return false;
+  }
+
+  const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
+  if (do_endian_swap) {
+    BLI_endian_switch_uint64(&trailer.index_offset);
+  }
+  if (trailer.index_offset < SIZEOFBLENDERHEADER) {
+    return false;
+  }
+
+  BHeadN *new_bhead = get_bhead_at_offset(fd, (off64_t)trailer.index_offset);
+  if (new_bhead == NULL) {
+    return false;
+  }
+
+  const BHead *bhead = &new_bhead->bhead;
+  BlendFileIndexHeader header;
+  size_t index_size = 0;
+
+  if (bhead->code == DATA && bhead->len >= sizeof(header)) {
+    memcpy(&header, bhead + 1, sizeof(header));
+    if (do_endian_swap) {
+      BLI_endian_switch_int32(&header.version);
+      BLI_endian_switch_int32(&header.entries_len);
+      BLI_endian_switch_int32(&header.strings_len);
+      BLI_endian_switch_int64(&header.glob_offset);
+      BLI_endian_switch_int64(&header.dna_offset);
+      BLI_endian_switch_int64(&header.thumb_offset);
+    }
+    if (header.version == BLEND_FILE_INDEX_VERSION && header.entries_len >= 0 &&
+        header.strings_len >= 0) {
+      index_size = sizeof(header) + sizeof(BlendFileIndexEntry) * (size_t)header.entries_len +
+                   (size_t)header.strings_len;
+      if (index_size > (size_t)bhead->len) {
+        index_size = 0;
+      }
+    }
+  }
+
+  if (index_size != 0) {
+    /* Extra byte so the strings are always terminated. */
+    fd->file_index = MEM_mallocN(index_size + 1, __func__);
+    memcpy(fd->file_index, bhead + 1, index_size);
+    *fd->file_index = header;
+    ((char *)fd->file_index)[index_size] = '\0';
+
+    if (do_endian_swap) {
+      switch_endian_file_index(fd->file_index);
+    }
+
+    BlendFileIndexEntry *entries = blo_file_index_entries(fd->file_index);
+    for (int i = 0; i < header.entries_len; i++) {
+      entries[i].name[sizeof(entries[i].name) - 1] = '\0';
+      if (entries[i].filepath >= header.strings_len) {
+        entries[i].filepath = -1;
+      }
+      if (entries[i].library >= header.entries_len) {
+        entries[i].library = -1;
+      }
+    }
+  }
+
+  MEM_freeN(new_bhead);
+  return fd->file_index != NULL;
+}
+
+BlendFileIndexEntry *blo_file_index_entries(const BlendFileIndexHeader *file_index)
+{
+  return (BlendFileIndexEntry *)(file_index + 1);
+}
+
+/**
+ * \return The file path of a library entry, NULL for other entries.
+ */
+const char *blo_file_index_filepath(const BlendFileIndexHeader *file_index,
+                                    const BlendFileIndexEntry *entry)
+{
+  if (entry->filepath < 0) {
+    return NULL;
+  }
+  const char *strings = (const char *)(blo_file_index_entries(file_index) +
+                                       file_index->entries_len);
+  return strings + entry->filepath;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name File DNA
+ * \{ */
+
+/**
+ * Subversion of the file from its #GLOB block.
+ */
+static int read_file_subversion(FileData *fd, const BHead *bhead)
+{
+  /* Before this, the subversion didn't exist in 'FileGlobal' so the subversion
+   * value isn't accessible for the purpose of DNA versioning in this case. */
+  if (fd->fileversion <= 242) {
+    return 0;
+  }
+  /* We can't use read_global because this needs 'DNA1' to be decoded,
+   * however the first 4 chars are _always_ the subversion. */
+  const FileGlobal *fg = (const void *)&bhead[1];
+  BLI_STATIC_ASSERT(offsetof(FileGlobal, subvstr) == 0, "Must be first: subvstr")
+  char num[5];
+  memcpy(num, fg->subvstr, 4);
+  num[4] = 0;
+  return atoi(num);
+}
+
+static bool read_file_dna_block(FileData *fd,
+                                const BHead *bhead,
+                                const int subversion,
+                                const char **r_error_message)
+{
+  const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
+
+  fd->filesdna = DNA_sdna_from_data(&bhead[1], bhead->len, do_endian_swap, true, r_error_message);
+  if (fd->filesdna) {
+    blo_do_versions_dna(fd->filesdna, fd->fileversion, subversion);
+    fd->compflags = DNA_struct_get_compareflags(fd->filesdna, fd->memsdna);
+    fd->reconstruct_info = DNA_reconstruct_info_create(fd->filesdna, fd->memsdna, fd->compflags);
+    /* used to retrieve ID names from (bhead+1) */
+    fd->id_name_offs = DNA_elem_offset(fd->filesdna, "ID", "char", "name[]");
+
+    return true;
+  }
+  else {
+    return false;
+  }
+}
+
+/**
+ * Read the #GLOB and #DNA1 blocks at the offsets given by the index,
+ * leaving the blocks in between unread.
+ * \return false when the index doesn't match the file, then blocks have to be scanned.
+ */
+static bool read_file_dna_from_index(FileData *fd, bool *r_success, const char **r_error_message)
+{
+  const BlendFileIndexHeader *file_index = fd->file_index;
+  if (file_index->dna_offset == 0) {
+    return false;
+  }
+
+  BHeadN *dna_bhead = get_bhead_at_offset(fd, (off64_t)file_index->dna_offset);
+  if (dna_bhead == NULL) {
+    return false;
+  }
+  if (dna_bhead->bhead.code != DNA1) {
+    MEM_freeN(dna_bhead);
+    return false;
+  }
+
+  int subversion = 0;
+  if (file_index->glob_offset != 0) {
+    BHeadN *glob_bhead = get_bhead_at_offset(fd, (off64_t)file_index->glob_offset);
+    if (glob_bhead && glob_bhead->bhead.code == GLOB) {
+      subversion = read_file_subversion(fd, &glob_bhead->bhead);
+    }
+    MEM_SAFE_FREE(glob_bhead);
+  }
+
+  *r_success = read_file_dna_block(fd, &dna_bhead->bhead, subversion, r_error_message);
+  MEM_freeN(dna_bhead);
+  return true;
+}
+
 /**
  * \return Success if the file is read correctly, else set \a r_error_message.
  */
@@ -1047,38 +1357,21 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
   BHead *bhead;
   int subversion = 0;
 
+  if (read_file_index(fd)) {
+    bool success;
+    if (read_file_dna_from_index(fd, &success, r_error_message)) {
+      return success;
+    }
+    /* Not matching the file, don't use it for anything else either. */
+    MEM_SAFE_FREE(fd->file_index);
+  }
+
   for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
     if (bhead->code == GLOB) {
-      /* Before this, the subversion didn't exist in 'FileGlobal' so the subversion
-       * value isn't accessible for the purpose of DNA versioning in this case. */
-      if (fd->fileversion <= 242) {
-        continue;
-      }
-      /* We can't use read_global because this needs 'DNA1' to be decoded,
-       * however the first 4 chars are _always_ the subversion. */
-      FileGlobal *fg = (void *)&bhead[1];
-      BLI_STATIC_ASSERT(offsetof(FileGlobal, subvstr) == 0, "Must be first: subvstr")
-      char num[5];
-      memcpy(num, fg->subvstr, 4);
-      num[4] = 0;
-      subversion = atoi(num);
+      subversion = read_file_subversion(fd, bhead);
     }
     else if (bhead->code == DNA1) {
-      const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
-
-      fd->filesdna = DNA_sdna_from_data(
-          &bhead[1], bhead->len, do_endian_swap, true, r_error_message);
-      if (fd->filesdna) {
-        blo_do_versions_dna(fd->filesdna, fd->fileversion, subversion);
-        fd->compflags = DNA_struct_get_compareflags(fd->filesdna, fd->memsdna);
-        /* used to retrieve ID names from (bhead+1) */
-        fd->id_name_offs = DNA_elem_offset(fd->filesdna, "ID", "char", "name[]");
-
-        return true;
-      }
-      else {
-        return false;
-      }
+      return read_file_dna_block(fd, bhead, subversion, r_error_message);
     }
     else if (bhead->code == ENDB) {
       break;
@@ -1089,36 +1382,42 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
   return false;
 }
 
-static int *read_file_thumbnail(FileData *fd)
+/**
+ * \return The thumbnail data of a #TEST block, NULL when it isn't valid.
+ */
+static int *read_file_thumbnail_block(FileData *fd, BHead *bhead)
 {
-  BHead *bhead;
-  int *blend_thumb = NULL;
+  const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
+  int *data = (int *)(bhead + 1);
 
-  for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
-    if (bhead->code == TEST) {
-      const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
-      int *data = (int *)(bhead + 1);
+  if (bhead->len < (2 * sizeof(int))) {
+    return NULL;
+  }
 
-      if (bhead->len < (2 * sizeof(int))) {
-        break;
-      }
+  if (do_endian_swap) {
+    BLI_endian_switch_int32(&data[0]);
+    BLI_endian_switch_int32(&data[1]);
+  }
 
-      if (do_endian_swap) {
-        BLI_endian_switch_int32(&data[0]);
-        BLI_endian_switch_int32(&data[1]);
-      }
+  const int width = data[0];
+  const int height = data[1];
+  if (!BLEN_THUMB_MEMSIZE_IS_VALID(width, height)) {
+    return NULL;
+  }
+  if (bhead->len < BLEN_THUMB_MEMSIZE_FILE(width, height)) {
+    return NULL;
+  }
 
-      const int width = data[0];
-      const int height = data[1];
-      if (!BLEN_THUMB_MEMSIZE_IS_VALID(width, height)) {
-        break;
-      }
-      if (bhead->len < BLEN_THUMB_MEMSIZE_FILE(width, height)) {
-        break;
-      }
+  return data;
+}
 
-      blend_thumb = data;
-      break;
+static int *read_file_thumbnail(FileData *fd)
+{
+  BHead *bhead;
+
+  for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
+    if (bhead->code == TEST) {
+      return read_file_thumbnail_block(fd, bhead);
     }
     else if (bhead->code != REND) {
       /* Thumbnail is stored in TEST immediately after first REND... */
@@ -1126,7 +1425,7 @@ static int *read_file_thumbnail(FileData *fd)
     }
   }
 
-  return blend_thumb;
+  return NULL;
 }
 
 /** \} */
@@ -1173,68 +1472,375 @@ static int fd_read_gzip_from_file(FileData *filedata, void *buffer, uint size)
   return (readsize);
 }
 
-/* Memory reading. */
-
-static int fd_read_from_memory(FileData *filedata, void *buffer, uint size)
-{
-  /* don't read more bytes then there are available in the buffer */
-  int readsize = (int)MIN2(size, (uint)(filedata->buffersize - filedata->file_offset));
-
-  memcpy(buffer, filedata->buffer + filedata->file_offset, readsize);
-  filedata->file_offset += readsize;
+/* Framed GZip file reading, see #BLEND_GZIP_FRAME_EXTRA_ID. */
 
-  return (readsize);
+typedef struct GzipFrame {
+  /** Offset of the gzip member in the file. */
+  off64_t file_offset;
+  /** Offset of the uncompressed data of the frame in the stream. */
+  off64_t data_offset;
+  uint member_len;
+  uint data_len;
+} GzipFrame;
+
+typedef struct GzipFrames {
+  GzipFrame *frames;
+  int frames_len;
+  /** Size of the uncompressed stream. */
+  off64_t data_len;
+
+  /** Frame which is inflated in #frame_data, -1 for none. */
+  int frame_loaded;
+  char *frame_data;
+  size_t frame_data_size;
+  char *member_data;
+  size_t member_data_size;
+} GzipFrames;
+
+static uint gzip_frame_load_uint32(const uchar *src)
+{
+  return (uint)src[0] | ((uint)src[1] << 8) | ((uint)src[2] << 16) | ((uint)src[3] << 24);
+}
+
+/* Returns false for members not written as frames, these can only be read as a stream. */
+static bool gzip_frame_header_decode(const uchar header[BLEND_GZIP_FRAME_HEADER_SIZE],
+                                     uint *r_member_len,
+                                     uint *r_data_len)
+{
+  if (header[0] != 0x1f || header[1] != 0x8b || header[2] != 8 || header[3] != 4 ||
+      header[10] != 12 || header[11] != 0 || header[12] != BLEND_GZIP_FRAME_EXTRA_ID[0] ||
+      header[13] != BLEND_GZIP_FRAME_EXTRA_ID[1] || header[14] != 8 || header[15] != 0) {
+    return false;
+  }
+  *r_member_len = gzip_frame_load_uint32(&header[16]);
+  *r_data_len = gzip_frame_load_uint32(&header[20]);
+  return *r_member_len >= BLEND_GZIP_FRAME_HEADER_SIZE + BLEND_GZIP_FRAME_TRAILER_SIZE;
 }
 
-/* MemFile reading. */
+static void gzip_frames_free(GzipFrames *gf)
+{
+  MEM_SAFE_FREE(gf->frames);
+  MEM_SAFE_FREE(gf->frame_data);
+  MEM_SAFE_FREE(gf->member_data);
+  MEM_freeN(gf);
+}
 
-static int fd_read_from_memfile(FileData *filedata, void *buffer, uint size)
+/**
+ * Build the table of frames by hopping over the member headers.
+ * Returns NULL when the file is not made of frames only (written by gzwrite, or by other tools),
+ * such files are read with gzread() instead.
+ */
+static GzipFrames *gzip_frames_from_file_descriptor(int file)
 {
-  static size_t seek = SIZE_MAX; /* the current position */
-  static size_t offset = 0;      /* size of previous chunks */
-  static MemFileChunk *chunk = NULL;
-  size_t chunkoffset, readsize, totread;
+  const size_t file_size = BLI_file_descriptor_size(file);
+  if (file_size == (size_t)-1) {
+    return NULL;
+  }
 
-  if (size == 0) {
-    return 0;
+  GzipFrames *gf = MEM_callocN(sizeof(*gf), __func__);
+  gf->frame_loaded = -1;
+  int frames_alloc = 0;
+
+  off64_t file_offset = 0;
+  while ((size_t)file_offset < file_size) {
+    uchar header[BLEND_GZIP_FRAME_HEADER_SIZE];
+    uint member_len, data_len;
+    if (lseek(file, file_offset, SEEK_SET) != file_offset ||
+        read(file, header, sizeof(header)) != sizeof(header) ||
+        !gzip_frame_header_decode(header, &member_len, &data_len) ||
+        (size_t)file_offset + member_len > file_size) {
+      gzip_frames_free(gf);
+      lseek(file, 0, SEEK_SET);
+      return NULL;
+    }
+
+    if (gf->frames_len == frames_alloc) {
+      frames_alloc = frames_alloc ? frames_alloc * 2 : 64;
+      gf->frames = MEM_reallocN(gf->frames, sizeof(*gf->frames) * (size_t)frames_alloc);
+    }
+    GzipFrame *frame = &gf->frames[gf->frames_len++];
+    frame->file_offset = file_offset;
+    frame->data_offset = gf->data_len;
+    frame->member_len = member_len;
+    frame->data_len = data_len;
+
+    file_offset += member_len;
+    gf->data_len += data_len;
   }
 
-  if (seek != (size_t)filedata->file_offset) {
-    chunk = filedata->memfile->chunks.first;
-    seek = 0;
+  lseek(file, 0, SEEK_SET);
+  if (gf->frames_len == 0) {
+    gzip_frames_free(gf);
+    return NULL;
+  }
+  return gf;
+}
 
-    while (chunk) {
-      if (seek + chunk->size > (size_t)filedata->file_offset) {
-        break;
-      }
-      seek += chunk->size;
-      chunk = chunk->next;
+/* Index of the frame containing the given offset of the uncompressed stream. */
+static int gzip_frames_find(const GzipFrames *gf, const off64_t data_offset)
+{
+  /* Reading is mostly sequential. */
+  if (gf->frame_loaded != -1) {
+    const GzipFrame *frame = &gf->frames[gf->frame_loaded];
+    if (data_offset >= frame->data_offset &&
+        data_offset < frame->data_offset + (off64_t)frame->data_len) {
+      return gf->frame_loaded;
     }
-    offset = seek;
-    seek = filedata->file_offset;
   }
 
-  if (chunk) {
-    totread = 0;
+  int lo = 0, hi = gf->frames_len - 1;
+  while (lo < hi) {
+    const int mid = (lo + hi + 1) / 2;
+    if (gf->frames[mid].data_offset <= data_offset) {
+      lo = mid;
+    }
+    else {
+      hi = mid - 1;
+    }
+  }
+  return lo;
+}
 
-    do {
-      /* first check if it's on the end if current chunk */
-      if (seek - offset == chunk->size) {
-        offset += chunk->size;
-        chunk = chunk->next;
-      }
+/* Inflate a frame into #GzipFrames.frame_data. */
+static bool gzip_frames_load(GzipFrames *gf, int file, const int frame_index)
+{
+  if (gf->frame_loaded == frame_index) {
+    return true;
+  }
+  gf->frame_loaded = -1;
 
-      /* debug, should never happen */
-      if (chunk == NULL) {
-        printf("illegal read, chunk zero\n");
-        return 0;
-      }
+  const GzipFrame *frame = &gf->frames[frame_index];
+  const size_t member_data_len = frame->member_len - BLEND_GZIP_FRAME_HEADER_SIZE;
+  if (gf->member_data_size < member_data_len) {
+    MEM_SAFE_FREE(gf->member_data);
+    gf->member_data = MEM_mallocN(member_data_len, __func__);
+    gf->member_data_size = member_data_len;
+  }
+  if (gf->frame_data_size < frame->data_len) {
+    MEM_SAFE_FREE(gf->frame_data);
+    gf->frame_data = MEM_mallocN(frame->data_len, __func__);
+    gf->frame_data_size = frame->data_len;
+  }
 
-      chunkoffset = seek - offset;
-      readsize = size - totread;
+  const off64_t member_data_offset = frame->file_offset + BLEND_GZIP_FRAME_HEADER_SIZE;
+  if (lseek(file, member_data_offset, SEEK_SET) != member_data_offset ||
+      (size_t)read(file, gf->member_data, member_data_len) != member_data_len) {
+    return false;
+  }
 
-      /* data can be spread over multiple chunks, so clamp size
-       * to within this chunk, and then it will read further in
+  z_stream stream = {NULL};
+  if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+    return false;
+  }
+  stream.next_in = (Bytef *)gf->member_data;
+  stream.avail_in = (uInt)(member_data_len - BLEND_GZIP_FRAME_TRAILER_SIZE);
+  stream.next_out = (Bytef *)gf->frame_data;
+  stream.avail_out = frame->data_len;
+  const int ret = inflate(&stream, Z_FINISH);
+  const size_t inflated_len = stream.total_out;
+  inflateEnd(&stream);
+
+  const uchar *trailer = (const uchar *)gf->member_data + member_data_len -
+                         BLEND_GZIP_FRAME_TRAILER_SIZE;
+  if (ret != Z_STREAM_END || inflated_len != frame->data_len ||
+      gzip_frame_load_uint32(&trailer[0]) !=
+          (uint)crc32(0, (const Bytef *)gf->frame_data, frame->data_len) ||
+      gzip_frame_load_uint32(&trailer[4]) != frame->data_len) {
+    printf("%s: zlib error in frame %d\n", __func__, frame_index);
+    return false;
+  }
+
+  gf->frame_loaded = frame_index;
+  return true;
+}
+
+static int fd_read_gzip_frames_from_file(FileData *filedata, void *buffer, uint size)
+{
+  GzipFrames *gf = filedata->gzip_frames;
+  char *dst = buffer;
+  uint readsize = 0;
+
+  while (readsize < size && filedata->file_offset < gf->data_len) {
+    const int frame_index = gzip_frames_find(gf, filedata->file_offset);
+    if (!gzip_frames_load(gf, filedata->filedes, frame_index)) {
+      return EOF;
+    }
+    const GzipFrame *frame = &gf->frames[frame_index];
+    const size_t frame_offset = (size_t)(filedata->file_offset - frame->data_offset);
+    const size_t copy_len = MIN2((size_t)(size - readsize), frame->data_len - frame_offset);
+    memcpy(dst + readsize, gf->frame_data + frame_offset, copy_len);
+    readsize += (uint)copy_len;
+    filedata->file_offset += (off64_t)copy_len;
+  }
+
+  return (int)readsize;
+}
+
+static off64_t fd_seek_gzip_frames_from_file(FileData *filedata, off64_t offset, int whence)
+{
+  const GzipFrames *gf = filedata->gzip_frames;
+  off64_t new_offset;
+  switch (whence) {
+    case SEEK_SET:
+      new_offset = offset;
+      break;
+    case SEEK_CUR:
+      new_offset = filedata->file_offset + offset;
+      break;
+    case SEEK_END:
+      new_offset = gf->data_len + offset;
+      break;
+    default:
+      return -1;
+  }
+
+  /* Frames are only inflated when read from. */
+  if (new_offset < 0 || new_offset > gf->data_len) {
+    return -1;
+  }
+  filedata->file_offset = new_offset;
+  return new_offset;
+}
+
+#ifdef USE_BHEAD_READ_MMAP
+/* Memory mapped file reading. */
+
+static int fd_read_from_mmap(FileData *filedata, void *buffer, uint size)
+{
+  /* Don't read more bytes than there are available in the mapping. */
+  const size_t offset = (size_t)filedata->file_offset;
+  const size_t readsize = (offset < filedata->mmap_size) ?
+                              MIN2((size_t)size, filedata->mmap_size - offset) :
+                              0;
+
+  memcpy(buffer, filedata->buffer + offset, readsize);
+  filedata->file_offset += readsize;
+
+  return (int)readsize;
+}
+
+static off64_t fd_seek_from_mmap(FileData *filedata, off64_t offset, int whence)
+{
+  off64_t new_offset;
+  switch (whence) {
+    case SEEK_SET:
+      new_offset = offset;
+      break;
+    case SEEK_CUR:
+      new_offset = filedata->file_offset + offset;
+      break;
+    case SEEK_END:
+      new_offset = (off64_t)filedata->mmap_size + offset;
+      break;
+    default:
+      return -1;
+  }
+
+  /* Seeking past the end is valid for files, but the data would never be readable here. */
+  if (new_offset < 0 || new_offset > (off64_t)filedata->mmap_size) {
+    return -1;
+  }
+  filedata->file_offset = new_offset;
+  return new_offset;
+}
+
+/**
+ * Map the whole file, returns false when mapping isn't possible,
+ * in that case the file is read through the descriptor instead.
+ */
+static bool fd_mmap_file(FileData *fd, int file)
+{
+  /* Reading a mapping raises SIGBUS when the file is truncated or becomes unavailable (a network
+   * share going away, a removable drive being pulled), while read() just fails, which is
+   * reported. Only map files on local file systems, where files are replaced by renaming instead
+   * of being written in place (see #USE_BHEAD_READ_MMAP). */
+  if (!BLI_file_descriptor_is_local(file)) {
+    return false;
+  }
+
+  const size_t size = BLI_file_descriptor_size(file);
+  if (size == (size_t)-1 || size == 0) {
+    return false;
+  }
+  /* Mapping offsets are 'off64_t', don't try to map what can't be addressed. */
+  if ((uint64_t)size > (uint64_t)SIZE_MAX / 2) {
+    return false;
+  }
+
+  void *mem = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+  if (mem == MAP_FAILED) {
+    return false;
+  }
+
+  fd->buffer = mem;
+  fd->mmap_size = size;
+  fd->flags |= FD_FLAGS_FILE_MMAP;
+  return true;
+}
+#endif /* USE_BHEAD_READ_MMAP */
+
+/* Memory reading. */
+
+static int fd_read_from_memory(FileData *filedata, void *buffer, uint size)
+{
+  /* don't read more bytes then there are available in the buffer */
+  int readsize = (int)MIN2(size, (uint)(filedata->buffersize - filedata->file_offset));
+
+  memcpy(buffer, filedata->buffer + filedata->file_offset, readsize);
+  filedata->file_offset += readsize;
+
+  return (readsize);
+}
+
+/* MemFile reading. */
+
+static int fd_read_from_memfile(FileData *filedata, void *buffer, uint size)
+{
+  static size_t seek = SIZE_MAX; /* the current position */
+  static size_t offset = 0;      /* size of previous chunks */
+  static MemFileChunk *chunk = NULL;
+  size_t chunkoffset, readsize, totread;
+
+  if (size == 0) {
+    return 0;
+  }
+
+  if (seek != (size_t)filedata->file_offset) {
+    chunk = filedata->memfile->chunks.first;
+    seek = 0;
+
+    while (chunk) {
+      if (seek + chunk->size > (size_t)filedata->file_offset) {
+        break;
+      }
+      seek += chunk->size;
+      chunk = chunk->next;
+    }
+    offset = seek;
+    seek = filedata->file_offset;
+  }
+
+  if (chunk) {
+    totread = 0;
+
+    do {
+      /* first check if it's on the end if current chunk */
+      if (seek - offset == chunk->size) {
+        offset += chunk->size;
+        chunk = chunk->next;
+      }
+
+      /* debug, should never happen */
+      if (chunk == NULL) {
+        printf("illegal read, chunk zero\n");
+        return 0;
+      }
+
+      chunkoffset = seek - offset;
+      readsize = size - totread;
+
+      /* data can be spread over multiple chunks, so clamp size
+       * to within this chunk, and then it will read further in
        * the next chunk */
       if (chunkoffset + readsize > chunk->size) {
         readsize = chunk->size - chunkoffset;
@@ -1299,6 +1905,7 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
   FileDataSeekFn *seek_fn = NULL; /* Optional. */
 
   gzFile gzfile = (gzFile)Z_NULL;
+  GzipFrames *gzip_frames = NULL;
 
   char header[7];
 
@@ -1327,20 +1934,28 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
   if ((read_fn == NULL) &&
       /* Check header magic. */
       (header[0] == 0x1f && header[1] == 0x8b)) {
-    gzfile = BLI_gzopen(filepath, "rb");
-    if (gzfile == (gzFile)Z_NULL) {
-      BKE_reportf(reports,
-                  RPT_WARNING,
-                  "Unable to open '%s': %s",
-                  filepath,
-                  errno ? strerror(errno) : TIP_("unknown error reading file"));
-      return NULL;
+    /* Files compressed in frames are read from the descriptor and can seek. */
+    gzip_frames = gzip_frames_from_file_descriptor(file);
+    if (gzip_frames != NULL) {
+      read_fn = fd_read_gzip_frames_from_file;
+      seek_fn = fd_seek_gzip_frames_from_file;
     }
     else {
-      /* 'seek_fn' is too slow for gzip, don't set it. */
-      read_fn = fd_read_gzip_from_file;
-      /* Caller must close. */
-      file = -1;
+      gzfile = BLI_gzopen(filepath, "rb");
+      if (gzfile == (gzFile)Z_NULL) {
+        BKE_reportf(reports,
+                    RPT_WARNING,
+                    "Unable to open '%s': %s",
+                    filepath,
+                    errno ? strerror(errno) : TIP_("unknown error reading file"));
+        return NULL;
+      }
+      else {
+        /* 'seek_fn' is too slow for gzip, don't set it. */
+        read_fn = fd_read_gzip_from_file;
+        /* Caller must close. */
+        file = -1;
+      }
     }
   }
 
@@ -1353,10 +1968,20 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath,
 
   fd->filedes = file;
   fd->gzfiledes = gzfile;
+  fd->gzip_frames = gzip_frames;
 
   fd->read = read_fn;
   fd->seek = seek_fn;
 
+#ifdef USE_BHEAD_READ_MMAP
+  if ((read_fn == fd_read_data_from_file) && fd_mmap_file(fd, file)) {
+    /* The mapping stays valid once the descriptor is closed, keep it open anyway
+     * so the file is handled the same way by the caller. */
+    fd->read = fd_read_from_mmap;
+    fd->seek = fd_seek_from_mmap;
+  }
+#endif
+
   return fd;
 }
 
@@ -1417,20 +2042,27 @@ static int fd_read_gzip_from_memory(FileData *filedata, void *buffer, uint size)
   filedata->strm.next_out = (Bytef *)buffer;
   filedata->strm.avail_out = size;
 
-  // Inflate another chunk.
-  err = inflate(&filedata->strm, Z_SYNC_FLUSH);
+  while (filedata->strm.avail_out != 0) {
+    // Inflate another chunk.
+    err = inflate(&filedata->strm, Z_SYNC_FLUSH);
 
-  if (err == Z_STREAM_END) {
-    return 0;
-  }
-  else if (err != Z_OK) {
-    printf("fd_read_gzip_from_memory: zlib error\n");
-    return 0;
+    if (err == Z_STREAM_END) {
+      /* Files compressed on multiple threads consist of several gzip members. */
+      if (filedata->strm.avail_in == 0) {
+        break;
+      }
+      inflateReset(&filedata->strm);
+    }
+    else if (err != Z_OK) {
+      printf("fd_read_gzip_from_memory: zlib error\n");
+      return 0;
+    }
   }
 
-  filedata->file_offset += size;
+  const uint readsize = size - filedata->strm.avail_out;
+  filedata->file_offset += readsize;
 
-  return (size);
+  return readsize;
 }
 
 static int fd_read_gzip_from_memory_init(FileData *fd)
@@ -1509,12 +2141,25 @@ void blo_filedata_free(FileData *fd)
       gzclose(fd->gzfiledes);
     }
 
+    if (fd->gzip_frames != NULL) {
+      gzip_frames_free(fd->gzip_frames);
+    }
+
     if (fd->strm.next_in) {
       if (inflateEnd(&fd->strm) != Z_OK) {
         printf("close gzip stream error\n");
       }
     }
 
+#ifdef USE_BHEAD_READ_MMAP
+    if (fd->flags & FD_FLAGS_FILE_MMAP) {
+      if (munmap((void *)fd->buffer, fd->mmap_size) != 0) {
+        printf("%s: couldn't unmap file %s\n", __func__, fd->relabase);
+      }
+      fd->buffer = NULL;
+    }
+#endif
+
     if (fd->buffer && !(fd->flags & FD_FLAGS_NOT_MY_BUFFER)) {
       MEM_freeN((void *)fd->buffer);
       fd->buffer = NULL;
@@ -1536,6 +2181,12 @@ void blo_filedata_free(FileData *fd)
     if (fd->filesdna) {
       DNA_sdna_free(fd->filesdna);
     }
+    if (fd->reconstruct_info) {
+      DNA_reconstruct_info_free(fd->reconstruct_info);
+    }
+    if (fd->file_index) {
+      MEM_freeN(fd->file_index);
+    }
     if (fd->compflags) {
       MEM_freeN((void *)fd->compflags);
     }
@@ -1568,6 +2219,18 @@ void blo_filedata_free(FileData *fd)
       MEM_freeN(fd->bheadmap);
     }
 
+#ifdef USE_PARALLEL_DIRECT_LINK
+    if (fd->direct_link_queue) {
+      direct_link_queue_free(fd->direct_link_queue);
+    }
+#endif
+
+#ifdef USE_UNDO_REUSE_UNCHANGED_ID
+    if (fd->undo_reuse) {
+      undo_reuse_free(fd->undo_reuse);
+    }
+#endif
+
 #ifdef USE_GHASH_BHEAD
     if (fd->bhead_idname_hash) {
       BLI_ghash_free(fd->bhead_idname_hash, NULL, NULL);
@@ -1680,10 +2343,24 @@ BlendThumbnail *BLO_thumbnail_from_file(const char *filepath)
 {
   FileData *fd;
   BlendThumbnail *data = NULL;
-  int *fd_data;
+  BHeadN *thumb_bhead = NULL;
+  int *fd_data = NULL;
 
   fd = blo_filedata_from_file_minimal(filepath);
-  fd_data = fd ? read_file_thumbnail(fd) : NULL;
+
+  if (fd && read_file_index(fd)) {
+    /* The index locates the thumbnail, files without one have none. */
+    const int64_t thumb_offset = fd->file_index->thumb_offset;
+    if (thumb_offset != 0) {
+      thumb_bhead = get_bhead_at_offset(fd, (off64_t)thumb_offset);
+      if (thumb_bhead && thumb_bhead->bhead.code == TEST) {
+        fd_data = read_file_thumbnail_block(fd, &thumb_bhead->bhead);
+      }
+    }
+  }
+  else if (fd) {
+    fd_data = read_file_thumbnail(fd);
+  }
 
   if (fd_data) {
     const int width = fd_data[0];
@@ -1701,11 +2378,59 @@ BlendThumbnail *BLO_thumbnail_from_file(const char *filepath)
     }
   }
 
+  MEM_SAFE_FREE(thumb_bhead);
   blo_filedata_free(fd);
 
   return data;
 }
 
+/**
+ * Read the index of a .blend file, without reading its blocks.
+ *
+ * \param filepath: The path of the file to read the index from.
+ * \return The index, or NULL when the file has none (written by older versions or compressed),
+ * free with #BLO_blendfile_index_free.
+ */
+BlendFileIndex *BLO_blendfile_index_from_file(const char *filepath)
+{
+  FileData *fd = blo_filedata_from_file_minimal(filepath);
+  BlendFileIndex *index = NULL;
+
+  if (fd && read_file_index(fd)) {
+    const BlendFileIndexHeader *file_index = fd->file_index;
+    const BlendFileIndexEntry *entries = blo_file_index_entries(file_index);
+
+    index = MEM_callocN(sizeof(*index), __func__);
+    index->items_len = file_index->entries_len;
+    index->has_thumbnail = file_index->thumb_offset != 0;
+
+    /* Copy the strings along, items point into them. */
+    const char *strings = (const char *)(entries + file_index->entries_len);
+    const size_t items_size = sizeof(*index->items) * (size_t)index->items_len;
+    index->items = MEM_mallocN(items_size + (size_t)file_index->strings_len + 1, __func__);
+    char *items_strings = (char *)(index->items + index->items_len);
+    memcpy(items_strings, strings, (size_t)file_index->strings_len + 1);
+
+    for (int i = 0; i < index->items_len; i++) {
+      BlendFileIndexItem *item = &index->items[i];
+      item->code = entries[i].code;
+      item->library = entries[i].library;
+      STRNCPY(item->name, entries[i].name);
+      item->filepath = (entries[i].filepath != -1) ? items_strings + entries[i].filepath : NULL;
+    }
+  }
+
+  blo_filedata_free(fd);
+
+  return index;
+}
+
+void BLO_blendfile_index_free(BlendFileIndex *index)
+{
+  MEM_freeN(index->items);
+  MEM_freeN(index);
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -2084,6 +2809,78 @@ void blo_end_sound_pointer_map(FileData *fd, Main *oldmain)
   }
 }
 
+#ifdef USE_UNDO_REUSE_UNCHANGED_ID
+
+typedef struct UndoReuse {
+  Main *oldmain;
+  /** The old main written as undo step, its unchanged chunks are shared with #FileData.memfile. */
+  MemFile memfile_current;
+  /** #MemFileIDRange of the local data-blocks of #memfile_current, by ID name. */
+  GHash *id_ranges;
+  struct MemFileChunkIndex *chunk_index_current;
+  struct MemFileChunkIndex *chunk_index;
+  /** Number of data-blocks kept from the old main. */
+  int reused_len;
+} UndoReuse;
+
+static void undo_reuse_free(UndoReuse *undo_reuse)
+{
+  if (undo_reuse->chunk_index_current) {
+    memfile_chunk_index_free(undo_reuse->chunk_index_current);
+  }
+  if (undo_reuse->chunk_index) {
+    memfile_chunk_index_free(undo_reuse->chunk_index);
+  }
+  BLO_memfile_free(&undo_reuse->memfile_current);
+  BLI_ghash_free(undo_reuse->id_ranges, NULL, MEM_freeN);
+  MEM_freeN(undo_reuse);
+}
+
+#endif /* USE_UNDO_REUSE_UNCHANGED_ID */
+
+/* Needs to be called before the old main is split or modified in any way,
+ * since it's written to find the data-blocks which are unchanged. */
+void blo_make_undo_reuse_map(FileData *fd, Main *oldmain)
+{
+#ifdef USE_UNDO_REUSE_UNCHANGED_ID
+  BLI_assert(fd->memfile != NULL && oldmain->next == NULL);
+
+  UndoReuse *undo_reuse = MEM_callocN(sizeof(*undo_reuse), __func__);
+  undo_reuse->oldmain = oldmain;
+  undo_reuse->id_ranges = BLI_ghash_str_new(__func__);
+
+  /* Comparing against the step being read shares all chunks which didn't change. */
+  if (!BLO_write_file_mem_ex(
+          oldmain, fd->memfile, &undo_reuse->memfile_current, G.fileflags, undo_reuse->id_ranges)) {
+    undo_reuse_free(undo_reuse);
+    return;
+  }
+
+  undo_reuse->chunk_index_current = memfile_chunk_index_new(&undo_reuse->memfile_current);
+  undo_reuse->chunk_index = memfile_chunk_index_new(fd->memfile);
+  fd->undo_reuse = undo_reuse;
+#else
+  UNUSED_VARS(fd, oldmain);
+#endif
+}
+
+/* Data-blocks which were kept are not in the old main anymore, they won't be freed with it. */
+void blo_end_undo_reuse_map(FileData *fd)
+{
+#ifdef USE_UNDO_REUSE_UNCHANGED_ID
+  if (fd->undo_reuse == NULL) {
+    return;
+  }
+  if (G.debug & G_DEBUG_IO) {
+    printf("Undo: kept %d unchanged data-blocks\n", fd->undo_reuse->reused_len);
+  }
+  undo_reuse_free(fd->undo_reuse);
+  fd->undo_reuse = NULL;
+#else
+  UNUSED_VARS(fd);
+#endif
+}
+
 /* XXX disabled this feature - packed files also belong in temp saves and quit.blend,
  * to make restore work. */
 
@@ -2242,17 +3039,27 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 
     if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
       if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
+        const void *data = (bh + 1);
 #ifdef USE_BHEAD_READ_ON_DEMAND
         if (BHEADN_FROM_BHEAD(bh)->has_data == false) {
-          bh = blo_bhead_read_full(fd, bh);
-          if (UNLIKELY(bh == NULL)) {
-            fd->flags &= ~FD_FLAGS_FILE_OK;
-            return NULL;
+#  ifdef USE_BHEAD_READ_MMAP
+          if (fd->flags & FD_FLAGS_FILE_MMAP) {
+            /* Reconstruct straight from the mapping, there is no need for a copy. */
+            data = blo_bhead_data_mapped(fd, bh);
+          }
+          else
+#  endif
+          {
+            bh = blo_bhead_read_full(fd, bh);
+            if (UNLIKELY(bh == NULL)) {
+              fd->flags &= ~FD_FLAGS_FILE_OK;
+              return NULL;
+            }
+            data = (bh + 1);
           }
         }
 #endif
-        temp = DNA_struct_reconstruct(
-            fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, (bh + 1));
+        temp = DNA_struct_reconstruct(fd->reconstruct_info, bh->SDNAnr, bh->nr, data);
       }
       else {
         /* SDNA_CMP_EQUAL */
@@ -3578,6 +4385,9 @@ static void direct_link_nodetree(FileData *fd, bNodeTree *ntree)
   for (node = ntree->nodes.first; node; node = node->next) {
     node->parent = newdataadr(fd, node->parent);
     node->lasty = 0;
+    node->profile_pixels = 0;
+    node->profile_memory = 0;
+    node->profile_time = 0.0f;
 
     for (sock = node->inputs.first; sock; sock = sock->next) {
       direct_link_node_socket(fd, sock);
@@ -4251,6 +5061,9 @@ static void direct_link_image(FileData *fd, Image *ima)
     ima->last_render_slot = ima->render_slot;
   }
 
+  /* Pixels may differ from when the file was saved, or may have changed since the undo step. */
+  ima->update_count = BKE_image_update_count_next();
+
   link_list(fd, &(ima->views));
   link_list(fd, &(ima->packedfiles));
 
@@ -9017,127 +9830,25 @@ static BHead *read_data_into_oldnewmap(FileData *fd, BHead *bhead, const char *a
   return bhead;
 }
 
-static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const int tag, ID **r_id)
+/**
+ * Read the data blocks following the ID block \a *r_bhead and restore the pointers of the ID,
+ * \a *r_bhead is set to the first block after the data.
+ *
+ * \return false when the ID is invalid and needs to be freed.
+ */
+static bool read_libblock_direct_link(
+    FileData *fd, Main *main, ID *id, const int tag, BHead **r_bhead)
 {
-  /* this routine reads a libblock and its direct data. Use link functions to connect it all
-   */
-  ID *id;
-  ListBase *lb;
-  const char *allocname;
   bool wrong_id = false;
 
-  /* In undo case, most libs and linked data should be kept as is from previous state
-   * (see BLO_read_from_memfile).
-   * However, some needed by the snapshot being read may have been removed in previous one,
-   * and would go missing.
-   * This leads e.g. to disappearing objects in some undo/redo case, see T34446.
-   * That means we have to carefully check whether current lib or
-   * libdata already exits in old main, if it does we merely copy it over into new main area,
-   * otherwise we have to do a full read of that bhead... */
-  if (fd->memfile && ELEM(bhead->code, ID_LI, ID_LINK_PLACEHOLDER)) {
-    const char *idname = blo_bhead_id_name(fd, bhead);
+  /* need a name for the mallocN, just for debugging and sane prints on leaks */
+  const char *allocname = dataname(GS(id->name));
 
-    DEBUG_PRINTF("Checking %s...\n", idname);
+  /* read all data into fd->datamap */
+  *r_bhead = read_data_into_oldnewmap(fd, *r_bhead, allocname);
 
-    if (bhead->code == ID_LI) {
-      Main *libmain = fd->old_mainlist->first;
-      /* Skip oldmain itself... */
-      for (libmain = libmain->next; libmain; libmain = libmain->next) {
-        DEBUG_PRINTF("... against %s: ", libmain->curlib ? libmain->curlib->id.name : "<NULL>");
-        if (libmain->curlib && STREQ(idname, libmain->curlib->id.name)) {
-          Main *oldmain = fd->old_mainlist->first;
-          DEBUG_PRINTF("FOUND!\n");
-          /* In case of a library, we need to re-add its main to fd->mainlist,
-           * because if we have later a missing ID_LINK_PLACEHOLDER,
-           * we need to get the correct lib it is linked to!
-           * Order is crucial, we cannot bulk-add it in BLO_read_from_memfile()
-           * like it used to be. */
-          BLI_remlink(fd->old_mainlist, libmain);
-          BLI_remlink_safe(&oldmain->libraries, libmain->curlib);
-          BLI_addtail(fd->mainlist, libmain);
-          BLI_addtail(&main->libraries, libmain->curlib);
-
-          if (r_id) {
-            *r_id = NULL; /* Just in case... */
-          }
-          return blo_bhead_next(fd, bhead);
-        }
-        DEBUG_PRINTF("nothing...\n");
-      }
-    }
-    else {
-      DEBUG_PRINTF("... in %s (%s): ",
-                   main->curlib ? main->curlib->id.name : "<NULL>",
-                   main->curlib ? main->curlib->name : "<NULL>");
-      if ((id = BKE_libblock_find_name(main, GS(idname), idname + 2))) {
-        DEBUG_PRINTF("FOUND!\n");
-        /* Even though we found our linked ID,
-         * there is no guarantee its address is still the same. */
-        if (id != bhead->old) {
-          oldnewmap_insert(fd->libmap, bhead->old, id, GS(id->name));
-        }
-
-        /* No need to do anything else for ID_LINK_PLACEHOLDER,
-         * it's assumed already present in its lib's main. */
-        if (r_id) {
-          *r_id = NULL; /* Just in case... */
-        }
-        return blo_bhead_next(fd, bhead);
-      }
-      DEBUG_PRINTF("nothing...\n");
-    }
-  }
-
-  /* read libblock */
-  id = read_struct(fd, bhead, "lib block");
-
-  if (id) {
-    const short idcode = GS(id->name);
-    /* do after read_struct, for dna reconstruct */
-    lb = which_libbase(main, idcode);
-    if (lb) {
-      oldnewmap_insert(
-          fd->libmap, bhead->old, id, bhead->code); /* for ID_LINK_PLACEHOLDER check */
-      BLI_addtail(lb, id);
-    }
-    else {
-      /* unknown ID type */
-      printf("%s: unknown id code '%c%c'\n", __func__, (idcode & 0xff), (idcode >> 8));
-      MEM_freeN(id);
-      id = NULL;
-    }
-  }
-
-  if (r_id) {
-    *r_id = id;
-  }
-  if (!id) {
-    return blo_bhead_next(fd, bhead);
-  }
-
-  id->lib = main->curlib;
-  id->us = ID_FAKE_USERS(id);
-  id->icon_id = 0;
-  id->newid = NULL; /* Needed because .blend may have been saved with crap value here... */
-  id->orig_id = NULL;
-  id->recalc = 0;
-
-  /* this case cannot be direct_linked: it's just the ID part */
-  if (bhead->code == ID_LINK_PLACEHOLDER) {
-    /* That way, we know which datablock needs do_versions (required currently for linking). */
-    id->tag = tag | LIB_TAG_NEED_LINK | LIB_TAG_NEW;
-
-    return blo_bhead_next(fd, bhead);
-  }
-
-  /* need a name for the mallocN, just for debugging and sane prints on leaks */
-  allocname = dataname(GS(id->name));
-
-  /* read all data into fd->datamap */
-  bhead = read_data_into_oldnewmap(fd, bhead, allocname);
-
-  /* init pointers direct data */
-  direct_link_id(fd, id);
+  /* init pointers direct data */
+  direct_link_id(fd, id);
 
   /* That way, we know which datablock needs do_versions (required currently for linking). */
   /* Note: doing this after driect_link_id(), which resets that field. */
@@ -9257,6 +9968,384 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const int ta
   oldnewmap_free_unused(fd->datamap);
   oldnewmap_clear(fd->datamap);
 
+  return !wrong_id;
+}
+
+#ifdef USE_PARALLEL_DIRECT_LINK
+typedef struct DirectLinkDelayed {
+  Main *main;
+  ID *id;
+  /** Block of the ID, its data blocks directly follow it. */
+  BHead *bhead;
+  int tag;
+  /** Set by the worker thread, invalid IDs are freed after all threads are done. */
+  bool is_valid;
+} DirectLinkDelayed;
+
+typedef struct DirectLinkQueue {
+  DirectLinkDelayed *items;
+  int items_len, items_alloc;
+} DirectLinkQueue;
+
+/* Per thread data of #direct_link_queue_flush. */
+typedef struct DirectLinkQueueChunk {
+  struct OldNewMap *datamap;
+  /** #eFileDataFlag cleared while reading (e.g. on read errors). */
+  int flags_cleared;
+} DirectLinkQueueChunk;
+
+/**
+ * Types which direct linking only touches the data of the ID itself:
+ * no main or library lists, no undo maps and no reports.
+ */
+static bool direct_link_can_delay(const short idcode)
+{
+  switch (idcode) {
+    case ID_ME:
+    case ID_CU:
+    case ID_MB:
+    case ID_MA:
+    case ID_TE:
+    case ID_LA:
+    case ID_CA:
+    case ID_WO:
+    case ID_KE:
+    case ID_LT:
+    case ID_LP:
+    case ID_AR:
+    case ID_AC:
+    case ID_PA:
+    case ID_GD:
+    case ID_CF:
+    case ID_PAL:
+    case ID_PC:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static DirectLinkQueue *direct_link_queue_new(void)
+{
+  DirectLinkQueue *queue = MEM_callocN(sizeof(*queue), __func__);
+  queue->items_alloc = 1024;
+  queue->items = MEM_mallocN(sizeof(*queue->items) * queue->items_alloc, __func__);
+  return queue;
+}
+
+static void direct_link_queue_free(DirectLinkQueue *queue)
+{
+  MEM_freeN(queue->items);
+  MEM_freeN(queue);
+}
+
+static void direct_link_queue_add(
+    DirectLinkQueue *queue, Main *main, ID *id, BHead *bhead, const int tag)
+{
+  if (queue->items_len == queue->items_alloc) {
+    queue->items_alloc *= 2;
+    queue->items = MEM_reallocN(queue->items, sizeof(*queue->items) * queue->items_alloc);
+  }
+  DirectLinkDelayed *item = &queue->items[queue->items_len++];
+  item->main = main;
+  item->id = id;
+  item->bhead = bhead;
+  item->tag = tag;
+  item->is_valid = false;
+}
+
+static void direct_link_queue_task(void *__restrict userdata,
+                                   const int index,
+                                   const ParallelRangeTLS *__restrict tls)
+{
+  FileData *fd = userdata;
+  DirectLinkQueueChunk *chunk = tls->userdata_chunk;
+  DirectLinkDelayed *item = &fd->direct_link_queue->items[index];
+
+  if (chunk->datamap == NULL) {
+    chunk->datamap = oldnewmap_new();
+  }
+
+  /* All blocks are known at this point, so apart from the data map
+   * the file data is only read from here. */
+  FileData fd_local = *fd;
+  fd_local.datamap = chunk->datamap;
+
+  BHead *bhead = item->bhead;
+  item->is_valid = read_libblock_direct_link(&fd_local, item->main, item->id, item->tag, &bhead);
+
+  chunk->flags_cleared |= (fd->flags & ~fd_local.flags);
+}
+
+static void direct_link_queue_task_finalize(void *__restrict userdata,
+                                            void *__restrict userdata_chunk)
+{
+  FileData *fd = userdata;
+  DirectLinkQueueChunk *chunk = userdata_chunk;
+
+  if (chunk->datamap != NULL) {
+    oldnewmap_free(chunk->datamap);
+  }
+  fd->flags &= ~chunk->flags_cleared;
+}
+
+/* Direct link all data-blocks delayed by #read_libblock. */
+static void direct_link_queue_flush(FileData *fd)
+{
+  DirectLinkQueue *queue = fd->direct_link_queue;
+  if (queue->items_len == 0) {
+    return;
+  }
+
+  DirectLinkQueueChunk chunk = {NULL};
+
+  ParallelRangeSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  /* Cost of data-blocks varies a lot, from a palette to a mesh with millions of vertices. */
+  settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+  settings.min_iter_per_thread = 4;
+  settings.userdata_chunk = &chunk;
+  settings.userdata_chunk_size = sizeof(chunk);
+  settings.func_finalize = direct_link_queue_task_finalize;
+  BLI_task_parallel_range(0, queue->items_len, fd, direct_link_queue_task, &settings);
+
+  /* Free invalid IDs as #read_libblock does, freeing touches the main lists. */
+  for (int i = 0; i < queue->items_len; i++) {
+    DirectLinkDelayed *item = &queue->items[i];
+    if (item->is_valid) {
+      continue;
+    }
+    blo_reportf_wrap(fd->reports,
+                     RPT_WARNING,
+                     TIP_("Data-block '%s' has invalid data and was not loaded"),
+                     item->id->name + 2);
+    /* Pointers to it are resolved by lib_link later on, they become NULL. */
+    OldNew *entry = oldnewmap_lookup_entry(fd->libmap, item->bhead->old);
+    if (entry != NULL && entry->newp == item->id) {
+      entry->newp = NULL;
+    }
+    BKE_id_free(item->main, item->id);
+  }
+
+  queue->items_len = 0;
+}
+#endif /* USE_PARALLEL_DIRECT_LINK */
+
+#ifdef USE_UNDO_REUSE_UNCHANGED_ID
+
+/**
+ * Types which only point to their own data and to other data-blocks.
+ * Pointers to other data-blocks are remapped by lib_link, as for a data-block read from the file.
+ */
+static bool undo_reuse_can_keep(const short idcode)
+{
+  return ELEM(idcode, ID_ME, ID_CU, ID_MB, ID_LT, ID_KE, ID_AC, ID_GD);
+}
+
+/**
+ * Move the data-block of the old main over to \a main when it's identical to the one of the
+ * step being read.
+ *
+ * \return The kept data-block, or NULL when it needs to be read.
+ */
+static ID *read_libblock_undo_reuse(
+    FileData *fd, Main *main, BHead *bhead, const int tag, BHead **r_bhead_next)
+{
+  UndoReuse *undo_reuse = fd->undo_reuse;
+
+  if (!undo_reuse_can_keep((short)bhead->code)) {
+    return NULL;
+  }
+  const MemFileIDRange *range = BLI_ghash_lookup(undo_reuse->id_ranges,
+                                                 blo_bhead_id_name(fd, bhead));
+  if (range == NULL) {
+    return NULL;
+  }
+
+  /* The data-block in the step, its ID block followed by all its data blocks. */
+  BHead *bhead_last = bhead;
+  BHead *bhead_next = blo_bhead_next(fd, bhead);
+  while (bhead_next && bhead_next->code == DATA) {
+    bhead_last = bhead_next;
+    bhead_next = blo_bhead_next(fd, bhead_next);
+  }
+  const size_t bhead_size = (fd->flags & FD_FLAGS_FILE_POINTSIZE_IS_4) ? sizeof(BHead4) :
+                                                                          sizeof(BHead8);
+  const size_t offset = (size_t)BHEADN_FROM_BHEAD(bhead)->file_offset - bhead_size;
+  const size_t size = (size_t)BHEADN_FROM_BHEAD(bhead_last)->file_offset +
+                      (size_t)bhead_last->len - offset;
+
+  if ((size != range->size) || !memfile_chunk_index_range_equals(undo_reuse->chunk_index,
+                                                                 offset,
+                                                                 undo_reuse->chunk_index_current,
+                                                                 range->offset,
+                                                                 size)) {
+    return NULL;
+  }
+
+  /* Identical bytes, including the address of the data-block and all pointers it holds. */
+  ID *id = range->id;
+  const short idcode = GS(id->name);
+  BLI_assert(id == bhead->old);
+
+  BLI_remlink(which_libbase(undo_reuse->oldmain, idcode), id);
+  BLI_addtail(which_libbase(main, idcode), id);
+  oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);
+
+  id->lib = main->curlib;
+  id->us = ID_FAKE_USERS(id);
+  id->newid = NULL;
+  id->orig_id = NULL;
+  id->recalc = 0;
+  id->tag = tag | LIB_TAG_NEED_LINK | LIB_TAG_NEW;
+
+  undo_reuse->reused_len++;
+
+  *r_bhead_next = bhead_next;
+  return id;
+}
+
+#endif /* USE_UNDO_REUSE_UNCHANGED_ID */
+
+static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const int tag, ID **r_id)
+{
+  /* this routine reads a libblock and its direct data. Use link functions to connect it all
+   */
+  ID *id;
+  ListBase *lb;
+  bool wrong_id = false;
+
+  /* In undo case, most libs and linked data should be kept as is from previous state
+   * (see BLO_read_from_memfile).
+   * However, some needed by the snapshot being read may have been removed in previous one,
+   * and would go missing.
+   * This leads e.g. to disappearing objects in some undo/redo case, see T34446.
+   * That means we have to carefully check whether current lib or
+   * libdata already exits in old main, if it does we merely copy it over into new main area,
+   * otherwise we have to do a full read of that bhead... */
+  if (fd->memfile && ELEM(bhead->code, ID_LI, ID_LINK_PLACEHOLDER)) {
+    const char *idname = blo_bhead_id_name(fd, bhead);
+
+    DEBUG_PRINTF("Checking %s...\n", idname);
+
+    if (bhead->code == ID_LI) {
+      Main *libmain = fd->old_mainlist->first;
+      /* Skip oldmain itself... */
+      for (libmain = libmain->next; libmain; libmain = libmain->next) {
+        DEBUG_PRINTF("... against %s: ", libmain->curlib ? libmain->curlib->id.name : "<NULL>");
+        if (libmain->curlib && STREQ(idname, libmain->curlib->id.name)) {
+          Main *oldmain = fd->old_mainlist->first;
+          DEBUG_PRINTF("FOUND!\n");
+          /* In case of a library, we need to re-add its main to fd->mainlist,
+           * because if we have later a missing ID_LINK_PLACEHOLDER,
+           * we need to get the correct lib it is linked to!
+           * Order is crucial, we cannot bulk-add it in BLO_read_from_memfile()
+           * like it used to be. */
+          BLI_remlink(fd->old_mainlist, libmain);
+          BLI_remlink_safe(&oldmain->libraries, libmain->curlib);
+          BLI_addtail(fd->mainlist, libmain);
+          BLI_addtail(&main->libraries, libmain->curlib);
+
+          if (r_id) {
+            *r_id = NULL; /* Just in case... */
+          }
+          return blo_bhead_next(fd, bhead);
+        }
+        DEBUG_PRINTF("nothing...\n");
+      }
+    }
+    else {
+      DEBUG_PRINTF("... in %s (%s): ",
+                   main->curlib ? main->curlib->id.name : "<NULL>",
+                   main->curlib ? main->curlib->name : "<NULL>");
+      if ((id = BKE_libblock_find_name(main, GS(idname), idname + 2))) {
+        DEBUG_PRINTF("FOUND!\n");
+        /* Even though we found our linked ID,
+         * there is no guarantee its address is still the same. */
+        if (id != bhead->old) {
+          oldnewmap_insert(fd->libmap, bhead->old, id, GS(id->name));
+        }
+
+        /* No need to do anything else for ID_LINK_PLACEHOLDER,
+         * it's assumed already present in its lib's main. */
+        if (r_id) {
+          *r_id = NULL; /* Just in case... */
+        }
+        return blo_bhead_next(fd, bhead);
+      }
+      DEBUG_PRINTF("nothing...\n");
+    }
+  }
+
+#ifdef USE_UNDO_REUSE_UNCHANGED_ID
+  if (fd->undo_reuse && main->curlib == NULL) {
+    BHead *bhead_next;
+    if ((id = read_libblock_undo_reuse(fd, main, bhead, tag, &bhead_next))) {
+      if (r_id) {
+        *r_id = id;
+      }
+      return bhead_next;
+    }
+  }
+#endif
+
+  /* read libblock */
+  id = read_struct(fd, bhead, "lib block");
+
+  if (id) {
+    const short idcode = GS(id->name);
+    /* do after read_struct, for dna reconstruct */
+    lb = which_libbase(main, idcode);
+    if (lb) {
+      oldnewmap_insert(
+          fd->libmap, bhead->old, id, bhead->code); /* for ID_LINK_PLACEHOLDER check */
+      BLI_addtail(lb, id);
+    }
+    else {
+      /* unknown ID type */
+      printf("%s: unknown id code '%c%c'\n", __func__, (idcode & 0xff), (idcode >> 8));
+      MEM_freeN(id);
+      id = NULL;
+    }
+  }
+
+  if (r_id) {
+    *r_id = id;
+  }
+  if (!id) {
+    return blo_bhead_next(fd, bhead);
+  }
+
+  id->lib = main->curlib;
+  id->us = ID_FAKE_USERS(id);
+  id->icon_id = 0;
+  id->newid = NULL; /* Needed because .blend may have been saved with crap value here... */
+  id->orig_id = NULL;
+  id->recalc = 0;
+
+  /* this case cannot be direct_linked: it's just the ID part */
+  if (bhead->code == ID_LINK_PLACEHOLDER) {
+    /* That way, we know which datablock needs do_versions (required currently for linking). */
+    id->tag = tag | LIB_TAG_NEED_LINK | LIB_TAG_NEW;
+
+    return blo_bhead_next(fd, bhead);
+  }
+
+#ifdef USE_PARALLEL_DIRECT_LINK
+  if (fd->direct_link_queue && direct_link_can_delay(GS(id->name))) {
+    direct_link_queue_add(fd->direct_link_queue, main, id, bhead, tag);
+
+    /* Data is read by the worker thread, skip over it. */
+    bhead = blo_bhead_next(fd, bhead);
+    while (bhead && bhead->code == DATA) {
+      bhead = blo_bhead_next(fd, bhead);
+    }
+    return bhead;
+  }
+#endif
+
+  wrong_id = !read_libblock_direct_link(fd, main, id, tag, &bhead);
+
   if (wrong_id) {
     BKE_id_free(main, id);
   }
@@ -9651,6 +10740,14 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
     }
   }
 
+#ifdef USE_PARALLEL_DIRECT_LINK
+  /* Delayed data can only be read from worker threads when it's in memory or mapped,
+   * undo restores data from the previous state while reading so it's kept serial. */
+  if ((fd->memfile == NULL) && ((fd->seek == NULL) || (fd->flags & FD_FLAGS_FILE_MMAP))) {
+    fd->direct_link_queue = direct_link_queue_new();
+  }
+#endif
+
   while (bhead) {
     switch (bhead->code) {
       case DATA:
@@ -9703,6 +10800,14 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
     }
   }
 
+#ifdef USE_PARALLEL_DIRECT_LINK
+  if (fd->direct_link_queue) {
+    direct_link_queue_flush(fd);
+    direct_link_queue_free(fd->direct_link_queue);
+    fd->direct_link_queue = NULL;
+  }
+#endif
+
   /* do before read_libraries, but skip undo case */
   if (fd->memfile == NULL) {
     if ((fd->skip_flags & BLO_READ_SKIP_DATA) == 0) {
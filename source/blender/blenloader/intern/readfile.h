@@ -46,6 +46,8 @@ enum eFileDataFlag {
   FD_FLAGS_NOT_MY_BUFFER = 1 << 4,
   /* XXX Unused in practice (checked once but never set). */
   FD_FLAGS_NOT_MY_LIBMAP = 1 << 5,
+  /** #FileData.buffer is a read-only mapping of the file (see #USE_BHEAD_READ_MMAP). */
+  FD_FLAGS_FILE_MMAP = 1 << 6,
 };
 
 /* Disallow since it's 32bit on ms-windows. */
@@ -57,6 +59,62 @@ enum eFileDataFlag {
 typedef int64_t off64_t;
 #endif
 
+/**
+ * File index, written by #write_file_index as a #DATA block right after #DNA1,
+ * and located by a #BlendFileIndexTrailer after #ENDB.
+ *
+ * Lists the data-block and library blocks of the file, so tools which only need names,
+ * library dependencies or the DNA don't have to walk over all the blocks of the file.
+ * Integers are in the endianness of the file, block codes are stored as they are in #BHead.
+ * Files without index (older ones, compressed ones or undo memfiles) are read block by block.
+ */
+#define BLEND_FILE_INDEX_MAGIC "BLENDIDX"
+#define BLEND_FILE_INDEX_VERSION 1
+
+typedef struct BlendFileIndexTrailer {
+  /** Offset of the #BHead of the index block. */
+  uint64_t index_offset;
+  char magic[8];
+} BlendFileIndexTrailer;
+
+typedef struct BlendFileIndexHeader {
+  int version;
+  int entries_len;
+  /** Size of the library file paths, stored after the entries. */
+  int strings_len;
+  int _pad;
+  /** Offsets of the #GLOB, #DNA1 and #TEST block headers, zero when not written. */
+  int64_t glob_offset;
+  int64_t dna_offset;
+  int64_t thumb_offset;
+} BlendFileIndexHeader;
+
+typedef struct BlendFileIndexEntry {
+  /** #BHead.code of the block (ID code, #ID_LI or #ID_LINK_PLACEHOLDER). */
+  int code;
+  /** Entry of the library of linked data-blocks, -1 for local ones. */
+  int library;
+  /** Offset of the #BHead of the block. */
+  int64_t offset;
+  /** Offset of the file path of libraries in the strings, -1 for other blocks. */
+  int filepath;
+  char name[66]; /* MAX_ID_NAME */
+  char _pad[2];
+} BlendFileIndexEntry;
+
+/**
+ * Compressed files written on worker threads (see #ww_open_zlib_parallel) are a sequence of
+ * independently compressed gzip members, the frames. The header of every member has an extra
+ * field #BLEND_GZIP_FRAME_EXTRA_ID storing the size of the whole member and of its uncompressed
+ * data as little endian uint32, so readers can locate any frame without inflating the ones
+ * before it.
+ */
+#define BLEND_GZIP_FRAME_EXTRA_ID "BL"
+/* Fixed header (10), extra field length (2), sub-field header (4) and data (8). */
+#define BLEND_GZIP_FRAME_HEADER_SIZE 24
+/* CRC32 and uncompressed size. */
+#define BLEND_GZIP_FRAME_TRAILER_SIZE 8
+
 typedef int(FileDataReadFn)(struct FileData *filedata, void *buffer, unsigned int size);
 typedef off64_t(FileDataSeekFn)(struct FileData *filedata, off64_t offset, int whence);
 
@@ -76,6 +134,8 @@ typedef struct FileData {
 
   /** Variables needed for reading from memory / stream. */
   const char *buffer;
+  /** Size of the mapped #buffer, #buffersize can't hold the size of large files. */
+  size_t mmap_size;
   /** Variables needed for reading from memfile (undo). */
   struct MemFile *memfile;
 
@@ -83,6 +143,8 @@ typedef struct FileData {
   gzFile gzfiledes;
   /** Gzip stream for memory decompression. */
   z_stream strm;
+  /** Frames of compressed files which can seek, see #BLEND_GZIP_FRAME_EXTRA_ID. */
+  struct GzipFrames *gzip_frames;
 
   /** Now only in use for library appending. */
   char relabase[FILE_MAX];
@@ -92,6 +154,10 @@ typedef struct FileData {
   const struct SDNA *memsdna;
   /** Array of #eSDNA_StructCompare. */
   const char *compflags;
+  /** Conversion of the structs which are #SDNA_CMP_NOT_EQUAL, see #DNA_struct_reconstruct. */
+  struct DNA_ReconstructInfo *reconstruct_info;
+  /** Index of the file when it has one, followed by its entries and strings. */
+  BlendFileIndexHeader *file_index;
 
   int fileversion;
   /** Used to retrieve ID names from (bhead+1). */
@@ -117,6 +183,11 @@ typedef struct FileData {
   /** See: #USE_GHASH_BHEAD. */
   struct GHash *bhead_idname_hash;
 
+  /** Data-blocks waiting to be direct linked, see: #USE_PARALLEL_DIRECT_LINK. */
+  struct DirectLinkQueue *direct_link_queue;
+  /** Data-blocks of the old main which may be kept on undo, see: #USE_UNDO_REUSE_UNCHANGED_ID. */
+  struct UndoReuse *undo_reuse;
+
   ListBase *mainlist;
   /** Used for undo. */
   ListBase *old_mainlist;
@@ -148,6 +219,8 @@ void blo_make_sound_pointer_map(FileData *fd, struct Main *oldmain);
 void blo_end_sound_pointer_map(FileData *fd, struct Main *oldmain);
 void blo_make_packed_pointer_map(FileData *fd, struct Main *oldmain);
 void blo_end_packed_pointer_map(FileData *fd, struct Main *oldmain);
+void blo_make_undo_reuse_map(FileData *fd, struct Main *oldmain);
+void blo_end_undo_reuse_map(FileData *fd);
 void blo_add_library_pointer_map(ListBase *old_mainlist, FileData *fd);
 
 void blo_filedata_free(FileData *fd);
@@ -158,6 +231,10 @@ BHead *blo_bhead_prev(FileData *fd, BHead *thisblock);
 
 const char *blo_bhead_id_name(const FileData *fd, const BHead *bhead);
 
+BlendFileIndexEntry *blo_file_index_entries(const BlendFileIndexHeader *file_index);
+const char *blo_file_index_filepath(const BlendFileIndexHeader *file_index,
+                                    const BlendFileIndexEntry *entry);
+
 /* do versions stuff */
 
 void blo_reportf_wrap(struct ReportList *reports, ReportType type, const char *format, ...)
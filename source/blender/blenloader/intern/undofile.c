@@ -36,11 +36,15 @@
 #  include <io.h>
 #endif
 
+#include "zlib.h"
+
 #include "MEM_guardedalloc.h"
 
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 
 #include "BLO_undofile.h"
 #include "BLO_readfile.h"
@@ -70,50 +74,142 @@ void BLO_memfile_free(MemFile *memfile)
 /* result is that 'first' is being freed */
 void BLO_memfile_merge(MemFile *first, MemFile *second)
 {
-  MemFileChunk *fc, *sc;
+  /* Chunks of 'second' can share memory with any chunk of 'first' (not only the one at the same
+   * position), and several of them can share the same memory. Hand ownership of every buffer
+   * which is still used over to one of the chunks using it. */
+  GHash *owned_buffers = BLI_ghash_ptr_new_ex(__func__, (uint)BLI_listbase_count(&first->chunks));
+
+  LISTBASE_FOREACH (MemFileChunk *, fc, &first->chunks) {
+    if (fc->is_identical == false) {
+      BLI_ghash_insert(owned_buffers, (void *)fc->buf, fc);
+    }
+  }
 
-  fc = first->chunks.first;
-  sc = second->chunks.first;
-  while (fc || sc) {
-    if (fc && sc) {
-      if (sc->is_identical) {
+  LISTBASE_FOREACH (MemFileChunk *, sc, &second->chunks) {
+    if (sc->is_identical) {
+      MemFileChunk *fc = BLI_ghash_popkey(owned_buffers, sc->buf, NULL);
+      if (fc != NULL) {
         sc->is_identical = false;
         fc->is_identical = true;
       }
     }
-    if (fc) {
-      fc = fc->next;
-    }
-    if (sc) {
-      sc = sc->next;
-    }
   }
 
+  BLI_ghash_free(owned_buffers, NULL, NULL);
+
   BLO_memfile_free(first);
 }
 
-void memfile_chunk_add(MemFile *memfile, const char *buf, uint size, MemFileChunk **compchunk_step)
+/**
+ * Copy of \a memfile where all chunks own their memory.
+ *
+ * Chunks of undo steps share memory with the steps before them, the copy stays valid
+ * when those are freed, so it can be used outside of the undo stack (e.g. saved by a job).
+ */
+MemFile *BLO_memfile_copy(const MemFile *memfile)
+{
+  MemFile *memfile_copy = MEM_callocN(sizeof(MemFile), __func__);
+
+  LISTBASE_FOREACH (MemFileChunk *, chunk, &memfile->chunks) {
+    MemFileChunk *chunk_copy = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
+    char *buf_copy = MEM_mallocN(chunk->size, "Chunk buffer");
+    memcpy(buf_copy, chunk->buf, chunk->size);
+    chunk_copy->buf = buf_copy;
+    chunk_copy->size = chunk->size;
+    chunk_copy->hash = chunk->hash;
+    chunk_copy->is_identical = false;
+    BLI_addtail(&memfile_copy->chunks, chunk_copy);
+    memfile_copy->size += chunk->size;
+  }
+
+  return memfile_copy;
+}
+
+static uint memfile_chunk_hash(const char *buf, uint size)
+{
+  return BLI_hash_mm2((const uchar *)buf, size, 0);
+}
+
+static bool memfile_chunk_equals(const MemFileChunk *chunk_a, const MemFileChunk *chunk_b)
+{
+  return (chunk_a->hash == chunk_b->hash) && (chunk_a->size == chunk_b->size) &&
+         (memcmp(chunk_a->buf, chunk_b->buf, chunk_a->size) == 0);
+}
+
+static uint memfile_chunk_set_hash(const void *key)
+{
+  return ((const MemFileChunk *)key)->hash;
+}
+
+static bool memfile_chunk_set_cmp(const void *a, const void *b)
+{
+  /* Note that GHash expects false for equal keys. */
+  return !memfile_chunk_equals(a, b);
+}
+
+/**
+ * Set of all chunks of \a memfile by contents,
+ * to find identical chunks when they are written at another position than before.
+ */
+GSet *memfile_chunk_set_new(MemFile *memfile)
+{
+  GSet *compchunk_set = BLI_gset_new_ex(memfile_chunk_set_hash,
+                                        memfile_chunk_set_cmp,
+                                        __func__,
+                                        (uint)BLI_listbase_count(&memfile->chunks));
+  LISTBASE_FOREACH (MemFileChunk *, chunk, &memfile->chunks) {
+    /* Keep the first of identical chunks. */
+    BLI_gset_add(compchunk_set, chunk);
+  }
+  return compchunk_set;
+}
+
+void memfile_chunk_set_free(GSet *compchunk_set)
+{
+  BLI_gset_free(compchunk_set, NULL);
+}
+
+/**
+ * \param compchunk_step: Chunk of the previous step at the same position, checked first.
+ * \param compchunk_set: Optional, all chunks of the previous step (see #memfile_chunk_set_new),
+ * used when the data moved to another position, e.g. after data-blocks were added or removed.
+ */
+void memfile_chunk_add(MemFile *memfile,
+                       const char *buf,
+                       uint size,
+                       MemFileChunk **compchunk_step,
+                       GSet *compchunk_set)
 {
   MemFileChunk *curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
   curchunk->size = size;
-  curchunk->buf = NULL;
+  curchunk->buf = buf;
+  curchunk->hash = memfile_chunk_hash(buf, size);
   curchunk->is_identical = false;
   BLI_addtail(&memfile->chunks, curchunk);
 
   /* we compare compchunk with buf */
   if (*compchunk_step != NULL) {
     MemFileChunk *compchunk = *compchunk_step;
-    if (compchunk->size == curchunk->size) {
-      if (memcmp(compchunk->buf, buf, size) == 0) {
-        curchunk->buf = compchunk->buf;
-        curchunk->is_identical = true;
-      }
+    if (memfile_chunk_equals(compchunk, curchunk)) {
+      curchunk->buf = compchunk->buf;
+      curchunk->is_identical = true;
     }
     *compchunk_step = compchunk->next;
   }
 
+  /* Not at the same position, the data may have moved. */
+  if ((curchunk->is_identical == false) && (compchunk_set != NULL)) {
+    MemFileChunk *compchunk = BLI_gset_lookup(compchunk_set, curchunk);
+    if (compchunk != NULL) {
+      curchunk->buf = compchunk->buf;
+      curchunk->is_identical = true;
+      /* Following data most likely moved along, continue comparing from there. */
+      *compchunk_step = compchunk->next;
+    }
+  }
+
   /* not equal... */
-  if (curchunk->buf == NULL) {
+  if (curchunk->is_identical == false) {
     char *buf_new = MEM_mallocN(size, "Chunk buffer");
     memcpy(buf_new, buf, size);
     curchunk->buf = buf_new;
@@ -121,6 +217,103 @@ void memfile_chunk_add(MemFile *memfile, const char *buf, uint size, MemFileChun
   }
 }
 
+/** Random access to the contents of a #MemFile. */
+typedef struct MemFileChunkIndex {
+  const MemFileChunk **chunks;
+  /** Offset of every chunk from the start of the file. */
+  size_t *offsets;
+  uint chunks_len;
+  /** Size of the whole file, unlike #MemFile.size this includes shared chunks. */
+  size_t size;
+} MemFileChunkIndex;
+
+MemFileChunkIndex *memfile_chunk_index_new(const MemFile *memfile)
+{
+  MemFileChunkIndex *index = MEM_mallocN(sizeof(*index), __func__);
+  index->chunks_len = (uint)BLI_listbase_count(&memfile->chunks);
+  index->chunks = MEM_malloc_arrayN(MAX2(index->chunks_len, 1u), sizeof(*index->chunks), __func__);
+  index->offsets = MEM_malloc_arrayN(
+      MAX2(index->chunks_len, 1u), sizeof(*index->offsets), __func__);
+
+  size_t offset = 0;
+  uint i = 0;
+  for (const MemFileChunk *chunk = memfile->chunks.first; chunk; chunk = chunk->next, i++) {
+    index->chunks[i] = chunk;
+    index->offsets[i] = offset;
+    offset += chunk->size;
+  }
+  index->size = offset;
+
+  return index;
+}
+
+void memfile_chunk_index_free(MemFileChunkIndex *index)
+{
+  MEM_freeN((void *)index->chunks);
+  MEM_freeN(index->offsets);
+  MEM_freeN(index);
+}
+
+/* Index of the chunk containing the byte at \a offset. */
+static uint memfile_chunk_index_find(const MemFileChunkIndex *index, const size_t offset)
+{
+  uint low = 0, high = index->chunks_len;
+  while (high - low > 1) {
+    const uint mid = low + (high - low) / 2;
+    if (index->offsets[mid] <= offset) {
+      low = mid;
+    }
+    else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+/**
+ * Compare a range of bytes of two files.
+ * Chunks shared between both files are not compared byte per byte.
+ */
+bool memfile_chunk_index_range_equals(const MemFileChunkIndex *index_a,
+                                      size_t offset_a,
+                                      const MemFileChunkIndex *index_b,
+                                      size_t offset_b,
+                                      size_t size)
+{
+  if (offset_a + size > index_a->size || offset_b + size > index_b->size) {
+    return false;
+  }
+
+  uint i_a = memfile_chunk_index_find(index_a, offset_a);
+  uint i_b = memfile_chunk_index_find(index_b, offset_b);
+
+  while (size != 0) {
+    const MemFileChunk *chunk_a = index_a->chunks[i_a];
+    const MemFileChunk *chunk_b = index_b->chunks[i_b];
+    const size_t chunk_offset_a = offset_a - index_a->offsets[i_a];
+    const size_t chunk_offset_b = offset_b - index_b->offsets[i_b];
+    const size_t len = MIN3(
+        size, chunk_a->size - chunk_offset_a, chunk_b->size - chunk_offset_b);
+
+    if (!(chunk_a->buf == chunk_b->buf && chunk_offset_a == chunk_offset_b) &&
+        memcmp(chunk_a->buf + chunk_offset_a, chunk_b->buf + chunk_offset_b, len) != 0) {
+      return false;
+    }
+
+    size -= len;
+    offset_a += len;
+    offset_b += len;
+    if (chunk_offset_a + len == chunk_a->size) {
+      i_a++;
+    }
+    if (chunk_offset_b + len == chunk_b->size) {
+      i_b++;
+    }
+  }
+
+  return true;
+}
+
 struct Main *BLO_memfile_main_get(struct MemFile *memfile,
                                   struct Main *oldmain,
                                   struct Scene **r_scene)
@@ -144,12 +337,25 @@ struct Main *BLO_memfile_main_get(struct MemFile *memfile,
 /**
  * Saves .blend using undo buffer.
  *
+ * The file is written to a temporary file which is renamed once complete,
+ * so the previous file is kept when writing fails or is cancelled.
+ *
+ * \param use_compress: Write a gzip compressed file.
+ * \param r_progress: Optional, fraction of the file written so far.
+ * \param stop: Optional, writing is cancelled when set (from another thread).
  * \return success.
  */
-bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename)
+bool BLO_memfile_write_file_ex(struct MemFile *memfile,
+                               const char *filename,
+                               const bool use_compress,
+                               float *r_progress,
+                               const short *stop)
 {
   MemFileChunk *chunk;
+  char tempname[FILE_MAX + 1];
   int file, oflags;
+  gzFile gzfile = NULL;
+  size_t size_total = 0, size_written = 0;
 
   /* note: This is currently used for autosave and 'quit.blend',
    * where _not_ following symlinks is OK,
@@ -167,7 +373,10 @@ bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename)
 #    warning "Symbolic links will be followed on undo save, possibly causing CVE-2008-1103"
 #  endif
 #endif
-  file = BLI_open(filename, oflags, 0666);
+
+  /* open temporary file, so we preserve the original in case we crash */
+  BLI_snprintf(tempname, sizeof(tempname), "%s@", filename);
+  file = BLI_open(tempname, oflags, 0666);
 
   if (file == -1) {
     fprintf(stderr,
@@ -177,20 +386,70 @@ bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename)
     return false;
   }
 
+  if (use_compress) {
+    /* Same compression level as regular saving, it's fast and compresses well enough. */
+    gzfile = gzdopen(file, "wb1");
+    if (gzfile == NULL) {
+      close(file);
+      BLI_delete(tempname, false, false);
+      fprintf(stderr, "Unable to save '%s': %s\n", filename, "Unable to start compression");
+      return false;
+    }
+  }
+
   for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
-    if ((size_t)write(file, chunk->buf, chunk->size) != chunk->size) {
+    size_total += chunk->size;
+  }
+
+  for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
+    if (stop && *stop) {
+      break;
+    }
+    if (gzfile) {
+      if (gzwrite(gzfile, chunk->buf, chunk->size) != (int)chunk->size) {
+        break;
+      }
+    }
+    else if ((size_t)write(file, chunk->buf, chunk->size) != chunk->size) {
       break;
     }
+    size_written += chunk->size;
+    if (r_progress) {
+      *r_progress = (float)((double)size_written / (double)MAX2(size_total, (size_t)1));
+    }
   }
 
-  close(file);
+  bool ok = (chunk == NULL);
+  if (gzfile) {
+    /* Also closes the file descriptor. */
+    if (gzclose(gzfile) != Z_OK) {
+      ok = false;
+    }
+  }
+  else {
+    close(file);
+  }
 
-  if (chunk) {
+  if (!ok) {
+    BLI_delete(tempname, false, false);
+    if (stop && *stop) {
+      return false;
+    }
     fprintf(stderr,
             "Unable to save '%s': %s\n",
             filename,
             errno ? strerror(errno) : "Unknown error writing file");
     return false;
   }
+
+  if (BLI_rename(tempname, filename) != 0) {
+    fprintf(stderr, "Unable to save '%s': %s\n", filename, "Cannot replace the old file");
+    return false;
+  }
   return true;
 }
+
+bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename)
+{
+  return BLO_memfile_write_file_ex(memfile, filename, false, NULL, NULL);
+}
@@ -103,6 +103,8 @@ void BLO_update_defaults_userpref_blend(void)
    * without actually enabling translation itself, for now. */
   U.transopts = USER_TR_TOOLTIPS;
   U.memcachelimit = min_ii(BLI_system_memory_max_in_megabytes_int() / 2, 4096);
+  U.mesh_eval_cache_limit = min_ii(BLI_system_memory_max_in_megabytes_int() / 8, 1024);
+  U.compositor_cache_limit = min_ii(BLI_system_memory_max_in_megabytes_int() / 4, 4096);
 
   /* Auto perspective. */
   U.uiflag |= USER_AUTOPERSP;
@@ -607,6 +607,16 @@ void BLO_version_defaults_userpref_blend(Main *bmain, UserDef *userdef)
     userdef->drag_threshold_tablet = 10;
   }
 
+  if (!USER_VERSION_ATLEAST(280, 75)) {
+    /* Zero disables the cache, only set the default for preferences saved before it existed. */
+    userdef->mesh_eval_cache_limit = 256;
+  }
+
+  if (!USER_VERSION_ATLEAST(280, 76)) {
+    /* Zero disables the cache, only set the default for preferences saved before it existed. */
+    userdef->compositor_cache_limit = 1024;
+  }
+
   /**
    * Include next version bump.
    */
@@ -84,7 +84,8 @@
 #  include <io.h>
 #  include "BLI_winstuff.h"
 #else
-#  include <unistd.h> /* FreeBSD, for write() and close(). */
+#  include <sys/uio.h> /* For writev(). */
+#  include <unistd.h>  /* FreeBSD, for write() and close(). */
 #endif
 
 #include "BLI_utildefines.h"
@@ -142,7 +143,10 @@
 #include "MEM_guardedalloc.h"  // MEM_freeN
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_action.h"
 #include "BKE_blender_version.h"
@@ -196,14 +200,28 @@
 typedef enum {
   WW_WRAP_NONE = 1,
   WW_WRAP_ZLIB,
+  WW_WRAP_ZLIB_PARALLEL,
 } eWriteWrapType;
 
+typedef struct ZlibParallelWriter ZlibParallelWriter;
+
+/** Part of a gather write, see #WriteWrap.write_vec. */
+typedef struct WriteVec {
+  const void *data;
+  size_t data_len;
+} WriteVec;
+
+/* Most vectors used by a single gather write: the buffered data and a large block. */
+#define WRITE_VEC_MAX 2
+
 typedef struct WriteWrap WriteWrap;
 struct WriteWrap {
   /* callbacks */
   bool (*open)(WriteWrap *ww, const char *filepath);
   bool (*close)(WriteWrap *ww);
   size_t (*write)(WriteWrap *ww, const char *data, size_t data_len);
+  /* Optional, write several pieces of memory in one go, without copying them together. */
+  size_t (*write_vec)(WriteWrap *ww, const WriteVec *vec, int vec_len);
 
   /* Buffer output (we only want when output isn't already buffered). */
   bool use_buf;
@@ -212,6 +230,7 @@ struct WriteWrap {
   union {
     int file_handle;
     gzFile gz_handle;
+    ZlibParallelWriter *zlib_parallel;
   } _user_data;
 };
 
@@ -240,6 +259,48 @@ static size_t ww_write_none(WriteWrap *ww, const char *buf, size_t buf_len)
 {
   return write(FILE_HANDLE(ww), buf, buf_len);
 }
+static size_t ww_write_vec_none(WriteWrap *ww, const WriteVec *vec, int vec_len)
+{
+  BLI_assert(vec_len <= WRITE_VEC_MAX);
+  size_t written_len = 0;
+#ifdef WIN32
+  for (int i = 0; i < vec_len; i++) {
+    const size_t len = ww_write_none(ww, vec[i].data, vec[i].data_len);
+    written_len += len;
+    if (len != vec[i].data_len) {
+      break;
+    }
+  }
+#else
+  struct iovec iov[WRITE_VEC_MAX];
+  for (int i = 0; i < vec_len; i++) {
+    iov[i].iov_base = (void *)vec[i].data;
+    iov[i].iov_len = vec[i].data_len;
+  }
+  /* The kernel may write less than requested (large writes are capped at about 2GB),
+   * continue from where it stopped. */
+  int iov_first = 0;
+  while (iov_first < vec_len) {
+    ssize_t len = writev(FILE_HANDLE(ww), &iov[iov_first], vec_len - iov_first);
+    if (len <= 0) {
+      if (len == -1 && errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    written_len += (size_t)len;
+    while (iov_first < vec_len && (size_t)len >= iov[iov_first].iov_len) {
+      len -= (ssize_t)iov[iov_first].iov_len;
+      iov_first++;
+    }
+    if (iov_first < vec_len) {
+      iov[iov_first].iov_base = (char *)iov[iov_first].iov_base + len;
+      iov[iov_first].iov_len -= (size_t)len;
+    }
+  }
+#endif
+  return written_len;
+}
 #undef FILE_HANDLE
 
 /* zlib */
@@ -269,6 +330,239 @@ static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
+/* zlib, compressed on worker threads
+ *
+ * The stream is split into frames which are compressed independently, each frame is written as
+ * a complete gzip member. Concatenated members are a valid gzip file, so files can be read with
+ * gzread() like the ones written by #ww_write_zlib. The sizes stored in the header of every
+ * member let the reader seek to any frame, see #BLEND_GZIP_FRAME_EXTRA_ID. */
+
+/* Uncompressed size of a frame. */
+#define ZLIB_FRAME_SIZE (1 << 20)
+#define ZLIB_FRAME_HEADER_SIZE BLEND_GZIP_FRAME_HEADER_SIZE
+#define ZLIB_FRAME_TRAILER_SIZE BLEND_GZIP_FRAME_TRAILER_SIZE
+
+typedef struct ZlibFrame {
+  struct ZlibFrame *next, *prev;
+  char *in;
+  size_t in_len;
+  /* Complete gzip member, header and trailer included. */
+  char *out;
+  size_t out_len;
+  /* Set by the worker thread, protected by #ZlibParallelWriter.mutex. */
+  bool is_done;
+  bool is_error;
+} ZlibFrame;
+
+struct ZlibParallelWriter {
+  int file_handle;
+  TaskPool *task_pool;
+  /* Frames being compressed, in file order. */
+  ListBase frames;
+  int frames_len;
+  /* Limit of frames in flight, so memory usage stays bound when compression is slower than
+   * serialization. */
+  int frames_max;
+  /* Frame being filled by the writer. */
+  ZlibFrame *frame_fill;
+
+  ThreadMutex mutex;
+  ThreadCondition cond;
+
+  bool error;
+  size_t in_len, out_len;
+  int frames_num;
+};
+
+static void zlib_frame_store_uint32(char *dst, uint32_t value)
+{
+  dst[0] = (char)(value & 0xff);
+  dst[1] = (char)((value >> 8) & 0xff);
+  dst[2] = (char)((value >> 16) & 0xff);
+  dst[3] = (char)((value >> 24) & 0xff);
+}
+
+static bool zlib_frame_compress(ZlibFrame *frame)
+{
+  z_stream stream = {NULL};
+  /* Same compression level as #ww_open_zlib, negative window bits for raw deflate data. */
+  if (deflateInit2(&stream, 1, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+  const size_t deflate_max_len = deflateBound(&stream, frame->in_len);
+  frame->out = MEM_mallocN(ZLIB_FRAME_HEADER_SIZE + deflate_max_len + ZLIB_FRAME_TRAILER_SIZE,
+                           __func__);
+
+  stream.next_in = (Bytef *)frame->in;
+  stream.avail_in = frame->in_len;
+  stream.next_out = (Bytef *)frame->out + ZLIB_FRAME_HEADER_SIZE;
+  stream.avail_out = deflate_max_len;
+  const int ret = deflate(&stream, Z_FINISH);
+  const size_t deflate_len = stream.total_out;
+  deflateEnd(&stream);
+  if (ret != Z_STREAM_END) {
+    return false;
+  }
+  frame->out_len = ZLIB_FRAME_HEADER_SIZE + deflate_len + ZLIB_FRAME_TRAILER_SIZE;
+
+  char *header = frame->out;
+  header[0] = 0x1f; /* Magic. */
+  header[1] = (char)0x8b;
+  header[2] = 8;          /* Deflate. */
+  header[3] = 4;          /* FEXTRA. */
+  zlib_frame_store_uint32(&header[4], 0); /* No modification time. */
+  header[8] = 4;          /* Fastest compression. */
+  header[9] = (char)0xff; /* Unknown OS. */
+  header[10] = 12;        /* Extra field length. */
+  header[11] = 0;
+  header[12] = BLEND_GZIP_FRAME_EXTRA_ID[0];
+  header[13] = BLEND_GZIP_FRAME_EXTRA_ID[1];
+  header[14] = 8; /* Sub-field length. */
+  header[15] = 0;
+  zlib_frame_store_uint32(&header[16], (uint32_t)frame->out_len);
+  zlib_frame_store_uint32(&header[20], (uint32_t)frame->in_len);
+
+  char *trailer = frame->out + ZLIB_FRAME_HEADER_SIZE + deflate_len;
+  zlib_frame_store_uint32(&trailer[0], crc32(0, (const Bytef *)frame->in, frame->in_len));
+  zlib_frame_store_uint32(&trailer[4], (uint32_t)frame->in_len);
+  return true;
+}
+
+static void zlib_frame_compress_task(TaskPool *__restrict pool,
+                                     void *taskdata,
+                                     int UNUSED(threadid))
+{
+  ZlibParallelWriter *zw = BLI_task_pool_userdata(pool);
+  ZlibFrame *frame = taskdata;
+
+  const bool ok = zlib_frame_compress(frame);
+  MEM_freeN(frame->in);
+  frame->in = NULL;
+
+  BLI_mutex_lock(&zw->mutex);
+  frame->is_done = true;
+  frame->is_error = !ok;
+  BLI_condition_notify_all(&zw->cond);
+  BLI_mutex_unlock(&zw->mutex);
+}
+
+/* Write compressed frames to the file in order. Waits for frames to be compressed while there
+ * are more than `frames_keep` frames in flight. */
+static void zlib_parallel_write_frames(ZlibParallelWriter *zw, const int frames_keep)
+{
+  ZlibFrame *frame;
+  while ((frame = zw->frames.first)) {
+    BLI_mutex_lock(&zw->mutex);
+    if (!frame->is_done && zw->frames_len <= frames_keep) {
+      BLI_mutex_unlock(&zw->mutex);
+      break;
+    }
+    while (!frame->is_done) {
+      BLI_condition_wait(&zw->cond, &zw->mutex);
+    }
+    BLI_mutex_unlock(&zw->mutex);
+
+    if (frame->is_error) {
+      zw->error = true;
+    }
+    else if (!zw->error) {
+      if ((size_t)write(zw->file_handle, frame->out, frame->out_len) != frame->out_len) {
+        zw->error = true;
+      }
+      zw->out_len += frame->out_len;
+    }
+
+    BLI_remlink(&zw->frames, frame);
+    zw->frames_len--;
+    MEM_SAFE_FREE(frame->out);
+    MEM_freeN(frame);
+  }
+}
+
+static void zlib_parallel_frame_submit(ZlibParallelWriter *zw)
+{
+  ZlibFrame *frame = zw->frame_fill;
+  zw->frame_fill = NULL;
+  zw->in_len += frame->in_len;
+  zw->frames_num++;
+
+  BLI_addtail(&zw->frames, frame);
+  zw->frames_len++;
+  BLI_task_pool_push(zw->task_pool, zlib_frame_compress_task, frame, false, TASK_PRIORITY_HIGH);
+
+  zlib_parallel_write_frames(zw, zw->frames_max);
+}
+
+#define FILE_HANDLE(ww) (ww)->_user_data.zlib_parallel
+
+static bool ww_open_zlib_parallel(WriteWrap *ww, const char *filepath)
+{
+  int file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
+  if (file == -1) {
+    return false;
+  }
+
+  ZlibParallelWriter *zw = MEM_callocN(sizeof(*zw), __func__);
+  zw->file_handle = file;
+  zw->task_pool = BLI_task_pool_create_background(BLI_task_scheduler_get(), zw);
+  zw->frames_max = 2 * BLI_system_thread_count();
+  BLI_mutex_init(&zw->mutex);
+  BLI_condition_init(&zw->cond);
+
+  FILE_HANDLE(ww) = zw;
+  return true;
+}
+static bool ww_close_zlib_parallel(WriteWrap *ww)
+{
+  ZlibParallelWriter *zw = FILE_HANDLE(ww);
+
+  if (zw->frame_fill) {
+    zlib_parallel_frame_submit(zw);
+  }
+  zlib_parallel_write_frames(zw, 0);
+  BLI_task_pool_work_and_wait(zw->task_pool);
+  BLI_task_pool_free(zw->task_pool);
+
+  if (G.debug & G_DEBUG_IO) {
+    printf("%s: compressed %.2f MB to %.2f MB (%.1f%%) in %d frames\n",
+           __func__,
+           (double)zw->in_len / (1024.0 * 1024.0),
+           (double)zw->out_len / (1024.0 * 1024.0),
+           zw->in_len ? 100.0 * (double)zw->out_len / (double)zw->in_len : 0.0,
+           zw->frames_num);
+  }
+
+  bool ok = !zw->error;
+  if (close(zw->file_handle) == -1) {
+    ok = false;
+  }
+  BLI_condition_end(&zw->cond);
+  BLI_mutex_end(&zw->mutex);
+  MEM_freeN(zw);
+  return ok;
+}
+static size_t ww_write_zlib_parallel(WriteWrap *ww, const char *buf, size_t buf_len)
+{
+  ZlibParallelWriter *zw = FILE_HANDLE(ww);
+  size_t buf_offset = 0;
+  while (buf_offset < buf_len && !zw->error) {
+    if (zw->frame_fill == NULL) {
+      zw->frame_fill = MEM_callocN(sizeof(ZlibFrame), __func__);
+      zw->frame_fill->in = MEM_mallocN(ZLIB_FRAME_SIZE, __func__);
+    }
+    ZlibFrame *frame = zw->frame_fill;
+    const size_t copy_len = MIN2(buf_len - buf_offset, ZLIB_FRAME_SIZE - frame->in_len);
+    memcpy(frame->in + frame->in_len, buf + buf_offset, copy_len);
+    frame->in_len += copy_len;
+    buf_offset += copy_len;
+    if (frame->in_len == ZLIB_FRAME_SIZE) {
+      zlib_parallel_frame_submit(zw);
+    }
+  }
+  return zw->error ? 0 : buf_len;
+}
+#undef FILE_HANDLE
+
 /* --- end compression types --- */
 
 static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
@@ -283,10 +577,18 @@ static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
       r_ww->use_buf = false;
       break;
     }
+    case WW_WRAP_ZLIB_PARALLEL: {
+      r_ww->open = ww_open_zlib_parallel;
+      r_ww->close = ww_close_zlib_parallel;
+      r_ww->write = ww_write_zlib_parallel;
+      r_ww->use_buf = false;
+      break;
+    }
     default: {
       r_ww->open = ww_open_none;
       r_ww->close = ww_close_none;
       r_ww->write = ww_write_none;
+      r_ww->write_vec = ww_write_vec_none;
       r_ww->use_buf = true;
       break;
     }
@@ -306,6 +608,8 @@ typedef struct {
   uchar *buf;
   /** Number of bytes used in #WriteData.buf (flushed when exceeded). */
   int buf_used_len;
+  /** Number of bytes passed on to the file or #MemFile, see #mywrite_offset. */
+  size_t offset;
 
 #ifdef USE_WRITE_DATA_LEN
   /** Total number of bytes written. */
@@ -321,10 +625,18 @@ typedef struct {
     MemFile *compare;
     /** Use to de-duplicate chunks when writing. */
     MemFileChunk *compare_chunk;
+    /** All chunks of #compare by contents, to de-duplicate chunks which moved. */
+    struct GSet *compare_chunk_set;
+    /** Optional, #MemFileIDRange of every local data-block written, by ID name. */
+    struct GHash *id_ranges;
   } mem;
   /** When true, write to #WriteData.current, could also call 'is_undo'. */
   bool use_memfile;
 
+  /** Blocks listed in the file index, NULL for undo and compressed files
+   * (see: #write_file_index). */
+  struct WriteFileIndex *index;
+
   /**
    * Wrap writing, so we can use zlib or
    * other compression types later, see: G_FILE_COMPRESS
@@ -360,13 +672,43 @@ static void writedata_do_write(WriteData *wd, const void *mem, int memlen)
 
   /* memory based save */
   if (wd->use_memfile) {
-    memfile_chunk_add(wd->mem.current, mem, memlen, &wd->mem.compare_chunk);
+    memfile_chunk_add(
+        wd->mem.current, mem, memlen, &wd->mem.compare_chunk, wd->mem.compare_chunk_set);
   }
   else {
     if (wd->ww->write(wd->ww, mem, memlen) != memlen) {
       wd->error = true;
     }
   }
+  wd->offset += (size_t)memlen;
+}
+
+/**
+ * Write the pieces of memory to the file as a single gather write, skipping empty ones.
+ * Only for files with #WriteWrap.write_vec, undo needs chunks to de-duplicate them.
+ */
+static void writedata_do_write_vec(WriteData *wd, const WriteVec *vec, int vec_len)
+{
+  BLI_assert(!wd->use_memfile && wd->ww->write_vec != NULL);
+
+  if (UNLIKELY(wd->error)) {
+    return;
+  }
+
+  WriteVec vec_used[WRITE_VEC_MAX];
+  int vec_used_len = 0;
+  size_t len = 0;
+  for (int i = 0; i < vec_len; i++) {
+    if (vec[i].data_len != 0) {
+      vec_used[vec_used_len++] = vec[i];
+      len += vec[i].data_len;
+    }
+  }
+
+  if (wd->ww->write_vec(wd->ww, vec_used, vec_used_len) != len) {
+    wd->error = true;
+  }
+  wd->offset += len;
 }
 
 static void writedata_free(WriteData *wd)
@@ -395,6 +737,12 @@ static void mywrite_flush(WriteData *wd)
   }
 }
 
+/* Offset from the start of the file of the next byte written (including buffered bytes). */
+static size_t mywrite_offset(const WriteData *wd)
+{
+  return wd->offset + (size_t)wd->buf_used_len;
+}
+
 /**
  * Low level WRITE(2) wrapper that buffers data
  * \param adr: Pointer to new chunk of data
@@ -422,6 +770,18 @@ static void mywrite(WriteData *wd, const void *adr, int len)
     /* if we have a single big chunk, write existing data in
      * buffer and write out big chunk in smaller pieces */
     if (len > MYWRITE_MAX_CHUNK) {
+      /* Only undo needs the pieces, files get the buffer (usually ending with the header of
+       * this block) and the chunk straight from its memory, in one system call. */
+      if (!wd->use_memfile && wd->ww->write_vec) {
+        const WriteVec vec[2] = {
+            {wd->buf, (size_t)wd->buf_used_len},
+            {adr, (size_t)len},
+        };
+        writedata_do_write_vec(wd, vec, ARRAY_SIZE(vec));
+        wd->buf_used_len = 0;
+        return;
+      }
+
       if (wd->buf_used_len) {
         writedata_do_write(wd, wd->buf, wd->buf_used_len);
         wd->buf_used_len = 0;
@@ -464,12 +824,15 @@ static WriteData *mywrite_begin(WriteWrap *ww, MemFile *compare, MemFile *curren
     wd->mem.current = current;
     wd->mem.compare = compare;
     wd->mem.compare_chunk = compare ? compare->chunks.first : NULL;
+    wd->mem.compare_chunk_set = compare ? memfile_chunk_set_new(compare) : NULL;
     wd->use_memfile = true;
   }
 
   return wd;
 }
 
+static void write_file_index_free(struct WriteFileIndex *index);
+
 /**
  * END the mywrite wrapper
  * \return 1 if write failed
@@ -483,6 +846,13 @@ static bool mywrite_end(WriteData *wd)
     wd->buf_used_len = 0;
   }
 
+  if (wd->mem.compare_chunk_set) {
+    memfile_chunk_set_free(wd->mem.compare_chunk_set);
+  }
+  if (wd->index) {
+    write_file_index_free(wd->index);
+  }
+
   const bool err = wd->error;
   writedata_free(wd);
 
@@ -491,6 +861,108 @@ static bool mywrite_end(WriteData *wd)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name File Index
+ *
+ * Offsets of the blocks which are needed to list the contents of the file,
+ * written at the end of regular files (see #BlendFileIndexHeader).
+ * \{ */
+
+typedef struct WriteFileIndex {
+  BlendFileIndexEntry *entries;
+  int entries_len;
+  int entries_alloc;
+
+  /** Library file paths. */
+  char *strings;
+  int strings_len;
+  int strings_alloc;
+
+  int64_t glob_offset;
+  int64_t dna_offset;
+  int64_t thumb_offset;
+
+  /** Entry of the library written last, linked data-blocks are written after their library. */
+  int library;
+} WriteFileIndex;
+
+static WriteFileIndex *write_file_index_new(void)
+{
+  WriteFileIndex *index = MEM_callocN(sizeof(*index), __func__);
+  index->library = -1;
+  return index;
+}
+
+static void write_file_index_free(WriteFileIndex *index)
+{
+  MEM_SAFE_FREE(index->entries);
+  MEM_SAFE_FREE(index->strings);
+  MEM_freeN(index);
+}
+
+static int write_file_index_add_string(WriteFileIndex *index, const char *str)
+{
+  const int len = (int)strlen(str) + 1;
+  if (index->strings_len + len > index->strings_alloc) {
+    index->strings_alloc = MAX2(index->strings_alloc * 2, index->strings_len + len + 1024);
+    index->strings = MEM_reallocN(index->strings, (size_t)index->strings_alloc);
+  }
+  const int offset = index->strings_len;
+  memcpy(index->strings + offset, str, (size_t)len);
+  index->strings_len += len;
+  return offset;
+}
+
+/**
+ * Call before writing the header of a block which isn't #DATA.
+ * \param data: Contents of the block, an ID for data-block and library blocks.
+ */
+static void write_file_index_add(WriteData *wd, const int filecode, const void *data)
+{
+  WriteFileIndex *index = wd->index;
+  const int64_t offset = (int64_t)mywrite_offset(wd);
+
+  switch (filecode) {
+    case GLOB:
+      index->glob_offset = offset;
+      return;
+    case DNA1:
+      index->dna_offset = offset;
+      return;
+    case TEST:
+      index->thumb_offset = offset;
+      return;
+    case REND:
+    case USER:
+    case ENDB:
+    case DATA:
+      return;
+  }
+
+  if (index->entries_len == index->entries_alloc) {
+    index->entries_alloc = MAX2(index->entries_alloc * 2, 256);
+    index->entries = MEM_reallocN(index->entries,
+                                  sizeof(*index->entries) * (size_t)index->entries_alloc);
+  }
+  BlendFileIndexEntry *entry = &index->entries[index->entries_len];
+  const ID *id = data;
+
+  memset(entry, 0, sizeof(*entry));
+  entry->code = filecode;
+  entry->offset = offset;
+  entry->library = (filecode == ID_LINK_PLACEHOLDER) ? index->library : -1;
+  entry->filepath = -1;
+  STRNCPY(entry->name, id->name);
+
+  if (filecode == ID_LI) {
+    entry->filepath = write_file_index_add_string(index, ((const Library *)id)->name);
+    index->library = index->entries_len;
+  }
+  index->entries_len++;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Generic DNA File Writing
  * \{ */
@@ -521,6 +993,10 @@ static void writestruct_at_address_nr(
     return;
   }
 
+  if (wd->index && filecode != DATA) {
+    write_file_index_add(wd, filecode, data);
+  }
+
   mywrite(wd, &bh, sizeof(BHead));
   mywrite(wd, data, bh.len);
 }
@@ -574,6 +1050,10 @@ static void writedata(WriteData *wd,
   bh.SDNAnr = 0;
   bh.len = len;
 
+  if (wd->index && filecode != DATA) {
+    write_file_index_add(wd, filecode, adr);
+  }
+
   mywrite(wd, &bh, sizeof(BHead));
   mywrite(wd, adr, len);
 }
@@ -3736,6 +4216,47 @@ static void write_thumb(WriteData *wd, const BlendThumbnail *thumb)
   }
 }
 
+/**
+ * Written as #DATA so versions which don't know about it skip it,
+ * see #BlendFileIndexHeader for the layout.
+ */
+static void write_file_index(WriteData *wd)
+{
+  WriteFileIndex *index = wd->index;
+  const size_t entries_size = sizeof(BlendFileIndexEntry) * (size_t)index->entries_len;
+  const size_t len = sizeof(BlendFileIndexHeader) + entries_size + (size_t)index->strings_len;
+  /* Padded with zeros, #writedata aligns the size to 4 bytes. */
+  char *data = MEM_callocN(len + 4, __func__);
+
+  BlendFileIndexHeader *header = (BlendFileIndexHeader *)data;
+  header->version = BLEND_FILE_INDEX_VERSION;
+  header->entries_len = index->entries_len;
+  header->strings_len = index->strings_len;
+  header->glob_offset = index->glob_offset;
+  header->dna_offset = index->dna_offset;
+  header->thumb_offset = index->thumb_offset;
+  if (entries_size) {
+    memcpy(data + sizeof(*header), index->entries, entries_size);
+  }
+  if (index->strings_len) {
+    memcpy(data + sizeof(*header) + entries_size, index->strings, (size_t)index->strings_len);
+  }
+
+  BlendFileIndexTrailer trailer;
+  trailer.index_offset = (uint64_t)mywrite_offset(wd);
+  memcpy(trailer.magic, BLEND_FILE_INDEX_MAGIC, sizeof(trailer.magic));
+
+  writedata(wd, DATA, (int)len, data);
+  MEM_freeN(data);
+
+  /* End of file, the trailer is after #ENDB so it's never read as a block. */
+  BHead bhead;
+  memset(&bhead, 0, sizeof(BHead));
+  bhead.code = ENDB;
+  mywrite(wd, &bhead, sizeof(BHead));
+  mywrite(wd, &trailer, sizeof(trailer));
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -3747,6 +4268,7 @@ static bool write_file_handle(Main *mainvar,
                               WriteWrap *ww,
                               MemFile *compare,
                               MemFile *current,
+                              GHash *id_ranges,
                               int write_flags,
                               const BlendThumbnail *thumb)
 {
@@ -3758,6 +4280,12 @@ static bool write_file_handle(Main *mainvar,
   blo_split_main(&mainlist, mainvar);
 
   wd = mywrite_begin(ww, compare, current);
+  wd->mem.id_ranges = id_ranges;
+  /* Readers don't seek in compressed files, they would have to inflate the whole file to reach
+   * the index. */
+  if (wd->use_memfile == false && (write_flags & G_FILE_COMPRESS) == 0) {
+    wd->index = write_file_index_new();
+  }
 
   sprintf(buf,
           "BLENDER%c%c%.3d",
@@ -3805,6 +4333,8 @@ static bool write_file_handle(Main *mainvar,
           BKE_override_static_operations_store_start(bmain, override_storage, id);
         }
 
+        const size_t id_offset = mywrite_offset(wd);
+
         switch ((ID_Type)GS(id->name)) {
           case ID_WM:
             write_windowmanager(wd, (wmWindowManager *)id);
@@ -3924,6 +4454,20 @@ static bool write_file_handle(Main *mainvar,
         if (do_override) {
           BKE_override_static_operations_store_end(override_storage, id);
         }
+
+        /* Every data-block in its own chunks, so unchanged data-blocks are shared with
+         * the previous undo step, whatever changed before them. */
+        if (wd->use_memfile) {
+          mywrite_flush(wd);
+
+          if (wd->mem.id_ranges && bmain == mainvar) {
+            MemFileIDRange *range = MEM_mallocN(sizeof(*range), __func__);
+            range->id = id;
+            range->offset = id_offset;
+            range->size = mywrite_offset(wd) - id_offset;
+            BLI_ghash_insert(wd->mem.id_ranges, id->name, range);
+          }
+        }
       }
 
       mywrite_flush(wd);
@@ -3951,10 +4495,15 @@ static bool write_file_handle(Main *mainvar,
    * so writing each time uses the same address and doesn't cause unnecessary undo overhead. */
   writedata(wd, DNA1, wd->sdna->data_len, wd->sdna->data);
 
-  /* end of file */
-  memset(&bhead, 0, sizeof(BHead));
-  bhead.code = ENDB;
-  mywrite(wd, &bhead, sizeof(BHead));
+  if (wd->index) {
+    write_file_index(wd);
+  }
+  else {
+    /* end of file */
+    memset(&bhead, 0, sizeof(BHead));
+    bhead.code = ENDB;
+    mywrite(wd, &bhead, sizeof(BHead));
+  }
 
   blo_join_main(&mainlist);
 
@@ -4036,7 +4585,8 @@ bool BLO_write_file(Main *mainvar,
   BLI_snprintf(tempname, sizeof(tempname), "%s@", filepath);
 
   if (write_flags & G_FILE_COMPRESS) {
-    ww_type = WW_WRAP_ZLIB;
+    /* Compressing is much slower than serializing, use all threads if possible. */
+    ww_type = (BLI_system_thread_count() > 1) ? WW_WRAP_ZLIB_PARALLEL : WW_WRAP_ZLIB;
   }
   else {
     ww_type = WW_WRAP_NONE;
@@ -4086,7 +4636,7 @@ bool BLO_write_file(Main *mainvar,
   }
 
   /* actual file writing */
-  const bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, thumb);
+  const bool err = write_file_handle(mainvar, &ww, NULL, NULL, NULL, write_flags, thumb);
 
   ww.close(&ww);
 
@@ -4129,10 +4679,21 @@ bool BLO_write_file(Main *mainvar,
  * \return Success.
  */
 bool BLO_write_file_mem(Main *mainvar, MemFile *compare, MemFile *current, int write_flags)
+{
+  return BLO_write_file_mem_ex(mainvar, compare, current, write_flags, NULL);
+}
+
+/**
+ * \param r_id_ranges: When not NULL, filled with the #MemFileIDRange of every local data-block,
+ * keyed by ID name. Values are owned by the caller, free them with #MEM_freeN.
+ */
+bool BLO_write_file_mem_ex(
+    Main *mainvar, MemFile *compare, MemFile *current, int write_flags, GHash *r_id_ranges)
 {
   write_flags &= ~G_FILE_USERPREFS;
 
-  const bool err = write_file_handle(mainvar, NULL, compare, current, write_flags, NULL);
+  const bool err = write_file_handle(
+      mainvar, NULL, compare, current, r_id_ranges, write_flags, NULL);
 
   return (err == 0);
 }
@@ -26,6 +26,8 @@ extern "C" {
 #include "DNA_color_types.h"
 #include "DNA_node_types.h"
 
+struct Render;
+
 /* Keep ascii art. */
 /* clang-format off */
 /**
@@ -243,11 +245,11 @@ extern "C" {
  *
  * \subsection multithread Multi threaded
  * Default the work-scheduler will place all work as WorkPackage in a queue.
- * For every CPUcore a working thread is created.
- * These working threads will ask the WorkScheduler if there is work
- * for a specific Device.
- * the work-scheduler will find work for the device and the device
- * will be asked to execute the WorkPackage.
+ * For every WorkPackage a task is pushed to the BLI_task scheduler, so the compositor shares
+ * the threads with the rest of Blender.
+ * A task executes the WorkPackage with the highest priority, the chunks of output groups come
+ * first and otherwise the ChunkOrder is kept. WorkPackages of a cancelled execution are skipped.
+ * OpenCL devices have a working thread each, which asks the WorkScheduler for work.
  *
  * \subsection singlethread Single threaded
  * For debugging reasons the multi-threading can be disabled.
@@ -304,6 +306,12 @@ extern "C" {
  * It can be executed during editing (blenkernel/node.c) or rendering
  * (renderer/pipeline.c)
  *
+ * \param render: [struct Render]
+ *   Render the composite result is written to, NULL for the render of the scene.
+ *   Executions writing to a render other than the one of the scene are frames composited at
+ *   the same time by the render pipeline, they run concurrently with each other.
+ * \see RE_RenderAnim
+ *
  * \param rd: [struct RenderData]
  *   Render data for this composite, this won't always belong to a scene.
  *
@@ -342,7 +350,8 @@ extern "C" {
  */
 /* clang-format off */
 
-void COM_execute(RenderData *rd,
+void COM_execute(struct Render *render,
+                 RenderData *rd,
                  Scene *scene,
                  bNodeTree *editingtree,
                  int rendering,
@@ -359,8 +368,11 @@ void COM_deinitialize(void);
 /**
  * \brief Clear all compositor caches. (Compositor system will still remain available).
  * To deinitialize the compositor use the COM_deinitialize method.
+ *
+ * A running execution may still use the cached buffers, they are freed when the next execution
+ * starts.
  */
-// void COM_clearCaches(void); // NOT YET WRITTEN
+void COM_clearCaches(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,331 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <list>
+#include <map>
+#include <string.h>
+
+#include "COM_BufferCache.h" /* own include */
+#include "COM_CompositorContext.h"
+#include "COM_MemoryBuffer.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_math_base.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_color_types.h"
+#include "DNA_genfile.h"
+#include "DNA_image_types.h"
+#include "DNA_scene_types.h"
+#include "DNA_sdna_types.h"
+#include "DNA_userdef_types.h"
+
+#include "BKE_node.h"
+
+#include "RE_pipeline.h"
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Hashing
+ * \{ */
+
+BufferCacheHash::BufferCacheHash()
+{
+  BLI_hash_mm2a_init(&m_mm2[0], 0);
+  BLI_hash_mm2a_init(&m_mm2[1], 0x9e3779b9);
+}
+
+void BufferCacheHash::add(const void *data, size_t len)
+{
+  BLI_hash_mm2a_add(&m_mm2[0], (const unsigned char *)data, len);
+  BLI_hash_mm2a_add(&m_mm2[1], (const unsigned char *)data, len);
+}
+
+void BufferCacheHash::add_int(int value)
+{
+  BLI_hash_mm2a_add_int(&m_mm2[0], value);
+  BLI_hash_mm2a_add_int(&m_mm2[1], value);
+}
+
+void BufferCacheHash::add_uint64(uint64_t value)
+{
+  add(&value, sizeof(value));
+}
+
+void BufferCacheHash::add_string(const char *str)
+{
+  if (str) {
+    add(str, strlen(str) + 1);
+  }
+  else {
+    add_int(0);
+  }
+}
+
+/* Hash all non-pointer members of a DNA struct, recursing into nested structs. */
+static void hash_dna_struct(BufferCacheHash *hash,
+                            const SDNA *sdna,
+                            const int struct_nr,
+                            const char *data)
+{
+  const short *sp = sdna->structs[struct_nr];
+  const int members_len = sp[1];
+  sp += 2;
+
+  for (int a = 0; a < members_len; a++, sp += 2) {
+    const int type_nr = sp[0];
+    const char *name = sdna->names[sp[1]];
+    const int array_len = sdna->names_array_len[sp[1]];
+    const bool is_pointer = ELEM(name[0], '*', '(');
+    const int size = (is_pointer ? sdna->pointer_size : sdna->types_size[type_nr]) * array_len;
+
+    if (!is_pointer) {
+      const int member_struct_nr = DNA_struct_find_nr(sdna, sdna->types[type_nr]);
+      if (member_struct_nr != -1) {
+        const int member_size = sdna->types_size[type_nr];
+        for (int i = 0; i < array_len; i++) {
+          hash_dna_struct(hash, sdna, member_struct_nr, data + i * member_size);
+        }
+      }
+      else {
+        hash->add(data, (size_t)size);
+      }
+    }
+    data += size;
+  }
+}
+
+void BufferCacheHash::add_dna(const char *struct_name, const void *data)
+{
+  const SDNA *sdna = DNA_sdna_current_get();
+  const int struct_nr = DNA_struct_find_nr(sdna, struct_name);
+  BLI_assert(struct_nr != -1);
+  if (struct_nr != -1) {
+    hash_dna_struct(this, sdna, struct_nr, (const char *)data);
+  }
+}
+
+uint64_t BufferCacheHash::end()
+{
+  return ((uint64_t)BLI_hash_mm2a_end(&m_mm2[0]) << 32) |
+         (uint64_t)BLI_hash_mm2a_end(&m_mm2[1]);
+}
+
+/* Returns false for data-blocks which can change without the node tree being executed again. */
+static bool hash_node_id(const CompositorContext &context, ID *id, BufferCacheHash *hash)
+{
+  hash->add_string(id->name);
+  hash->add_uint64((uint64_t)(intptr_t)id);
+
+  switch (GS(id->name)) {
+    case ID_IM: {
+      /* Generated and viewer images are painted on or written to by Blender itself. */
+      Image *image = (Image *)id;
+      if (!ELEM(image->source, IMA_SRC_FILE, IMA_SRC_SEQUENCE, IMA_SRC_MOVIE)) {
+        return false;
+      }
+      /* Reloading and painting keep the settings, but change the pixels. */
+      hash->add_int(image->update_count);
+      hash->add_string(image->name);
+      hash->add_int(image->source);
+      hash->add_int(image->type);
+      hash->add_dna("ColorManagedColorspaceSettings", &image->colorspace_settings);
+      hash->add_int(image->alpha_mode);
+      return true;
+    }
+    case ID_SCE: {
+      /* Render layers, a new render creates a new result. Rendering also clears the cache, see
+       * #COM_execute. */
+      if (context.isRendering()) {
+        return false;
+      }
+      Render *re = RE_GetSceneRender((Scene *)id);
+      if (re) {
+        RenderResult *rr = RE_AcquireResultRead(re);
+        hash->add_uint64((uint64_t)(intptr_t)rr);
+        RE_ReleaseResult(re);
+      }
+      return true;
+    }
+    default:
+      /* Movie clips, masks and textures are animated or edited outside of the node tree. */
+      return false;
+  }
+}
+
+bool BufferCache::hashNode(const CompositorContext &context, bNode *node, uint64_t *r_hash)
+{
+  BufferCacheHash hash;
+  hash.add_string(node->idname);
+  hash.add_int(node->type);
+  hash.add_int(node->custom1);
+  hash.add_int(node->custom2);
+  hash.add(&node->custom3, sizeof(node->custom3));
+  hash.add(&node->custom4, sizeof(node->custom4));
+
+  if (node->storage) {
+    const char *storagename = node->typeinfo->storagename;
+    if (storagename[0] == '\0') {
+      hash.add(node->storage, MEM_allocN_len(node->storage));
+    }
+    else {
+      hash.add_dna(storagename, node->storage);
+
+      /* Pointers are skipped by the DNA hash, add the data they point to. */
+      if (STREQ(storagename, "CurveMapping")) {
+        const CurveMapping *cumap = (const CurveMapping *)node->storage;
+        for (int i = 0; i < CM_TOT; i++) {
+          if (cumap->cm[i].curve) {
+            hash.add(cumap->cm[i].curve, sizeof(CurveMapPoint) * cumap->cm[i].totpoint);
+          }
+        }
+      }
+      else if (STREQ(storagename, "NodeCryptomatte")) {
+        hash.add_string(((const NodeCryptomatte *)node->storage)->matte_id);
+      }
+    }
+  }
+
+  /* Values of unconnected inputs, which some nodes read directly. */
+  for (bNodeSocket *sock = (bNodeSocket *)node->inputs.first; sock; sock = sock->next) {
+    hash.add_int(sock->type);
+    if (sock->default_value) {
+      hash.add(sock->default_value, MEM_allocN_len(sock->default_value));
+    }
+  }
+
+  if (node->id && !hash_node_id(context, node->id, &hash)) {
+    return false;
+  }
+
+  *r_hash = hash.end();
+  return true;
+}
+
+uint64_t BufferCache::hashContext(const CompositorContext &context)
+{
+  BufferCacheHash hash;
+  hash.add_int(context.getQuality());
+  hash.add_int(context.isFastCalculation());
+  hash.add_int(context.getFramenumber());
+  hash.add_string(context.getViewName());
+  if (context.getViewSettings()) {
+    hash.add_dna("ColorManagedViewSettings", context.getViewSettings());
+  }
+  if (context.getDisplaySettings()) {
+    hash.add_dna("ColorManagedDisplaySettings", context.getDisplaySettings());
+  }
+  return hash.end();
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Cache
+ * \{ */
+
+struct BufferCacheEntry {
+  uint64_t key;
+  MemoryBuffer *buffer;
+  size_t memory_size;
+};
+
+typedef std::list<BufferCacheEntry> BufferCacheEntries;
+
+/* Entries ordered from most to least recently used. */
+static BufferCacheEntries g_cache_lru;
+static std::map<uint64_t, BufferCacheEntries::iterator> g_cache_entries;
+static size_t g_cache_memory_used = 0;
+
+static size_t cache_memory_limit()
+{
+  return (size_t)max_ii(U.compositor_cache_limit, 0) * 1024 * 1024;
+}
+
+static void cache_remove(std::map<uint64_t, BufferCacheEntries::iterator>::iterator it,
+                         bool free_buffer)
+{
+  BufferCacheEntries::iterator entry = it->second;
+  g_cache_memory_used -= entry->memory_size;
+  if (free_buffer) {
+    delete entry->buffer;
+  }
+  g_cache_lru.erase(entry);
+  g_cache_entries.erase(it);
+}
+
+bool BufferCache::isEnabled()
+{
+  return U.compositor_cache_limit > 0;
+}
+
+bool BufferCache::contains(uint64_t key)
+{
+  return g_cache_entries.find(key) != g_cache_entries.end();
+}
+
+MemoryBuffer *BufferCache::take(uint64_t key)
+{
+  std::map<uint64_t, BufferCacheEntries::iterator>::iterator it = g_cache_entries.find(key);
+  if (it == g_cache_entries.end()) {
+    return NULL;
+  }
+  MemoryBuffer *buffer = it->second->buffer;
+  cache_remove(it, false);
+  return buffer;
+}
+
+void BufferCache::store(uint64_t key, MemoryBuffer *buffer)
+{
+  std::map<uint64_t, BufferCacheEntries::iterator>::iterator it = g_cache_entries.find(key);
+  if (it != g_cache_entries.end()) {
+    cache_remove(it, true);
+  }
+
+  const size_t memory_limit = cache_memory_limit();
+  const size_t memory_size = buffer->getMemorySize();
+  if (memory_size > memory_limit) {
+    delete buffer;
+    return;
+  }
+
+  /* Evict least recently used buffers. */
+  while (!g_cache_lru.empty() && g_cache_memory_used + memory_size > memory_limit) {
+    cache_remove(g_cache_entries.find(g_cache_lru.back().key), true);
+  }
+
+  /* The proxy of the buffer does not exist anymore after the execution. */
+  buffer->setMemoryProxy(NULL);
+
+  BufferCacheEntry entry = {key, buffer, memory_size};
+  g_cache_lru.push_front(entry);
+  g_cache_entries[key] = g_cache_lru.begin();
+  g_cache_memory_used += memory_size;
+}
+
+void BufferCache::clear()
+{
+  for (BufferCacheEntries::iterator it = g_cache_lru.begin(); it != g_cache_lru.end(); ++it) {
+    delete it->buffer;
+  }
+  g_cache_lru.clear();
+  g_cache_entries.clear();
+  g_cache_memory_used = 0;
+}
+
+/** \} */
@@ -0,0 +1,104 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __COM_BUFFERCACHE_H__
+#define __COM_BUFFERCACHE_H__
+
+extern "C" {
+#include "BLI_hash_mm2a.h"
+#include "BLI_sys_types.h"
+}
+
+#include "DNA_node_types.h"
+
+class CompositorContext;
+class MemoryBuffer;
+
+/**
+ * \brief 64 bit hash used for the keys of the BufferCache.
+ * \ingroup Memory
+ */
+class BufferCacheHash {
+ private:
+  /* Two independent 32 bit hashes, combined into the 64 bit key. */
+  BLI_HashMurmur2A m_mm2[2];
+
+ public:
+  BufferCacheHash();
+
+  void add(const void *data, size_t len);
+  void add_int(int value);
+  void add_uint64(uint64_t value);
+  void add_string(const char *str);
+  /**
+   * \brief add all non-pointer members of a DNA struct
+   */
+  void add_dna(const char *struct_name, const void *data);
+
+  uint64_t end();
+};
+
+/**
+ * \brief Buffers of write buffer operations, kept across executions of the compositor.
+ *
+ * A buffer is identified by a key hashing all operations which calculate it, including the
+ * settings of their nodes. Changing a node only invalidates the buffers which depend on it, the
+ * other buffers are reused and the operations calculating them are not executed at all.
+ *
+ * Buffers are kept in least recently used order within #UserDef.compositor_cache_limit.
+ * The cache is only used by executions while editing, which run one at a time, see #COM_execute.
+ * \ingroup Memory
+ */
+class BufferCache {
+ public:
+  /**
+   * \brief is caching enabled by the user preferences
+   */
+  static bool isEnabled();
+
+  /**
+   * \brief hash the settings of a node which influence its operations
+   * \return false when the node reads data which is not covered by the hash
+   */
+  static bool hashNode(const CompositorContext &context, bNode *node, uint64_t *r_hash);
+
+  /**
+   * \brief hash the settings of the context which influence all operations
+   */
+  static uint64_t hashContext(const CompositorContext &context);
+
+  static bool contains(uint64_t key);
+
+  /**
+   * \brief take a buffer out of the cache, the caller becomes the owner
+   * \return the buffer, NULL when there is no buffer for the key
+   */
+  static MemoryBuffer *take(uint64_t key);
+
+  /**
+   * \brief add a buffer to the cache, which becomes the owner of the buffer
+   *
+   * Least recently used buffers are freed to stay within the memory limit.
+   */
+  static void store(uint64_t key, MemoryBuffer *buffer);
+
+  /**
+   * \brief free all buffers
+   */
+  static void clear();
+};
+
+#endif /* __COM_BUFFERCACHE_H__ */
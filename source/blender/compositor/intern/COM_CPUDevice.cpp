@@ -18,6 +18,8 @@
 
 #include "COM_CPUDevice.h"
 
+#include "PIL_time.h"
+
 CPUDevice::CPUDevice(int thread_id) : Device(), m_thread_id(thread_id)
 {
 }
@@ -30,7 +32,9 @@ void CPUDevice::execute(WorkPackage *work)
 
   executionGroup->determineChunkRect(&rect, chunkNumber);
 
+  const double time_start = PIL_check_seconds_timer();
   executionGroup->getOutputOperation()->executeRegion(&rect, chunkNumber);
+  executionGroup->addChunkProfile(&rect, PIL_check_seconds_timer() - time_start);
 
   executionGroup->finalizeChunkExecution(chunkNumber, NULL);
 }
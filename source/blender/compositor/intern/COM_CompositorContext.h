@@ -48,6 +48,13 @@ class CompositorContext {
 
   Scene *m_scene;
 
+  /**
+   * \brief Render the composite result is written to.
+   * This field is initialized in ExecutionSystem and must only be read from that point on.
+   * \see COM_execute
+   */
+  struct Render *m_render;
+
   /**
    * \brief Reference to the render data that is being composited.
    * This field is initialized in ExecutionSystem and must only be read from that point on.
@@ -150,6 +157,15 @@ class CompositorContext {
     return m_scene;
   }
 
+  void setRender(struct Render *render)
+  {
+    this->m_render = render;
+  }
+  struct Render *getRender() const
+  {
+    return this->m_render;
+  }
+
   /**
    * \brief set the preview image hash table
    */
@@ -268,6 +284,22 @@ class CompositorContext {
   {
     return (this->getbNodeTree()->flag & NTREE_COM_GROUPNODE_BUFFER) != 0;
   }
+
+  /**
+   * \brief store intermediate buffers as half floats where possible
+   */
+  bool isHalfBufferEnabled() const
+  {
+    return (this->getbNodeTree()->flag & NTREE_COM_HALF_BUFFERS) != 0;
+  }
+
+  /**
+   * \brief record execution time and memory of the nodes, see Profiler
+   */
+  bool isProfileEnabled() const
+  {
+    return (this->getbNodeTree()->flag & NTREE_COM_PROFILE) != 0;
+  }
 };
 
 #endif
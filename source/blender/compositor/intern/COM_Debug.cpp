@@ -530,3 +530,52 @@ void DebugInfo::graphviz(const ExecutionSystem * /*system*/)
 }
 
 #endif
+
+/* Available without COM_DEBUG, to find out where the memory of a composite goes. */
+
+extern "C" {
+#include "BKE_global.h"
+}
+
+#include "COM_ExecutionGroup.h"
+#include "COM_ExecutionSystem.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_WriteBufferOperation.h"
+
+void DebugInfo::memory_report(const ExecutionSystem *system)
+{
+  if ((G.debug & G_DEBUG) == 0) {
+    return;
+  }
+
+  size_t total_size = 0, total_half_size = 0;
+  printf("Compositor buffers:\n");
+  for (int i = 0; i < system->m_groups.size(); i++) {
+    NodeOperation *output = system->m_groups[i]->getOutputOperation();
+    if (!output->isWriteBufferOperation()) {
+      continue;
+    }
+    WriteBufferOperation *write = (WriteBufferOperation *)output;
+    MemoryBuffer *buffer = write->getMemoryProxy()->getBuffer();
+    if (buffer == NULL) {
+      continue;
+    }
+    const size_t size = buffer->getMemorySize();
+    total_size += size;
+    if (buffer->isHalf()) {
+      total_half_size += size;
+    }
+    printf("  Group %2d%s: %5dx%-5d %u channels, %s%s, %8.2f MB\n",
+           i,
+           operation_name(write).empty() ? "" : (" " + operation_name(write)).c_str(),
+           buffer->getWidth(),
+           buffer->getHeight(),
+           buffer->get_num_channels(),
+           buffer->isHalf() ? "half" : "float",
+           write->isCached() ? ", cached" : "",
+           (double)size / (1024.0 * 1024.0));
+  }
+  printf("  Total: %.2f MB, %.2f MB of it as half floats\n",
+         (double)total_size / (1024.0 * 1024.0),
+         (double)total_half_size / (1024.0 * 1024.0));
+}
@@ -53,6 +53,12 @@ class DebugInfo {
 
   static void graphviz(const ExecutionSystem *system);
 
+  /**
+   * \brief print the memory of the buffers of every execution group, with --debug
+   * \note call before the execution is de-initialized, while the buffers are allocated
+   */
+  static void memory_report(const ExecutionSystem *system);
+
 #ifdef COM_DEBUG
  protected:
   static int graphviz_operation(const ExecutionSystem *system,
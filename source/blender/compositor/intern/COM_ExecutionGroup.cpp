@@ -58,7 +58,10 @@ ExecutionGroup::ExecutionGroup()
   this->m_singleThreaded = false;
   this->m_chunksFinished = 0;
   BLI_rcti_init(&this->m_viewerBorder, 0, 0, 0, 0);
+  BLI_rcti_init(&this->m_areaOfInterest, 0, 0, 0, 0);
   this->m_executionStartTime = 0;
+  this->m_profileTime = 0;
+  this->m_profilePixels = 0;
 }
 
 CompositorPriority ExecutionGroup::getRenderPriotrity()
@@ -127,12 +130,17 @@ void ExecutionGroup::initExecution()
   unsigned int index;
   determineNumberOfChunks();
 
+  /* Buffers taken from the cache don't need to be calculated. */
+  NodeOperation *output_operation = this->getOutputOperation();
+  const bool is_cached = output_operation->isWriteBufferOperation() &&
+                         ((WriteBufferOperation *)output_operation)->isCached();
+
   this->m_chunkExecutionStates = NULL;
   if (this->m_numberOfChunks != 0) {
     this->m_chunkExecutionStates = (ChunkExecutionState *)MEM_mallocN(
         sizeof(ChunkExecutionState) * this->m_numberOfChunks, __func__);
     for (index = 0; index < this->m_numberOfChunks; index++) {
-      this->m_chunkExecutionStates[index] = COM_ES_NOT_SCHEDULED;
+      this->m_chunkExecutionStates[index] = is_cached ? COM_ES_EXECUTED : COM_ES_NOT_SCHEDULED;
     }
   }
 
@@ -148,6 +156,78 @@ void ExecutionGroup::initExecution()
   }
   maxNumber++;
   this->m_cachedMaxReadBufferOffset = maxNumber;
+  BLI_rcti_init(&this->m_areaOfInterest, 0, 0, 0, 0);
+  this->m_profileTime = 0;
+  this->m_profilePixels = 0;
+}
+
+bool ExecutionGroup::isFullyExecuted() const
+{
+  if (this->m_viewerBorder.xmin != 0 || this->m_viewerBorder.ymin != 0 ||
+      this->m_viewerBorder.xmax != (int)this->m_width ||
+      this->m_viewerBorder.ymax != (int)this->m_height) {
+    return false;
+  }
+  for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+    if (this->m_chunkExecutionStates[index] != COM_ES_EXECUTED) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ExecutionGroup::addAreaOfInterest(rcti *area)
+{
+  /* Grow the area to the chunks which contain it, those are calculated as a whole. */
+  if (this->m_singleThreaded) {
+    *area = this->m_viewerBorder;
+  }
+  else {
+    const int chunk_size = (int)this->m_chunkSize;
+    const int xmin = max_ii(area->xmin - this->m_viewerBorder.xmin, 0);
+    const int ymin = max_ii(area->ymin - this->m_viewerBorder.ymin, 0);
+    const int xmax = area->xmax - this->m_viewerBorder.xmin;
+    const int ymax = area->ymax - this->m_viewerBorder.ymin;
+    BLI_rcti_init(area,
+                  this->m_viewerBorder.xmin + (xmin / chunk_size) * chunk_size,
+                  this->m_viewerBorder.xmin + ((xmax + chunk_size - 1) / chunk_size) * chunk_size,
+                  this->m_viewerBorder.ymin + (ymin / chunk_size) * chunk_size,
+                  this->m_viewerBorder.ymin + ((ymax + chunk_size - 1) / chunk_size) * chunk_size);
+    if (!BLI_rcti_isect(area, &this->m_viewerBorder, area)) {
+      return;
+    }
+  }
+  if (BLI_rcti_is_empty(area)) {
+    return;
+  }
+
+  if (!BLI_rcti_is_empty(&this->m_areaOfInterest)) {
+    if (BLI_rcti_inside_rcti(&this->m_areaOfInterest, area)) {
+      return;
+    }
+    BLI_rcti_union(area, &this->m_areaOfInterest);
+  }
+  this->m_areaOfInterest = *area;
+
+  /* Buffers taken from the cache don't read their inputs. */
+  NodeOperation *output_operation = this->getOutputOperation();
+  if (output_operation->isWriteBufferOperation() &&
+      ((WriteBufferOperation *)output_operation)->isCached()) {
+    return;
+  }
+
+  for (unsigned int index = 0; index < this->m_cachedReadOperations.size(); index++) {
+    ReadBufferOperation *readOperation =
+        (ReadBufferOperation *)this->m_cachedReadOperations[index];
+    ExecutionGroup *group = readOperation->getMemoryProxy()->getExecutor();
+    if (group == NULL) {
+      continue;
+    }
+    rcti input_area;
+    BLI_rcti_init(&input_area, 0, 0, 0, 0);
+    determineDependingAreaOfInterest(area, readOperation, &input_area);
+    group->addAreaOfInterest(&input_area);
+  }
 }
 
 void ExecutionGroup::deinitExecution()
@@ -403,6 +483,13 @@ MemoryBuffer *ExecutionGroup::constructConsolidatedMemoryBuffer(MemoryProxy *mem
   return result;
 }
 
+void ExecutionGroup::addChunkProfile(const rcti *rect, double time)
+{
+  atomic_add_and_fetch_uint64(&this->m_profileTime, (uint64_t)(time * 1e6));
+  atomic_add_and_fetch_uint64(&this->m_profilePixels,
+                              (uint64_t)BLI_rcti_size_x(rect) * BLI_rcti_size_y(rect));
+}
+
 void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memoryBuffers)
 {
   if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_SCHEDULED) {
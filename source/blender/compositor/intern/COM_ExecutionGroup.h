@@ -173,11 +173,30 @@ class ExecutionGroup {
    */
   rcti m_viewerBorder;
 
+  /**
+   * \brief area of the output which is read by other groups or shown, aligned to chunks
+   * \see addAreaOfInterest
+   */
+  rcti m_areaOfInterest;
+
   /**
    * \brief start time of execution
    */
   double m_executionStartTime;
 
+  /**
+   * \brief time spent on executing the chunks of this group in microseconds, summed over all
+   * devices
+   * \see Profiler
+   */
+  uint64_t m_profileTime;
+
+  /**
+   * \brief number of pixels in the executed chunks
+   * \see Profiler
+   */
+  uint64_t m_profilePixels;
+
   // methods
   /**
    * \brief check whether parameter operation can be added to the execution group
@@ -417,6 +436,62 @@ class ExecutionGroup {
    */
   bool isOpenCL();
 
+  /**
+   * \brief have all chunks of the whole resolution been executed
+   * \note only valid between initExecution and deinitExecution
+   */
+  bool isFullyExecuted() const;
+
+  /**
+   * \brief add an area of the output which has to be calculated
+   *
+   * The area is grown to the chunks containing it. The areas the group reads from its inputs are
+   * added to the groups calculating them, so adding the borders of the output groups gives every
+   * group the area the outputs depend on.
+   * \note only valid between initExecution and deinitExecution
+   * \param area: area in pixel space, is changed to the grown area
+   */
+  void addAreaOfInterest(rcti *area);
+
+  /**
+   * \brief get the border of the output, in pixel space
+   */
+  const rcti *getViewerBorder() const
+  {
+    return &this->m_viewerBorder;
+  }
+
+  /**
+   * \brief get the area added by addAreaOfInterest, empty when nothing depends on this group
+   */
+  const rcti *getAreaOfInterest() const
+  {
+    return &this->m_areaOfInterest;
+  }
+
+  /**
+   * \brief record the execution of a chunk, called by the device which executed it
+   * \param rect: the rect of the chunk
+   * \param time: wall time of the execution in seconds
+   */
+  void addChunkProfile(const rcti *rect, double time);
+
+  /**
+   * \brief get the time spent on executing chunks in seconds
+   */
+  double getProfileTime() const
+  {
+    return this->m_profileTime / 1e6;
+  }
+
+  /**
+   * \brief get the number of pixels of the executed chunks
+   */
+  uint64_t getProfilePixels() const
+  {
+    return this->m_profilePixels;
+  }
+
   void setChunksize(int chunksize)
   {
     this->m_chunkSize = chunksize;
@@ -436,8 +511,9 @@ class ExecutionGroup {
 
   void setRenderBorder(float xmin, float xmax, float ymin, float ymax);
 
-  /* allow the DebugInfo class to look at internals */
+  /* allow the DebugInfo and Profiler classes to look at internals */
   friend class DebugInfo;
+  friend class Profiler;
 
 #ifdef WITH_CXX_GUARDEDALLOC
   MEM_CXX_CLASS_ALLOC_FUNCS("COM:ExecutionGroup")
@@ -33,12 +33,14 @@ extern "C" {
 #include "COM_WorkScheduler.h"
 #include "COM_ReadBufferOperation.h"
 #include "COM_Debug.h"
+#include "COM_Profiler.h"
 
 #ifdef WITH_CXX_GUARDEDALLOC
 #  include "MEM_guardedalloc.h"
 #endif
 
-ExecutionSystem::ExecutionSystem(RenderData *rd,
+ExecutionSystem::ExecutionSystem(struct Render *render,
+                                 RenderData *rd,
                                  Scene *scene,
                                  bNodeTree *editingtree,
                                  bool rendering,
@@ -49,6 +51,7 @@ ExecutionSystem::ExecutionSystem(RenderData *rd,
 {
   this->m_context.setViewName(viewName);
   this->m_context.setScene(scene);
+  this->m_context.setRender(render);
   this->m_context.setbNodeTree(editingtree);
   this->m_context.setPreviewHash(editingtree->previews);
   this->m_context.setFastCalculation(fastcalculation);
@@ -134,6 +137,7 @@ void ExecutionSystem::execute()
   editingtree->stats_draw(editingtree->sdh, IFACE_("Compositing | Initializing execution"));
 
   DebugInfo::execute_started(this);
+  Profiler profiler(this->m_context);
 
   unsigned int order = 0;
   for (vector<NodeOperation *>::iterator iter = this->m_operations.begin();
@@ -148,12 +152,23 @@ void ExecutionSystem::execute()
   }
   unsigned int index;
 
+  for (index = 0; index < this->m_groups.size(); index++) {
+    ExecutionGroup *executionGroup = this->m_groups[index];
+    executionGroup->setChunksize(this->m_context.getChunksize());
+    executionGroup->initExecution();
+  }
+
+  // Determine the areas of the write buffers to allocate
+  determineAreasOfInterest();
+
   // First allocale all write buffer
   for (index = 0; index < this->m_operations.size(); index++) {
     NodeOperation *operation = this->m_operations[index];
     if (operation->isWriteBufferOperation()) {
       operation->setbNodeTree(this->m_context.getbNodeTree());
+      const double time_start = PIL_check_seconds_timer();
       operation->initExecution();
+      profiler.operationInitialized(operation, PIL_check_seconds_timer() - time_start);
     }
   }
   // Connect read buffers to their write buffers
@@ -169,14 +184,11 @@ void ExecutionSystem::execute()
     NodeOperation *operation = this->m_operations[index];
     if (!operation->isWriteBufferOperation()) {
       operation->setbNodeTree(this->m_context.getbNodeTree());
+      const double time_start = PIL_check_seconds_timer();
       operation->initExecution();
+      profiler.operationInitialized(operation, PIL_check_seconds_timer() - time_start);
     }
   }
-  for (index = 0; index < this->m_groups.size(); index++) {
-    ExecutionGroup *executionGroup = this->m_groups[index];
-    executionGroup->setChunksize(this->m_context.getChunksize());
-    executionGroup->initExecution();
-  }
 
   WorkScheduler::start(this->m_context);
 
@@ -189,6 +201,9 @@ void ExecutionSystem::execute()
   WorkScheduler::finish();
   WorkScheduler::stop();
 
+  DebugInfo::memory_report(this);
+  profiler.executionFinished(this);
+
   editingtree->stats_draw(editingtree->sdh, IFACE_("Compositing | De-initializing execution"));
   for (index = 0; index < this->m_operations.size(); index++) {
     NodeOperation *operation = this->m_operations[index];
@@ -200,6 +215,26 @@ void ExecutionSystem::execute()
   }
 }
 
+void ExecutionSystem::determineAreasOfInterest()
+{
+  vector<ExecutionGroup *> executionGroups;
+  this->findOutputExecutionGroup(&executionGroups, COM_PRIORITY_HIGH);
+  if (!this->getContext().isFastCalculation()) {
+    this->findOutputExecutionGroup(&executionGroups, COM_PRIORITY_MEDIUM);
+    this->findOutputExecutionGroup(&executionGroups, COM_PRIORITY_LOW);
+  }
+
+  /* Outputs calculate all chunks within their border, see ExecutionGroup.execute. */
+  for (unsigned int index = 0; index < executionGroups.size(); index++) {
+    ExecutionGroup *group = executionGroups[index];
+    if (group->getWidth() == 0 || group->getHeight() == 0) {
+      continue;
+    }
+    rcti area = *group->getViewerBorder();
+    group->addAreaOfInterest(&area);
+  }
+}
+
 void ExecutionSystem::executeGroups(CompositorPriority priority)
 {
   unsigned int index;
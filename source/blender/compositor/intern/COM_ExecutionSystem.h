@@ -154,7 +154,8 @@ class ExecutionSystem {
    * \param editingtree: [bNodeTree *]
    * \param rendering: [true false]
    */
-  ExecutionSystem(RenderData *rd,
+  ExecutionSystem(struct Render *render,
+                  RenderData *rd,
                   Scene *scene,
                   bNodeTree *editingtree,
                   bool rendering,
@@ -189,8 +190,15 @@ class ExecutionSystem {
  private:
   void executeGroups(CompositorPriority priority);
 
-  /* allow the DebugInfo class to look at internals */
+  /**
+   * \brief propagate the borders of the output groups to all groups, see
+   * ExecutionGroup.addAreaOfInterest
+   */
+  void determineAreasOfInterest();
+
+  /* allow the DebugInfo and Profiler classes to look at internals */
   friend class DebugInfo;
+  friend class Profiler;
 
 #ifdef WITH_CXX_GUARDEDALLOC
   MEM_CXX_CLASS_ALLOC_FUNCS("COM:ExecutionSystem")
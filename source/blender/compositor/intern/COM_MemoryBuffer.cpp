@@ -58,8 +58,18 @@ MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, r
   this->m_memoryProxy = memoryProxy;
   this->m_chunkNumber = chunkNumber;
   this->m_num_channels = determine_num_channels(memoryProxy->getDataType());
-  this->m_buffer = (float *)MEM_mallocN_aligned(
-      sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
+  if (memoryProxy->useHalf()) {
+    this->m_buffer = NULL;
+    this->m_half_buffer = (unsigned short *)MEM_mallocN_aligned(
+        sizeof(unsigned short) * determineBufferSize() * this->m_num_channels,
+        16,
+        "COM_MemoryBuffer");
+  }
+  else {
+    this->m_buffer = (float *)MEM_mallocN_aligned(
+        sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
+    this->m_half_buffer = NULL;
+  }
   this->m_state = COM_MB_ALLOCATED;
   this->m_datatype = memoryProxy->getDataType();
 }
@@ -74,6 +84,7 @@ MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect)
   this->m_num_channels = determine_num_channels(memoryProxy->getDataType());
   this->m_buffer = (float *)MEM_mallocN_aligned(
       sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
+  this->m_half_buffer = NULL;
   this->m_state = COM_MB_TEMPORARILY;
   this->m_datatype = memoryProxy->getDataType();
 }
@@ -88,28 +99,52 @@ MemoryBuffer::MemoryBuffer(DataType dataType, rcti *rect)
   this->m_num_channels = determine_num_channels(dataType);
   this->m_buffer = (float *)MEM_mallocN_aligned(
       sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
+  this->m_half_buffer = NULL;
   this->m_state = COM_MB_TEMPORARILY;
   this->m_datatype = dataType;
 }
+size_t MemoryBuffer::getMemorySize() const
+{
+  const size_t elem_size = this->isHalf() ? sizeof(unsigned short) : sizeof(float);
+  return elem_size * this->m_num_channels * this->m_width * this->m_height;
+}
+
 MemoryBuffer *MemoryBuffer::duplicate()
 {
   MemoryBuffer *result = new MemoryBuffer(this->m_memoryProxy, &this->m_rect);
-  memcpy(result->m_buffer,
-         this->m_buffer,
-         this->determineBufferSize() * this->m_num_channels * sizeof(float));
+  if (this->isHalf()) {
+    result->copyContentFrom(this);
+  }
+  else {
+    memcpy(result->m_buffer,
+           this->m_buffer,
+           this->determineBufferSize() * this->m_num_channels * sizeof(float));
+  }
   return result;
 }
 void MemoryBuffer::clear()
 {
-  memset(this->m_buffer, 0, this->determineBufferSize() * this->m_num_channels * sizeof(float));
+  /* A half float of zero has all bits cleared as well. */
+  memset(this->isHalf() ? (void *)this->m_half_buffer : (void *)this->m_buffer,
+         0,
+         this->getMemorySize());
 }
 
 float MemoryBuffer::getMaximumValue()
 {
-  float result = this->m_buffer[0];
   const unsigned int size = this->determineBufferSize();
   unsigned int i;
 
+  if (this->isHalf()) {
+    const unsigned short *hp_src = this->m_half_buffer;
+    float result = half_to_float(hp_src[0]);
+    for (i = 0; i < size; i++, hp_src += this->m_num_channels) {
+      result = max_ff(result, half_to_float(*hp_src));
+    }
+    return result;
+  }
+
+  float result = this->m_buffer[0];
   const float *fp_src = this->m_buffer;
 
   for (i = 0; i < size; i++, fp_src += this->m_num_channels) {
@@ -148,6 +183,10 @@ MemoryBuffer::~MemoryBuffer()
     MEM_freeN(this->m_buffer);
     this->m_buffer = NULL;
   }
+  if (this->m_half_buffer) {
+    MEM_freeN(this->m_half_buffer);
+    this->m_half_buffer = NULL;
+  }
 }
 
 void MemoryBuffer::copyContentFrom(MemoryBuffer *otherBuffer)
@@ -170,9 +209,27 @@ void MemoryBuffer::copyContentFrom(MemoryBuffer *otherBuffer)
                   this->m_num_channels;
     offset = ((otherY - this->m_rect.ymin) * this->m_width + minX - this->m_rect.xmin) *
              this->m_num_channels;
-    memcpy(&this->m_buffer[offset],
-           &otherBuffer->m_buffer[otherOffset],
-           (maxX - minX) * this->m_num_channels * sizeof(float));
+    const unsigned int len = (maxX - minX) * this->m_num_channels;
+    if (this->isHalf() == otherBuffer->isHalf()) {
+      if (this->isHalf()) {
+        memcpy(&this->m_half_buffer[offset],
+               &otherBuffer->m_half_buffer[otherOffset],
+               len * sizeof(unsigned short));
+      }
+      else {
+        memcpy(&this->m_buffer[offset], &otherBuffer->m_buffer[otherOffset], len * sizeof(float));
+      }
+    }
+    else if (this->isHalf()) {
+      for (unsigned int i = 0; i < len; i++) {
+        this->m_half_buffer[offset + i] = float_to_half(otherBuffer->m_buffer[otherOffset + i]);
+      }
+    }
+    else {
+      for (unsigned int i = 0; i < len; i++) {
+        this->m_buffer[offset + i] = half_to_float(otherBuffer->m_half_buffer[otherOffset + i]);
+      }
+    }
   }
 }
 
@@ -182,7 +239,7 @@ void MemoryBuffer::writePixel(int x, int y, const float color[4])
       y < this->m_rect.ymax) {
     const int offset = (this->m_width * (y - this->m_rect.ymin) + x - this->m_rect.xmin) *
                        this->m_num_channels;
-    memcpy(&this->m_buffer[offset], color, sizeof(float) * this->m_num_channels);
+    this->writeElem(offset, color);
   }
 }
 
@@ -192,6 +249,15 @@ void MemoryBuffer::addPixel(int x, int y, const float color[4])
       y < this->m_rect.ymax) {
     const int offset = (this->m_width * (y - this->m_rect.ymin) + x - this->m_rect.xmin) *
                        this->m_num_channels;
+    if (this->isHalf()) {
+      float sum[4];
+      this->readElem(sum, offset);
+      for (int i = 0; i < this->m_num_channels; i++) {
+        sum[i] += color[i];
+      }
+      this->writeElem(offset, sum);
+      return;
+    }
     float *dst = &this->m_buffer[offset];
     const float *src = color;
     for (int i = 0; i < this->m_num_channels; i++, dst++, src++) {
@@ -200,10 +266,63 @@ void MemoryBuffer::addPixel(int x, int y, const float color[4])
   }
 }
 
+void MemoryBuffer::readBilinearHalf(float *result, float u, float v, bool wrap_x, bool wrap_y)
+{
+  /* Same as BLI_bilinear_interpolation_wrap_fl, on half floats. */
+  int x1 = (int)floorf(u);
+  int x2 = (int)ceilf(u);
+  int y1 = (int)floorf(v);
+  int y2 = (int)ceilf(v);
+
+  if (wrap_x) {
+    if (x1 < 0) {
+      x1 = this->m_width - 1;
+    }
+    if (x2 >= this->m_width) {
+      x2 = 0;
+    }
+  }
+  else if (x2 < 0 || x1 >= this->m_width) {
+    copy_vn_fl(result, this->m_num_channels, 0.0f);
+    return;
+  }
+
+  if (wrap_y) {
+    if (y1 < 0) {
+      y1 = this->m_height - 1;
+    }
+    if (y2 >= this->m_height) {
+      y2 = 0;
+    }
+  }
+  else if (y2 < 0 || y1 >= this->m_height) {
+    copy_vn_fl(result, this->m_num_channels, 0.0f);
+    return;
+  }
+
+  /* Sample including outside of edges of the buffer. */
+  const int xs[4] = {x1, x1, x2, x2};
+  const int ys[4] = {y1, y2, y1, y2};
+  const float a = u - floorf(u);
+  const float b = v - floorf(v);
+  const float weights[4] = {(1.0f - a) * (1.0f - b), (1.0f - a) * b, a * (1.0f - b), a * b};
+
+  copy_vn_fl(result, this->m_num_channels, 0.0f);
+  for (int i = 0; i < 4; i++) {
+    if (xs[i] < 0 || ys[i] < 0 || xs[i] >= this->m_width || ys[i] >= this->m_height) {
+      continue;
+    }
+    float color[4];
+    this->readElem(color, (ys[i] * this->m_width + xs[i]) * this->m_num_channels);
+    madd_vn_vn(result, color, weights[i], this->m_num_channels);
+  }
+}
+
 static void read_ewa_pixel_sampled(void *userdata, int x, int y, float result[4])
 {
   MemoryBuffer *buffer = (MemoryBuffer *)userdata;
-  buffer->read(result, x, y);
+  /* The filter works relative to the rect of the buffer. */
+  buffer->read(result, x + buffer->getRect()->xmin, y + buffer->getRect()->ymin);
 }
 
 void MemoryBuffer::readEWA(float *result, const float uv[2], const float derivatives[2][2])
@@ -214,7 +333,8 @@ void MemoryBuffer::readEWA(float *result, const float uv[2], const float derivat
    * but compositor uses pixel space. For now let's just divide the values and
    * switch compositor to normalized space for EWA later.
    */
-  float uv_normal[2] = {uv[0] * inv_width, uv[1] * inv_height};
+  float uv_normal[2] = {(uv[0] - this->m_rect.xmin) * inv_width,
+                       (uv[1] - this->m_rect.ymin) * inv_height};
   float du_normal[2] = {derivatives[0][0] * inv_width, derivatives[0][1] * inv_height};
   float dv_normal[2] = {derivatives[1][0] * inv_width, derivatives[1][1] * inv_height};
 
@@ -52,8 +52,73 @@ typedef enum MemoryBufferExtend {
 
 class MemoryProxy;
 
+/**
+ * \brief convert a float to a half float, rounding to the nearest value
+ * Values out of the half range become infinite, NaN stays NaN.
+ */
+inline unsigned short float_to_half(float f)
+{
+  union {
+    float f;
+    unsigned int u;
+  } value, denorm_magic;
+  value.f = f;
+  const unsigned int sign = value.u & 0x80000000u;
+  value.u ^= sign;
+
+  unsigned short half;
+  if (value.u >= (143u << 23)) {
+    /* Out of range, infinite or NaN. */
+    half = (value.u > (255u << 23)) ? 0x7e00 : 0x7c00;
+  }
+  else if (value.u < (113u << 23)) {
+    /* Denormal or zero, let the float addition do the rounding. */
+    denorm_magic.u = 126u << 23;
+    value.f += denorm_magic.f;
+    half = (unsigned short)(value.u - denorm_magic.u);
+  }
+  else {
+    /* Adjust the exponent and round the mantissa to nearest even. */
+    const unsigned int mant_odd = (value.u >> 13) & 1;
+    value.u += 0xc8000fffu + mant_odd;
+    half = (unsigned short)(value.u >> 13);
+  }
+  return half | (unsigned short)(sign >> 16);
+}
+
+/**
+ * \brief convert a half float to a float, which is exact
+ */
+inline float half_to_float(unsigned short half)
+{
+  union {
+    float f;
+    unsigned int u;
+  } value, magic;
+  const unsigned int exp_mask = 0x7c00u << 13;
+  value.u = (half & 0x7fffu) << 13;
+  const unsigned int exp = value.u & exp_mask;
+  value.u += (127u - 15u) << 23;
+  if (exp == exp_mask) {
+    /* Infinite or NaN. */
+    value.u += (128u - 16u) << 23;
+  }
+  else if (exp == 0) {
+    /* Denormal or zero, renormalize. */
+    magic.u = 113u << 23;
+    value.u += 1u << 23;
+    value.f -= magic.f;
+  }
+  value.u |= (unsigned int)(half & 0x8000u) << 16;
+  return value.f;
+}
+
 /**
  * \brief a MemoryBuffer contains access to the data of a chunk
+ *
+ * Buffers of a MemoryProxy can be stored as half floats to save memory, see
+ * MemoryProxy.setUseHalf. Those are converted on read and write, and can't be accessed directly
+ * with getBuffer and getElem.
  */
 class MemoryBuffer {
  private:
@@ -88,6 +153,11 @@ class MemoryBuffer {
    */
   float *m_buffer;
 
+  /**
+   * \brief the data when stored as half floats, m_buffer is NULL in that case
+   */
+  unsigned short *m_half_buffer;
+
   /**
    * \brief the number of channels of a single value in the buffer.
    * For value buffers this is 1, vector 3 and color 4
@@ -118,6 +188,14 @@ class MemoryBuffer {
    */
   ~MemoryBuffer();
 
+  /**
+   * \brief move the buffer to another MemoryProxy, used for buffers kept across executions
+   */
+  void setMemoryProxy(MemoryProxy *memoryProxy)
+  {
+    this->m_memoryProxy = memoryProxy;
+  }
+
   /**
    * \brief read the ChunkNumber of this MemoryBuffer
    */
@@ -131,15 +209,41 @@ class MemoryBuffer {
     return this->m_num_channels;
   }
 
+  /**
+   * \brief is the data stored as half floats
+   */
+  bool isHalf() const
+  {
+    return this->m_half_buffer != NULL;
+  }
+
+  /**
+   * \brief size of the data in bytes
+   */
+  size_t getMemorySize() const;
+
   /**
    * \brief get the data of this MemoryBuffer
    * \note buffer should already be available in memory
    */
   float *getBuffer()
   {
+    BLI_assert(!this->isHalf());
     return this->m_buffer;
   }
 
+  /**
+   * \brief get the address of a pixel, which has to be inside the rect of this buffer
+   * \note pixels of a row are stored next to each other, this can be used to loop over rows
+   */
+  inline float *getElem(int x, int y)
+  {
+    BLI_assert(x >= m_rect.xmin && x < m_rect.xmax && y >= m_rect.ymin && y < m_rect.ymax);
+    BLI_assert(!this->isHalf());
+    return &this->m_buffer[((y - m_rect.ymin) * this->m_width + (x - m_rect.xmin)) *
+                           this->m_num_channels];
+  }
+
   /**
    * \brief after execution the state will be set to available by calling this method
    */
@@ -163,7 +267,7 @@ class MemoryBuffer {
           x = 0;
         }
         if (x >= w) {
-          x = w;
+          x = w - 1;
         }
         break;
       case COM_MB_REPEAT:
@@ -179,7 +283,7 @@ class MemoryBuffer {
           y = 0;
         }
         if (y >= h) {
-          y = h;
+          y = h - 1;
         }
         break;
       case COM_MB_REPEAT:
@@ -247,9 +351,8 @@ class MemoryBuffer {
       int u = x;
       int v = y;
       this->wrap_pixel(u, v, extend_x, extend_y);
-      const int offset = (this->m_width * y + x) * this->m_num_channels;
-      float *buffer = &this->m_buffer[offset];
-      memcpy(result, buffer, sizeof(float) * this->m_num_channels);
+      const int offset = (this->m_width * v + u) * this->m_num_channels;
+      this->readElem(result, offset);
     }
   }
 
@@ -274,8 +377,7 @@ class MemoryBuffer {
     BLI_assert((int)(MEM_allocN_len(this->m_buffer) / sizeof(*this->m_buffer)) ==
                (int)(this->determineBufferSize() * COM_NUMBER_OF_CHANNELS));
 #endif
-    float *buffer = &this->m_buffer[offset];
-    memcpy(result, buffer, sizeof(float) * this->m_num_channels);
+    this->readElem(result, offset);
   }
 
   void writePixel(int x, int y, const float color[4]);
@@ -294,6 +396,10 @@ class MemoryBuffer {
       copy_vn_fl(result, this->m_num_channels, 0.0f);
       return;
     }
+    if (this->isHalf()) {
+      this->readBilinearHalf(result, u, v, extend_x == COM_MB_REPEAT, extend_y == COM_MB_REPEAT);
+      return;
+    }
     BLI_bilinear_interpolation_wrap_fl(this->m_buffer,
                                        result,
                                        this->m_width,
@@ -355,6 +461,40 @@ class MemoryBuffer {
  private:
   unsigned int determineBufferSize();
 
+  /**
+   * \brief read the value at an offset in the data, converting half floats
+   */
+  inline void readElem(float *result, int offset)
+  {
+    if (this->m_half_buffer) {
+      const unsigned short *half = &this->m_half_buffer[offset];
+      for (unsigned int i = 0; i < this->m_num_channels; i++) {
+        result[i] = half_to_float(half[i]);
+      }
+    }
+    else {
+      memcpy(result, &this->m_buffer[offset], sizeof(float) * this->m_num_channels);
+    }
+  }
+
+  /**
+   * \brief write a value at an offset in the data, converting to half floats
+   */
+  inline void writeElem(int offset, const float *value)
+  {
+    if (this->m_half_buffer) {
+      unsigned short *half = &this->m_half_buffer[offset];
+      for (unsigned int i = 0; i < this->m_num_channels; i++) {
+        half[i] = float_to_half(value[i]);
+      }
+    }
+    else {
+      memcpy(&this->m_buffer[offset], value, sizeof(float) * this->m_num_channels);
+    }
+  }
+
+  void readBilinearHalf(float *result, float u, float v, bool wrap_x, bool wrap_y);
+
 #ifdef WITH_CXX_GUARDEDALLOC
   MEM_CXX_CLASS_ALLOC_FUNCS("COM:MemoryBuffer")
 #endif
@@ -23,6 +23,8 @@ MemoryProxy::MemoryProxy(DataType datatype)
   this->m_writeBufferOperation = NULL;
   this->m_executor = NULL;
   this->m_datatype = datatype;
+  this->m_use_half = false;
+  this->m_use_area = false;
 }
 
 void MemoryProxy::allocate(unsigned int width, unsigned int height)
@@ -36,6 +38,11 @@ void MemoryProxy::allocate(unsigned int width, unsigned int height)
   this->m_buffer = new MemoryBuffer(this, 1, &result);
 }
 
+void MemoryProxy::allocate(rcti *area)
+{
+  this->m_buffer = new MemoryBuffer(this, 1, area);
+}
+
 void MemoryProxy::free()
 {
   if (this->m_buffer) {
@@ -43,3 +50,17 @@ void MemoryProxy::free()
     this->m_buffer = NULL;
   }
 }
+
+void MemoryProxy::setBuffer(MemoryBuffer *buffer)
+{
+  BLI_assert(this->m_buffer == NULL || this->m_buffer == buffer);
+  buffer->setMemoryProxy(this);
+  this->m_buffer = buffer;
+}
+
+MemoryBuffer *MemoryProxy::releaseBuffer()
+{
+  MemoryBuffer *buffer = this->m_buffer;
+  this->m_buffer = NULL;
+  return buffer;
+}
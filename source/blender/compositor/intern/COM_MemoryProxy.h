@@ -63,6 +63,16 @@ class MemoryProxy {
    */
   DataType m_datatype;
 
+  /**
+   * \brief store the buffer as half floats
+   */
+  bool m_use_half;
+
+  /**
+   * \brief only allocate the area of interest of the executor
+   */
+  bool m_use_area;
+
  public:
   MemoryProxy(DataType type);
 
@@ -106,11 +116,26 @@ class MemoryProxy {
    */
   void allocate(unsigned int width, unsigned int height);
 
+  /**
+   * \brief allocate memory for an area, reading outside of it gives zero
+   */
+  void allocate(rcti *area);
+
   /**
    * \brief free the allocated memory
    */
   void free();
 
+  /**
+   * \brief use an existing buffer instead of allocating one, the proxy becomes the owner
+   */
+  void setBuffer(MemoryBuffer *buffer);
+
+  /**
+   * \brief take the buffer out of the proxy, the caller becomes the owner
+   */
+  MemoryBuffer *releaseBuffer();
+
   /**
    * \brief get the allocated memory
    */
@@ -124,6 +149,35 @@ class MemoryProxy {
     return this->m_datatype;
   }
 
+  /**
+   * \brief store the buffer as half floats, halving its memory usage
+   * \note only valid when all readers access the buffer through MemoryBuffer.read and
+   * MemoryBuffer.readBilinear, see NodeOperationBuilder.add_half_buffers
+   */
+  void setUseHalf(bool use_half)
+  {
+    this->m_use_half = use_half;
+  }
+
+  bool useHalf() const
+  {
+    return this->m_use_half;
+  }
+
+  /**
+   * \brief only allocate the area other groups read, see ExecutionGroup.addAreaOfInterest
+   * \note same requirements as setUseHalf, readers have to support buffers not starting at zero
+   */
+  void setUseArea(bool use_area)
+  {
+    this->m_use_area = use_area;
+  }
+
+  bool useArea() const
+  {
+    return this->m_use_area;
+  }
+
 #ifdef WITH_CXX_GUARDEDALLOC
   MEM_CXX_CLASS_ALLOC_FUNCS("COM:MemoryProxy")
 #endif
@@ -23,6 +23,9 @@
 #include "COM_ExecutionSystem.h"
 
 #include "COM_NodeOperation.h" /* own include */
+#include "COM_ReadBufferOperation.h"
+
+#include "MEM_guardedalloc.h"
 
 /*******************
  **** NodeOperation ****
@@ -36,7 +39,10 @@ NodeOperation::NodeOperation()
   this->m_height = 0;
   this->m_isResolutionSet = false;
   this->m_openCL = false;
+  this->m_areaOperation = false;
+  this->m_pointwise = false;
   this->m_btree = NULL;
+  this->m_bnode = NULL;
 }
 
 NodeOperation::~NodeOperation()
@@ -150,6 +156,64 @@ NodeOperation *NodeOperation::getInputOperation(unsigned int inputSocketIndex)
   }
 }
 
+void NodeOperation::readArea(MemoryBuffer *output, rcti *area)
+{
+  if (!this->isAreaOperation()) {
+    /* Complex operations are only read by write buffers, which handle them. */
+    BLI_assert(!this->isComplex());
+    float color[4];
+    for (int y = area->ymin; y < area->ymax; y++) {
+      for (int x = area->xmin; x < area->xmax; x++) {
+        this->readSampled(color, x, y, COM_PS_NEAREST);
+        output->writePixel(x, y, color);
+      }
+    }
+    return;
+  }
+
+  const unsigned int num_inputs = this->getNumberOfInputSockets();
+  MemoryBuffer **inputs = NULL;
+  if (num_inputs > 0) {
+    inputs = (MemoryBuffer **)MEM_callocN(sizeof(MemoryBuffer *) * num_inputs, __func__);
+  }
+
+  for (unsigned int index = 0; index < num_inputs; index++) {
+    NodeOperation *operation = this->getInputOperation(index);
+    BLI_assert(operation != NULL);
+    /* Use the buffer of a read buffer operation directly when it covers the area. */
+    if (operation->isReadBufferOperation()) {
+      inputs[index] = ((ReadBufferOperation *)operation)->getAreaBuffer(area);
+    }
+    if (inputs[index] == NULL) {
+      inputs[index] = new MemoryBuffer(this->getInputSocket(index)->getDataType(), area);
+      operation->readArea(inputs[index], area);
+    }
+  }
+
+  this->executeArea(output, area, inputs);
+
+  for (unsigned int index = 0; index < num_inputs; index++) {
+    if (inputs[index]->isTemporarily()) {
+      delete inputs[index];
+    }
+  }
+  if (inputs) {
+    MEM_freeN(inputs);
+  }
+}
+
+MemoryBuffer *NodeOperation::readInputArea(unsigned int inputSocketIndex, rcti *area)
+{
+  NodeOperation *operation = this->getInputOperation(inputSocketIndex);
+  if (!this->useBufferExecution() || operation == NULL || !operation->isAreaOperation()) {
+    return NULL;
+  }
+  MemoryBuffer *buffer = new MemoryBuffer(this->getInputSocket(inputSocketIndex)->getDataType(),
+                                          area);
+  operation->readArea(buffer, area);
+  return buffer;
+}
+
 void NodeOperation::getConnectedInputSockets(Inputs *sockets)
 {
   for (Inputs::const_iterator it = m_inputs.begin(); it != m_inputs.end(); ++it) {
@@ -105,6 +105,18 @@ class NodeOperation : public SocketReader {
    */
   bool m_openCL;
 
+  /**
+   * \brief can this operation calculate whole areas at once.
+   * \see NodeOperation.executeArea
+   */
+  bool m_areaOperation;
+
+  /**
+   * \brief does the output of a pixel only depend on the inputs at the same pixel.
+   * \see NodeOperation.setPointwise
+   */
+  bool m_pointwise;
+
   /**
    * \brief mutex reference for very special node initializations
    * \note only use when you really know what you are doing.
@@ -121,6 +133,12 @@ class NodeOperation : public SocketReader {
    */
   const bNodeTree *m_btree;
 
+  /**
+   * \brief the node this operation was created for, NULL for operations added by the compiler
+   * \see Profiler
+   */
+  bNode *m_bnode;
+
   /**
    * \brief set to truth when resolution for this operation is set
    */
@@ -190,6 +208,18 @@ class NodeOperation : public SocketReader {
   {
     this->m_btree = tree;
   }
+  const bNodeTree *getbNodeTree() const
+  {
+    return this->m_btree;
+  }
+  void setbNode(bNode *node)
+  {
+    this->m_bnode = node;
+  }
+  bNode *getbNode() const
+  {
+    return this->m_bnode;
+  }
   virtual void initExecution();
 
   /**
@@ -248,6 +278,29 @@ class NodeOperation : public SocketReader {
   }
   virtual void deinitExecution();
 
+  /**
+   * \brief calculate all pixels of an area at once, used by the buffer execution mode.
+   * \ingroup execution
+   * \note only called for operations which are marked with setAreaOperation
+   * \param output: the buffer to write to, its rect contains the area
+   * \param area: the area to calculate
+   * \param inputs: a buffer per input socket, containing the same area
+   */
+  virtual void executeArea(MemoryBuffer * /*output*/, rcti * /*area*/, MemoryBuffer ** /*inputs*/)
+  {
+  }
+
+  /**
+   * \brief calculate an area of the output of this operation into a buffer.
+   * \ingroup execution
+   *
+   * Area operations get all their inputs calculated into buffers first, other operations are
+   * evaluated pixel by pixel.
+   * \param output: the buffer to write to, its rect contains the area
+   * \param area: the area to calculate
+   */
+  void readArea(MemoryBuffer *output, rcti *area);
+
   bool isResolutionSet()
   {
     return this->m_isResolutionSet;
@@ -346,6 +399,30 @@ class NodeOperation : public SocketReader {
     return this->m_openCL;
   }
 
+  /**
+   * \brief can this NodeOperation calculate whole areas at once
+   * \see NodeOperation.executeArea
+   */
+  bool isAreaOperation() const
+  {
+    return this->m_areaOperation;
+  }
+
+  /**
+   * \brief does the output of a pixel only depend on the inputs at the same pixel.
+   * \see NodeOperationBuilder.fold_constant_operations
+   * \see NodeOperationBuilder.fuse_pointwise_operations
+   */
+  bool isPointwise() const
+  {
+    return this->m_pointwise;
+  }
+
+  virtual bool isFusedOperation() const
+  {
+    return false;
+  }
+
   virtual bool isViewerOperation() const
   {
     return false;
@@ -373,6 +450,14 @@ class NodeOperation : public SocketReader {
     return this->m_btree->test_break(this->m_btree->tbh);
   }
 
+  /**
+   * \brief is the buffer execution mode enabled for the tree of this operation
+   */
+  inline bool useBufferExecution() const
+  {
+    return (this->m_btree->flag & NTREE_COM_BUFFER_EXECUTION) != 0;
+  }
+
   inline void updateDraw()
   {
     if (this->m_btree->update_draw) {
@@ -399,6 +484,13 @@ class NodeOperation : public SocketReader {
   SocketReader *getInputSocketReader(unsigned int inputSocketindex);
   NodeOperation *getInputOperation(unsigned int inputSocketindex);
 
+  /**
+   * \brief calculate an area of an input at once, when the buffer execution mode is used
+   * \return a temporarily buffer to be freed by the caller,
+   * or NULL when the input is to be read pixel by pixel
+   */
+  MemoryBuffer *readInputArea(unsigned int inputSocketIndex, rcti *area);
+
   void deinitMutex();
   void initMutex();
   void lockMutex();
@@ -423,6 +515,27 @@ class NodeOperation : public SocketReader {
     this->m_openCL = openCL;
   }
 
+  /**
+   * \brief set if this NodeOperation implements executeArea
+   */
+  void setAreaOperation(bool areaOperation)
+  {
+    this->m_areaOperation = areaOperation;
+  }
+
+  /**
+   * \brief set if the output of a pixel only depends on the inputs at the same pixel
+   *
+   * The inputs must only be read in executePixelSampled, at the coordinates and with the sampler
+   * it is called with, and the result must not depend on anything else than the settings of the
+   * operation. Constant inputs of these operations are folded into a constant, and chains of
+   * them are fused into a single operation.
+   */
+  void setPointwise(bool pointwise)
+  {
+    this->m_pointwise = pointwise;
+  }
+
   /* allow the DebugInfo class to look at internals */
   friend class DebugInfo;
 
@@ -16,8 +16,13 @@
  * Copyright 2013, Blender Foundation.
  */
 
+#include <algorithm>
+#include <typeinfo>
+
 extern "C" {
 #include "BLI_utildefines.h"
+
+#include "BKE_global.h"
 }
 
 #include "COM_NodeConverter.h"
@@ -28,6 +33,7 @@ extern "C" {
 #include "COM_SocketProxyNode.h"
 
 #include "COM_NodeOperation.h"
+#include "COM_FusedOperation.h"
 #include "COM_PreviewOperation.h"
 #include "COM_SetValueOperation.h"
 #include "COM_SetVectorOperation.h"
@@ -37,11 +43,16 @@ extern "C" {
 #include "COM_WriteBufferOperation.h"
 #include "COM_ViewerOperation.h"
 
+#include "COM_BufferCache.h"
 #include "COM_NodeOperationBuilder.h" /* own include */
 
 NodeOperationBuilder::NodeOperationBuilder(const CompositorContext *context, bNodeTree *b_nodetree)
     : m_context(context), m_current_node(NULL), m_active_viewer(NULL)
 {
+  m_use_buffer_cache = !context->isRendering() && BufferCache::isEnabled();
+  m_current_node_hash = 0;
+  m_current_node_cacheable = false;
+  m_current_node_operations_num = 0;
   m_graph.from_bNodeTree(*context, b_nodetree);
 }
 
@@ -58,6 +69,12 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
     Node *node = (Node *)m_graph.nodes()[index];
 
     m_current_node = node;
+    if (m_use_buffer_cache) {
+      m_current_node_cacheable = (node->getbNode() == NULL) ||
+                                 BufferCache::hashNode(
+                                     *m_context, node->getbNode(), &m_current_node_hash);
+      m_current_node_operations_num = 0;
+    }
 
     DebugInfo::node_to_operations(node);
     node->convertToOperations(converter, *m_context);
@@ -104,11 +121,35 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 
   add_datatype_conversions();
 
+  const int num_operations = m_operations.size();
+
+  /* calculate constant parts of the graph once instead of for every pixel */
+  fold_constant_operations();
+
   determineResolutions();
 
+  /* calculate chains of pointwise operations together, pixel by pixel */
+  fuse_pointwise_operations();
+
+  if (G.debug & G_DEBUG) {
+    printf(
+        "Compositor: %d operations, %d after folding constants and fusing pointwise "
+        "operations\n",
+        num_operations,
+        (int)m_operations.size());
+  }
+
   /* surround complex ops with read/write buffer */
   add_complex_operation_buffers();
 
+  /* store buffers with half precision and only for the area which is read where possible */
+  determine_buffer_storage();
+
+  /* skip calculating buffers which did not change since the last execution */
+  if (m_use_buffer_cache) {
+    add_cached_buffers();
+  }
+
   /* links not available from here on */
   /* XXX make m_links a local variable to avoid confusion! */
   m_links.clear();
@@ -128,6 +169,23 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 void NodeOperationBuilder::addOperation(NodeOperation *operation)
 {
   m_operations.push_back(operation);
+
+  if (m_current_node) {
+    operation->setbNode(m_current_node->getbNode());
+  }
+
+  if (m_use_buffer_cache && m_current_node) {
+    if (m_current_node_cacheable) {
+      /* Operations of a node only differ by the order in which they are added. */
+      BufferCacheHash hash;
+      hash.add_uint64(m_current_node_hash);
+      hash.add_int(m_current_node_operations_num++);
+      m_operation_hashes[operation] = hash.end();
+    }
+    else {
+      m_uncached_operations.insert(operation);
+    }
+  }
 }
 
 void NodeOperationBuilder::mapInputSocket(NodeInput *node_socket,
@@ -453,6 +511,242 @@ void NodeOperationBuilder::determineResolutions()
   }
 }
 
+static bool is_constant_operation(NodeOperation *op)
+{
+  if (!op->isPointwise() || op->isSetOperation() || op->getNumberOfInputSockets() == 0 ||
+      op->getNumberOfOutputSockets() != 1) {
+    return false;
+  }
+  for (int index = 0; index < op->getNumberOfInputSockets(); index++) {
+    NodeOperationInput *input = op->getInputSocket(index);
+    if (!input->isConnected() || !input->getLink()->getOperation().isSetOperation()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void NodeOperationBuilder::fold_constant_operations()
+{
+  /* Folding an operation can make the operations reading it constant, repeat until none is left.
+   * The set operations which were read are left unconnected and are pruned. */
+  Operations constant_ops;
+  do {
+    constant_ops.clear();
+    for (Operations::const_iterator it = m_operations.begin(); it != m_operations.end(); ++it) {
+      if (is_constant_operation(*it)) {
+        constant_ops.push_back(*it);
+      }
+    }
+
+    for (Operations::const_iterator it = constant_ops.begin(); it != constant_ops.end(); ++it) {
+      NodeOperation *op = *it;
+
+      float value[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+      op->setbNodeTree(m_context->getbNodeTree());
+      op->initExecution();
+      op->readSampled(value, 0.0f, 0.0f, COM_PS_NEAREST);
+      op->deinitExecution();
+
+      NodeOperation *constant_op = NULL;
+      switch (op->getOutputSocket()->getDataType()) {
+        case COM_DT_VALUE: {
+          SetValueOperation *value_op = new SetValueOperation();
+          value_op->setValue(value[0]);
+          constant_op = value_op;
+          break;
+        }
+        case COM_DT_VECTOR: {
+          SetVectorOperation *vector_op = new SetVectorOperation();
+          vector_op->setVector(value);
+          constant_op = vector_op;
+          break;
+        }
+        case COM_DT_COLOR: {
+          SetColorOperation *color_op = new SetColorOperation();
+          color_op->setChannels(value);
+          constant_op = color_op;
+          break;
+        }
+      }
+      /* Constants are cached by their value, no settings hash is needed. */
+      addOperation(constant_op);
+      constant_op->setbNode(op->getbNode());
+
+      OpInputs targets = cache_output_links(op->getOutputSocket());
+      for (OpInputs::const_iterator it_target = targets.begin(); it_target != targets.end();
+           ++it_target) {
+        removeInputLink(*it_target);
+        addLink(constant_op->getOutputSocket(), *it_target);
+      }
+      for (int index = 0; index < op->getNumberOfInputSockets(); index++) {
+        removeInputLink(op->getInputSocket(index));
+      }
+
+      m_operations.erase(std::find(m_operations.begin(), m_operations.end(), op));
+      m_operation_hashes.erase(op);
+      m_uncached_operations.erase(op);
+      delete op;
+    }
+  } while (!constant_ops.empty());
+}
+
+static bool is_fusable_operation(NodeOperation *op)
+{
+  if (!op->isPointwise() || op->isSetOperation() || op->isOpenCL() ||
+      op->getNumberOfOutputSockets() != 1) {
+    return false;
+  }
+  for (int index = 0; index < op->getNumberOfInputSockets(); index++) {
+    if (!op->getInputSocket(index)->isConnected()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void NodeOperationBuilder::fuse_pointwise_operations()
+{
+  /* Regions of fusable operations are found from the outputs upstream. An operation joins the
+   * region of the operations reading it when all of them are in the same region, so only the
+   * first operation of a region, its root, is read from outside. */
+  sort_operations();
+
+  std::map<NodeOperation *, OpInputs> targets;
+  for (Links::const_iterator it = m_links.begin(); it != m_links.end(); ++it) {
+    targets[&it->from()->getOperation()].push_back(it->to());
+  }
+
+  std::map<NodeOperation *, int> op_regions;
+  std::vector<Operations> regions;
+  /* Upper bound of the registers needed by every region. */
+  std::vector<int> region_registers;
+  for (Operations::reverse_iterator it = m_operations.rbegin(); it != m_operations.rend(); ++it) {
+    NodeOperation *op = *it;
+    if (!is_fusable_operation(op)) {
+      continue;
+    }
+
+    const int num_registers = 1 + op->getNumberOfInputSockets();
+    const OpInputs &op_targets = targets[op];
+    int region = -1;
+    for (OpInputs::const_iterator it_target = op_targets.begin(); it_target != op_targets.end();
+         ++it_target) {
+      NodeOperation &target_op = (*it_target)->getOperation();
+      std::map<NodeOperation *, int>::const_iterator found = op_regions.find(&target_op);
+      if (found == op_regions.end() || (region != -1 && found->second != region) ||
+          target_op.getWidth() != op->getWidth() || target_op.getHeight() != op->getHeight()) {
+        region = -1;
+        break;
+      }
+      region = found->second;
+    }
+    if (region != -1 &&
+        region_registers[region] + num_registers > COM_FUSED_MAX_REGISTERS) {
+      region = -1;
+    }
+
+    if (region == -1) {
+      region = regions.size();
+      regions.push_back(Operations());
+      region_registers.push_back(0);
+    }
+    regions[region].push_back(op);
+    region_registers[region] += num_registers;
+    op_regions[op] = region;
+  }
+
+  std::set<NodeOperation *> fused_ops;
+  for (int region = 0; region < regions.size(); region++) {
+    const Operations &ops = regions[region];
+    if (ops.size() < 2) {
+      continue;
+    }
+
+    /* Operations were added downstream first, the root is the first one. */
+    NodeOperation *root = ops.front();
+    FusedOperation *fused = new FusedOperation(root->getOutputSocket()->getDataType());
+    std::map<NodeOperation *, int> op_registers;
+    std::map<NodeOperationOutput *, int> input_registers;
+    BufferCacheHash hash;
+    bool cacheable = true;
+    for (Operations::const_reverse_iterator it = ops.rbegin(); it != ops.rend(); ++it) {
+      NodeOperation *op = *it;
+      for (int index = 0; index < op->getNumberOfInputSockets(); index++) {
+        NodeOperationInput *input = op->getInputSocket(index);
+        NodeOperationOutput *from = input->getLink();
+        int reg;
+        std::map<NodeOperation *, int>::const_iterator found = op_registers.find(
+            &from->getOperation());
+        if (found != op_registers.end()) {
+          reg = found->second;
+        }
+        else if (input_registers.find(from) != input_registers.end()) {
+          reg = input_registers[from];
+        }
+        else {
+          reg = fused->addInput(from->getDataType());
+          addLink(from, fused->getInputSocket(fused->getNumberOfInputSockets() - 1));
+          input_registers[from] = reg;
+        }
+        removeInputLink(input);
+        fused->linkRegister(input, reg);
+        hash.add_int(reg);
+      }
+      op_registers[op] = fused->fuseOperation(op);
+
+      hash.add_string(typeid(*op).name());
+      OperationHashes::const_iterator settings = m_operation_hashes.find(op);
+      if (settings != m_operation_hashes.end()) {
+        hash.add_uint64(settings->second);
+      }
+      if (m_uncached_operations.find(op) != m_uncached_operations.end()) {
+        cacheable = false;
+      }
+      fused_ops.insert(op);
+    }
+
+    unsigned int resolution[2] = {root->getWidth(), root->getHeight()};
+    fused->setResolution(resolution);
+    addOperation(fused);
+    fused->setbNode(root->getbNode());
+    if (m_use_buffer_cache) {
+      if (cacheable) {
+        m_operation_hashes[fused] = hash.end();
+      }
+      else {
+        m_uncached_operations.insert(fused);
+      }
+    }
+
+    OpInputs root_targets = cache_output_links(root->getOutputSocket());
+    for (OpInputs::const_iterator it_target = root_targets.begin();
+         it_target != root_targets.end();
+         ++it_target) {
+      removeInputLink(*it_target);
+      addLink(fused->getOutputSocket(), *it_target);
+    }
+  }
+
+  if (fused_ops.empty()) {
+    return;
+  }
+
+  /* The fused operations are owned by the operations they are fused into. */
+  Operations remaining_ops;
+  for (Operations::const_iterator it = m_operations.begin(); it != m_operations.end(); ++it) {
+    NodeOperation *op = *it;
+    if (fused_ops.find(op) == fused_ops.end()) {
+      remaining_ops.push_back(op);
+    }
+    else {
+      m_operation_hashes.erase(op);
+      m_uncached_operations.erase(op);
+    }
+  }
+  m_operations = remaining_ops;
+}
+
 NodeOperationBuilder::OpInputs NodeOperationBuilder::cache_output_links(
     NodeOperationOutput *output) const
 {
@@ -599,6 +893,151 @@ void NodeOperationBuilder::add_complex_operation_buffers()
   }
 }
 
+bool NodeOperationBuilder::operation_cache_key(OperationHashes &keys,
+                                               NodeOperation *operation,
+                                               uint64_t context_key,
+                                               uint64_t *r_key)
+{
+  OperationHashes::const_iterator found = keys.find(operation);
+  if (found != keys.end()) {
+    *r_key = found->second;
+    return true;
+  }
+  if (m_uncached_operations.find(operation) != m_uncached_operations.end()) {
+    return false;
+  }
+
+  BufferCacheHash hash;
+  hash.add_uint64(context_key);
+  hash.add_string(typeid(*operation).name());
+  hash.add_int(operation->getWidth());
+  hash.add_int(operation->getHeight());
+  for (int index = 0; index < operation->getNumberOfOutputSockets(); index++) {
+    hash.add_int(operation->getOutputSocket(index)->getDataType());
+  }
+
+  OperationHashes::const_iterator settings = m_operation_hashes.find(operation);
+  if (settings != m_operation_hashes.end()) {
+    hash.add_uint64(settings->second);
+  }
+  if (operation->isWriteBufferOperation()) {
+    /* Half float buffers differ from float buffers of the same operations. */
+    hash.add_int(((WriteBufferOperation *)operation)->getMemoryProxy()->useHalf());
+  }
+  if (operation->isSetOperation()) {
+    /* Constants are also added for unconnected inputs and resolution conversions. */
+    float value[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    operation->readSampled(value, 0.0f, 0.0f, COM_PS_NEAREST);
+    hash.add(value, sizeof(value));
+  }
+
+  uint64_t input_key;
+  if (operation->isReadBufferOperation()) {
+    MemoryProxy *memproxy = ((ReadBufferOperation *)operation)->getMemoryProxy();
+    if (!operation_cache_key(
+            keys, memproxy->getWriteBufferOperation(), context_key, &input_key)) {
+      m_uncached_operations.insert(operation);
+      return false;
+    }
+    hash.add_uint64(input_key);
+  }
+
+  for (int index = 0; index < operation->getNumberOfInputSockets(); index++) {
+    NodeOperationInput *input = operation->getInputSocket(index);
+    hash.add_int(input->isConnected());
+    if (!input->isConnected()) {
+      continue;
+    }
+    NodeOperationOutput *output = input->getLink();
+    NodeOperation &input_operation = output->getOperation();
+    if (!operation_cache_key(keys, &input_operation, context_key, &input_key)) {
+      m_uncached_operations.insert(operation);
+      return false;
+    }
+    hash.add_uint64(input_key);
+    for (int output_index = 0; output_index < input_operation.getNumberOfOutputSockets();
+         output_index++) {
+      if (input_operation.getOutputSocket(output_index) == output) {
+        hash.add_int(output_index);
+      }
+    }
+  }
+
+  *r_key = hash.end();
+  keys[operation] = *r_key;
+  return true;
+}
+
+void NodeOperationBuilder::determine_buffer_storage()
+{
+  /* Complex operations get the buffers of their inputs from initializeTileData and access their
+   * data directly, those buffers have to stay full floats. Other operations only read pixels. */
+  std::set<MemoryProxy *> float_proxies;
+  for (Operations::const_iterator it = m_operations.begin(); it != m_operations.end(); ++it) {
+    NodeOperation *op = *it;
+    if (!op->isReadBufferOperation()) {
+      continue;
+    }
+    MemoryProxy *memproxy = ((ReadBufferOperation *)op)->getMemoryProxy();
+    OpInputs targets = cache_output_links(op->getOutputSocket());
+    for (OpInputs::const_iterator it_target = targets.begin(); it_target != targets.end();
+         ++it_target) {
+      if ((*it_target)->getOperation().isComplex()) {
+        float_proxies.insert(memproxy);
+        break;
+      }
+    }
+  }
+
+  for (Operations::const_iterator it = m_operations.begin(); it != m_operations.end(); ++it) {
+    NodeOperation *op = *it;
+    if (op->isWriteBufferOperation()) {
+      WriteBufferOperation *write_op = (WriteBufferOperation *)op;
+      MemoryProxy *memproxy = write_op->getMemoryProxy();
+      const bool read_per_pixel = float_proxies.find(memproxy) == float_proxies.end();
+      memproxy->setUseHalf(read_per_pixel && m_context->isHalfBufferEnabled());
+      /* Single values are read at the origin, wherever the pixel is read. */
+      memproxy->setUseArea(read_per_pixel && !write_op->isSingleValue());
+    }
+  }
+}
+
+void NodeOperationBuilder::add_cached_buffers()
+{
+  const uint64_t context_key = BufferCache::hashContext(*m_context);
+
+  /* Keys of all write buffers are calculated before any link is removed. */
+  OperationHashes keys;
+  std::vector<WriteBufferOperation *> cacheable_ops;
+  for (Operations::const_iterator it = m_operations.begin(); it != m_operations.end(); ++it) {
+    NodeOperation *op = *it;
+    uint64_t key;
+    if (op->isWriteBufferOperation() && !((WriteBufferOperation *)op)->isSingleValue() &&
+        operation_cache_key(keys, op, context_key, &key)) {
+      WriteBufferOperation *write_op = (WriteBufferOperation *)op;
+      write_op->setCacheKey(key);
+      cacheable_ops.push_back(write_op);
+    }
+  }
+
+  std::set<uint64_t> cached_keys;
+  for (std::vector<WriteBufferOperation *>::const_iterator it = cacheable_ops.begin();
+       it != cacheable_ops.end();
+       ++it) {
+    WriteBufferOperation *write_op = *it;
+    const uint64_t key = keys[write_op];
+    /* Identical buffers in the same graph are calculated once for every write buffer. */
+    if (!BufferCache::contains(key) || cached_keys.find(key) != cached_keys.end()) {
+      continue;
+    }
+    cached_keys.insert(key);
+
+    /* Operations which only calculated this buffer become unreachable and are pruned. */
+    removeInputLink(write_op->getInputSocket(0));
+    write_op->setCached();
+  }
+}
+
 typedef std::set<NodeOperation *> Tags;
 
 static void find_reachable_operations_recursive(Tags &reachable, NodeOperation *op)
@@ -23,6 +23,8 @@
 #include <set>
 #include <vector>
 
+#include "BLI_sys_types.h"
+
 #include "COM_NodeGraph.h"
 
 using std::vector;
@@ -75,6 +77,8 @@ class NodeOperationBuilder {
   typedef std::vector<NodeOperationInput *> OpInputs;
   typedef std::map<NodeInput *, OpInputs> OpInputInverseMap;
 
+  typedef std::map<NodeOperation *, uint64_t> OperationHashes;
+
  private:
   const CompositorContext *m_context;
   NodeGraph m_graph;
@@ -90,6 +94,17 @@ class NodeOperationBuilder {
 
   Node *m_current_node;
 
+  /** Buffers are reused from the BufferCache */
+  bool m_use_buffer_cache;
+  /** Hash of the settings of the current node, for the keys of cached buffers */
+  uint64_t m_current_node_hash;
+  bool m_current_node_cacheable;
+  int m_current_node_operations_num;
+  /** Hashes of the node settings of operations */
+  OperationHashes m_operation_hashes;
+  /** Operations reading data not covered by the hashes */
+  std::set<NodeOperation *> m_uncached_operations;
+
   /** Operation that will be writing to the viewer image
    *  Only one operation can occupy this place at a time,
    *  to avoid race conditions
@@ -147,9 +162,15 @@ class NodeOperationBuilder {
   /** Replace proxy operations with direct links */
   void resolve_proxies();
 
+  /** Replace pointwise operations of constants by their result */
+  void fold_constant_operations();
+
   /** Calculate resolution for each operation */
   void determineResolutions();
 
+  /** Replace chains of pointwise operations by fused operations */
+  void fuse_pointwise_operations();
+
   /** Helper function to store connected inputs for replacement */
   OpInputs cache_output_links(NodeOperationOutput *output) const;
   /** Find a connected write buffer operation to an OpOutput */
@@ -159,6 +180,16 @@ class NodeOperationBuilder {
   void add_input_buffers(NodeOperation *operation, NodeOperationInput *input);
   void add_output_buffers(NodeOperation *operation, NodeOperationOutput *output);
 
+  /** Store buffers which are only read per pixel as half floats and for the read area only */
+  void determine_buffer_storage();
+
+  /** Use buffers of the BufferCache instead of calculating unchanged parts of the graph */
+  void add_cached_buffers();
+  bool operation_cache_key(OperationHashes &keys,
+                           NodeOperation *operation,
+                           uint64_t context_key,
+                           uint64_t *r_key);
+
   /** Remove unreachable operations */
   void prune_operations();
 
@@ -0,0 +1,321 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <stdio.h>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include "COM_Profiler.h" /* own include */
+#include "COM_CompositorContext.h"
+#include "COM_ExecutionGroup.h"
+#include "COM_ExecutionSystem.h"
+#include "COM_FusedOperation.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_WriteBufferOperation.h"
+
+extern "C" {
+#include "BLI_string.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_node_types.h"
+
+#include "BKE_global.h"
+#include "BKE_node.h"
+
+#include "PIL_time.h"
+}
+
+typedef std::map<const NodeOperation *, Profiler::Stats> OperationStats;
+typedef std::map<bNode *, Profiler::Stats> NodeStats;
+
+Profiler::Profiler(const CompositorContext &context)
+    : m_context(context), m_enabled(context.isProfileEnabled())
+{
+  this->m_startTime = PIL_check_seconds_timer();
+}
+
+void Profiler::operationInitialized(const NodeOperation *operation, double time)
+{
+  if (this->m_enabled) {
+    this->m_initTimes[operation] += time;
+  }
+}
+
+/* -------------------------------------------------------------------- */
+/** \name JSON Output
+ * \{ */
+
+static std::string json_string(const char *str)
+{
+  std::string result = "\"";
+  for (const char *c = str; *c; c++) {
+    if (ELEM(*c, '"', '\\')) {
+      result += '\\';
+      result += *c;
+    }
+    else if ((unsigned char)*c < 0x20) {
+      char escaped[8];
+      sprintf(escaped, "\\u%04x", *c);
+      result += escaped;
+    }
+    else {
+      result += *c;
+    }
+  }
+  return result + "\"";
+}
+
+/* Class name of the operation, without the decoration some compilers add. */
+static std::string operation_type_name(const NodeOperation *operation)
+{
+  const char *name = typeid(*operation).name();
+  if (STREQLEN(name, "class ", 6)) {
+    name += 6;
+  }
+  while (*name >= '0' && *name <= '9') {
+    name++;
+  }
+  return name;
+}
+
+static void json_append_stats(std::string &json, const Profiler::Stats &stats)
+{
+  char str[128];
+  BLI_snprintf(str,
+               sizeof(str),
+               "\"time\": %.6f, \"pixels\": %llu, \"memory\": %llu",
+               stats.time,
+               (unsigned long long)stats.pixels,
+               (unsigned long long)stats.memory);
+  json += str;
+}
+
+static bool json_append_nodes(std::string &json,
+                              const bNodeTree *ntree,
+                              const NodeStats &nodes,
+                              bool first)
+{
+  for (bNode *node = (bNode *)ntree->nodes.first; node; node = node->next) {
+    NodeStats::const_iterator it = nodes.find(node);
+    if (it != nodes.end()) {
+      json += first ? "\n    {\"name\": " : ",\n    {\"name\": ";
+      json += json_string(node->name);
+      json += ", \"tree\": ";
+      json += json_string(ntree->id.name + 2);
+      json += ", ";
+      json_append_stats(json, it->second);
+      json += "}";
+      first = false;
+    }
+    if (ELEM(node->type, NODE_GROUP, NODE_CUSTOM_GROUP) && node->id) {
+      first = json_append_nodes(json, (const bNodeTree *)node->id, nodes, first);
+    }
+  }
+  return first;
+}
+
+/** \} */
+
+static void add_node_stats(NodeStats &nodes, bNode *node, const Profiler::Stats &operation_stats)
+{
+  Profiler::Stats &stats = nodes[node];
+  stats.time += operation_stats.time;
+  stats.pixels = MAX2(stats.pixels, operation_stats.pixels);
+  stats.memory += operation_stats.memory;
+}
+
+/* Clear the statistics of all nodes, including the nodes in groups. */
+static void clear_node_stats(const bNodeTree *ntree)
+{
+  for (bNode *node = (bNode *)ntree->nodes.first; node; node = node->next) {
+    node->profile_time = 0.0f;
+    node->profile_pixels = 0;
+    node->profile_memory = 0;
+    if (ELEM(node->type, NODE_GROUP, NODE_CUSTOM_GROUP) && node->id) {
+      clear_node_stats((const bNodeTree *)node->id);
+    }
+  }
+}
+
+/* Group nodes get the sum of the nodes inside them. */
+static Profiler::Stats sum_group_node_stats(const bNodeTree *ntree)
+{
+  Profiler::Stats total;
+  for (bNode *node = (bNode *)ntree->nodes.first; node; node = node->next) {
+    if (ELEM(node->type, NODE_GROUP, NODE_CUSTOM_GROUP) && node->id) {
+      const Profiler::Stats stats = sum_group_node_stats((const bNodeTree *)node->id);
+      node->profile_time = (float)stats.time;
+      node->profile_pixels = (int64_t)stats.pixels;
+      node->profile_memory = (int64_t)stats.memory;
+    }
+    total.time += node->profile_time;
+    total.pixels = MAX2(total.pixels, (uint64_t)node->profile_pixels);
+    total.memory += (size_t)node->profile_memory;
+  }
+  return total;
+}
+
+void Profiler::executionFinished(const ExecutionSystem *system)
+{
+  if (!this->m_enabled) {
+    return;
+  }
+
+  const double total_time = PIL_check_seconds_timer() - this->m_startTime;
+  const bNodeTree *ntree = this->m_context.getbNodeTree();
+
+  /* Groups. */
+  OperationStats operations;
+  std::vector<Profiler::Stats> groups(system->m_groups.size());
+  for (int i = 0; i < system->m_groups.size(); i++) {
+    const ExecutionGroup *group = system->m_groups[i];
+    Profiler::Stats &group_stats = groups[i];
+    group_stats.time = group->getProfileTime();
+    group_stats.pixels = group->getProfilePixels();
+
+    NodeOperation *output = group->getOutputOperation();
+    if (output->isWriteBufferOperation()) {
+      MemoryBuffer *buffer = ((WriteBufferOperation *)output)->getMemoryProxy()->getBuffer();
+      if (buffer) {
+        group_stats.memory = buffer->getMemorySize();
+        operations[output].memory = group_stats.memory;
+      }
+    }
+
+    /* The operations of a group are executed pixel by pixel together, so their time can't be
+     * told apart. Divide it evenly over the operations doing the work. */
+    int num_working = 0;
+    for (int j = 0; j < group->m_operations.size(); j++) {
+      const NodeOperation *operation = group->m_operations[j];
+      if (!operation->isReadBufferOperation() && !operation->isWriteBufferOperation()) {
+        num_working++;
+      }
+    }
+    for (int j = 0; j < group->m_operations.size(); j++) {
+      const NodeOperation *operation = group->m_operations[j];
+      Profiler::Stats &stats = operations[operation];
+      stats.pixels += group_stats.pixels;
+      if (!operation->isReadBufferOperation() && !operation->isWriteBufferOperation()) {
+        stats.time += group_stats.time / num_working;
+      }
+    }
+    if (num_working == 0) {
+      operations[output].time += group_stats.time;
+    }
+  }
+
+  /* Operations. */
+  for (std::map<const NodeOperation *, double>::const_iterator it = this->m_initTimes.begin();
+       it != this->m_initTimes.end();
+       ++it) {
+    operations[it->first].time += it->second;
+  }
+
+  /* Nodes, buffers added by the compiler count for the node writing to them. */
+  NodeStats nodes;
+  for (OperationStats::const_iterator it = operations.begin(); it != operations.end(); ++it) {
+    const NodeOperation *operation = it->first;
+    bNode *node = operation->getbNode();
+    if (node == NULL && operation->isWriteBufferOperation()) {
+      NodeOperationOutput *link = operation->getInputSocket(0)->getLink();
+      node = link ? link->getOperation().getbNode() : NULL;
+    }
+    if (operation->isFusedOperation()) {
+      /* Like the operations of a group, the time of fused operations can't be told apart. */
+      const std::vector<NodeOperation *> &fused =
+          ((const FusedOperation *)operation)->getFusedOperations();
+      Profiler::Stats fused_stats;
+      fused_stats.time = it->second.time / fused.size();
+      fused_stats.pixels = it->second.pixels;
+      for (int i = 0; i < fused.size(); i++) {
+        if (fused[i]->getbNode()) {
+          add_node_stats(nodes, fused[i]->getbNode(), fused_stats);
+        }
+      }
+      /* The output buffer of the last one. */
+      if (node) {
+        fused_stats.time = 0.0;
+        fused_stats.memory = it->second.memory;
+        add_node_stats(nodes, node, fused_stats);
+      }
+      continue;
+    }
+    if (node == NULL) {
+      continue;
+    }
+    add_node_stats(nodes, node, it->second);
+  }
+
+  clear_node_stats(ntree);
+  for (NodeStats::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+    bNode *node = it->first;
+    node->profile_time = (float)it->second.time;
+    node->profile_pixels = (int64_t)it->second.pixels;
+    node->profile_memory = (int64_t)it->second.memory;
+  }
+  sum_group_node_stats(ntree);
+
+  if (!(G.background && this->m_context.isRendering())) {
+    return;
+  }
+
+  /* One JSON document per execution, for render farms and scripts to pick up from the log. */
+  Profiler::Stats total;
+  total.time = total_time;
+  for (int i = 0; i < groups.size(); i++) {
+    total.pixels += groups[i].pixels;
+    total.memory += groups[i].memory;
+  }
+  /* Built in one string and printed at once, so documents of frames composited at the same
+   * time don't interleave. */
+  char str[64];
+  std::string json = "{\"compositor_profile\": {\"frame\": ";
+  BLI_snprintf(str, sizeof(str), "%d", this->m_context.getFramenumber());
+  json += str;
+  json += ", \"view\": ";
+  json += json_string(this->m_context.getViewName() ? this->m_context.getViewName() : "");
+  json += ", ";
+  json_append_stats(json, total);
+
+  json += ",\n  \"nodes\": [";
+  json_append_nodes(json, ntree, nodes, true);
+
+  json += "],\n  \"groups\": [";
+  for (int i = 0; i < groups.size(); i++) {
+    const ExecutionGroup *group = system->m_groups[i];
+    BLI_snprintf(str, sizeof(str), "%s\n    {\"index\": %d, ", i ? "," : "", i);
+    json += str;
+    json_append_stats(json, groups[i]);
+    json += ", \"operations\": [";
+    for (int j = 0; j < group->m_operations.size(); j++) {
+      const NodeOperation *operation = group->m_operations[j];
+      const bNode *node = operation->getbNode();
+      json += j ? ",\n      {\"type\": " : "\n      {\"type\": ";
+      json += json_string(operation_type_name(operation).c_str());
+      json += ", \"node\": ";
+      json += node ? json_string(node->name) : "null";
+      json += ", ";
+      json_append_stats(json, operations[operation]);
+      json += "}";
+    }
+    json += "]}";
+  }
+  json += "]}}\n";
+
+  fputs(json.c_str(), stdout);
+  fflush(stdout);
+}
@@ -0,0 +1,79 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __COM_PROFILER_H__
+#define __COM_PROFILER_H__
+
+#include <map>
+
+extern "C" {
+#include "BLI_sys_types.h"
+}
+
+class CompositorContext;
+class ExecutionSystem;
+class NodeOperation;
+
+/**
+ * \brief Execution time, pixels and memory of an execution of the compositor.
+ *
+ * Enabled by #NTREE_COM_PROFILE. The time of the chunks is recorded by every ExecutionGroup,
+ * the time to initialize by every NodeOperation. When the execution is finished the numbers are
+ * summed per node into the runtime fields of #bNode, where the node editor and the Python API
+ * show them. Background renders also print them as JSON.
+ * \ingroup Execution
+ */
+class Profiler {
+ public:
+  struct Stats {
+    /** Wall time in seconds, summed over all threads. */
+    double time;
+    uint64_t pixels;
+    /** Size of the output buffer in bytes. */
+    size_t memory;
+
+    Stats() : time(0.0), pixels(0), memory(0)
+    {
+    }
+  };
+
+ private:
+  const CompositorContext &m_context;
+  bool m_enabled;
+  double m_startTime;
+  std::map<const NodeOperation *, double> m_initTimes;
+
+ public:
+  Profiler(const CompositorContext &context);
+
+  bool isEnabled() const
+  {
+    return this->m_enabled;
+  }
+
+  /**
+   * \brief record the time NodeOperation.initExecution took
+   */
+  void operationInitialized(const NodeOperation *operation, double time);
+
+  /**
+   * \brief store the statistics in the nodes, and print them as JSON in background renders
+   * \note call before the execution is de-initialized, while the buffers are allocated
+   */
+  void executionFinished(const ExecutionSystem *system);
+};
+
+#endif /* __COM_PROFILER_H__ */
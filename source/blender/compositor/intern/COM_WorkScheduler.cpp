@@ -30,6 +30,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "PIL_time.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_global.h"
@@ -38,7 +39,7 @@
 #  ifndef DEBUG /* test this so we dont get warnings in debug builds */
 #    warning COM_CURRENT_THREADING_MODEL COM_TM_NOTHREAD is activated. Use only for debugging.
 #  endif
-#elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 /* do nothing - default */
 #else
 #  error COM_CURRENT_THREADING_MODEL No threading model selected
@@ -48,12 +49,34 @@
 static vector<CPUDevice *> g_cpudevices;
 static ThreadLocal(CPUDevice *) g_thread_device;
 
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-/// \brief list of all thread for every CPUDevice in cpudevices a thread exists
-static ListBase g_cputhreads;
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+/// \brief priority of a WorkPackage, higher priorities are executed first
+typedef enum WorkPackagePriority {
+  COM_WP_PRIORITY_LOW = 0,
+  COM_WP_PRIORITY_HIGH = 1,
+} WorkPackagePriority;
+#  define COM_WP_PRIORITY_NUM 2
+
 static bool g_cpuInitialized = false;
-/// \brief all scheduled work for the cpu
-static ThreadQueue *g_cpuqueue;
+/// \brief maximum number of tasks of an execution running at the same time, the number of
+/// threads requested by the render settings
+static int g_cpuTasksMax = 1;
+/// \brief work of an execution for the cpu, frames of an animation composited at once each
+/// have their own
+typedef struct CPUQueue {
+  /// \brief tasks executing the scheduled work, every task executes packages until the queue is
+  /// empty
+  TaskPool *pool;
+  /// \brief number of tasks pushed to the pool which did not finish yet, at most tasks_max
+  int tasks_len, tasks_max;
+  /// \brief scheduled work, in order of execution for every priority
+  std::list<WorkPackage *> packages[COM_WP_PRIORITY_NUM];
+  ThreadMutex mutex;
+  /// \brief node tree of the execution, to skip work when it is cancelled
+  const bNodeTree *btree;
+} CPUQueue;
+/// \brief queue of the execution started by the calling thread, which schedules all its work
+static thread_local CPUQueue *g_cpuqueue = NULL;
 static ThreadQueue *g_gpuqueue;
 #  ifdef COM_OPENCL_ENABLED
 static cl_context g_context;
@@ -71,18 +94,42 @@ static bool g_openclInitialized = false;
 #  endif
 #endif
 
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-void *WorkScheduler::thread_execute_cpu(void *data)
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+void WorkScheduler::task_execute_cpu(TaskPool *__restrict pool,
+                                     void * /*taskdata*/,
+                                     int threadid)
 {
-  CPUDevice *device = (CPUDevice *)data;
-  WorkPackage *work;
+  CPUQueue *queue = (CPUQueue *)BLI_task_pool_userdata(pool);
+  CPUDevice *device = g_cpudevices[threadid];
   BLI_thread_local_set(g_thread_device, device);
-  while ((work = (WorkPackage *)BLI_thread_queue_pop(g_cpuqueue))) {
-    device->execute(work);
+
+  for (;;) {
+    /* Packages are taken from the queue when a task is ready for them, so priorities are still
+     * followed after scheduling. */
+    WorkPackage *work = NULL;
+    BLI_mutex_lock(&queue->mutex);
+    for (int priority = COM_WP_PRIORITY_NUM - 1; priority >= 0; priority--) {
+      if (!queue->packages[priority].empty()) {
+        work = queue->packages[priority].front();
+        queue->packages[priority].pop_front();
+        break;
+      }
+    }
+    if (work == NULL) {
+      queue->tasks_len--;
+    }
+    BLI_mutex_unlock(&queue->mutex);
+
+    if (work == NULL) {
+      return;
+    }
+    /* The tree was edited or rendering was cancelled, the result is not going to be used. */
+    const bNodeTree *btree = queue->btree;
+    if (!(btree && btree->test_break && btree->test_break(btree->tbh))) {
+      device->execute(work);
+    }
     delete work;
   }
-
-  return NULL;
 }
 
 void *WorkScheduler::thread_execute_gpu(void *data)
@@ -106,31 +153,43 @@ void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
   CPUDevice device(0);
   device.execute(package);
   delete package;
-#elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 #  ifdef COM_OPENCL_ENABLED
   if (group->isOpenCL() && g_openclActive) {
     BLI_thread_queue_push(g_gpuqueue, package);
+    return;
   }
-  else {
-    BLI_thread_queue_push(g_cpuqueue, package);
-  }
-#  else
-  BLI_thread_queue_push(g_cpuqueue, package);
 #  endif
+  /* Chunks which are shown to the user come first. */
+  const WorkPackagePriority priority = group->isOutputExecutionGroup() ? COM_WP_PRIORITY_HIGH :
+                                                                         COM_WP_PRIORITY_LOW;
+  CPUQueue *queue = g_cpuqueue;
+  BLI_mutex_lock(&queue->mutex);
+  queue->packages[priority].push_back(package);
+  /* Running tasks pick up the package, only start a new one below the thread limit. */
+  const bool push_task = queue->tasks_len < queue->tasks_max;
+  if (push_task) {
+    queue->tasks_len++;
+  }
+  BLI_mutex_unlock(&queue->mutex);
+  if (push_task) {
+    BLI_task_pool_push(queue->pool, task_execute_cpu, NULL, false, TASK_PRIORITY_LOW);
+  }
 #endif
 }
 
 void WorkScheduler::start(CompositorContext &context)
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-  unsigned int index;
-  g_cpuqueue = BLI_thread_queue_init();
-  BLI_threadpool_init(&g_cputhreads, thread_execute_cpu, g_cpudevices.size());
-  for (index = 0; index < g_cpudevices.size(); index++) {
-    Device *device = g_cpudevices[index];
-    BLI_threadpool_insert(&g_cputhreads, device);
-  }
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+  CPUQueue *queue = new CPUQueue();
+  BLI_mutex_init(&queue->mutex);
+  queue->tasks_len = 0;
+  queue->tasks_max = g_cpuTasksMax;
+  queue->btree = context.getbNodeTree();
+  queue->pool = BLI_task_pool_create(BLI_task_scheduler_get(), queue);
+  g_cpuqueue = queue;
 #  ifdef COM_OPENCL_ENABLED
+  unsigned int index;
   if (context.getHasActiveOpenCLDevices()) {
     g_gpuqueue = BLI_thread_queue_init();
     BLI_threadpool_init(&g_gputhreads, thread_execute_gpu, g_gpudevices.size());
@@ -148,26 +207,23 @@ void WorkScheduler::start(CompositorContext &context)
 }
 void WorkScheduler::finish()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 #  ifdef COM_OPENCL_ENABLED
   if (g_openclActive) {
     BLI_thread_queue_wait_finish(g_gpuqueue);
-    BLI_thread_queue_wait_finish(g_cpuqueue);
   }
-  else {
-    BLI_thread_queue_wait_finish(g_cpuqueue);
-  }
-#  else
-  BLI_thread_queue_wait_finish(cpuqueue);
 #  endif
+  BLI_task_pool_work_and_wait(g_cpuqueue->pool);
 #endif
 }
 void WorkScheduler::stop()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-  BLI_thread_queue_nowait(g_cpuqueue);
-  BLI_threadpool_end(&g_cputhreads);
-  BLI_thread_queue_free(g_cpuqueue);
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+  CPUQueue *queue = g_cpuqueue;
+  BLI_task_pool_work_and_wait(queue->pool);
+  BLI_task_pool_free(queue->pool);
+  BLI_mutex_end(&queue->mutex);
+  delete queue;
   g_cpuqueue = NULL;
 #  ifdef COM_OPENCL_ENABLED
   if (g_openclActive) {
@@ -182,7 +238,7 @@ void WorkScheduler::stop()
 
 bool WorkScheduler::hasGPUDevices()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 #  ifdef COM_OPENCL_ENABLED
   return g_gpudevices.size() > 0;
 #  else
@@ -193,7 +249,7 @@ bool WorkScheduler::hasGPUDevices()
 #endif
 }
 
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 static void CL_CALLBACK clContextError(const char *errinfo,
                                        const void * /*private_info*/,
                                        size_t /*cb*/,
@@ -205,9 +261,14 @@ static void CL_CALLBACK clContextError(const char *errinfo,
 
 void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+  /* Work is executed in the threads of the task scheduler, which can be any of them, so there is
+   * a device for every thread. The requested number of threads limits how many packages are
+   * executed at the same time instead. The calling thread works on tasks as well while waiting. */
+  const int num_devices = BLI_task_scheduler_num_threads(BLI_task_scheduler_get());
+  g_cpuTasksMax = max(1, min(num_cpu_threads, num_devices));
   /* deinitialize if number of threads doesn't match */
-  if (g_cpudevices.size() != num_cpu_threads) {
+  if (g_cpudevices.size() != num_devices) {
     Device *device;
 
     while (g_cpudevices.size() > 0) {
@@ -224,7 +285,7 @@ void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
 
   /* initialize CPU threads */
   if (!g_cpuInitialized) {
-    for (int index = 0; index < num_cpu_threads; index++) {
+    for (int index = 0; index < num_devices; index++) {
       CPUDevice *device = new CPUDevice(index);
       device->initialize();
       g_cpudevices.push_back(device);
@@ -327,7 +388,7 @@ void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
 
 void WorkScheduler::deinitialize()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
   /* deinitialize CPU threads */
   if (g_cpuInitialized) {
     Device *device;
@@ -21,6 +21,7 @@
 
 #include "COM_ExecutionGroup.h"
 extern "C" {
+#include "BLI_task.h"
 #include "BLI_threads.h"
 }
 #include "COM_WorkPackage.h"
@@ -32,17 +33,12 @@ extern "C" {
  */
 class WorkScheduler {
 
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
   /**
-   * \brief are we being stopped.
+   * \brief task run by the task scheduler for every scheduled WorkPackage of the cpudevices
+   * the WorkPackage with the highest priority is taken from the queue and executed
    */
-  static bool isStopping();
-
-  /**
-   * \brief main thread loop for cpudevices
-   * inside this loop new work is queried and being executed
-   */
-  static void *thread_execute_cpu(void *data);
+  static void task_execute_cpu(TaskPool *__restrict pool, void *taskdata, int threadid);
 
   /**
    * \brief main thread loop for gpudevices
@@ -86,6 +82,8 @@ class WorkScheduler {
    * \brief Start the execution
    * this methods will start the WorkScheduler. Inside this method all threads are initialized.
    * for every device a thread is created.
+   * Work scheduled by the calling thread until stop belongs to this execution, executions
+   * started by different threads run at the same time.
    * \see initialize Initialization and query of the number of devices
    */
   static void start(CompositorContext &context);
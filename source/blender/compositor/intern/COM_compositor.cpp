@@ -19,6 +19,7 @@
 extern "C" {
 #include "BKE_node.h"
 #include "BLI_threads.h"
+#include "RE_pipeline.h"
 }
 
 #include "BLT_translation.h"
@@ -26,15 +27,23 @@ extern "C" {
 #include "BKE_scene.h"
 
 #include "COM_compositor.h"
+#include "COM_BufferCache.h"
 #include "COM_ExecutionSystem.h"
 #include "COM_WorkScheduler.h"
 #include "clew.h"
 #include "COM_MovieDistortionOperation.h"
 
+/* Held by every execution, shared by frames of an animation render composited at once and
+ * exclusive for all other executions. */
+static ThreadRWMutex s_executionMutex;
+/* Held while setting up an execution, the caches and the devices are shared. */
 static ThreadMutex s_compositorMutex;
 static bool is_compositorMutex_init = false;
+/* Set by COM_clearCaches, protected by s_compositorMutex. */
+static bool s_clearCachesRequested = false;
 
-void COM_execute(RenderData *rd,
+void COM_execute(Render *render,
+                 RenderData *rd,
                  Scene *scene,
                  bNodeTree *editingtree,
                  int rendering,
@@ -46,16 +55,27 @@ void COM_execute(RenderData *rd,
    * should be done somewhere as part of blender startup, all the other
    * initializations can be done lazily */
   if (is_compositorMutex_init == false) {
+    BLI_rw_mutex_init(&s_executionMutex);
     BLI_mutex_init(&s_compositorMutex);
     is_compositorMutex_init = true;
   }
 
+  /* Frames composited at once write to a render of their own and to a local copy of the tree,
+   * see RE_RenderAnim. */
+  Render *scene_render = RE_GetSceneRender(scene);
+  const bool is_frame = rendering && render != NULL && render != scene_render;
+  if (render == NULL) {
+    render = scene_render;
+  }
+
+  BLI_rw_mutex_lock(&s_executionMutex, is_frame ? THREAD_LOCK_READ : THREAD_LOCK_WRITE);
   BLI_mutex_lock(&s_compositorMutex);
 
   if (editingtree->test_break(editingtree->tbh)) {
     // during editing multiple calls to this method can be triggered.
     // make sure one the last one will be doing the work.
     BLI_mutex_unlock(&s_compositorMutex);
+    BLI_rw_mutex_unlock(&s_executionMutex);
     return;
   }
 
@@ -78,10 +98,19 @@ void COM_execute(RenderData *rd,
   }
   BKE_node_preview_init_tree(editingtree, preview_width, preview_height, false);
 
+  /* Cached buffers are only reused while editing, render results and the memory limit are
+   * likely to change for renders. */
+  if (rendering || !BufferCache::isEnabled() || s_clearCachesRequested) {
+    BufferCache::clear();
+    s_clearCachesRequested = false;
+  }
+
   /* initialize workscheduler, will check if already done. TODO deinitialize somewhere */
   bool use_opencl = (editingtree->flag & NTREE_COM_OPENCL) != 0;
   WorkScheduler::initialize(use_opencl, BKE_render_num_threads(rd));
 
+  BLI_mutex_unlock(&s_compositorMutex);
+
   /* set progress bar to 0% and status to init compositing */
   editingtree->progress(editingtree->prh, 0.0);
   editingtree->stats_draw(editingtree->sdh, IFACE_("Compositing"));
@@ -89,34 +118,54 @@ void COM_execute(RenderData *rd,
   bool twopass = (editingtree->flag & NTREE_TWO_PASS) && !rendering;
   /* initialize execution system */
   if (twopass) {
-    ExecutionSystem *system = new ExecutionSystem(
-        rd, scene, editingtree, rendering, twopass, viewSettings, displaySettings, viewName);
+    ExecutionSystem *system = new ExecutionSystem(render,
+                                                  rd,
+                                                  scene,
+                                                  editingtree,
+                                                  rendering,
+                                                  twopass,
+                                                  viewSettings,
+                                                  displaySettings,
+                                                  viewName);
     system->execute();
     delete system;
 
     if (editingtree->test_break(editingtree->tbh)) {
       // during editing multiple calls to this method can be triggered.
       // make sure one the last one will be doing the work.
-      BLI_mutex_unlock(&s_compositorMutex);
+      BLI_rw_mutex_unlock(&s_executionMutex);
       return;
     }
   }
 
   ExecutionSystem *system = new ExecutionSystem(
-      rd, scene, editingtree, rendering, false, viewSettings, displaySettings, viewName);
+      render, rd, scene, editingtree, rendering, false, viewSettings, displaySettings, viewName);
   system->execute();
   delete system;
 
-  BLI_mutex_unlock(&s_compositorMutex);
+  BLI_rw_mutex_unlock(&s_executionMutex);
+}
+
+void COM_clearCaches()
+{
+  if (is_compositorMutex_init) {
+    BLI_mutex_lock(&s_compositorMutex);
+    s_clearCachesRequested = true;
+    BLI_mutex_unlock(&s_compositorMutex);
+  }
 }
 
 void COM_deinitialize()
 {
   if (is_compositorMutex_init) {
+    BLI_rw_mutex_lock(&s_executionMutex, THREAD_LOCK_WRITE);
     BLI_mutex_lock(&s_compositorMutex);
     WorkScheduler::deinitialize();
+    BufferCache::clear();
     is_compositorMutex_init = false;
     BLI_mutex_unlock(&s_compositorMutex);
     BLI_mutex_end(&s_compositorMutex);
+    BLI_rw_mutex_unlock(&s_executionMutex);
+    BLI_rw_mutex_end(&s_executionMutex);
   }
 }
@@ -57,6 +57,7 @@ void BokehBlurNode::convertToOperations(NodeConverter &converter,
     BokehBlurOperation *operation = new BokehBlurOperation();
     operation->setQuality(context.getQuality());
     operation->setExtendBounds(extend_bounds);
+    operation->setUseFFT(!context.getHasActiveOpenCLDevices());
 
     converter.addOperation(operation);
     converter.mapInputSocket(getInputSocket(0), operation->getInputSocket(0));
@@ -38,6 +38,7 @@ void CompositorNode::convertToOperations(NodeConverter &converter,
 
   CompositorOperation *compositorOperation = new CompositorOperation();
   compositorOperation->setScene(context.getScene());
+  compositorOperation->setRender(context.getRender());
   compositorOperation->setSceneName(context.getScene()->id.name);
   compositorOperation->setRenderData(context.getRenderData());
   compositorOperation->setViewName(context.getViewName());
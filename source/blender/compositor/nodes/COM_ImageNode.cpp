@@ -29,10 +29,33 @@
 #include "COM_SetColorOperation.h"
 #include "COM_SeparateColorNode.h"
 
+extern "C" {
+#include "BLI_path_util.h"
+
+#include "BKE_image.h"
+
+#include "intern/openexr/openexr_multi.h"
+}
+
 ImageNode::ImageNode(bNode *editorNode) : Node(editorNode)
 {
   /* pass */
 }
+
+/* Whether the passes of a multilayer image are read from its file. A render result which is
+ * already loaded for the frame is used as it is. */
+static bool multilayer_use_stream(Image *image, ImageUser *imageuser)
+{
+  if (!ELEM(image->source, IMA_SRC_FILE, IMA_SRC_SEQUENCE) || BKE_image_has_packedfile(image)) {
+    return false;
+  }
+  if (image->rr &&
+      (image->source == IMA_SRC_FILE || image->rr->framenr == imageuser->framenr)) {
+    return false;
+  }
+  return true;
+}
+
 NodeOperation *ImageNode::doMultilayerCheck(NodeConverter &converter,
                                             RenderLayer *rl,
                                             Image *image,
@@ -84,125 +107,195 @@ void ImageNode::convertToOperations(NodeConverter &converter,
   /* force a load, we assume iuser index will be set OK anyway */
   if (image && image->type == IMA_TYPE_MULTILAYER) {
     bool is_multilayer_ok = false;
-    ImBuf *ibuf = BKE_image_acquire_ibuf(image, imageuser, NULL);
-    if (image->rr) {
-      RenderLayer *rl = (RenderLayer *)BLI_findlink(&image->rr->layers, imageuser->layer);
-      if (rl) {
-        NodeOutput *socket;
-        int index;
+    ImBuf *ibuf = NULL;
+    RenderLayer *rl = NULL;
 
-        is_multilayer_ok = true;
+    /* Passes of files which are not loaded yet are streamed from the file, only the passes
+     * which are used are read, instead of loading all of them into the render result. */
+    char filepath[FILE_MAX];
+    void *exrhandle = NULL;
+    int exr_width = 0, exr_height = 0;
+    const char *exr_layer = NULL;
+    if (multilayer_use_stream(image, imageuser)) {
+      BKE_image_user_file_path(imageuser, image, filepath);
+      exrhandle = IMB_exr_get_handle();
+      if (IMB_exr_begin_read_passes(exrhandle, filepath, &exr_width, &exr_height)) {
+        exr_layer = IMB_exr_layer_name(exrhandle, imageuser->layer);
+      }
+      if (exr_layer == NULL && exrhandle) {
+        IMB_exr_close(exrhandle);
+        exrhandle = NULL;
+      }
+    }
 
-        for (index = 0; index < numberOfOutputs; index++) {
-          NodeOperation *operation = NULL;
-          socket = this->getOutputSocket(index);
-          bNodeSocket *bnodeSocket = socket->getbNodeSocket();
-          NodeImageLayer *storage = (NodeImageLayer *)bnodeSocket->storage;
-          RenderPass *rpass = (RenderPass *)BLI_findstring(
-              &rl->passes, storage->pass_name, offsetof(RenderPass, name));
-          int view = 0;
+    if (exrhandle == NULL) {
+      ibuf = BKE_image_acquire_ibuf(image, imageuser, NULL);
+      if (image->rr) {
+        rl = (RenderLayer *)BLI_findlink(&image->rr->layers, imageuser->layer);
+      }
+    }
 
-          if (STREQ(storage->pass_name, RE_PASSNAME_COMBINED) &&
-              STREQ(bnodeSocket->name, "Alpha")) {
-            /* Alpha output is already handled with the associated combined output. */
-            continue;
-          }
+    if (rl || exrhandle) {
+      NodeOutput *socket;
+      int index;
+      const int num_views = exrhandle ? IMB_exr_views_num(exrhandle) :
+                                        BLI_listbase_count_at_most(&image->rr->views, 2);
 
-          /* returns the image view to use for the current active view */
-          if (BLI_listbase_count_at_most(&image->rr->views, 2) > 1) {
-            const int view_image = imageuser->view;
-            const bool is_allview = (view_image == 0); /* if view selected == All (0) */
+      is_multilayer_ok = true;
 
-            if (is_allview) {
-              /* heuristic to match image name with scene names
-               * check if the view name exists in the image */
-              view = BLI_findstringindex(
-                  &image->rr->views, context.getViewName(), offsetof(RenderView, name));
-              if (view == -1) {
-                view = 0;
+      for (index = 0; index < numberOfOutputs; index++) {
+        NodeOperation *operation = NULL;
+        socket = this->getOutputSocket(index);
+        bNodeSocket *bnodeSocket = socket->getbNodeSocket();
+        NodeImageLayer *storage = (NodeImageLayer *)bnodeSocket->storage;
+        RenderPass *rpass = NULL;
+        int view = 0;
+
+        if (STREQ(storage->pass_name, RE_PASSNAME_COMBINED) &&
+            STREQ(bnodeSocket->name, "Alpha")) {
+          /* Alpha output is already handled with the associated combined output. */
+          continue;
+        }
+
+        /* returns the image view to use for the current active view */
+        if (num_views > 1) {
+          const int view_image = imageuser->view;
+          const bool is_allview = (view_image == 0); /* if view selected == All (0) */
+
+          if (is_allview) {
+            /* heuristic to match image name with scene names
+             * check if the view name exists in the image */
+            if (exrhandle) {
+              view = -1;
+              for (int i = 0; i < num_views; i++) {
+                if (STREQ(IMB_exr_view_name(exrhandle, i), context.getViewName())) {
+                  view = i;
+                  break;
+                }
               }
             }
             else {
-              view = view_image - 1;
+              view = BLI_findstringindex(
+                  &image->rr->views, context.getViewName(), offsetof(RenderView, name));
+            }
+            if (view == -1) {
+              view = 0;
             }
           }
+          else {
+            view = view_image - 1;
+          }
+        }
 
+        int channels = 0;
+        int passindex = 0;
+        const char *exr_view = NULL;
+        if (exrhandle) {
+          /* Like the render result, the channels are those of the first view of the pass. */
+          channels = IMB_exr_pass_channels(exrhandle, exr_layer, storage->pass_name, NULL);
+          if (num_views > 1) {
+            exr_view = IMB_exr_view_name(exrhandle, view);
+          }
+        }
+        else {
+          rpass = (RenderPass *)BLI_findstring(
+              &rl->passes, storage->pass_name, offsetof(RenderPass, name));
           if (rpass) {
-            int passindex = BLI_findindex(&rl->passes, rpass);
-            switch (rpass->channels) {
-              case 1:
-                operation = doMultilayerCheck(converter,
-                                              rl,
-                                              image,
-                                              imageuser,
-                                              framenumber,
-                                              index,
-                                              passindex,
-                                              view,
-                                              COM_DT_VALUE);
-                break;
-                /* using image operations for both 3 and 4 channels (RGB and RGBA respectively) */
-                /* XXX any way to detect actual vector images? */
-              case 3:
-                operation = doMultilayerCheck(converter,
-                                              rl,
-                                              image,
-                                              imageuser,
-                                              framenumber,
-                                              index,
-                                              passindex,
-                                              view,
-                                              COM_DT_VECTOR);
-                break;
-              case 4:
-                operation = doMultilayerCheck(converter,
-                                              rl,
-                                              image,
-                                              imageuser,
-                                              framenumber,
-                                              index,
-                                              passindex,
-                                              view,
-                                              COM_DT_COLOR);
-                break;
-              default:
-                /* dummy operation is added below */
-                break;
-            }
-            if (index == 0 && operation) {
-              converter.addPreview(operation->getOutputSocket());
-            }
-            if (STREQ(rpass->name, RE_PASSNAME_COMBINED)) {
-              for (int alphaIndex = 0; alphaIndex < numberOfOutputs; alphaIndex++) {
-                NodeOutput *alphaSocket = this->getOutputSocket(alphaIndex);
-                bNodeSocket *bnodeAlphaSocket = alphaSocket->getbNodeSocket();
-                if (!STREQ(bnodeAlphaSocket->name, "Alpha")) {
-                  continue;
-                }
-                NodeImageLayer *alphaStorage = (NodeImageLayer *)bnodeSocket->storage;
-                if (!STREQ(alphaStorage->pass_name, RE_PASSNAME_COMBINED)) {
-                  continue;
-                }
-                SeparateChannelOperation *separate_operation;
-                separate_operation = new SeparateChannelOperation();
-                separate_operation->setChannel(3);
-                converter.addOperation(separate_operation);
-                converter.addLink(operation->getOutputSocket(),
-                                  separate_operation->getInputSocket(0));
-                converter.mapOutputSocket(alphaSocket, separate_operation->getOutputSocket());
-                break;
+            channels = rpass->channels;
+            passindex = BLI_findindex(&rl->passes, rpass);
+          }
+        }
+
+        if (channels) {
+          switch (channels) {
+            case 1:
+              operation = doMultilayerCheck(converter,
+                                            rl,
+                                            image,
+                                            imageuser,
+                                            framenumber,
+                                            index,
+                                            passindex,
+                                            view,
+                                            COM_DT_VALUE);
+              break;
+              /* using image operations for both 3 and 4 channels (RGB and RGBA respectively) */
+              /* XXX any way to detect actual vector images? */
+            case 3:
+              operation = doMultilayerCheck(converter,
+                                            rl,
+                                            image,
+                                            imageuser,
+                                            framenumber,
+                                            index,
+                                            passindex,
+                                            view,
+                                            COM_DT_VECTOR);
+              break;
+            case 4:
+              operation = doMultilayerCheck(converter,
+                                            rl,
+                                            image,
+                                            imageuser,
+                                            framenumber,
+                                            index,
+                                            passindex,
+                                            view,
+                                            COM_DT_COLOR);
+              break;
+            default:
+              /* dummy operation is added below */
+              break;
+          }
+          if (operation && exrhandle) {
+            ((MultilayerBaseOperation *)operation)
+                ->setStreamedPass(filepath,
+                                  exr_layer,
+                                  storage->pass_name,
+                                  exr_view,
+                                  channels,
+                                  exr_width,
+                                  exr_height);
+          }
+          if (index == 0 && operation) {
+            converter.addPreview(operation->getOutputSocket());
+          }
+          if (operation && STREQ(storage->pass_name, RE_PASSNAME_COMBINED)) {
+            for (int alphaIndex = 0; alphaIndex < numberOfOutputs; alphaIndex++) {
+              NodeOutput *alphaSocket = this->getOutputSocket(alphaIndex);
+              bNodeSocket *bnodeAlphaSocket = alphaSocket->getbNodeSocket();
+              if (!STREQ(bnodeAlphaSocket->name, "Alpha")) {
+                continue;
               }
+              NodeImageLayer *alphaStorage = (NodeImageLayer *)bnodeSocket->storage;
+              if (!STREQ(alphaStorage->pass_name, RE_PASSNAME_COMBINED)) {
+                continue;
+              }
+              SeparateChannelOperation *separate_operation;
+              separate_operation = new SeparateChannelOperation();
+              separate_operation->setChannel(3);
+              converter.addOperation(separate_operation);
+              converter.addLink(operation->getOutputSocket(),
+                                separate_operation->getInputSocket(0));
+              converter.mapOutputSocket(alphaSocket, separate_operation->getOutputSocket());
+              break;
             }
           }
+        }
 
-          /* incase we can't load the layer */
-          if (operation == NULL) {
-            converter.setInvalidOutput(getOutputSocket(index));
-          }
+        /* incase we can't load the layer */
+        if (operation == NULL) {
+          converter.setInvalidOutput(getOutputSocket(index));
         }
       }
     }
-    BKE_image_release_ibuf(image, ibuf, NULL);
+
+    if (exrhandle) {
+      IMB_exr_close(exrhandle);
+    }
+    else {
+      BKE_image_release_ibuf(image, ibuf, NULL);
+    }
 
     /* without this, multilayer that fail to load will crash blender [#32490] */
     if (is_multilayer_ok == false) {
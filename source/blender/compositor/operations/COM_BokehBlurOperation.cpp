@@ -18,12 +18,17 @@
 
 #include "COM_BokehBlurOperation.h"
 #include "BLI_math.h"
+#include "COM_FHTConvolution.h"
 #include "COM_OpenCLDevice.h"
+#include "MEM_guardedalloc.h"
 
 extern "C" {
 #include "RE_pipeline.h"
 }
 
+/* Below this radius filtering per pixel is faster than FFT convolution of the whole image. */
+#define BOKEH_BLUR_FFT_MIN_RADIUS 16
+
 BokehBlurOperation::BokehBlurOperation() : NodeOperation()
 {
   this->addInputSocket(COM_DT_COLOR);
@@ -41,6 +46,8 @@ BokehBlurOperation::BokehBlurOperation() : NodeOperation()
   this->m_inputBoundingBoxReader = NULL;
 
   this->m_extend_bounds = false;
+  this->m_use_fft = false;
+  this->m_fftResult = NULL;
 }
 
 void *BokehBlurOperation::initializeTileData(rcti * /*rect*/)
@@ -50,10 +57,47 @@ void *BokehBlurOperation::initializeTileData(rcti * /*rect*/)
     updateSize();
   }
   void *buffer = getInputOperation(0)->initializeTileData(NULL);
+  if (useFFT() && this->m_fftResult == NULL) {
+    this->m_fftResult = filterFFT((MemoryBuffer *)buffer);
+  }
   unlockMutex();
   return buffer;
 }
 
+int BokehBlurOperation::getPixelSize() const
+{
+  const float max_dim = max(this->getWidth(), this->getHeight());
+  return this->m_size * max_dim / 100.0f;
+}
+
+bool BokehBlurOperation::useFFT() const
+{
+  return this->m_use_fft && getPixelSize() >= BOKEH_BLUR_FFT_MIN_RADIUS;
+}
+
+MemoryBuffer *BokehBlurOperation::filterFFT(MemoryBuffer *input)
+{
+  /* Same kernel as the per pixel filter, offsets from -pixelSize to pixelSize - 1. */
+  const int pixelSize = getPixelSize();
+  const int kernelSize = 2 * pixelSize;
+  const float m = this->m_bokehDimension / pixelSize;
+  float *kernel = (float *)MEM_mallocN(
+      sizeof(float) * COM_NUM_CHANNELS_COLOR * kernelSize * kernelSize, __func__);
+  float *bokeh = kernel;
+  for (int j = 0; j < kernelSize; j++) {
+    for (int i = 0; i < kernelSize; i++, bokeh += COM_NUM_CHANNELS_COLOR) {
+      float u = this->m_bokehMidX - (i - pixelSize) * m;
+      float v = this->m_bokehMidY - (j - pixelSize) * m;
+      this->m_inputBokehProgram->readSampled(bokeh, u, v, COM_PS_NEAREST);
+    }
+  }
+
+  MemoryBuffer *result = fht_filter_normalized(
+      input, kernel, COM_NUM_CHANNELS_COLOR, kernelSize, kernelSize, pixelSize, pixelSize);
+  MEM_freeN(kernel);
+  return result;
+}
+
 void BokehBlurOperation::initExecution()
 {
   initMutex();
@@ -79,7 +123,17 @@ void BokehBlurOperation::executePixel(float output[4], int x, int y, void *data)
   float bokeh[4];
 
   this->m_inputBoundingBoxReader->readSampled(tempBoundingBox, x, y, COM_PS_NEAREST);
-  if (tempBoundingBox[0] > 0.0f) {
+  if (tempBoundingBox[0] > 0.0f && this->m_fftResult) {
+    const rcti &rect = *this->m_fftResult->getRect();
+    if (x >= rect.xmin && x < rect.xmax && y >= rect.ymin && y < rect.ymax) {
+      const int offset = (y - rect.ymin) * this->m_fftResult->getWidth() + (x - rect.xmin);
+      copy_v4_v4(output, &this->m_fftResult->getBuffer()[offset * COM_NUM_CHANNELS_COLOR]);
+    }
+    else {
+      zero_v4(output);
+    }
+  }
+  else if (tempBoundingBox[0] > 0.0f) {
     float multiplier_accum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
     MemoryBuffer *inputBuffer = (MemoryBuffer *)data;
     float *buffer = inputBuffer->getBuffer();
@@ -134,6 +188,10 @@ void BokehBlurOperation::executePixel(float output[4], int x, int y, void *data)
 
 void BokehBlurOperation::deinitExecution()
 {
+  if (this->m_fftResult) {
+    delete this->m_fftResult;
+    this->m_fftResult = NULL;
+  }
   deinitMutex();
   this->m_inputProgram = NULL;
   this->m_inputBokehProgram = NULL;
@@ -148,7 +206,15 @@ bool BokehBlurOperation::determineDependingAreaOfInterest(rcti *input,
   rcti bokehInput;
   const float max_dim = max(this->getWidth(), this->getHeight());
 
-  if (this->m_sizeavailable) {
+  /* A size from the socket is only known when executing, it may need the whole image too. */
+  if (this->m_sizeavailable ? useFFT() : this->m_use_fft) {
+    NodeOperation *operation = getInputOperation(0);
+    newInput.xmax = operation->getWidth();
+    newInput.xmin = 0;
+    newInput.ymax = operation->getHeight();
+    newInput.ymin = 0;
+  }
+  else if (this->m_sizeavailable) {
     newInput.xmax = input->xmax + (this->m_size * max_dim / 100.0f);
     newInput.xmin = input->xmin - (this->m_size * max_dim / 100.0f);
     newInput.ymax = input->ymax + (this->m_size * max_dim / 100.0f);
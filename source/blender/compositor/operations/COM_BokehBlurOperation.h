@@ -34,6 +34,14 @@ class BokehBlurOperation : public NodeOperation, public QualityStepHelper {
   float m_bokehMidY;
   float m_bokehDimension;
   bool m_extend_bounds;
+  bool m_use_fft;
+  /* whole image filtered at once, NULL when filtering per pixel */
+  MemoryBuffer *m_fftResult;
+
+  int getPixelSize() const;
+  /* filter with FFT, the size has to be known */
+  bool useFFT() const;
+  MemoryBuffer *filterFFT(MemoryBuffer *input);
 
  public:
   BokehBlurOperation();
@@ -76,6 +84,16 @@ class BokehBlurOperation : public NodeOperation, public QualityStepHelper {
     this->m_extend_bounds = extend_bounds;
   }
 
+  /**
+   * \brief filter the whole image at once with FFT convolution for large sizes
+   *
+   * The cost per pixel does not depend on the size, but the whole input image is needed.
+   */
+  void setUseFFT(bool use_fft)
+  {
+    this->m_use_fft = use_fft;
+  }
+
   void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
 };
 #endif
@@ -26,6 +26,7 @@ BrightnessOperation::BrightnessOperation() : NodeOperation()
   this->addOutputSocket(COM_DT_COLOR);
   this->m_inputProgram = NULL;
   this->m_use_premultiply = false;
+  this->setPointwise(true);
 }
 
 void BrightnessOperation::setUsePremultiply(bool use_premultiply)
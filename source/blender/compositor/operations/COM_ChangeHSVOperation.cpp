@@ -26,6 +26,7 @@ ChangeHSVOperation::ChangeHSVOperation() : NodeOperation()
   this->addInputSocket(COM_DT_VALUE);
   this->addOutputSocket(COM_DT_COLOR);
   this->m_inputOperation = NULL;
+  this->setPointwise(true);
 }
 
 void ChangeHSVOperation::initExecution()
@@ -39,6 +39,7 @@ ColorBalanceASCCDLOperation::ColorBalanceASCCDLOperation() : NodeOperation()
   this->m_inputValueOperation = NULL;
   this->m_inputColorOperation = NULL;
   this->setResolutionInputSocketIndex(1);
+  this->setPointwise(true);
 }
 
 void ColorBalanceASCCDLOperation::initExecution()
@@ -44,6 +44,7 @@ ColorBalanceLGGOperation::ColorBalanceLGGOperation() : NodeOperation()
   this->m_inputValueOperation = NULL;
   this->m_inputColorOperation = NULL;
   this->setResolutionInputSocketIndex(1);
+  this->setPointwise(true);
 }
 
 void ColorBalanceLGGOperation::initExecution()
@@ -33,6 +33,7 @@ ColorCorrectionOperation::ColorCorrectionOperation() : NodeOperation()
   this->m_redChannelEnabled = true;
   this->m_greenChannelEnabled = true;
   this->m_blueChannelEnabled = true;
+  this->setPointwise(true);
 }
 void ColorCorrectionOperation::initExecution()
 {
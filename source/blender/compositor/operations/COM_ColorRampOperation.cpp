@@ -33,6 +33,8 @@ ColorRampOperation::ColorRampOperation() : NodeOperation()
 
   this->m_inputProgram = NULL;
   this->m_colorBand = NULL;
+  this->setAreaOperation(true);
+  this->setPointwise(true);
 }
 void ColorRampOperation::initExecution()
 {
@@ -50,6 +52,18 @@ void ColorRampOperation::executePixelSampled(float output[4],
   BKE_colorband_evaluate(this->m_colorBand, values[0], output);
 }
 
+void ColorRampOperation::executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  const int width = BLI_rcti_size_x(area);
+  for (int y = area->ymin; y < area->ymax; y++) {
+    float *out = output->getElem(area->xmin, y);
+    const float *values = inputs[0]->getElem(area->xmin, y);
+    for (int i = 0; i < width; i++, out += 4) {
+      BKE_colorband_evaluate(this->m_colorBand, values[i], out);
+    }
+  }
+}
+
 void ColorRampOperation::deinitExecution()
 {
   this->m_inputProgram = NULL;
@@ -48,6 +48,7 @@ CompositorOperation::CompositorOperation() : NodeOperation()
   this->m_active = false;
 
   this->m_scene = NULL;
+  this->m_render = NULL;
   this->m_sceneName[0] = '\0';
   this->m_viewName = NULL;
 }
@@ -79,7 +80,7 @@ void CompositorOperation::deinitExecution()
   }
 
   if (!isBreaked()) {
-    Render *re = RE_GetSceneRender(this->m_scene);
+    Render *re = this->m_render;
     RenderResult *rr = RE_AcquireResultWrite(re);
 
     if (rr) {
@@ -192,11 +193,18 @@ void CompositorOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
   }
 #endif
 
+  MemoryBuffer *image = this->readInputArea(0, rect);
+
   for (y = y1; y < y2 && (!breaked); y++) {
     for (x = x1; x < x2 && (!breaked); x++) {
       int input_x = x + dx, input_y = y + dy;
 
-      this->m_imageInput->readSampled(color, input_x, input_y, COM_PS_NEAREST);
+      if (image) {
+        copy_v4_v4(color, image->getElem(x, y));
+      }
+      else {
+        this->m_imageInput->readSampled(color, input_x, input_y, COM_PS_NEAREST);
+      }
       if (this->m_useAlphaInput) {
         this->m_alphaInput->readSampled(&(color[3]), input_x, input_y, COM_PS_NEAREST);
       }
@@ -214,6 +222,10 @@ void CompositorOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
     offset += add;
     offset4 += add * COM_NUM_CHANNELS_COLOR;
   }
+
+  if (image) {
+    delete image;
+  }
 }
 
 void CompositorOperation::determineResolution(unsigned int resolution[2],
@@ -224,7 +236,7 @@ void CompositorOperation::determineResolution(unsigned int resolution[2],
 
   // check actual render resolution with cropping it may differ with cropped border.rendering
   // FIX for: [31777] Border Crop gives black (easy)
-  Render *re = RE_GetSceneRender(this->m_scene);
+  Render *re = this->m_render;
   if (re) {
     RenderResult *rr = RE_AcquireResultRead(re);
     if (rr) {
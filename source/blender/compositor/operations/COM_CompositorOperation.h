@@ -22,6 +22,7 @@
 #include "BLI_rect.h"
 #include "BLI_string.h"
 
+struct Render;
 struct Scene;
 
 /**
@@ -35,6 +36,11 @@ class CompositorOperation : public NodeOperation {
    */
   char m_sceneName[MAX_ID_NAME];
 
+  /**
+   * \brief render the output is written to
+   */
+  struct Render *m_render;
+
   /**
    * \brief local reference to the scene
    */
@@ -91,6 +97,10 @@ class CompositorOperation : public NodeOperation {
   {
     m_scene = scene;
   }
+  void setRender(struct Render *render)
+  {
+    this->m_render = render;
+  }
   void setSceneName(const char *sceneName)
   {
     BLI_strncpy(this->m_sceneName, sceneName, sizeof(this->m_sceneName));
@@ -29,6 +29,7 @@ extern "C" {
 CurveBaseOperation::CurveBaseOperation() : NodeOperation()
 {
   this->m_curveMapping = NULL;
+  this->setPointwise(true);
 }
 
 CurveBaseOperation::~CurveBaseOperation()
@@ -26,6 +26,7 @@ DotproductOperation::DotproductOperation() : NodeOperation()
   this->setResolutionInputSocketIndex(0);
   this->m_input1Operation = NULL;
   this->m_input2Operation = NULL;
+  this->setPointwise(true);
 }
 void DotproductOperation::initExecution()
 {
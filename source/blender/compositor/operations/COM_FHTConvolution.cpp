@@ -0,0 +1,448 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2011, Blender Foundation.
+ */
+
+#include <string.h>
+
+#include "COM_FHTConvolution.h"
+#include "COM_MemoryBuffer.h"
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_math_base.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+}
+
+typedef float fREAL;
+
+namespace FHT {
+
+unsigned int fht_next_pow2(unsigned int x, unsigned int *L2)
+{
+  unsigned int pw, x_notpow2 = x & (x - 1);
+  *L2 = 0;
+  while (x >>= 1) {
+    ++(*L2);
+  }
+  pw = 1 << (*L2);
+  if (x_notpow2) {
+    (*L2)++;
+    pw <<= 1;
+  }
+  return pw;
+}
+
+//------------------------------------------------------------------------------
+
+// from FXT library by Joerg Arndt, faster in order bitreversal
+// use: r = revbin_upd(r, h) where h = N>>1
+static unsigned int revbin_upd(unsigned int r, unsigned int h)
+{
+  while (!((r ^= h) & h)) {
+    h >>= 1;
+  }
+  return r;
+}
+//------------------------------------------------------------------------------
+static void FHT(fREAL *data, unsigned int M, unsigned int inverse)
+{
+  double tt, fc, dc, fs, ds, a = M_PI;
+  fREAL t1, t2;
+  int n2, bd, bl, istep, k, len = 1 << M, n = 1;
+
+  int i, j = 0;
+  unsigned int Nh = len >> 1;
+  for (i = 1; i < (len - 1); ++i) {
+    j = revbin_upd(j, Nh);
+    if (j > i) {
+      t1 = data[i];
+      data[i] = data[j];
+      data[j] = t1;
+    }
+  }
+
+  do {
+    fREAL *data_n = &data[n];
+
+    istep = n << 1;
+    for (k = 0; k < len; k += istep) {
+      t1 = data_n[k];
+      data_n[k] = data[k] - t1;
+      data[k] += t1;
+    }
+
+    n2 = n >> 1;
+    if (n > 2) {
+      fc = dc = cos(a);
+      fs = ds = sqrt(1.0 - fc * fc);  // sin(a);
+      bd = n - 2;
+      for (bl = 1; bl < n2; bl++) {
+        fREAL *data_nbd = &data_n[bd];
+        fREAL *data_bd = &data[bd];
+        for (k = bl; k < len; k += istep) {
+          t1 = fc * (double)data_n[k] + fs * (double)data_nbd[k];
+          t2 = fs * (double)data_n[k] - fc * (double)data_nbd[k];
+          data_n[k] = data[k] - t1;
+          data_nbd[k] = data_bd[k] - t2;
+          data[k] += t1;
+          data_bd[k] += t2;
+        }
+        tt = fc * dc - fs * ds;
+        fs = fs * dc + fc * ds;
+        fc = tt;
+        bd -= 2;
+      }
+    }
+
+    if (n > 1) {
+      for (k = n2; k < len; k += istep) {
+        t1 = data_n[k];
+        data_n[k] = data[k] - t1;
+        data[k] += t1;
+      }
+    }
+
+    n = istep;
+    a *= 0.5;
+  } while (n < len);
+
+  if (inverse) {
+    fREAL sc = (fREAL)1 / (fREAL)len;
+    for (k = 0; k < len; ++k) {
+      data[k] *= sc;
+    }
+  }
+}
+//------------------------------------------------------------------------------
+/* 2D Fast Hartley Transform, Mx/My -> log2 of width/height,
+ * nzp -> the row where zero pad data starts,
+ * inverse -> see above */
+void FHT2D(fREAL *data, unsigned int Mx, unsigned int My, unsigned int nzp, unsigned int inverse)
+{
+  unsigned int i, j, Nx, Ny, maxy;
+
+  Nx = 1 << Mx;
+  Ny = 1 << My;
+
+  // rows (forward transform skips 0 pad data)
+  maxy = inverse ? Ny : nzp;
+  for (j = 0; j < maxy; ++j) {
+    FHT(&data[Nx * j], Mx, inverse);
+  }
+
+  // transpose data
+  if (Nx == Ny) {  // square
+    for (j = 0; j < Ny; ++j) {
+      for (i = j + 1; i < Nx; ++i) {
+        unsigned int op = i + (j << Mx), np = j + (i << My);
+        SWAP(fREAL, data[op], data[np]);
+      }
+    }
+  }
+  else {  // rectangular
+    unsigned int k, Nym = Ny - 1, stm = 1 << (Mx + My);
+    for (i = 0; stm > 0; i++) {
+#define PRED(k) (((k & Nym) << Mx) + (k >> My))
+      for (j = PRED(i); j > i; j = PRED(j)) {
+        /* pass */
+      }
+      if (j < i) {
+        continue;
+      }
+      for (k = i, j = PRED(i); j != i; k = j, j = PRED(j), stm--) {
+        SWAP(fREAL, data[j], data[k]);
+      }
+#undef PRED
+      stm--;
+    }
+  }
+
+  SWAP(unsigned int, Nx, Ny);
+  SWAP(unsigned int, Mx, My);
+
+  // now columns == transposed rows
+  for (j = 0; j < Ny; ++j) {
+    FHT(&data[Nx * j], Mx, inverse);
+  }
+
+  // finalize
+  for (j = 0; j <= (Ny >> 1); j++) {
+    unsigned int jm = (Ny - j) & (Ny - 1);
+    unsigned int ji = j << Mx;
+    unsigned int jmi = jm << Mx;
+    for (i = 0; i <= (Nx >> 1); i++) {
+      unsigned int im = (Nx - i) & (Nx - 1);
+      fREAL A = data[ji + i];
+      fREAL B = data[jmi + i];
+      fREAL C = data[ji + im];
+      fREAL D = data[jmi + im];
+      fREAL E = (fREAL)0.5 * ((A + D) - (B + C));
+      data[ji + i] = A - E;
+      data[jmi + i] = B + E;
+      data[ji + im] = C + E;
+      data[jmi + im] = D - E;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+
+/* 2D convolution calc, d1 *= d2, M/N - > log2 of width/height */
+void fht_convolve(fREAL *d1, fREAL *d2, unsigned int M, unsigned int N)
+{
+  fREAL a, b;
+  unsigned int i, j, k, L, mj, mL;
+  unsigned int m = 1 << M, n = 1 << N;
+  unsigned int m2 = 1 << (M - 1), n2 = 1 << (N - 1);
+  unsigned int mn2 = m << (N - 1);
+
+  d1[0] *= d2[0];
+  d1[mn2] *= d2[mn2];
+  d1[m2] *= d2[m2];
+  d1[m2 + mn2] *= d2[m2 + mn2];
+  for (i = 1; i < m2; i++) {
+    k = m - i;
+    a = d1[i] * d2[i] - d1[k] * d2[k];
+    b = d1[k] * d2[i] + d1[i] * d2[k];
+    d1[i] = (b + a) * (fREAL)0.5;
+    d1[k] = (b - a) * (fREAL)0.5;
+    a = d1[i + mn2] * d2[i + mn2] - d1[k + mn2] * d2[k + mn2];
+    b = d1[k + mn2] * d2[i + mn2] + d1[i + mn2] * d2[k + mn2];
+    d1[i + mn2] = (b + a) * (fREAL)0.5;
+    d1[k + mn2] = (b - a) * (fREAL)0.5;
+  }
+  for (j = 1; j < n2; j++) {
+    L = n - j;
+    mj = j << M;
+    mL = L << M;
+    a = d1[mj] * d2[mj] - d1[mL] * d2[mL];
+    b = d1[mL] * d2[mj] + d1[mj] * d2[mL];
+    d1[mj] = (b + a) * (fREAL)0.5;
+    d1[mL] = (b - a) * (fREAL)0.5;
+    a = d1[m2 + mj] * d2[m2 + mj] - d1[m2 + mL] * d2[m2 + mL];
+    b = d1[m2 + mL] * d2[m2 + mj] + d1[m2 + mj] * d2[m2 + mL];
+    d1[m2 + mj] = (b + a) * (fREAL)0.5;
+    d1[m2 + mL] = (b - a) * (fREAL)0.5;
+  }
+  for (i = 1; i < m2; i++) {
+    k = m - i;
+    for (j = 1; j < n2; j++) {
+      L = n - j;
+      mj = j << M;
+      mL = L << M;
+      a = d1[i + mj] * d2[i + mj] - d1[k + mL] * d2[k + mL];
+      b = d1[k + mL] * d2[i + mj] + d1[i + mj] * d2[k + mL];
+      d1[i + mj] = (b + a) * (fREAL)0.5;
+      d1[k + mL] = (b - a) * (fREAL)0.5;
+      a = d1[i + mL] * d2[i + mL] - d1[k + mj] * d2[k + mj];
+      b = d1[k + mj] * d2[i + mL] + d1[i + mL] * d2[k + mj];
+      d1[i + mL] = (b + a) * (fREAL)0.5;
+      d1[k + mj] = (b - a) * (fREAL)0.5;
+    }
+  }
+}
+
+}  // namespace FHT
+
+//------------------------------------------------------------------------------
+
+void fht_filter_channel(float *dst,
+                        int dst_stride,
+                        const float *src,
+                        int src_stride,
+                        int width,
+                        int height,
+                        const float *kernel,
+                        int kernel_stride,
+                        int kernel_width,
+                        int kernel_height,
+                        int center_x,
+                        int center_y)
+{
+  BLI_assert(kernel_width > 1 && kernel_height > 1);
+
+  // convolution result width & height, FFT pow2 required size & log2
+  unsigned int log2_w, log2_h;
+  const unsigned int w2 = FHT::fht_next_pow2(2 * kernel_width - 1, &log2_w);
+  const unsigned int h2 = FHT::fht_next_pow2(2 * kernel_height - 1, &log2_h);
+  // block size, so the convolution of a block fits in w2 * h2
+  const int xbsz = (w2 + 1) - kernel_width;
+  const int ybsz = (h2 + 1) - kernel_height;
+  // offset of the convolution result, the kernel is mirrored to filter instead of convolve
+  const int hw = kernel_width - 1 - center_x;
+  const int hh = kernel_height - 1 - center_y;
+
+  fREAL *data_kernel = (fREAL *)MEM_callocN(w2 * h2 * sizeof(fREAL), "fht_filter kernel");
+  fREAL *data_block = (fREAL *)MEM_mallocN(w2 * h2 * sizeof(fREAL), "fht_filter block");
+
+  // only need to calc fht data of the kernel once, re-used for every block
+  for (int y = 0; y < kernel_height; y++) {
+    const float *kernel_row = &kernel[(kernel_height - 1 - y) * kernel_width * kernel_stride];
+    for (int x = 0; x < kernel_width; x++) {
+      data_kernel[y * w2 + x] = kernel_row[(kernel_width - 1 - x) * kernel_stride];
+    }
+  }
+  FHT::FHT2D(data_kernel, log2_w, log2_h, kernel_height, 0);
+
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      dst[(y * width + x) * dst_stride] = 0.0f;
+    }
+  }
+
+  // block add-overlap
+  for (int ybl = 0; ybl < height; ybl += ybsz) {
+    for (int xbl = 0; xbl < width; xbl += xbsz) {
+      const int block_height = min_ii(ybsz, height - ybl);
+      const int block_width = min_ii(xbsz, width - xbl);
+
+      memset(data_block, 0, w2 * h2 * sizeof(fREAL));
+      for (int y = 0; y < block_height; y++) {
+        const float *src_row = &src[((ybl + y) * width + xbl) * src_stride];
+        for (int x = 0; x < block_width; x++) {
+          data_block[y * w2 + x] = src_row[x * src_stride];
+        }
+      }
+
+      // FHT2D transposed data, row/col now swapped
+      // convolve & inverse FHT
+      FHT::FHT2D(data_block, log2_w, log2_h, block_height, 0);
+      FHT::fht_convolve(data_block, data_kernel, log2_h, log2_w);
+      FHT::FHT2D(data_block, log2_h, log2_w, 0, 1);
+      // data again transposed, so in order again
+
+      // overlap-add result
+      for (int y = 0; y < (int)h2; y++) {
+        const int yy = ybl + y - hh;
+        if ((yy < 0) || (yy >= height)) {
+          continue;
+        }
+        const fREAL *fp = &data_block[y * w2];
+        for (int x = 0; x < (int)w2; x++) {
+          const int xx = xbl + x - hw;
+          if ((xx < 0) || (xx >= width)) {
+            continue;
+          }
+          dst[(yy * width + xx) * dst_stride] += fp[x];
+        }
+      }
+    }
+  }
+
+  MEM_freeN(data_block);
+  MEM_freeN(data_kernel);
+}
+
+//------------------------------------------------------------------------------
+
+typedef struct FilterNormalizedData {
+  MemoryBuffer *input;
+  MemoryBuffer *output;
+  /* sum of the kernel weights inside the image, for every kernel channel */
+  float *weights;
+  const float *kernel;
+  int kernel_channels;
+  int kernel_width, kernel_height;
+  int center_x, center_y;
+} FilterNormalizedData;
+
+static void fht_filter_normalized_cb(void *__restrict userdata,
+                                     const int index,
+                                     const ParallelRangeTLS *__restrict /*tls*/)
+{
+  FilterNormalizedData *data = (FilterNormalizedData *)userdata;
+  const int width = data->input->getWidth();
+  const int height = data->input->getHeight();
+  const int kernel_channels = data->kernel_channels;
+  static const float one = 1.0f;
+
+  if (index < COM_NUM_CHANNELS_COLOR) {
+    /* color channel */
+    const int kernel_channel = (kernel_channels == 1) ? 0 : index;
+    fht_filter_channel(data->output->getBuffer() + index,
+                       COM_NUM_CHANNELS_COLOR,
+                       data->input->getBuffer() + index,
+                       COM_NUM_CHANNELS_COLOR,
+                       width,
+                       height,
+                       data->kernel + kernel_channel,
+                       kernel_channels,
+                       data->kernel_width,
+                       data->kernel_height,
+                       data->center_x,
+                       data->center_y);
+  }
+  else {
+    /* weights of a kernel channel, the filtered constant image */
+    const int kernel_channel = index - COM_NUM_CHANNELS_COLOR;
+    fht_filter_channel(data->weights + kernel_channel,
+                       kernel_channels,
+                       &one,
+                       0,
+                       width,
+                       height,
+                       data->kernel + kernel_channel,
+                       kernel_channels,
+                       data->kernel_width,
+                       data->kernel_height,
+                       data->center_x,
+                       data->center_y);
+  }
+}
+
+MemoryBuffer *fht_filter_normalized(MemoryBuffer *input,
+                                    const float *kernel,
+                                    int kernel_channels,
+                                    int kernel_width,
+                                    int kernel_height,
+                                    int center_x,
+                                    int center_y)
+{
+  BLI_assert(ELEM(kernel_channels, 1, COM_NUM_CHANNELS_COLOR));
+  BLI_assert(input->get_num_channels() == COM_NUM_CHANNELS_COLOR);
+
+  const int num_pixels = input->getWidth() * input->getHeight();
+  MemoryBuffer *output = new MemoryBuffer(COM_DT_COLOR, input->getRect());
+
+  FilterNormalizedData data;
+  data.input = input;
+  data.output = output;
+  data.weights = (float *)MEM_mallocN(sizeof(float) * num_pixels * kernel_channels, __func__);
+  data.kernel = kernel;
+  data.kernel_channels = kernel_channels;
+  data.kernel_width = kernel_width;
+  data.kernel_height = kernel_height;
+  data.center_x = center_x;
+  data.center_y = center_y;
+
+  ParallelRangeSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  BLI_task_parallel_range(
+      0, COM_NUM_CHANNELS_COLOR + kernel_channels, &data, fht_filter_normalized_cb, &settings);
+
+  float *color = output->getBuffer();
+  for (int i = 0; i < num_pixels; i++, color += COM_NUM_CHANNELS_COLOR) {
+    const float *weights = &data.weights[i * kernel_channels];
+    for (int ch = 0; ch < COM_NUM_CHANNELS_COLOR; ch++) {
+      color[ch] /= weights[(kernel_channels == 1) ? 0 : ch];
+    }
+  }
+
+  MEM_freeN(data.weights);
+  return output;
+}
@@ -0,0 +1,78 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * Copyright 2011, Blender Foundation.
+ */
+
+#ifndef __COM_FHTCONVOLUTION_H__
+#define __COM_FHTCONVOLUTION_H__
+
+class MemoryBuffer;
+
+/*
+ *  2D Fast Hartley Transform, used for convolution
+ */
+namespace FHT {
+
+/* returns next highest power of 2 of x, as well it's log2 in L2 */
+unsigned int fht_next_pow2(unsigned int x, unsigned int *L2);
+/* 2D Fast Hartley Transform, Mx/My -> log2 of width/height,
+ * nzp -> the row where zero pad data starts,
+ * inverse -> inverse transform */
+void FHT2D(float *data, unsigned int Mx, unsigned int My, unsigned int nzp, unsigned int inverse);
+/* 2D convolution calc, d1 *= d2, M/N - > log2 of width/height */
+void fht_convolve(float *d1, float *d2, unsigned int M, unsigned int N);
+
+}  // namespace FHT
+
+/**
+ * \brief filter a single channel of an image with a kernel, using block add-overlap convolution
+ *
+ * dst(x, y) = sum(src(x + i - center_x, y + j - center_y) * kernel(i, j)), pixels outside of
+ * the image are zero. Strides are the distance between pixels in floats, a zero source stride
+ * filters a constant image.
+ */
+void fht_filter_channel(float *dst,
+                        int dst_stride,
+                        const float *src,
+                        int src_stride,
+                        int width,
+                        int height,
+                        const float *kernel,
+                        int kernel_stride,
+                        int kernel_width,
+                        int kernel_height,
+                        int center_x,
+                        int center_y);
+
+/**
+ * \brief filter a color buffer with a kernel, normalized by the kernel weights inside the image
+ *
+ * Gives the same result as a brute force filter which clips the kernel at the borders of the
+ * image, at a cost which does not depend on the size of the kernel. Channels are filtered in
+ * parallel.
+ *
+ * \param kernel: kernel_width * kernel_height pixels of 1 or 4 channels
+ * \return a new buffer with the rect of the input
+ */
+MemoryBuffer *fht_filter_normalized(MemoryBuffer *input,
+                                    const float *kernel,
+                                    int kernel_channels,
+                                    int kernel_width,
+                                    int kernel_height,
+                                    int center_x,
+                                    int center_y);
+
+#endif
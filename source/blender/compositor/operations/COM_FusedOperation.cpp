@@ -0,0 +1,191 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "COM_FusedOperation.h"
+
+extern "C" {
+#include "BLI_math_vector.h"
+}
+
+/* The registers of the fused operation being calculated, thread local since the chunks of a
+ * group are calculated by several threads at once. Either a value per register while calculating
+ * a pixel, or a buffer per register while calculating an area. */
+static thread_local float (*g_registers)[4] = NULL;
+static thread_local MemoryBuffer **g_register_buffers = NULL;
+
+/* Reads a register of the fused operation being calculated, in place of the operation which
+ * calculated the register before it was fused. */
+class RegisterOperation : public NodeOperation {
+ private:
+  int m_index;
+
+ public:
+  RegisterOperation(DataType datatype, int index) : NodeOperation(), m_index(index)
+  {
+    this->addOutputSocket(datatype);
+  }
+
+  int getIndex() const
+  {
+    return this->m_index;
+  }
+
+  void executePixelSampled(float output[4], float x, float y, PixelSampler /*sampler*/)
+  {
+    if (g_register_buffers) {
+      g_register_buffers[this->m_index]->read(output, (int)x, (int)y);
+    }
+    else {
+      copy_v4_v4(output, g_registers[this->m_index]);
+    }
+  }
+};
+
+FusedOperation::FusedOperation(DataType datatype) : NodeOperation()
+{
+  this->addOutputSocket(datatype);
+  this->setAreaOperation(true);
+  this->m_numRegisters = 0;
+}
+
+FusedOperation::~FusedOperation()
+{
+  for (int index = 0; index < this->m_operations.size(); index++) {
+    delete this->m_operations[index];
+  }
+  for (int index = 0; index < this->m_registerOperations.size(); index++) {
+    delete this->m_registerOperations[index];
+  }
+}
+
+int FusedOperation::addInput(DataType datatype)
+{
+  BLI_assert(this->m_numRegisters < COM_FUSED_MAX_REGISTERS);
+  /* Resolutions are determined before operations are fused. */
+  this->addInputSocket(datatype, COM_SC_NO_RESIZE);
+  this->m_inputRegisters.push_back(this->m_numRegisters);
+  return this->m_numRegisters++;
+}
+
+int FusedOperation::fuseOperation(NodeOperation *operation)
+{
+  BLI_assert(this->m_numRegisters < COM_FUSED_MAX_REGISTERS);
+  this->m_operations.push_back(operation);
+  this->m_operationRegisters.push_back(this->m_numRegisters);
+  return this->m_numRegisters++;
+}
+
+void FusedOperation::linkRegister(NodeOperationInput *input, int index)
+{
+  RegisterOperation *operation = new RegisterOperation(input->getDataType(), index);
+  this->m_registerOperations.push_back(operation);
+  input->setLink(operation->getOutputSocket());
+}
+
+void FusedOperation::initExecution()
+{
+  for (int index = 0; index < this->getNumberOfInputSockets(); index++) {
+    this->m_inputReaders.push_back(this->getInputSocketReader(index));
+  }
+  for (int index = 0; index < this->m_operations.size(); index++) {
+    NodeOperation *operation = this->m_operations[index];
+    operation->setbNodeTree(this->getbNodeTree());
+    operation->initExecution();
+  }
+}
+
+void FusedOperation::deinitExecution()
+{
+  for (int index = 0; index < this->m_operations.size(); index++) {
+    this->m_operations[index]->deinitExecution();
+  }
+  this->m_inputReaders.clear();
+}
+
+void FusedOperation::executePixelSampled(float output[4],
+                                         float x,
+                                         float y,
+                                         PixelSampler sampler)
+{
+  float registers[COM_FUSED_MAX_REGISTERS][4];
+  for (int index = 0; index < this->m_inputReaders.size(); index++) {
+    this->m_inputReaders[index]->readSampled(
+        registers[this->m_inputRegisters[index]], x, y, sampler);
+  }
+
+  /* Inputs can be fused operations as well, they are read before the registers are set. */
+  float(*registers_prev)[4] = g_registers;
+  MemoryBuffer **register_buffers_prev = g_register_buffers;
+  g_registers = registers;
+  g_register_buffers = NULL;
+
+  for (int index = 0; index < this->m_operations.size(); index++) {
+    this->m_operations[index]->readSampled(
+        registers[this->m_operationRegisters[index]], x, y, sampler);
+  }
+
+  g_registers = registers_prev;
+  g_register_buffers = register_buffers_prev;
+
+  copy_v4_v4(output, registers[this->m_operationRegisters.back()]);
+}
+
+void FusedOperation::executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  MemoryBuffer *buffers[COM_FUSED_MAX_REGISTERS];
+  for (int index = 0; index < this->m_inputRegisters.size(); index++) {
+    buffers[this->m_inputRegisters[index]] = inputs[index];
+  }
+
+  const int last = this->m_operations.size() - 1;
+  for (int index = 0; index <= last; index++) {
+    NodeOperation *operation = this->m_operations[index];
+    MemoryBuffer *buffer = (index == last) ?
+                               output :
+                               new MemoryBuffer(operation->getOutputSocket()->getDataType(),
+                                                area);
+    buffers[this->m_operationRegisters[index]] = buffer;
+
+    if (operation->isAreaOperation()) {
+      std::vector<MemoryBuffer *> operation_inputs;
+      for (int i = 0; i < operation->getNumberOfInputSockets(); i++) {
+        const RegisterOperation &input = (const RegisterOperation &)operation->getInputSocket(i)
+                                             ->getLink()
+                                             ->getOperation();
+        operation_inputs.push_back(buffers[input.getIndex()]);
+      }
+      operation->executeArea(buffer, area, operation_inputs.data());
+    }
+    else {
+      MemoryBuffer **register_buffers_prev = g_register_buffers;
+      g_register_buffers = buffers;
+
+      float color[4];
+      for (int y = area->ymin; y < area->ymax; y++) {
+        for (int x = area->xmin; x < area->xmax; x++) {
+          operation->readSampled(color, x, y, COM_PS_NEAREST);
+          buffer->writePixel(x, y, color);
+        }
+      }
+
+      g_register_buffers = register_buffers_prev;
+    }
+  }
+
+  for (int index = 0; index < last; index++) {
+    delete buffers[this->m_operationRegisters[index]];
+  }
+}
@@ -0,0 +1,93 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __COM_FUSEDOPERATION_H__
+#define __COM_FUSEDOPERATION_H__
+#include "COM_NodeOperation.h"
+
+/* Registers of a fused operation, its inputs and the results of the fused operations. */
+#define COM_FUSED_MAX_REGISTERS 64
+
+/**
+ * \brief Pointwise operations fused into a single operation.
+ *
+ * Reading a chain of pointwise operations pixel by pixel reads every operation through the
+ * operations after it, and an operation read by more than one operation of the chain is
+ * calculated again for every read. A fused operation reads its inputs once per pixel into
+ * registers, and calculates the fused operations once each in order, reading their inputs from
+ * the registers.
+ *
+ * The fused operations are owned by the fused operation and are not part of the graph anymore.
+ * \see NodeOperationBuilder.fuse_pointwise_operations
+ */
+class FusedOperation : public NodeOperation {
+ private:
+  /** Fused operations in the order they are calculated, the last one is the output */
+  std::vector<NodeOperation *> m_operations;
+  /** Register of the result of every fused operation */
+  std::vector<int> m_operationRegisters;
+  /** Register of every input socket */
+  std::vector<int> m_inputRegisters;
+  /** Operations reading the registers, linked to the inputs of the fused operations */
+  std::vector<NodeOperation *> m_registerOperations;
+  std::vector<SocketReader *> m_inputReaders;
+  int m_numRegisters;
+
+ public:
+  FusedOperation(DataType datatype);
+  ~FusedOperation();
+
+  /**
+   * \brief add an input socket
+   * \return the register of the input
+   */
+  int addInput(DataType datatype);
+
+  /**
+   * \brief add an operation, after the operations it reads from
+   * \note the inputs of the operation have to be linked to registers first, see linkRegister
+   * \return the register of the result of the operation
+   */
+  int fuseOperation(NodeOperation *operation);
+
+  /**
+   * \brief link an input of a fused operation to a register
+   */
+  void linkRegister(NodeOperationInput *input, int index);
+
+  int getNumberOfRegisters() const
+  {
+    return this->m_numRegisters;
+  }
+
+  const std::vector<NodeOperation *> &getFusedOperations() const
+  {
+    return this->m_operations;
+  }
+
+  bool isFusedOperation() const
+  {
+    return true;
+  }
+
+  void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
+
+  void initExecution();
+  void deinitExecution();
+};
+
+#endif
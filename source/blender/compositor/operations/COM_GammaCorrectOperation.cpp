@@ -24,6 +24,7 @@ GammaCorrectOperation::GammaCorrectOperation() : NodeOperation()
   this->addInputSocket(COM_DT_COLOR);
   this->addOutputSocket(COM_DT_COLOR);
   this->m_inputProgram = NULL;
+  this->setPointwise(true);
 }
 void GammaCorrectOperation::initExecution()
 {
@@ -66,6 +67,7 @@ GammaUncorrectOperation::GammaUncorrectOperation() : NodeOperation()
   this->addInputSocket(COM_DT_COLOR);
   this->addOutputSocket(COM_DT_COLOR);
   this->m_inputProgram = NULL;
+  this->setPointwise(true);
 }
 void GammaUncorrectOperation::initExecution()
 {
@@ -17,15 +17,20 @@
  */
 
 #include "COM_GaussianBokehBlurOperation.h"
+#include "COM_FHTConvolution.h"
 #include "BLI_math.h"
 #include "MEM_guardedalloc.h"
 extern "C" {
 #include "RE_pipeline.h"
 }
 
+/* Below this radius filtering per pixel is faster than FFT convolution of the whole image. */
+#define GAUSSIAN_BOKEH_BLUR_FFT_MIN_RADIUS 8
+
 GaussianBokehBlurOperation::GaussianBokehBlurOperation() : BlurBaseOperation(COM_DT_COLOR)
 {
   this->m_gausstab = NULL;
+  this->m_fftResult = NULL;
 }
 
 void *GaussianBokehBlurOperation::initializeTileData(rcti * /*rect*/)
@@ -35,6 +40,17 @@ void *GaussianBokehBlurOperation::initializeTileData(rcti * /*rect*/)
     updateGauss();
   }
   void *buffer = getInputOperation(0)->initializeTileData(NULL);
+  /* The whole input is read for every pixel already, filter it at once. */
+  if (this->m_fftResult == NULL &&
+      min_ii(this->m_radx, this->m_rady) >= GAUSSIAN_BOKEH_BLUR_FFT_MIN_RADIUS) {
+    this->m_fftResult = fht_filter_normalized((MemoryBuffer *)buffer,
+                                              this->m_gausstab,
+                                              1,
+                                              2 * this->m_radx + 1,
+                                              2 * this->m_rady + 1,
+                                              this->m_radx,
+                                              this->m_rady);
+  }
   unlockMutex();
   return buffer;
 }
@@ -126,6 +142,17 @@ void GaussianBokehBlurOperation::executePixel(float output[4], int x, int y, voi
   int bufferstarty = inputBuffer->getRect()->ymin;
 
   rcti &rect = *inputBuffer->getRect();
+  if (this->m_fftResult) {
+    if (x >= rect.xmin && x < rect.xmax && y >= rect.ymin && y < rect.ymax) {
+      const int offset = (y - bufferstarty) * bufferwidth + (x - bufferstartx);
+      copy_v4_v4(output, &this->m_fftResult->getBuffer()[offset * COM_NUM_CHANNELS_COLOR]);
+    }
+    else {
+      zero_v4(output);
+    }
+    return;
+  }
+
   int ymin = max_ii(y - this->m_rady, rect.ymin);
   int ymax = min_ii(y + this->m_rady + 1, rect.ymax);
   int xmin = max_ii(x - this->m_radx, rect.xmin);
@@ -159,6 +186,10 @@ void GaussianBokehBlurOperation::deinitExecution()
     MEM_freeN(this->m_gausstab);
     this->m_gausstab = NULL;
   }
+  if (this->m_fftResult) {
+    delete this->m_fftResult;
+    this->m_fftResult = NULL;
+  }
 
   deinitMutex();
 }
@@ -26,6 +26,8 @@ class GaussianBokehBlurOperation : public BlurBaseOperation {
  private:
   float *m_gausstab;
   int m_radx, m_rady;
+  /* whole image filtered at once for large sizes, NULL when filtering per pixel */
+  MemoryBuffer *m_fftResult;
   void updateGauss();
 
  public:
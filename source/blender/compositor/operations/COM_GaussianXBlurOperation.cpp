@@ -98,14 +98,26 @@ void GaussianXBlurOperation::executePixel(float output[4], int x, int y, void *d
 
 #ifdef __SSE2__
   __m128 accum_r = _mm_load_ps(color_accum);
-  for (int nx = xmin, index = (xmin - x) + this->m_filtersize; nx < xmax;
-       nx += step, index += step) {
+  __m128 accum_r2 = _mm_setzero_ps();
+  int nx = xmin, index = (xmin - x) + this->m_filtersize;
+  /* Two pixels per iteration into separate sums, so additions don't wait for each other. */
+  for (; nx + step < xmax; nx += 2 * step, index += 2 * step) {
+    __m128 reg_a = _mm_load_ps(&buffer[bufferindex]);
+    __m128 reg_b = _mm_load_ps(&buffer[bufferindex + offsetadd]);
+    reg_a = _mm_mul_ps(reg_a, this->m_gausstab_sse[index]);
+    reg_b = _mm_mul_ps(reg_b, this->m_gausstab_sse[index + step]);
+    accum_r = _mm_add_ps(accum_r, reg_a);
+    accum_r2 = _mm_add_ps(accum_r2, reg_b);
+    multiplier_accum += this->m_gausstab[index] + this->m_gausstab[index + step];
+    bufferindex += 2 * offsetadd;
+  }
+  if (nx < xmax) {
     __m128 reg_a = _mm_load_ps(&buffer[bufferindex]);
     reg_a = _mm_mul_ps(reg_a, this->m_gausstab_sse[index]);
     accum_r = _mm_add_ps(accum_r, reg_a);
     multiplier_accum += this->m_gausstab[index];
-    bufferindex += offsetadd;
   }
+  accum_r = _mm_add_ps(accum_r, accum_r2);
   _mm_store_ps(color_accum, accum_r);
 #else
   for (int nx = xmin, index = (xmin - x) + this->m_filtersize; nx < xmax;
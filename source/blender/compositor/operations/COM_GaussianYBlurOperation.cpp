@@ -97,15 +97,30 @@ void GaussianYBlurOperation::executePixel(float output[4], int x, int y, void *d
 
 #ifdef __SSE2__
   __m128 accum_r = _mm_load_ps(color_accum);
-  for (int ny = ymin; ny < ymax; ny += step) {
+  __m128 accum_r2 = _mm_setzero_ps();
+  const int rowadd = step * 4 * bufferwidth;
+  int ny = ymin;
+  /* Two pixels per iteration into separate sums, so additions don't wait for each other. */
+  for (; ny + step < ymax; ny += 2 * step) {
     index = (ny - y) + this->m_filtersize;
     int bufferindex = bufferIndexx + ((ny - bufferstarty) * 4 * bufferwidth);
-    const float multiplier = this->m_gausstab[index];
     __m128 reg_a = _mm_load_ps(&buffer[bufferindex]);
+    __m128 reg_b = _mm_load_ps(&buffer[bufferindex + rowadd]);
     reg_a = _mm_mul_ps(reg_a, this->m_gausstab_sse[index]);
+    reg_b = _mm_mul_ps(reg_b, this->m_gausstab_sse[index + step]);
     accum_r = _mm_add_ps(accum_r, reg_a);
-    multiplier_accum += multiplier;
+    accum_r2 = _mm_add_ps(accum_r2, reg_b);
+    multiplier_accum += this->m_gausstab[index] + this->m_gausstab[index + step];
+  }
+  if (ny < ymax) {
+    index = (ny - y) + this->m_filtersize;
+    int bufferindex = bufferIndexx + ((ny - bufferstarty) * 4 * bufferwidth);
+    __m128 reg_a = _mm_load_ps(&buffer[bufferindex]);
+    reg_a = _mm_mul_ps(reg_a, this->m_gausstab_sse[index]);
+    accum_r = _mm_add_ps(accum_r, reg_a);
+    multiplier_accum += this->m_gausstab[index];
   }
+  accum_r = _mm_add_ps(accum_r, accum_r2);
   _mm_store_ps(color_accum, accum_r);
 #else
   for (int ny = ymin; ny < ymax; ny += step) {
@@ -28,6 +28,7 @@ InvertOperation::InvertOperation() : NodeOperation()
   this->m_color = true;
   this->m_alpha = false;
   setResolutionInputSocketIndex(1);
+  this->setPointwise(true);
 }
 void InvertOperation::initExecution()
 {
@@ -28,6 +28,7 @@ MapRangeOperation::MapRangeOperation() : NodeOperation()
   this->addOutputSocket(COM_DT_VALUE);
   this->m_inputOperation = NULL;
   this->m_useClamp = false;
+  this->setPointwise(true);
 }
 
 void MapRangeOperation::initExecution()
@@ -23,6 +23,7 @@ MapValueOperation::MapValueOperation() : NodeOperation()
   this->addInputSocket(COM_DT_VALUE);
   this->addOutputSocket(COM_DT_VALUE);
   this->m_inputOperation = NULL;
+  this->setPointwise(true);
 }
 
 void MapValueOperation::initExecution()
@@ -29,6 +29,7 @@ MathBaseOperation::MathBaseOperation() : NodeOperation()
   this->m_inputValue1Operation = NULL;
   this->m_inputValue2Operation = NULL;
   this->m_useClamp = false;
+  this->setPointwise(true);
 }
 
 void MathBaseOperation::initExecution()
@@ -68,6 +69,28 @@ void MathBaseOperation::clampIfNeeded(float *color)
   }
 }
 
+template<typename Func>
+void MathBaseOperation::executeAreaBinary(MemoryBuffer *output,
+                                          rcti *area,
+                                          MemoryBuffer **inputs,
+                                          Func func)
+{
+  const int width = BLI_rcti_size_x(area);
+  for (int y = area->ymin; y < area->ymax; y++) {
+    float *out = output->getElem(area->xmin, y);
+    const float *value1 = inputs[0]->getElem(area->xmin, y);
+    const float *value2 = inputs[1]->getElem(area->xmin, y);
+    for (int i = 0; i < width; i++) {
+      out[i] = func(value1[i], value2[i]);
+    }
+    if (this->m_useClamp) {
+      for (int i = 0; i < width; i++) {
+        CLAMP(out[i], 0.0f, 1.0f);
+      }
+    }
+  }
+}
+
 void MathAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
   float inputValue1[4];
@@ -81,6 +104,11 @@ void MathAddOperation::executePixelSampled(float output[4], float x, float y, Pi
   clampIfNeeded(output);
 }
 
+void MathAddOperation::executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  executeAreaBinary(output, area, inputs, [](float a, float b) { return a + b; });
+}
+
 void MathSubtractOperation::executePixelSampled(float output[4],
                                                 float x,
                                                 float y,
@@ -97,6 +125,11 @@ void MathSubtractOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathSubtractOperation::executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  executeAreaBinary(output, area, inputs, [](float a, float b) { return a - b; });
+}
+
 void MathMultiplyOperation::executePixelSampled(float output[4],
                                                 float x,
                                                 float y,
@@ -113,6 +146,11 @@ void MathMultiplyOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathMultiplyOperation::executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  executeAreaBinary(output, area, inputs, [](float a, float b) { return a * b; });
+}
+
 void MathDivideOperation::executePixelSampled(float output[4],
                                               float x,
                                               float y,
@@ -134,6 +172,13 @@ void MathDivideOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathDivideOperation::executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  /* We don't want to divide by zero. */
+  executeAreaBinary(
+      output, area, inputs, [](float a, float b) { return (b == 0) ? 0.0f : a / b; });
+}
+
 void MathSineOperation::executePixelSampled(float output[4],
                                             float x,
                                             float y,
@@ -305,6 +350,11 @@ void MathMinimumOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathMinimumOperation::executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  executeAreaBinary(output, area, inputs, [](float a, float b) { return min(a, b); });
+}
+
 void MathMaximumOperation::executePixelSampled(float output[4],
                                                float x,
                                                float y,
@@ -321,6 +371,11 @@ void MathMaximumOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathMaximumOperation::executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  executeAreaBinary(output, area, inputs, [](float a, float b) { return max(a, b); });
+}
+
 void MathRoundOperation::executePixelSampled(float output[4],
                                              float x,
                                              float y,
@@ -353,6 +408,11 @@ void MathLessThanOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathLessThanOperation::executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  executeAreaBinary(output, area, inputs, [](float a, float b) { return a < b ? 1.0f : 0.0f; });
+}
+
 void MathGreaterThanOperation::executePixelSampled(float output[4],
                                                    float x,
                                                    float y,
@@ -369,6 +429,11 @@ void MathGreaterThanOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+void MathGreaterThanOperation::executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  executeAreaBinary(output, area, inputs, [](float a, float b) { return a > b ? 1.0f : 0.0f; });
+}
+
 void MathModuloOperation::executePixelSampled(float output[4],
                                               float x,
                                               float y,
@@ -42,6 +42,12 @@ class MathBaseOperation : public NodeOperation {
 
   void clampIfNeeded(float color[4]);
 
+  /**
+   * Calculate an area for operations which only depend on the input values of the same pixel.
+   */
+  template<typename Func>
+  void executeAreaBinary(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs, Func func);
+
  public:
   /**
    * the inner loop of this program
@@ -73,29 +79,37 @@ class MathAddOperation : public MathBaseOperation {
  public:
   MathAddOperation() : MathBaseOperation()
   {
+    this->setAreaOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 class MathSubtractOperation : public MathBaseOperation {
  public:
   MathSubtractOperation() : MathBaseOperation()
   {
+    this->setAreaOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 class MathMultiplyOperation : public MathBaseOperation {
  public:
   MathMultiplyOperation() : MathBaseOperation()
   {
+    this->setAreaOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 class MathDivideOperation : public MathBaseOperation {
  public:
   MathDivideOperation() : MathBaseOperation()
   {
+    this->setAreaOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 class MathSineOperation : public MathBaseOperation {
  public:
@@ -158,15 +172,19 @@ class MathMinimumOperation : public MathBaseOperation {
  public:
   MathMinimumOperation() : MathBaseOperation()
   {
+    this->setAreaOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 class MathMaximumOperation : public MathBaseOperation {
  public:
   MathMaximumOperation() : MathBaseOperation()
   {
+    this->setAreaOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 class MathRoundOperation : public MathBaseOperation {
  public:
@@ -179,15 +197,19 @@ class MathLessThanOperation : public MathBaseOperation {
  public:
   MathLessThanOperation() : MathBaseOperation()
   {
+    this->setAreaOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 class MathGreaterThanOperation : public MathBaseOperation {
  public:
   MathGreaterThanOperation() : MathBaseOperation()
   {
+    this->setAreaOperation(true);
   }
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 
 class MathModuloOperation : public MathBaseOperation {
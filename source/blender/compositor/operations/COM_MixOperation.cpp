@@ -35,6 +35,7 @@ MixBaseOperation::MixBaseOperation() : NodeOperation()
   this->m_inputColor2Operation = NULL;
   this->setUseValueAlphaMultiply(false);
   this->setUseClamp(false);
+  this->setPointwise(true);
 }
 
 void MixBaseOperation::initExecution()
@@ -65,6 +66,28 @@ void MixBaseOperation::executePixelSampled(float output[4], float x, float y, Pi
   output[3] = inputColor1[3];
 }
 
+template<void (*Func)(float *out, const float *color1, const float *color2, float value)>
+void MixBaseOperation::executeAreaMix(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  const int width = BLI_rcti_size_x(area);
+  const bool value_alpha_multiply = this->useValueAlphaMultiply();
+  for (int y = area->ymin; y < area->ymax; y++) {
+    float *out = output->getElem(area->xmin, y);
+    const float *value = inputs[0]->getElem(area->xmin, y);
+    const float *color1 = inputs[1]->getElem(area->xmin, y);
+    const float *color2 = inputs[2]->getElem(area->xmin, y);
+    for (int i = 0; i < width; i++, out += 4, color1 += 4, color2 += 4) {
+      float fac = value[i];
+      if (value_alpha_multiply) {
+        fac *= color2[3];
+      }
+      Func(out, color1, color2, fac);
+      out[3] = color1[3];
+      clampIfNeeded(out);
+    }
+  }
+}
+
 void MixBaseOperation::determineResolution(unsigned int resolution[2],
                                            unsigned int preferredResolution[2])
 {
@@ -101,7 +124,7 @@ void MixBaseOperation::deinitExecution()
 
 MixAddOperation::MixAddOperation() : MixBaseOperation()
 {
-  /* pass */
+  this->setAreaOperation(true);
 }
 
 void MixAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
@@ -126,11 +149,23 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
   clampIfNeeded(output);
 }
 
+static void mix_add(float *out, const float *color1, const float *color2, float value)
+{
+  out[0] = color1[0] + value * color2[0];
+  out[1] = color1[1] + value * color2[1];
+  out[2] = color1[2] + value * color2[2];
+}
+
+void MixAddOperation::executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  executeAreaMix<mix_add>(output, area, inputs);
+}
+
 /* ******** Mix Blend Operation ******** */
 
 MixBlendOperation::MixBlendOperation() : MixBaseOperation()
 {
-  /* pass */
+  this->setAreaOperation(true);
 }
 
 void MixBlendOperation::executePixelSampled(float output[4],
@@ -160,6 +195,19 @@ void MixBlendOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+static void mix_blend(float *out, const float *color1, const float *color2, float value)
+{
+  float valuem = 1.0f - value;
+  out[0] = valuem * color1[0] + value * color2[0];
+  out[1] = valuem * color1[1] + value * color2[1];
+  out[2] = valuem * color1[2] + value * color2[2];
+}
+
+void MixBlendOperation::executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  executeAreaMix<mix_blend>(output, area, inputs);
+}
+
 /* ******** Mix Burn Operation ******** */
 
 MixBurnOperation::MixBurnOperation() : MixBaseOperation()
@@ -675,7 +723,7 @@ void MixLinearLightOperation::executePixelSampled(float output[4],
 
 MixMultiplyOperation::MixMultiplyOperation() : MixBaseOperation()
 {
-  /* pass */
+  this->setAreaOperation(true);
 }
 
 void MixMultiplyOperation::executePixelSampled(float output[4],
@@ -704,6 +752,19 @@ void MixMultiplyOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+static void mix_multiply(float *out, const float *color1, const float *color2, float value)
+{
+  float valuem = 1.0f - value;
+  out[0] = color1[0] * (valuem + value * color2[0]);
+  out[1] = color1[1] * (valuem + value * color2[1]);
+  out[2] = color1[2] * (valuem + value * color2[2]);
+}
+
+void MixMultiplyOperation::executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  executeAreaMix<mix_multiply>(output, area, inputs);
+}
+
 /* ******** Mix Ovelray Operation ******** */
 
 MixOverlayOperation::MixOverlayOperation() : MixBaseOperation()
@@ -880,7 +941,7 @@ void MixSoftLightOperation::executePixelSampled(float output[4],
 
 MixSubtractOperation::MixSubtractOperation() : MixBaseOperation()
 {
-  /* pass */
+  this->setAreaOperation(true);
 }
 
 void MixSubtractOperation::executePixelSampled(float output[4],
@@ -908,6 +969,18 @@ void MixSubtractOperation::executePixelSampled(float output[4],
   clampIfNeeded(output);
 }
 
+static void mix_subtract(float *out, const float *color1, const float *color2, float value)
+{
+  out[0] = color1[0] - value * color2[0];
+  out[1] = color1[1] - value * color2[1];
+  out[2] = color1[2] - value * color2[2];
+}
+
+void MixSubtractOperation::executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+  executeAreaMix<mix_subtract>(output, area, inputs);
+}
+
 /* ******** Mix Value Operation ******** */
 
 MixValueOperation::MixValueOperation() : MixBaseOperation()
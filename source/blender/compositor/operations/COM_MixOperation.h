@@ -46,6 +46,13 @@ class MixBaseOperation : public NodeOperation {
     }
   }
 
+  /**
+   * Calculate an area for operations which only depend on the input colors of the same pixel.
+   * \a Func gets the output, both colors and the factor, alpha is taken from the first color.
+   */
+  template<void (*Func)(float *out, const float *color1, const float *color2, float value)>
+  void executeAreaMix(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
+
  public:
   /**
    * Default constructor
@@ -87,12 +94,14 @@ class MixAddOperation : public MixBaseOperation {
  public:
   MixAddOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 
 class MixBlendOperation : public MixBaseOperation {
  public:
   MixBlendOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 
 class MixBurnOperation : public MixBaseOperation {
@@ -159,6 +168,7 @@ class MixMultiplyOperation : public MixBaseOperation {
  public:
   MixMultiplyOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 
 class MixOverlayOperation : public MixBaseOperation {
@@ -189,6 +199,7 @@ class MixSubtractOperation : public MixBaseOperation {
  public:
   MixSubtractOperation();
   void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+  void executeArea(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 
 class MixValueOperation : public MixBaseOperation {
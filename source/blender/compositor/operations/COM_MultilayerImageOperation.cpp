@@ -17,19 +17,162 @@
  */
 
 #include "COM_MultilayerImageOperation.h"
+#include "DNA_image_types.h"
+
 extern "C" {
+#include "IMB_colormanagement.h"
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
+#include "intern/openexr/openexr_multi.h"
+
+#include "atomic_ops.h"
 }
 
 MultilayerBaseOperation::MultilayerBaseOperation(int passindex, int view) : BaseImageOperation()
 {
   this->m_passId = passindex;
   this->m_view = view;
+  this->m_streamAnyView = false;
+  this->m_streamChannels = 0;
+  this->m_streamWidth = 0;
+  this->m_streamHeight = 0;
+  this->m_exrhandle = NULL;
+}
+
+void MultilayerBaseOperation::setStreamedPass(const char *filepath,
+                                              const char *layername,
+                                              const char *passname,
+                                              const char *viewname,
+                                              int channels,
+                                              int width,
+                                              int height)
+{
+  this->m_streamFilepath = filepath;
+  this->m_streamLayer = layername;
+  this->m_streamPass = passname;
+  this->m_streamView = viewname ? viewname : "";
+  this->m_streamAnyView = (viewname == NULL);
+  this->m_streamChannels = channels;
+  this->m_streamWidth = width;
+  this->m_streamHeight = height;
+}
+
+void MultilayerBaseOperation::determineResolution(unsigned int resolution[2],
+                                                  unsigned int preferredResolution[2])
+{
+  if (this->m_streamFilepath.empty()) {
+    BaseImageOperation::determineResolution(resolution, preferredResolution);
+    return;
+  }
+  resolution[0] = this->m_streamWidth;
+  resolution[1] = this->m_streamHeight;
+}
+
+void MultilayerBaseOperation::initExecution()
+{
+  if (this->m_streamFilepath.empty()) {
+    BaseImageOperation::initExecution();
+    return;
+  }
+
+  int width, height;
+  this->m_exrhandle = IMB_exr_get_handle();
+  if (!IMB_exr_begin_read_passes(
+          this->m_exrhandle, this->m_streamFilepath.c_str(), &width, &height) ||
+      width != this->m_streamWidth || height != this->m_streamHeight) {
+    /* The file changed since the operations were created, the pass reads as black. */
+    if (this->m_exrhandle) {
+      IMB_exr_close(this->m_exrhandle);
+      this->m_exrhandle = NULL;
+    }
+    return;
+  }
+
+  BaseImageOperation::initExecution();
+  const int num_blocks = (height + COM_MULTILAYER_STREAM_ROWS - 1) / COM_MULTILAYER_STREAM_ROWS;
+  this->m_streamedRows.assign(num_blocks, 0);
+  initMutex();
+}
+
+void MultilayerBaseOperation::deinitExecution()
+{
+  if (this->m_streamFilepath.empty()) {
+    BaseImageOperation::deinitExecution();
+    return;
+  }
+
+  if (this->m_exrhandle) {
+    deinitMutex();
+    IMB_exr_close(this->m_exrhandle);
+    this->m_exrhandle = NULL;
+  }
+  this->m_streamedRows.clear();
+  this->m_imageFloatBuffer = NULL;
+  if (this->m_buffer) {
+    IMB_freeImBuf(this->m_buffer);
+    this->m_buffer = NULL;
+  }
+}
+
+void MultilayerBaseOperation::streamRows(int ymin, int ymax)
+{
+  ymin = max_ii(ymin, 0);
+  ymax = min_ii(ymax, this->m_streamHeight);
+  if (ymin >= ymax || this->m_imageFloatBuffer == NULL) {
+    return;
+  }
+
+  for (int block = ymin / COM_MULTILAYER_STREAM_ROWS;
+       block <= (ymax - 1) / COM_MULTILAYER_STREAM_ROWS;
+       block++) {
+    if (atomic_fetch_and_or_uint8(&this->m_streamedRows[block], 0)) {
+      continue;
+    }
+
+    lockMutex();
+    if (!this->m_streamedRows[block]) {
+      const int block_ymin = block * COM_MULTILAYER_STREAM_ROWS;
+      const int block_ymax = min_ii(block_ymin + COM_MULTILAYER_STREAM_ROWS,
+                                    this->m_streamHeight);
+      if (IMB_exr_read_pass_rows(this->m_exrhandle,
+                                 this->m_streamLayer.c_str(),
+                                 this->m_streamPass.c_str(),
+                                 this->m_streamAnyView ? NULL : this->m_streamView.c_str(),
+                                 this->m_imageFloatBuffer,
+                                 block_ymin,
+                                 block_ymax) &&
+          this->m_streamChannels >= 3) {
+        /* Same as loading the render result of the image. */
+        IMB_colormanagement_transform(
+            this->m_imageFloatBuffer +
+                (size_t)block_ymin * this->m_streamWidth * this->m_streamChannels,
+            this->m_streamWidth,
+            block_ymax - block_ymin,
+            this->m_streamChannels,
+            this->m_image->colorspace_settings.name,
+            IMB_colormanagement_role_colorspace_name_get(COLOR_ROLE_SCENE_LINEAR),
+            this->m_image->alpha_mode == IMA_ALPHA_PREMUL);
+      }
+      atomic_fetch_and_or_uint8(&this->m_streamedRows[block], 1);
+    }
+    unlockMutex();
+  }
 }
 
 ImBuf *MultilayerBaseOperation::getImBuf()
 {
+  if (!this->m_streamFilepath.empty()) {
+    /* Pages of rows which are never read are never touched, and don't take memory. */
+    ImBuf *ibuf = IMB_allocImBuf(this->m_streamWidth, this->m_streamHeight, 32, 0);
+    ibuf->rect_float = (float *)MEM_mapallocN(sizeof(float) * this->m_streamWidth *
+                                                  this->m_streamHeight * this->m_streamChannels,
+                                              __func__);
+    ibuf->flags |= IB_rectfloat;
+    ibuf->mall |= IB_rectfloat;
+    ibuf->channels = this->m_streamChannels;
+    return ibuf;
+  }
+
   /* temporarily changes the view to get the right ImBuf */
   int view = this->m_imageUser->view;
 
@@ -51,6 +194,7 @@ void MultilayerColorOperation::executePixelSampled(float output[4],
                                                    float y,
                                                    PixelSampler sampler)
 {
+  ensureRows(y, sampler);
   if (this->m_imageFloatBuffer == NULL) {
     zero_v4(output);
   }
@@ -88,6 +232,7 @@ void MultilayerValueOperation::executePixelSampled(float output[4],
                                                    float y,
                                                    PixelSampler /*sampler*/)
 {
+  ensureRows(y, COM_PS_NEAREST);
   if (this->m_imageFloatBuffer == NULL) {
     output[0] = 0.0f;
   }
@@ -110,6 +255,7 @@ void MultilayerVectorOperation::executePixelSampled(float output[4],
                                                     float y,
                                                     PixelSampler /*sampler*/)
 {
+  ensureRows(y, COM_PS_NEAREST);
   if (this->m_imageFloatBuffer == NULL) {
     output[0] = 0.0f;
   }
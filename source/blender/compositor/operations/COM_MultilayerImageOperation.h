@@ -19,16 +19,56 @@
 #ifndef __COM_MULTILAYERIMAGEOPERATION_H__
 #define __COM_MULTILAYERIMAGEOPERATION_H__
 
+#include <string>
+#include <vector>
+
 #include "COM_ImageOperation.h"
 
+/* Rows of a streamed pass which are read from the file at once. */
+#define COM_MULTILAYER_STREAM_ROWS 32
+
 class MultilayerBaseOperation : public BaseImageOperation {
  private:
   int m_passId;
   int m_view;
   RenderLayer *m_renderlayer;
 
+  /* A streamed pass is read from the file row by row as far as it is used, instead of loading
+   * the render result with all passes of the image. See setStreamedPass. */
+  std::string m_streamFilepath;
+  std::string m_streamLayer;
+  std::string m_streamPass;
+  std::string m_streamView;
+  bool m_streamAnyView;
+  int m_streamChannels;
+  int m_streamWidth;
+  int m_streamHeight;
+  void *m_exrhandle;
+  /** Per COM_MULTILAYER_STREAM_ROWS rows, whether they are read */
+  std::vector<uint8_t> m_streamedRows;
+
+  void streamRows(int ymin, int ymax);
+
  protected:
   ImBuf *getImBuf();
+  void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
+
+  /**
+   * \brief make sure the rows needed to sample at y are read, for streamed passes
+   */
+  inline void ensureRows(float y, PixelSampler sampler)
+  {
+    if (this->m_exrhandle) {
+      const int yi = (int)floorf(y);
+      if (sampler == COM_PS_NEAREST) {
+        streamRows(yi, yi + 1);
+      }
+      else {
+        /* Interpolation reads the neighboring rows. */
+        streamRows(yi - 1, yi + 3);
+      }
+    }
+  }
 
  public:
   /**
@@ -39,6 +79,21 @@ class MultilayerBaseOperation : public BaseImageOperation {
   {
     this->m_renderlayer = renderlayer;
   }
+
+  /**
+   * \brief read the pass from the multilayer EXR file instead of the render result of the image
+   * \param viewname: view of the pass, NULL for the pass of any view
+   */
+  void setStreamedPass(const char *filepath,
+                       const char *layername,
+                       const char *passname,
+                       const char *viewname,
+                       int channels,
+                       int width,
+                       int height);
+
+  void initExecution();
+  void deinitExecution();
 };
 
 class MultilayerColorOperation : public MultilayerBaseOperation {
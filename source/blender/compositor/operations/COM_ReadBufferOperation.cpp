@@ -131,3 +131,12 @@ void ReadBufferOperation::updateMemoryBuffer()
 {
   this->m_buffer = this->getMemoryProxy()->getBuffer();
 }
+
+MemoryBuffer *ReadBufferOperation::getAreaBuffer(rcti *area)
+{
+  /* Half float buffers are converted when read per pixel. */
+  if (m_single_value || m_buffer->isHalf() || !BLI_rcti_inside_rcti(m_buffer->getRect(), area)) {
+    return NULL;
+  }
+  return m_buffer;
+}
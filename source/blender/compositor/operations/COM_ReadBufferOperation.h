@@ -72,6 +72,13 @@ class ReadBufferOperation : public NodeOperation {
   }
   void readResolutionFromWriteBuffer();
   void updateMemoryBuffer();
+
+  /**
+   * \brief get the buffer to use as input of an area operation
+   * \return the whole buffer, or NULL when it does not contain the area or is stored as half
+   * floats
+   */
+  MemoryBuffer *getAreaBuffer(rcti *area);
 };
 
 #endif
@@ -26,6 +26,7 @@ SetAlphaOperation::SetAlphaOperation() : NodeOperation()
 
   this->m_inputColor = NULL;
   this->m_inputAlpha = NULL;
+  this->setPointwise(true);
 }
 
 void SetAlphaOperation::initExecution()
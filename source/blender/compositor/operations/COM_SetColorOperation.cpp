@@ -21,6 +21,7 @@
 SetColorOperation::SetColorOperation() : NodeOperation()
 {
   this->addOutputSocket(COM_DT_COLOR);
+  this->setAreaOperation(true);
 }
 
 void SetColorOperation::executePixelSampled(float output[4],
@@ -31,6 +32,19 @@ void SetColorOperation::executePixelSampled(float output[4],
   copy_v4_v4(output, this->m_color);
 }
 
+void SetColorOperation::executeArea(MemoryBuffer *output,
+                                    rcti *area,
+                                    MemoryBuffer ** /*inputs*/)
+{
+  const int width = BLI_rcti_size_x(area);
+  for (int y = area->ymin; y < area->ymax; y++) {
+    float *out = output->getElem(area->xmin, y);
+    for (int i = 0; i < width; i++, out += 4) {
+      copy_v4_v4(out, this->m_color);
+    }
+  }
+}
+
 void SetColorOperation::determineResolution(unsigned int resolution[2],
                                             unsigned int preferredResolution[2])
 {
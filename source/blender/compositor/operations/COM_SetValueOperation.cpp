@@ -21,6 +21,7 @@
 SetValueOperation::SetValueOperation() : NodeOperation()
 {
   this->addOutputSocket(COM_DT_VALUE);
+  this->setAreaOperation(true);
 }
 
 void SetValueOperation::executePixelSampled(float output[4],
@@ -31,6 +32,16 @@ void SetValueOperation::executePixelSampled(float output[4],
   output[0] = this->m_value;
 }
 
+void SetValueOperation::executeArea(MemoryBuffer *output,
+                                    rcti *area,
+                                    MemoryBuffer ** /*inputs*/)
+{
+  const int width = BLI_rcti_size_x(area);
+  for (int y = area->ymin; y < area->ymax; y++) {
+    copy_vn_fl(output->getElem(area->xmin, y), width, this->m_value);
+  }
+}
+
 void SetValueOperation::determineResolution(unsigned int resolution[2],
                                             unsigned int preferredResolution[2])
 {
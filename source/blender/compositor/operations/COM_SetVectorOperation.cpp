@@ -22,6 +22,7 @@
 SetVectorOperation::SetVectorOperation() : NodeOperation()
 {
   this->addOutputSocket(COM_DT_VECTOR);
+  this->setAreaOperation(true);
 }
 
 void SetVectorOperation::executePixelSampled(float output[4],
@@ -34,6 +35,21 @@ void SetVectorOperation::executePixelSampled(float output[4],
   output[2] = this->m_z;
 }
 
+void SetVectorOperation::executeArea(MemoryBuffer *output,
+                                     rcti *area,
+                                     MemoryBuffer ** /*inputs*/)
+{
+  const int width = BLI_rcti_size_x(area);
+  for (int y = area->ymin; y < area->ymax; y++) {
+    float *out = output->getElem(area->xmin, y);
+    for (int i = 0; i < width; i++, out += 3) {
+      out[0] = this->m_x;
+      out[1] = this->m_y;
+      out[2] = this->m_z;
+    }
+  }
+}
+
 void SetVectorOperation::determineResolution(unsigned int resolution[2],
                                              unsigned int preferredResolution[2])
 {
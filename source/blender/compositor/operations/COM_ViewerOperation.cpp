@@ -97,10 +97,16 @@ void ViewerOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
   int x;
   int y;
   bool breaked = false;
+  MemoryBuffer *image = this->readInputArea(0, rect);
 
   for (y = y1; y < y2 && (!breaked); y++) {
     for (x = x1; x < x2; x++) {
-      this->m_imageInput->readSampled(&(buffer[offset4]), x, y, COM_PS_NEAREST);
+      if (image) {
+        copy_v4_v4(&(buffer[offset4]), image->getElem(x, y));
+      }
+      else {
+        this->m_imageInput->readSampled(&(buffer[offset4]), x, y, COM_PS_NEAREST);
+      }
       if (this->m_useAlphaInput) {
         this->m_alphaInput->readSampled(alpha, x, y, COM_PS_NEAREST);
         buffer[offset4 + 3] = alpha[0];
@@ -117,6 +123,9 @@ void ViewerOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
     offset += offsetadd;
     offset4 += offsetadd4;
   }
+  if (image) {
+    delete image;
+  }
   updateImage(rect);
 }
 
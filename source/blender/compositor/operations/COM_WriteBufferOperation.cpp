@@ -17,6 +17,7 @@
  */
 
 #include "COM_WriteBufferOperation.h"
+#include "COM_BufferCache.h"
 #include "COM_defines.h"
 #include <stdio.h>
 #include "COM_OpenCLDevice.h"
@@ -27,6 +28,9 @@ WriteBufferOperation::WriteBufferOperation(DataType datatype) : NodeOperation()
   this->m_memoryProxy = new MemoryProxy(datatype);
   this->m_memoryProxy->setWriteBufferOperation(this);
   this->m_memoryProxy->setExecutor(NULL);
+  this->m_cacheKey = 0;
+  this->m_useCache = false;
+  this->m_isCached = false;
 }
 WriteBufferOperation::~WriteBufferOperation()
 {
@@ -47,20 +51,57 @@ void WriteBufferOperation::executePixelSampled(float output[4],
 void WriteBufferOperation::initExecution()
 {
   this->m_input = this->getInputOperation(0);
-  this->m_memoryProxy->allocate(this->m_width, this->m_height);
+  MemoryBuffer *buffer = this->m_isCached ? BufferCache::take(this->m_cacheKey) : NULL;
+  BLI_assert(buffer != NULL || !this->m_isCached);
+  ExecutionGroup *group = this->m_memoryProxy->getExecutor();
+  if (buffer) {
+    this->m_memoryProxy->setBuffer(buffer);
+  }
+  else if (this->m_memoryProxy->useArea() && group) {
+    /* Only the part of the buffer which is read by other groups or shown. */
+    rcti area = *group->getAreaOfInterest();
+    this->m_memoryProxy->allocate(&area);
+  }
+  else {
+    this->m_memoryProxy->allocate(this->m_width, this->m_height);
+  }
 }
 
 void WriteBufferOperation::deinitExecution()
 {
   this->m_input = NULL;
+  if (this->m_useCache) {
+    /* Only keep complete buffers, chunks are skipped when cancelled or outside of borders. */
+    ExecutionGroup *group = this->m_memoryProxy->getExecutor();
+    MemoryBuffer *buffer = this->m_memoryProxy->getBuffer();
+    const bool is_full = buffer->getWidth() == (int)this->m_width &&
+                         buffer->getHeight() == (int)this->m_height;
+    if (this->m_isCached || (!isBreaked() && is_full && group && group->isFullyExecuted())) {
+      BufferCache::store(this->m_cacheKey, this->m_memoryProxy->releaseBuffer());
+    }
+  }
   this->m_memoryProxy->free();
 }
 
-void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
+void WriteBufferOperation::executeRegion(rcti *chunk_rect, unsigned int /*tileNumber*/)
 {
   MemoryBuffer *memoryBuffer = this->m_memoryProxy->getBuffer();
+  /* Buffers allocated for the area of interest don't need to contain the whole chunk. */
+  rcti clipped_rect;
+  if (!BLI_rcti_isect(chunk_rect, memoryBuffer->getRect(), &clipped_rect) ||
+      BLI_rcti_is_empty(&clipped_rect)) {
+    memoryBuffer->setCreatedState();
+    return;
+  }
+  rcti *rect = &clipped_rect;
+  if (memoryBuffer->isHalf()) {
+    this->executeRegionHalf(memoryBuffer, rect);
+    return;
+  }
   float *buffer = memoryBuffer->getBuffer();
   const int num_channels = memoryBuffer->get_num_channels();
+  const int buffer_xmin = memoryBuffer->getRect()->xmin;
+  const int buffer_ymin = memoryBuffer->getRect()->ymin;
   if (this->m_input->isComplex()) {
     void *data = this->m_input->initializeTileData(rect);
     int x1 = rect->xmin;
@@ -71,7 +112,8 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/
     int y;
     bool breaked = false;
     for (y = y1; y < y2 && (!breaked); y++) {
-      int offset4 = (y * memoryBuffer->getWidth() + x1) * num_channels;
+      int offset4 = ((y - buffer_ymin) * memoryBuffer->getWidth() + x1 - buffer_xmin) *
+                    num_channels;
       for (x = x1; x < x2; x++) {
         this->m_input->read(&(buffer[offset4]), x, y, data);
         offset4 += num_channels;
@@ -85,6 +127,9 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/
       data = NULL;
     }
   }
+  else if (this->useBufferExecution() && this->m_input->isAreaOperation()) {
+    this->m_input->readArea(memoryBuffer, rect);
+  }
   else {
     int x1 = rect->xmin;
     int y1 = rect->ymin;
@@ -95,7 +140,8 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/
     int y;
     bool breaked = false;
     for (y = y1; y < y2 && (!breaked); y++) {
-      int offset4 = (y * memoryBuffer->getWidth() + x1) * num_channels;
+      int offset4 = ((y - buffer_ymin) * memoryBuffer->getWidth() + x1 - buffer_xmin) *
+                    num_channels;
       for (x = x1; x < x2; x++) {
         this->m_input->readSampled(&(buffer[offset4]), x, y, COM_PS_NEAREST);
         offset4 += num_channels;
@@ -108,6 +154,39 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/
   memoryBuffer->setCreatedState();
 }
 
+void WriteBufferOperation::executeRegionHalf(MemoryBuffer *memoryBuffer, rcti *rect)
+{
+  /* Calculate the chunk as floats, converted when copied into the buffer. */
+  MemoryBuffer *chunk = new MemoryBuffer(this->m_memoryProxy->getDataType(), rect);
+  if (!this->m_input->isComplex() && this->useBufferExecution() &&
+      this->m_input->isAreaOperation()) {
+    this->m_input->readArea(chunk, rect);
+  }
+  else {
+    float *buffer = chunk->getBuffer();
+    const int num_channels = chunk->get_num_channels();
+    const bool is_complex = this->m_input->isComplex();
+    void *data = is_complex ? this->m_input->initializeTileData(rect) : NULL;
+    int offset = 0;
+    for (int y = rect->ymin; y < rect->ymax && !isBreaked(); y++) {
+      for (int x = rect->xmin; x < rect->xmax; x++, offset += num_channels) {
+        if (is_complex) {
+          this->m_input->read(&buffer[offset], x, y, data);
+        }
+        else {
+          this->m_input->readSampled(&buffer[offset], x, y, COM_PS_NEAREST);
+        }
+      }
+    }
+    if (data) {
+      this->m_input->deinitializeTileData(rect, data);
+    }
+  }
+  memoryBuffer->copyContentFrom(chunk);
+  delete chunk;
+  memoryBuffer->setCreatedState();
+}
+
 void WriteBufferOperation::executeOpenCLRegion(OpenCLDevice *device,
                                                rcti * /*rect*/,
                                                unsigned int /*chunkNumber*/,
@@ -30,6 +30,11 @@ class WriteBufferOperation : public NodeOperation {
   MemoryProxy *m_memoryProxy;
   bool m_single_value; /* single value stored in buffer */
   NodeOperation *m_input;
+  /* key of the buffer in the BufferCache */
+  uint64_t m_cacheKey;
+  bool m_useCache;
+  /* buffer is taken from the BufferCache instead of being calculated */
+  bool m_isCached;
 
  public:
   WriteBufferOperation(DataType datatype);
@@ -49,6 +54,10 @@ class WriteBufferOperation : public NodeOperation {
   }
 
   void executeRegion(rcti *rect, unsigned int tileNumber);
+  /**
+   * \brief executeRegion for buffers stored as half floats
+   */
+  void executeRegionHalf(MemoryBuffer *memoryBuffer, rcti *rect);
   void initExecution();
   void deinitExecution();
   void executeOpenCLRegion(OpenCLDevice *device,
@@ -62,5 +71,27 @@ class WriteBufferOperation : public NodeOperation {
   {
     return m_input;
   }
+
+  /**
+   * \brief store the buffer in the BufferCache after execution
+   */
+  void setCacheKey(uint64_t key)
+  {
+    this->m_cacheKey = key;
+    this->m_useCache = true;
+  }
+  /**
+   * \brief take the buffer from the BufferCache, the input is not executed
+   * \note the cache key has to be set
+   */
+  void setCached()
+  {
+    BLI_assert(this->m_useCache);
+    this->m_isCached = true;
+  }
+  bool isCached() const
+  {
+    return this->m_isCached;
+  }
 };
 #endif
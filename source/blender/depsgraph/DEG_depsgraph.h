@@ -161,6 +161,39 @@ void DEG_evaluate_on_refresh(Depsgraph *graph);
 
 bool DEG_needs_eval(Depsgraph *graph);
 
+/* Frame-Parallel Evaluation --------------------- */
+
+/* A ring of independent dependency graphs of the same view layer, evaluating consecutive frames
+ * concurrently from background threads. Frames are handed out to the caller in order, each one
+ * on its own graph which stays untouched until it is released.
+ *
+ * Graph N of the ring evaluates frames N, N + size, N + 2 * size, ..., so simulations which are
+ * not cached or baked will not be correct. Editor updates such as animated image textures and
+ * sound are not handled either, only data-block evaluation. */
+typedef struct DepsgraphFrameRing DepsgraphFrameRing;
+
+/* Create and build the graphs. Use size 0 to size the ring from the number of threads. */
+DepsgraphFrameRing *DEG_frame_ring_new(struct Main *bmain,
+                                       struct Scene *scene,
+                                       struct ViewLayer *view_layer,
+                                       eEvaluationMode mode,
+                                       int size);
+/* Stops evaluation of pending frames, all graphs must be released. */
+void DEG_frame_ring_free(DepsgraphFrameRing *ring);
+
+int DEG_frame_ring_size(const DepsgraphFrameRing *ring);
+
+/* Start evaluating frames from frame_start to frame_end (inclusive) in background threads. */
+void DEG_frame_ring_start(DepsgraphFrameRing *ring,
+                          float frame_start,
+                          float frame_end,
+                          float frame_step);
+
+/* Wait for the next frame in order to be evaluated. Returns NULL when all frames were handed out.
+ * The graph is owned by the ring and must be given back with #DEG_frame_ring_release. */
+Depsgraph *DEG_frame_ring_acquire_next(DepsgraphFrameRing *ring, float *r_frame);
+void DEG_frame_ring_release(DepsgraphFrameRing *ring, Depsgraph *graph);
+
 /* Editors Integration  -------------------------- */
 
 /* Mechanism to allow editors to be informed of depsgraph updates,
@@ -53,6 +53,20 @@ void DEG_stats_simple(const struct Depsgraph *graph,
                       size_t *r_operations,
                       size_t *r_relations);
 
+/* Memory used by relations between operations, as stored in the nodes and as the flat arrays
+ * used for evaluation. */
+void DEG_stats_relations_memory(const struct Depsgraph *graph,
+                                size_t *r_nodes_memory,
+                                size_t *r_arrays_memory);
+
+/* Wall time of the last evaluation in seconds, and the time each thread of the task scheduler
+ * spent evaluating operations during it. Only gathered when G_DEBUG_DEPSGRAPH_TIME is set.
+ * Returns the number of threads written to r_busy_time. */
+double DEG_debug_eval_time_get(const struct Depsgraph *graph);
+int DEG_debug_eval_thread_busy_time_get(const struct Depsgraph *graph,
+                                        double *r_busy_time,
+                                        const int max_threads);
+
 /* ************************************************ */
 /* Diagram-Based Graph Debugging */
 
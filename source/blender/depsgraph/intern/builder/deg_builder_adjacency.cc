@@ -0,0 +1,107 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2019 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "intern/builder/deg_builder_adjacency.h"
+
+#include "intern/node/deg_node.h"
+#include "intern/node/deg_node_operation.h"
+
+#include "intern/depsgraph.h"
+
+namespace DEG {
+
+namespace {
+
+template<typename T> size_t vector_memory(const vector<T> &vector)
+{
+  return vector.capacity() * sizeof(T);
+}
+
+/* Fill links and offsets of every operation from the given relations of the nodes. The first
+ * pass counts links, so the arrays are allocated once. */
+void build_links(const Depsgraph *graph,
+                 const bool use_outlinks,
+                 vector<int> *r_offset,
+                 vector<OperationLink> *r_links)
+{
+  const int num_operations = graph->operations.size();
+  r_offset->resize(num_operations + 1);
+  int num_links = 0;
+  for (int i = 0; i < num_operations; i++) {
+    const OperationNode *op_node = graph->operations[i];
+    (*r_offset)[i] = num_links;
+    for (const Relation *rel : use_outlinks ? op_node->outlinks : op_node->inlinks) {
+      const Node *other = use_outlinks ? rel->to : rel->from;
+      if (other->type == NodeType::OPERATION) {
+        num_links++;
+      }
+    }
+  }
+  (*r_offset)[num_operations] = num_links;
+  r_links->resize(num_links);
+  int link_index = 0;
+  for (const OperationNode *op_node : graph->operations) {
+    for (const Relation *rel : use_outlinks ? op_node->outlinks : op_node->inlinks) {
+      const Node *other = use_outlinks ? rel->to : rel->from;
+      if (other->type != NodeType::OPERATION) {
+        continue;
+      }
+      OperationLink &link = (*r_links)[link_index++];
+      link.operation = ((const OperationNode *)other)->index;
+      link.flag = rel->flag;
+    }
+  }
+}
+
+}  // namespace
+
+void deg_graph_build_operation_adjacency(Depsgraph *graph)
+{
+  const int num_operations = graph->operations.size();
+  for (int i = 0; i < num_operations; i++) {
+    graph->operations[i]->index = i;
+  }
+  OperationAdjacency &adjacency = graph->operation_adjacency;
+  build_links(graph, true, &adjacency.outlinks_offset, &adjacency.outlinks);
+  build_links(graph, false, &adjacency.inlinks_offset, &adjacency.inlinks);
+}
+
+void deg_graph_operation_relations_memory(const Depsgraph *graph,
+                                          size_t *r_nodes_memory,
+                                          size_t *r_adjacency_memory)
+{
+  /* Every relation is owned by both of its nodes, count it on the inlinks side only. */
+  size_t nodes_memory = 0;
+  for (const OperationNode *op_node : graph->operations) {
+    nodes_memory += vector_memory(op_node->inlinks) + vector_memory(op_node->outlinks);
+    nodes_memory += op_node->inlinks.size() * sizeof(Relation);
+  }
+  const OperationAdjacency &adjacency = graph->operation_adjacency;
+  *r_nodes_memory = nodes_memory;
+  *r_adjacency_memory = vector_memory(adjacency.outlinks_offset) +
+                        vector_memory(adjacency.outlinks) +
+                        vector_memory(adjacency.inlinks_offset) +
+                        vector_memory(adjacency.inlinks);
+}
+
+}  // namespace DEG
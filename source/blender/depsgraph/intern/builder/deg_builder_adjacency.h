@@ -0,0 +1,40 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2019 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace DEG {
+
+struct Depsgraph;
+
+/* Freeze relations between operations into Depsgraph::operation_adjacency. */
+void deg_graph_build_operation_adjacency(Depsgraph *graph);
+
+/* Memory used by relations between operations, as nodes and as adjacency arrays. */
+void deg_graph_operation_relations_memory(const Depsgraph *graph,
+                                          size_t *r_nodes_memory,
+                                          size_t *r_adjacency_memory);
+
+}  // namespace DEG
@@ -68,6 +68,8 @@ template<typename T> static void remove_from_vector(vector<T> *vector, const T &
 Depsgraph::Depsgraph(Scene *scene, ViewLayer *view_layer, eEvaluationMode mode)
     : time_source(NULL),
       need_update(true),
+      num_flushed_operations(0),
+      flushed_operations_state(FLUSHED_OPERATIONS_NONE),
       scene(scene),
       view_layer(view_layer),
       mode(mode),
@@ -75,6 +77,7 @@ Depsgraph::Depsgraph(Scene *scene, ViewLayer *view_layer, eEvaluationMode mode)
       scene_cow(NULL),
       is_active(false),
       debug_is_evaluating(false),
+      debug_eval_time(0.0),
       is_render_pipeline_depsgraph(false)
 {
   BLI_spin_init(&lock);
@@ -269,6 +272,10 @@ void Depsgraph::add_entry_tag(OperationNode *node)
    * NOTE: this is necessary since we have several thousand nodes to play
    * with. */
   BLI_gset_insert(entry_tags, node);
+  /* Node is tagged for update without being in the flushed operations. */
+  if (flushed_operations_state == FLUSHED_OPERATIONS_VALID) {
+    flushed_operations_state = FLUSHED_OPERATIONS_INVALID;
+  }
 }
 
 void Depsgraph::clear_all_nodes()
@@ -278,6 +285,9 @@ void Depsgraph::clear_all_nodes()
     OBJECT_GUARDED_DELETE(time_source, TimeSourceNode);
     time_source = NULL;
   }
+  num_flushed_operations = 0;
+  flushed_operations_state = FLUSHED_OPERATIONS_NONE;
+  operation_adjacency = OperationAdjacency();
 }
 
 ID *Depsgraph::get_cow_id(const ID *id_orig) const
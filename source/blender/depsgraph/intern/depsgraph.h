@@ -93,9 +93,41 @@ struct Relation {
   int flag;         /* Bitmask of RelationFlag) */
 };
 
+/* Relation between two operations, as stored in OperationAdjacency. */
+struct OperationLink {
+  /* Index of the operation on the other end of the relation in Depsgraph::operations. */
+  int operation;
+  /* Bitmask of RelationFlag. */
+  int flag;
+};
+
+/* Relations between operations frozen into flat arrays once the graph is built, so flush and
+ * evaluation walk contiguous memory instead of chasing pointers to individual relations.
+ *
+ * Children of the operation with index i are outlinks[outlinks_offset[i]] up to
+ * outlinks[outlinks_offset[i + 1] - 1], parents are stored the same way in inlinks.
+ * Relations from or to nodes which are not operations (time source) are not included. */
+struct OperationAdjacency {
+  vector<int> outlinks_offset;
+  vector<OperationLink> outlinks;
+  vector<int> inlinks_offset;
+  vector<OperationLink> inlinks;
+};
+
 /* ********* */
 /* Depsgraph */
 
+/* How much of the graph is known to be tagged for update, see Depsgraph::flushed_operations. */
+enum eFlushedOperationsState {
+  /* No operation is tagged for update, other than the ones in entry_tags. */
+  FLUSHED_OPERATIONS_NONE = 0,
+  /* Every operation tagged for update is in flushed_operations. */
+  FLUSHED_OPERATIONS_VALID,
+  /* Operations got tagged after the flush, or the graph was flushed several times without being
+   * evaluated. Every operation needs to be checked. */
+  FLUSHED_OPERATIONS_INVALID,
+};
+
 /* Dependency Graph object */
 struct Depsgraph {
   // TODO(sergey): Go away from C++ container and use some native BLI.
@@ -160,12 +192,23 @@ struct Depsgraph {
   /* Nodes which have been tagged as "directly modified". */
   GSet *entry_tags;
 
+  /* Operations tagged for update by the last flush, including the entry tags. Allows preparing
+   * evaluation without visiting the whole graph. Only the first num_flushed_operations elements
+   * are used, the storage is kept around to avoid re-allocation on every frame. */
+  OperationNodes flushed_operations;
+  uint32_t num_flushed_operations;
+  eFlushedOperationsState flushed_operations_state;
+
   /* Convenience Data ................... */
 
   /* XXX: should be collected after building (if actually needed?) */
   /* All operation nodes, sorted in order of single-thread traversal order. */
   OperationNodes operations;
 
+  /* Relations between operations, built from the relations of the nodes at the end of graph
+   * construction. Used by update flush and evaluation. */
+  OperationAdjacency operation_adjacency;
+
   /* Spin lock for threading-critical operations.
    * Mainly used by graph evaluation. */
   SpinLock lock;
@@ -197,6 +240,11 @@ struct Depsgraph {
 
   bool debug_is_evaluating;
 
+  /* Timing of the last evaluation, only gathered when G_DEBUG_DEPSGRAPH_TIME is set.
+   * Busy time is indexed by the task scheduler thread ID. */
+  double debug_eval_time;
+  vector<double> debug_thread_busy_time;
+
   /* Is set to truth for dependency graph which are used for post-processing (compositor and
    * sequencer).
    * Such dependency graph needs all view layers (so render pipeline can access names), but it
@@ -46,6 +46,7 @@ extern "C" {
 #include "DEG_depsgraph_build.h"
 
 #include "builder/deg_builder.h"
+#include "builder/deg_builder_adjacency.h"
 #include "builder/deg_builder_cache.h"
 #include "builder/deg_builder_cycle.h"
 #include "builder/deg_builder_nodes.h"
@@ -233,6 +234,15 @@ static void graph_build_finalize_common(DEG::Depsgraph *deg_graph, Main *bmain)
   if (G.debug_value == 799) {
     DEG::deg_graph_transitive_reduction(deg_graph);
   }
+  /* Relations are final now, freeze them for the evaluation. */
+  DEG::deg_graph_build_operation_adjacency(deg_graph);
+  if (G.debug & G_DEBUG_DEPSGRAPH_BUILD) {
+    size_t nodes_memory, adjacency_memory;
+    DEG::deg_graph_operation_relations_memory(deg_graph, &nodes_memory, &adjacency_memory);
+    printf("Depsgraph relations use %.2f KB as nodes, %.2f KB as arrays.\n",
+           nodes_memory / 1024.0,
+           adjacency_memory / 1024.0);
+  }
   /* Store pointers to commonly used valuated datablocks. */
   deg_graph->scene_cow = (Scene *)deg_graph->get_cow_id(&deg_graph->scene->id);
   /* Flush visibility layer and re-schedule nodes for update. */
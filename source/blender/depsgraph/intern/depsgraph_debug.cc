@@ -37,6 +37,7 @@ extern "C" {
 #include "DEG_depsgraph_build.h"
 #include "DEG_depsgraph_query.h"
 
+#include "intern/builder/deg_builder_adjacency.h"
 #include "intern/depsgraph.h"
 #include "intern/depsgraph_type.h"
 #include "intern/debug/deg_debug.h"
@@ -246,6 +247,32 @@ void DEG_stats_simple(const Depsgraph *graph,
   }
 }
 
+void DEG_stats_relations_memory(const Depsgraph *graph,
+                                size_t *r_nodes_memory,
+                                size_t *r_arrays_memory)
+{
+  const DEG::Depsgraph *deg_graph = reinterpret_cast<const DEG::Depsgraph *>(graph);
+  DEG::deg_graph_operation_relations_memory(deg_graph, r_nodes_memory, r_arrays_memory);
+}
+
+double DEG_debug_eval_time_get(const Depsgraph *graph)
+{
+  const DEG::Depsgraph *deg_graph = reinterpret_cast<const DEG::Depsgraph *>(graph);
+  return deg_graph->debug_eval_time;
+}
+
+int DEG_debug_eval_thread_busy_time_get(const Depsgraph *graph,
+                                        double *r_busy_time,
+                                        const int max_threads)
+{
+  const DEG::Depsgraph *deg_graph = reinterpret_cast<const DEG::Depsgraph *>(graph);
+  const int num_threads = MIN2((int)deg_graph->debug_thread_busy_time.size(), max_threads);
+  for (int i = 0; i < num_threads; i++) {
+    r_busy_time[i] = deg_graph->debug_thread_busy_time[i];
+  }
+  return num_threads;
+}
+
 bool DEG_debug_is_evaluating(struct Depsgraph *depsgraph)
 {
   DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(depsgraph);
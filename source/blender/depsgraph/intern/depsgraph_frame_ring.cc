@@ -0,0 +1,257 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ *
+ * Evaluation of consecutive frames on a ring of dependency graphs.
+ *
+ * Every graph of the ring is owned by one worker thread, which evaluates every size'th frame.
+ * Once a frame is evaluated the graph is handed to the caller, and the worker waits for it to be
+ * released before moving on to its next frame. This keeps up to size frames in flight while the
+ * caller consumes them in order.
+ */
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math_base.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+
+namespace {
+
+enum eFrameRingSlotState {
+  /* Graph can be used for evaluating the next frame of the slot. */
+  FRAME_RING_SLOT_FREE = 0,
+  /* Worker thread is evaluating a frame. */
+  FRAME_RING_SLOT_EVALUATING,
+  /* Frame is evaluated, waiting to be acquired. */
+  FRAME_RING_SLOT_READY,
+  /* Caller is using the evaluated frame. */
+  FRAME_RING_SLOT_ACQUIRED,
+};
+
+struct FrameRingSlot {
+  struct DepsgraphFrameRingImpl *ring;
+  Depsgraph *graph;
+  int index;
+  eFrameRingSlotState state;
+  /* Index of the frame which is currently evaluated or ready. */
+  int frame_index;
+};
+
+struct DepsgraphFrameRingImpl {
+  Main *bmain;
+  int size;
+  FrameRingSlot *slots;
+
+  float frame_start, frame_step;
+  int frames_num;
+  /* Index of the next frame to be handed out to the caller. */
+  int frame_next;
+
+  ListBase threads;
+  bool is_running;
+  bool do_stop;
+
+  ThreadMutex mutex;
+  ThreadCondition cond;
+};
+
+float frame_ring_frame_get(const DepsgraphFrameRingImpl *ring, const int frame_index)
+{
+  return ring->frame_start + frame_index * ring->frame_step;
+}
+
+void *frame_ring_thread_func(void *slot_v)
+{
+  FrameRingSlot *slot = (FrameRingSlot *)slot_v;
+  DepsgraphFrameRingImpl *ring = slot->ring;
+
+  for (int frame_index = slot->index; frame_index < ring->frames_num;
+       frame_index += ring->size) {
+    BLI_mutex_lock(&ring->mutex);
+    while (slot->state != FRAME_RING_SLOT_FREE && !ring->do_stop) {
+      BLI_condition_wait(&ring->cond, &ring->mutex);
+    }
+    if (ring->do_stop) {
+      BLI_mutex_unlock(&ring->mutex);
+      break;
+    }
+    slot->state = FRAME_RING_SLOT_EVALUATING;
+    slot->frame_index = frame_index;
+    BLI_mutex_unlock(&ring->mutex);
+
+    /* Recalc flags of the previous frame were seen by the caller, and are only to be kept for
+     * the frame which is being evaluated now. */
+    DEG_ids_clear_recalc(ring->bmain, slot->graph);
+    DEG_evaluate_on_framechange(
+        ring->bmain, slot->graph, frame_ring_frame_get(ring, frame_index));
+
+    BLI_mutex_lock(&ring->mutex);
+    slot->state = FRAME_RING_SLOT_READY;
+    BLI_condition_notify_all(&ring->cond);
+    BLI_mutex_unlock(&ring->mutex);
+  }
+  return NULL;
+}
+
+void frame_ring_stop(DepsgraphFrameRingImpl *ring)
+{
+  if (!ring->is_running) {
+    return;
+  }
+  BLI_mutex_lock(&ring->mutex);
+  ring->do_stop = true;
+  BLI_condition_notify_all(&ring->cond);
+  BLI_mutex_unlock(&ring->mutex);
+
+  BLI_threadpool_end(&ring->threads);
+  ring->is_running = false;
+  ring->do_stop = false;
+
+  for (int i = 0; i < ring->size; i++) {
+    BLI_assert(ring->slots[i].state != FRAME_RING_SLOT_ACQUIRED);
+    ring->slots[i].state = FRAME_RING_SLOT_FREE;
+  }
+}
+
+}  // namespace
+
+DepsgraphFrameRing *DEG_frame_ring_new(
+    Main *bmain, Scene *scene, ViewLayer *view_layer, eEvaluationMode mode, int size)
+{
+  if (size <= 0) {
+    size = BLI_system_thread_count();
+  }
+  size = min_ii(size, BLENDER_MAX_THREADS);
+
+  DepsgraphFrameRingImpl *ring = (DepsgraphFrameRingImpl *)MEM_callocN(
+      sizeof(DepsgraphFrameRingImpl), __func__);
+  ring->bmain = bmain;
+  ring->size = size;
+  ring->slots = (FrameRingSlot *)MEM_callocN(sizeof(FrameRingSlot) * size, __func__);
+  ring->frame_step = 1.0f;
+  BLI_mutex_init(&ring->mutex);
+  BLI_condition_init(&ring->cond);
+
+  /* Graphs are built here on the calling thread, only evaluation happens in the workers. */
+  for (int i = 0; i < size; i++) {
+    FrameRingSlot *slot = &ring->slots[i];
+    slot->ring = ring;
+    slot->index = i;
+    slot->state = FRAME_RING_SLOT_FREE;
+    slot->graph = DEG_graph_new(scene, view_layer, mode);
+    DEG_graph_build_from_view_layer(slot->graph, bmain, scene, view_layer);
+  }
+
+  return reinterpret_cast<DepsgraphFrameRing *>(ring);
+}
+
+void DEG_frame_ring_free(DepsgraphFrameRing *ring_v)
+{
+  DepsgraphFrameRingImpl *ring = reinterpret_cast<DepsgraphFrameRingImpl *>(ring_v);
+  frame_ring_stop(ring);
+  for (int i = 0; i < ring->size; i++) {
+    DEG_graph_free(ring->slots[i].graph);
+  }
+  MEM_freeN(ring->slots);
+  BLI_condition_end(&ring->cond);
+  BLI_mutex_end(&ring->mutex);
+  MEM_freeN(ring);
+}
+
+int DEG_frame_ring_size(const DepsgraphFrameRing *ring_v)
+{
+  const DepsgraphFrameRingImpl *ring = reinterpret_cast<const DepsgraphFrameRingImpl *>(ring_v);
+  return ring->size;
+}
+
+void DEG_frame_ring_start(DepsgraphFrameRing *ring_v,
+                          float frame_start,
+                          float frame_end,
+                          float frame_step)
+{
+  DepsgraphFrameRingImpl *ring = reinterpret_cast<DepsgraphFrameRingImpl *>(ring_v);
+  BLI_assert(frame_step > 0.0f);
+
+  frame_ring_stop(ring);
+
+  ring->frame_start = frame_start;
+  ring->frame_step = frame_step;
+  ring->frames_num = (frame_end >= frame_start) ?
+                         (int)((frame_end - frame_start) / frame_step + 1e-5f) + 1 :
+                         0;
+  ring->frame_next = 0;
+
+  const int threads_num = min_ii(ring->size, ring->frames_num);
+  if (threads_num == 0) {
+    return;
+  }
+  BLI_threadpool_init(&ring->threads, frame_ring_thread_func, threads_num);
+  for (int i = 0; i < threads_num; i++) {
+    BLI_threadpool_insert(&ring->threads, &ring->slots[i]);
+  }
+  ring->is_running = true;
+}
+
+Depsgraph *DEG_frame_ring_acquire_next(DepsgraphFrameRing *ring_v, float *r_frame)
+{
+  DepsgraphFrameRingImpl *ring = reinterpret_cast<DepsgraphFrameRingImpl *>(ring_v);
+  if (!ring->is_running || ring->frame_next >= ring->frames_num) {
+    return NULL;
+  }
+
+  FrameRingSlot *slot = &ring->slots[ring->frame_next % ring->size];
+
+  BLI_mutex_lock(&ring->mutex);
+  while (!(slot->state == FRAME_RING_SLOT_READY && slot->frame_index == ring->frame_next)) {
+    BLI_condition_wait(&ring->cond, &ring->mutex);
+  }
+  slot->state = FRAME_RING_SLOT_ACQUIRED;
+  BLI_mutex_unlock(&ring->mutex);
+
+  if (r_frame) {
+    *r_frame = frame_ring_frame_get(ring, ring->frame_next);
+  }
+  ring->frame_next++;
+  return slot->graph;
+}
+
+void DEG_frame_ring_release(DepsgraphFrameRing *ring_v, Depsgraph *graph)
+{
+  DepsgraphFrameRingImpl *ring = reinterpret_cast<DepsgraphFrameRingImpl *>(ring_v);
+
+  BLI_mutex_lock(&ring->mutex);
+  for (int i = 0; i < ring->size; i++) {
+    FrameRingSlot *slot = &ring->slots[i];
+    if (slot->graph == graph) {
+      BLI_assert(slot->state == FRAME_RING_SLOT_ACQUIRED);
+      slot->state = FRAME_RING_SLOT_FREE;
+      break;
+    }
+  }
+  BLI_condition_notify_all(&ring->cond);
+  BLI_mutex_unlock(&ring->mutex);
+
+  /* All frames were consumed, join the workers. */
+  if (ring->frame_next >= ring->frames_num) {
+    frame_ring_stop(ring);
+  }
+}
@@ -67,6 +67,8 @@ struct DepsgraphEvalState {
   Depsgraph *graph;
   bool do_stats;
   bool is_cow_stage;
+  /* Time spent evaluating operations, per thread. Only used when do_stats is set. */
+  double *thread_busy_time;
 };
 
 static void deg_task_run_func(TaskPool *pool, void *taskdata, int thread_id)
@@ -80,7 +82,9 @@ static void deg_task_run_func(TaskPool *pool, void *taskdata, int thread_id)
   if (state->do_stats) {
     const double start_time = PIL_check_seconds_timer();
     node->evaluate((::Depsgraph *)state->graph);
-    node->stats.current_time += PIL_check_seconds_timer() - start_time;
+    const double eval_time = PIL_check_seconds_timer() - start_time;
+    node->stats.current_time += eval_time;
+    state->thread_busy_time[thread_id] += eval_time;
   }
   else {
     node->evaluate((::Depsgraph *)state->graph);
@@ -93,6 +97,7 @@ static void deg_task_run_func(TaskPool *pool, void *taskdata, int thread_id)
 
 struct CalculatePendingData {
   Depsgraph *graph;
+  OperationNode **operations;
 };
 
 static bool check_operation_node_visible(OperationNode *op_node)
@@ -112,7 +117,7 @@ static void calculate_pending_func(void *__restrict data_v,
 {
   CalculatePendingData *data = (CalculatePendingData *)data_v;
   Depsgraph *graph = data->graph;
-  OperationNode *node = graph->operations[i];
+  OperationNode *node = data->operations[i];
   /* Update counters, applies for both visible and invisible IDs. */
   node->num_links_pending = 0;
   node->scheduled = false;
@@ -124,30 +129,45 @@ static void calculate_pending_func(void *__restrict data_v,
   if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) == 0) {
     return;
   }
-  for (Relation *rel : node->inlinks) {
-    if (rel->from->type == NodeType::OPERATION && (rel->flag & RELATION_FLAG_CYCLIC) == 0) {
-      OperationNode *from = (OperationNode *)rel->from;
-      /* TODO(sergey): This is how old layer system was checking for the
-       * calculation, but how is it possible that visible object depends
-       * on an invisible? This is something what is prohibited after
-       * deg_graph_build_flush_layers(). */
-      if (!check_operation_node_visible(from)) {
-        continue;
-      }
-      /* No need to vait for operation which is up to date. */
-      if ((from->flag & DEPSOP_FLAG_NEEDS_UPDATE) == 0) {
-        continue;
-      }
-      ++node->num_links_pending;
+  const OperationAdjacency &adjacency = graph->operation_adjacency;
+  const int links_end = adjacency.inlinks_offset[node->index + 1];
+  for (int link_index = adjacency.inlinks_offset[node->index]; link_index < links_end;
+       link_index++) {
+    const OperationLink &link = adjacency.inlinks[link_index];
+    if (link.flag & RELATION_FLAG_CYCLIC) {
+      continue;
+    }
+    OperationNode *from = graph->operations[link.operation];
+    /* TODO(sergey): This is how old layer system was checking for the
+     * calculation, but how is it possible that visible object depends
+     * on an invisible? This is something what is prohibited after
+     * deg_graph_build_flush_layers(). */
+    if (!check_operation_node_visible(from)) {
+      continue;
     }
+    /* No need to vait for operation which is up to date. */
+    if ((from->flag & DEPSOP_FLAG_NEEDS_UPDATE) == 0) {
+      continue;
+    }
+    ++node->num_links_pending;
   }
 }
 
 static void calculate_pending_parents(Depsgraph *graph)
 {
-  const int num_operations = graph->operations.size();
+  /* When the flush knows all operations tagged for update, only those need to be prepared:
+   * operations which are not tagged are never scheduled, regardless of their counters. */
   CalculatePendingData data;
   data.graph = graph;
+  int num_operations;
+  if (graph->flushed_operations_state == FLUSHED_OPERATIONS_VALID) {
+    num_operations = graph->num_flushed_operations;
+    data.operations = graph->flushed_operations.data();
+  }
+  else {
+    num_operations = graph->operations.size();
+    data.operations = graph->operations.data();
+  }
   ParallelRangeSettings settings;
   BLI_parallel_range_settings_defaults(&settings);
   settings.min_iter_per_thread = 1024;
@@ -230,14 +250,17 @@ static void schedule_children(TaskPool *pool,
                               OperationNode *node,
                               const int thread_id)
 {
-  for (Relation *rel : node->outlinks) {
-    OperationNode *child = (OperationNode *)rel->to;
-    BLI_assert(child->type == NodeType::OPERATION);
+  const OperationAdjacency &adjacency = graph->operation_adjacency;
+  const int links_end = adjacency.outlinks_offset[node->index + 1];
+  for (int link_index = adjacency.outlinks_offset[node->index]; link_index < links_end;
+       link_index++) {
+    const OperationLink &link = adjacency.outlinks[link_index];
+    OperationNode *child = graph->operations[link.operation];
     if (child->scheduled) {
       /* Happens when having cyclic dependencies. */
       continue;
     }
-    schedule_node(pool, graph, child, (rel->flag & RELATION_FLAG_CYCLIC) == 0, thread_id);
+    schedule_node(pool, graph, child, (link.flag & RELATION_FLAG_CYCLIC) == 0, thread_id);
   }
 }
 
@@ -288,6 +311,14 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
     need_free_scheduler = false;
   }
   TaskPool *task_pool = BLI_task_pool_create_suspended(task_scheduler, &state);
+  /* Thread ID 0 is the thread which waits for the pool, workers start at 1. */
+  if (do_time_debug) {
+    graph->debug_thread_busy_time.assign(BLI_task_scheduler_num_threads(task_scheduler) + 1, 0.0);
+    state.thread_busy_time = &graph->debug_thread_busy_time[0];
+  }
+  else {
+    state.thread_busy_time = NULL;
+  }
   /* Prepare all nodes for evaluation. */
   initialize_execution(&state, graph);
   /* Do actual evaluation now. */
@@ -313,7 +344,8 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   }
   graph->debug_is_evaluating = false;
   if (do_time_debug) {
-    printf("Depsgraph updated in %f seconds.\n", PIL_check_seconds_timer() - start_time);
+    graph->debug_eval_time = PIL_check_seconds_timer() - start_time;
+    printf("Depsgraph updated in %f seconds.\n", graph->debug_eval_time);
   }
 }
 
@@ -25,10 +25,10 @@
 
 #include "intern/eval/deg_eval_flush.h"
 
-// TODO(sergey): Use some sort of wrapper.
-#include <deque>
 #include <cmath>
 
+#include "MEM_guardedalloc.h"
+
 #include "BKE_object.h"
 
 #include "BLI_utildefines.h"
@@ -45,6 +45,8 @@ extern "C" {
 
 #include "DEG_depsgraph.h"
 
+#include "atomic_ops.h"
+
 #include "intern/debug/deg_debug.h"
 #include "intern/depsgraph.h"
 #include "intern/depsgraph_update.h"
@@ -80,7 +82,23 @@ enum {
   COMPONENT_STATE_DONE = 2,
 };
 
-typedef std::deque<OperationNode *> FlushQueue;
+/* Breadth-first traversal of the operations affected by the update.
+ *
+ * Every operation is added to the queue at most once (guarded by OperationNode::scheduled), so
+ * the queue and the list of tagged operations are both bound by the number of operations. The
+ * queue is handled one level at a time: all operations of the current level are handled in
+ * parallel, appending their children to the end of the queue, which becomes the next level. */
+struct FlushState {
+  Depsgraph *graph;
+
+  OperationNode **queue;
+  uint32_t queue_len;
+
+  /* Operations which got DEPSOP_FLAG_NEEDS_UPDATE during this flush, stored into
+   * Depsgraph::flushed_operations. */
+  OperationNode **flushed;
+  uint32_t *flushed_len;
+};
 
 namespace {
 
@@ -123,10 +141,61 @@ BLI_INLINE void flush_prepare(Depsgraph *graph)
   }
 }
 
-BLI_INLINE void flush_schedule_entrypoints(Depsgraph *graph, FlushQueue *queue)
+BLI_INLINE void flush_queue_push(FlushState *state, OperationNode *op_node)
+{
+  const uint32_t index = atomic_fetch_and_add_uint32(&state->queue_len, 1);
+  BLI_assert(index < state->graph->operations.size());
+  state->queue[index] = op_node;
+}
+
+BLI_INLINE void flush_flushed_push(FlushState *state, OperationNode *op_node)
+{
+  const uint32_t index = atomic_fetch_and_add_uint32(state->flushed_len, 1);
+  BLI_assert(index < state->graph->operations.size());
+  state->flushed[index] = op_node;
+}
+
+/* Schedule operation for traversal, unless it was scheduled already. */
+BLI_INLINE void flush_schedule_operation(FlushState *state, OperationNode *op_node)
+{
+  if (op_node->scheduled) {
+    return;
+  }
+  if (atomic_fetch_and_or_uint8((uint8_t *)&op_node->scheduled, (uint8_t) true) == false) {
+    flush_queue_push(state, op_node);
+  }
+}
+
+/* Tag operation for update, remembering it as flushed if it was not tagged yet. */
+BLI_INLINE void flush_tag_operation(FlushState *state, OperationNode *op_node)
 {
+  if (op_node->flag & DEPSOP_FLAG_NEEDS_UPDATE) {
+    return;
+  }
+  const uint32_t flag = atomic_fetch_and_or_uint32((uint32_t *)&op_node->flag,
+                                                   DEPSOP_FLAG_NEEDS_UPDATE);
+  if ((flag & DEPSOP_FLAG_NEEDS_UPDATE) == 0) {
+    flush_flushed_push(state, op_node);
+  }
+}
+
+/* Atomically switch component to the new state, returns false if it was in that state already. */
+BLI_INLINE bool flush_component_state_set(ComponentNode *comp_node,
+                                          const int old_state,
+                                          const int new_state)
+{
+  return atomic_cas_int32((int32_t *)&comp_node->custom_flags, old_state, new_state) ==
+         old_state;
+}
+
+BLI_INLINE void flush_schedule_entrypoints(FlushState *state)
+{
+  Depsgraph *graph = state->graph;
   GSET_FOREACH_BEGIN (OperationNode *, op_node, graph->entry_tags) {
-    queue->push_back(op_node);
+    /* Entry points are tagged already, but are not in the flushed operations yet. */
+    BLI_assert(op_node->flag & DEPSOP_FLAG_NEEDS_UPDATE);
+    flush_queue_push(state, op_node);
+    flush_flushed_push(state, op_node);
     op_node->scheduled = true;
     DEG_DEBUG_PRINTF((::Depsgraph *)graph,
                      EVAL,
@@ -138,19 +207,20 @@ BLI_INLINE void flush_schedule_entrypoints(Depsgraph *graph, FlushQueue *queue)
 
 BLI_INLINE void flush_handle_id_node(IDNode *id_node)
 {
+  /* Same value is written by all threads, no need for atomics. */
   id_node->custom_flags = ID_STATE_MODIFIED;
 }
 
-/* TODO(sergey): We can reduce number of arguments here. */
-BLI_INLINE void flush_handle_component_node(IDNode *id_node,
-                                            ComponentNode *comp_node,
-                                            FlushQueue *queue)
+BLI_INLINE void flush_handle_component_node(FlushState *state,
+                                            IDNode *id_node,
+                                            ComponentNode *comp_node)
 {
-  /* We only handle component once. */
-  if (comp_node->custom_flags == COMPONENT_STATE_DONE) {
+  /* We only handle component once. Component might have been scheduled by an IK solver of the
+   * bone. */
+  if (!flush_component_state_set(comp_node, COMPONENT_STATE_NONE, COMPONENT_STATE_DONE) &&
+      !flush_component_state_set(comp_node, COMPONENT_STATE_SCHEDULED, COMPONENT_STATE_DONE)) {
     return;
   }
-  comp_node->custom_flags = COMPONENT_STATE_DONE;
   /* Tag all required operations in component for update, unless this is a
    * special component where we don't want all operations to be tagged.
    *
@@ -158,7 +228,7 @@ BLI_INLINE void flush_handle_component_node(IDNode *id_node,
   if (comp_node->type != NodeType::PARTICLE_SETTINGS &&
       comp_node->type != NodeType::PARTICLE_SYSTEM) {
     for (OperationNode *op : comp_node->operations) {
-      op->flag |= DEPSOP_FLAG_NEEDS_UPDATE;
+      flush_tag_operation(state, op);
     }
   }
   /* when some target changes bone, we might need to re-run the
@@ -166,25 +236,23 @@ BLI_INLINE void flush_handle_component_node(IDNode *id_node,
   if (comp_node->type == NodeType::BONE) {
     ComponentNode *pose_comp = id_node->find_component(NodeType::EVAL_POSE);
     BLI_assert(pose_comp != NULL);
-    if (pose_comp->custom_flags == COMPONENT_STATE_NONE) {
-      queue->push_front(pose_comp->get_entry_operation());
-      pose_comp->custom_flags = COMPONENT_STATE_SCHEDULED;
+    if (flush_component_state_set(pose_comp, COMPONENT_STATE_NONE, COMPONENT_STATE_SCHEDULED)) {
+      flush_schedule_operation(state, pose_comp->get_entry_operation());
     }
   }
 }
 
-/* Schedule children of the given operation node for traversal.
- *
- * One of the children will by-pass the queue and will be returned as a function
- * return value, so it can start being handled right away, without building too
- * much of a queue.
- */
-BLI_INLINE OperationNode *flush_schedule_children(OperationNode *op_node, FlushQueue *queue)
+/* Schedule children of the given operation node for traversal on the next level. */
+BLI_INLINE void flush_schedule_children(FlushState *state, OperationNode *op_node)
 {
-  OperationNode *result = NULL;
-  for (Relation *rel : op_node->outlinks) {
+  Depsgraph *graph = state->graph;
+  const OperationAdjacency &adjacency = graph->operation_adjacency;
+  const int links_end = adjacency.outlinks_offset[op_node->index + 1];
+  for (int link_index = adjacency.outlinks_offset[op_node->index]; link_index < links_end;
+       link_index++) {
+    const OperationLink &link = adjacency.outlinks[link_index];
     /* Flush is forbidden, completely. */
-    if (rel->flag & RELATION_FLAG_NO_FLUSH) {
+    if (link.flag & RELATION_FLAG_NO_FLUSH) {
       continue;
     }
     if (op_node->flag & DEPSOP_FLAG_USER_MODIFIED) {
@@ -193,27 +261,37 @@ BLI_INLINE OperationNode *flush_schedule_children(OperationNode *op_node, FlushQ
     }
     /* Relation only allows flushes on user changes, but the node was not
      * affected by user. */
-    if ((rel->flag & RELATION_FLAG_FLUSH_USER_EDIT_ONLY) &&
+    if ((link.flag & RELATION_FLAG_FLUSH_USER_EDIT_ONLY) &&
         (op_node->flag & DEPSOP_FLAG_USER_MODIFIED) == 0) {
       continue;
     }
-    OperationNode *to_node = (OperationNode *)rel->to;
+    OperationNode *to_node = graph->operations[link.operation];
     /* Always flush flushable flags, so children always know what happened
      * to their parents. */
-    to_node->flag |= (op_node->flag & DEPSOP_FLAG_FLUSH);
-    /* Flush update over the relation, if it was not flushed yet. */
-    if (to_node->scheduled) {
-      continue;
-    }
-    if (result != NULL) {
-      queue->push_front(to_node);
+    const int flush_flag = (op_node->flag & DEPSOP_FLAG_FLUSH);
+    if ((to_node->flag & flush_flag) != flush_flag) {
+      atomic_fetch_and_or_uint32((uint32_t *)&to_node->flag, flush_flag);
     }
-    else {
-      result = to_node;
-    }
-    to_node->scheduled = true;
+    /* Flush update over the relation, if it was not flushed yet. */
+    flush_schedule_operation(state, to_node);
   }
-  return result;
+}
+
+void flush_operation_func(void *__restrict data_v,
+                          const int i,
+                          const ParallelRangeTLS *__restrict /*tls*/)
+{
+  FlushState *state = (FlushState *)data_v;
+  OperationNode *op_node = state->queue[i];
+  /* Tag operation as required for update. */
+  flush_tag_operation(state, op_node);
+  /* Inform corresponding ID and component nodes about the change. */
+  ComponentNode *comp_node = op_node->owner;
+  IDNode *id_node = comp_node->owner;
+  flush_handle_id_node(id_node);
+  flush_handle_component_node(state, id_node, comp_node);
+  /* Flush to nodes along links. */
+  flush_schedule_children(state, op_node);
 }
 
 void flush_engine_data_update(ID *id)
@@ -353,31 +431,43 @@ void deg_graph_flush_updates(Main *bmain, Depsgraph *graph)
   }
   /* Reset all flags, get ready for the flush. */
   flush_prepare(graph);
+  /* Flushed operations are only usable if nothing else was tagged since the last evaluation. */
+  const bool is_flushed_operations_valid = (graph->flushed_operations_state ==
+                                            FLUSHED_OPERATIONS_NONE);
+  const size_t num_operations = graph->operations.size();
+  if (graph->flushed_operations.size() < num_operations) {
+    graph->flushed_operations.resize(num_operations);
+  }
+  graph->num_flushed_operations = 0;
+  FlushState state;
+  state.graph = graph;
+  state.queue = (OperationNode **)MEM_mallocN(sizeof(OperationNode *) * num_operations,
+                                              "flush queue");
+  state.queue_len = 0;
+  state.flushed = graph->flushed_operations.data();
+  state.flushed_len = &graph->num_flushed_operations;
   /* Starting from the tagged "entry" nodes, flush outwards. */
-  FlushQueue queue;
-  flush_schedule_entrypoints(graph, &queue);
+  flush_schedule_entrypoints(&state);
   /* Prepare update context for editors. */
   DEGEditorUpdateContext update_ctx;
   update_ctx.bmain = bmain;
   update_ctx.depsgraph = (::Depsgraph *)graph;
   update_ctx.scene = graph->scene;
   update_ctx.view_layer = graph->view_layer;
-  /* Do actual flush. */
-  while (!queue.empty()) {
-    OperationNode *op_node = queue.front();
-    queue.pop_front();
-    while (op_node != NULL) {
-      /* Tag operation as required for update. */
-      op_node->flag |= DEPSOP_FLAG_NEEDS_UPDATE;
-      /* Inform corresponding ID and component nodes about the change. */
-      ComponentNode *comp_node = op_node->owner;
-      IDNode *id_node = comp_node->owner;
-      flush_handle_id_node(id_node);
-      flush_handle_component_node(id_node, comp_node, &queue);
-      /* Flush to nodes along links. */
-      op_node = flush_schedule_children(op_node, &queue);
-    }
+  /* Do actual flush, one level of the traversal at a time. Small levels are handled on this
+   * thread, the overhead of threading is higher than handling a few hundreds of operations. */
+  uint32_t level_start = 0;
+  while (level_start < state.queue_len) {
+    const uint32_t level_end = state.queue_len;
+    ParallelRangeSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.min_iter_per_thread = 256;
+    BLI_task_parallel_range(level_start, level_end, &state, flush_operation_func, &settings);
+    level_start = level_end;
   }
+  MEM_freeN(state.queue);
+  graph->flushed_operations_state = is_flushed_operations_valid ? FLUSHED_OPERATIONS_VALID :
+                                                                  FLUSHED_OPERATIONS_INVALID;
   /* Inform editors about all changes. */
   flush_editors_id_update(graph, &update_ctx);
   /* Reset evaluation result tagged which is tagged for update to some state
@@ -409,6 +499,9 @@ void deg_graph_clear_tags(Depsgraph *graph)
   }
   /* Clear any entry tags which haven't been flushed. */
   BLI_gset_clear(graph->entry_tags, NULL);
+  /* No operation is tagged anymore. */
+  graph->num_flushed_operations = 0;
+  graph->flushed_operations_state = FLUSHED_OPERATIONS_NONE;
 }
 
 }  // namespace DEG
@@ -249,6 +249,9 @@ struct OperationNode : public Node {
   /* Callback for operation. */
   DepsEvalOperationCb evaluate;
 
+  /* Index in Depsgraph::operations, set once the graph is built. */
+  int index;
+
   /* How many inlinks are we still waiting on before we can be evaluated. */
   uint32_t num_links_pending;
   bool scheduled;
@@ -25,6 +25,7 @@
 #include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_dlrbTree.h"
+#include "BLI_threads.h"
 
 #include "DNA_anim_types.h"
 #include "DNA_armature_types.h"
@@ -202,6 +203,41 @@ static void motionpaths_calc_bake_targets(ListBase *targets, int cframe)
   }
 }
 
+/* Evaluate the frames on a ring of background depsgraphs, several frames at a time.
+ * The active depsgraph and the current frame are not touched, so there is nothing to restore.
+ *
+ * Only data-blocks are evaluated in the background graphs: frame change handlers are not run for
+ * the frames of the path, and simulations have to be baked (rigid bodies are checked for by
+ * the caller). */
+static void motionpaths_calc_frames_parallel(Depsgraph *depsgraph,
+                                             Main *bmain,
+                                             ListBase *targets,
+                                             const int sfra,
+                                             const int efra)
+{
+  /* Every graph of the ring is a full copy of the view layer, no need for more of them than
+   * there are frames. */
+  const int ring_size = min_ii(BLI_system_thread_count(), efra - sfra + 1);
+  DepsgraphFrameRing *ring = DEG_frame_ring_new(bmain,
+                                                DEG_get_input_scene(depsgraph),
+                                                DEG_get_input_view_layer(depsgraph),
+                                                DEG_get_mode(depsgraph),
+                                                ring_size);
+  DEG_frame_ring_start(ring, (float)sfra, (float)efra, 1.0f);
+
+  Depsgraph *frame_depsgraph;
+  float frame;
+  while ((frame_depsgraph = DEG_frame_ring_acquire_next(ring, &frame))) {
+    for (MPathTarget *mpt = targets->first; mpt; mpt = mpt->next) {
+      mpt->ob_eval = DEG_get_evaluated_object(frame_depsgraph, mpt->ob);
+    }
+    motionpaths_calc_bake_targets(targets, (int)frame);
+    DEG_frame_ring_release(ring, frame_depsgraph);
+  }
+
+  DEG_frame_ring_free(ring);
+}
+
 /* Perform baking of the given object's and/or its bones' transforms to motion paths
  * - scene: current scene
  * - ob: object whose flagged motionpaths should get calculated
@@ -294,27 +330,36 @@ void animviz_calc_motionpaths(Depsgraph *depsgraph,
             sfra,
             efra,
             efra - sfra + 1);
-  for (CFRA = sfra; CFRA <= efra; CFRA++) {
-    if (current_frame_only) {
-      /* For current frame, only update tagged. */
-      BKE_scene_graph_update_tagged(depsgraph, bmain);
+  /* Frames are independent of each other unless there is a simulation stepping through them. */
+  const bool use_parallel_frames = !current_frame_only && (efra > sfra) &&
+                                   (scene->rigidbody_world == NULL) &&
+                                   (BLI_system_thread_count() > 1);
+  if (use_parallel_frames) {
+    motionpaths_calc_frames_parallel(depsgraph, bmain, targets, sfra, efra);
+  }
+  else {
+    for (CFRA = sfra; CFRA <= efra; CFRA++) {
+      if (current_frame_only) {
+        /* For current frame, only update tagged. */
+        BKE_scene_graph_update_tagged(depsgraph, bmain);
+      }
+      else {
+        /* Update relevant data for new frame. */
+        motionpaths_calc_update_scene(bmain, depsgraph);
+      }
+
+      /* perform baking for targets */
+      motionpaths_calc_bake_targets(targets, CFRA);
     }
-    else {
-      /* Update relevant data for new frame. */
+
+    /* reset original environment */
+    /* NOTE: We don't always need to reevaluate the main scene, as the depsgraph
+     * may be a temporary one that works on a subset of the data. We always have
+     * to resoture the current frame though. */
+    CFRA = cfra;
+    if (!current_frame_only && restore) {
       motionpaths_calc_update_scene(bmain, depsgraph);
     }
-
-    /* perform baking for targets */
-    motionpaths_calc_bake_targets(targets, CFRA);
-  }
-
-  /* reset original environment */
-  /* NOTE: We don't always need to reevaluate the main scene, as the depsgraph
-   * may be a temporary one that works on a subset of the data. We always have
-   * to resoture the current frame though. */
-  CFRA = cfra;
-  if (!current_frame_only && restore) {
-    motionpaths_calc_update_scene(bmain, depsgraph);
   }
 
   /* clear recalc flags from targets */
@@ -995,6 +995,46 @@ void node_draw_sockets(View2D *v2d,
   GPU_blend(false);
 }
 
+/* Execution time and buffer memory of the last compositor execution, above the node. */
+static void node_draw_profile(SpaceNode *snode, bNode *node)
+{
+  bNodeTree *ntree = snode->nodetree;
+  if (!(ntree && ntree->type == NTREE_COMPOSIT && (ntree->flag & NTREE_COM_PROFILE))) {
+    return;
+  }
+  if (node->profile_time == 0.0f && node->profile_memory == 0) {
+    return;
+  }
+
+  char str[64];
+  if (node->profile_memory) {
+    BLI_snprintf(str,
+                 sizeof(str),
+                 "%.1f ms, %.1f MB",
+                 node->profile_time * 1000.0f,
+                 (double)node->profile_memory / (1024.0 * 1024.0));
+  }
+  else {
+    BLI_snprintf(str, sizeof(str), "%.1f ms", node->profile_time * 1000.0f);
+  }
+
+  rctf *rct = &node->totr;
+  uiDefBut(node->block,
+           UI_BTYPE_LABEL,
+           0,
+           str,
+           (int)rct->xmin,
+           (int)rct->ymax,
+           (short)BLI_rctf_size_x(rct),
+           (short)NODE_DY,
+           NULL,
+           0,
+           0,
+           0,
+           0,
+           "");
+}
+
 static void node_draw_basis(const bContext *C,
                             ARegion *ar,
                             SpaceNode *snode,
@@ -1199,6 +1239,8 @@ static void node_draw_basis(const bContext *C,
     }
   }
 
+  node_draw_profile(snode, node);
+
   UI_ThemeClearColor(color_id);
 
   UI_block_end(C, node->block);
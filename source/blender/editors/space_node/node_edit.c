@@ -261,7 +261,8 @@ static void compo_startjob(void *cjv, short *stop, short *do_update, float *prog
   /* 1 is do_previews */
 
   if ((cj->scene->r.scemode & R_MULTIVIEW) == 0) {
-    ntreeCompositExecTree(cj->scene,
+    ntreeCompositExecTree(NULL,
+                          cj->scene,
                           ntree,
                           &cj->scene->r,
                           false,
@@ -275,7 +276,8 @@ static void compo_startjob(void *cjv, short *stop, short *do_update, float *prog
       if (BKE_scene_multiview_is_render_view_active(&scene->r, srv) == false) {
         continue;
       }
-      ntreeCompositExecTree(cj->scene,
+      ntreeCompositExecTree(NULL,
+                            cj->scene,
                             ntree,
                             &cj->scene->r,
                             false,
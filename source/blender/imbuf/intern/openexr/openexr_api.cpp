@@ -1207,17 +1207,47 @@ void IMB_exrtile_write_channels(
   }
 }
 
+/* check if exr was saved with previous versions of blender which flipped images */
+static bool imb_exr_is_flipped(MultiPartInputFile &file)
+{
+  const StringAttribute *ta = file.header(0).findTypedAttribute<StringAttribute>(
+      "BlenderMultiChannel");
+  return (ta && STREQLEN(ta->value().c_str(),
+                         "Blender V2.43",
+                         13)); /* 'previous multilayer attribute, flipped */
+}
+
+static void imb_exr_insert_channel_slice(FrameBuffer &frameBuffer,
+                                         ExrChannel *echan,
+                                         const Box2i &dw,
+                                         int width,
+                                         int height,
+                                         bool flip)
+{
+  float *rect = echan->rect;
+  size_t xstride = echan->xstride * sizeof(float);
+  size_t ystride = echan->ystride * sizeof(float);
+
+  if (!flip) {
+    /* inverse correct first pixel for datawindow coordinates */
+    rect -= echan->xstride * (dw.min.x - dw.min.y * width);
+    /* move to last scanline to flip to Blender convention */
+    rect += echan->xstride * (height - 1) * width;
+    ystride = -ystride;
+  }
+  else {
+    /* inverse correct first pixel for datawindow coordinates */
+    rect -= echan->xstride * (dw.min.x + dw.min.y * width);
+  }
+
+  frameBuffer.insert(echan->m->internal_name, Slice(Imf::FLOAT, (char *)rect, xstride, ystride));
+}
+
 void IMB_exr_read_channels(void *handle)
 {
   ExrHandle *data = (ExrHandle *)handle;
   int numparts = data->ifile->parts();
-
-  /* check if exr was saved with previous versions of blender which flipped images */
-  const StringAttribute *ta = data->ifile->header(0).findTypedAttribute<StringAttribute>(
-      "BlenderMultiChannel");
-  short flip = (ta && STREQLEN(ta->value().c_str(),
-                               "Blender V2.43",
-                               13)); /* 'previous multilayer attribute, flipped */
+  const bool flip = imb_exr_is_flipped(*data->ifile);
 
   exr_printf(
       "\nIMB_exr_read_channels\n%s %-6s %-22s "
@@ -1249,24 +1279,7 @@ void IMB_exr_read_channels(void *handle)
                  echan->m->internal_name.c_str());
 
       if (echan->rect) {
-        float *rect = echan->rect;
-        size_t xstride = echan->xstride * sizeof(float);
-        size_t ystride = echan->ystride * sizeof(float);
-
-        if (!flip) {
-          /* inverse correct first pixel for datawindow coordinates */
-          rect -= echan->xstride * (dw.min.x - dw.min.y * data->width);
-          /* move to last scanline to flip to Blender convention */
-          rect += echan->xstride * (data->height - 1) * data->width;
-          ystride = -ystride;
-        }
-        else {
-          /* inverse correct first pixel for datawindow coordinates */
-          rect -= echan->xstride * (dw.min.x + dw.min.y * data->width);
-        }
-
-        frameBuffer.insert(echan->m->internal_name,
-                           Slice(Imf::FLOAT, (char *)rect, xstride, ystride));
+        imb_exr_insert_channel_slice(frameBuffer, echan, dw, data->width, data->height, flip);
       }
       else {
         printf("warning, channel with no rect set %s\n", echan->m->internal_name.c_str());
@@ -1527,6 +1540,106 @@ static ExrPass *imb_exr_get_pass(ListBase *lb, char *passname)
   return pass;
 }
 
+/* makes a hierarchy of layers and passes out of the channels */
+static bool imb_exr_build_layers(ExrHandle *data)
+{
+  ExrChannel *echan;
+  char layname[EXR_TOT_MAXNAME], passname[EXR_TOT_MAXNAME];
+
+  for (echan = (ExrChannel *)data->channels.first; echan; echan = echan->next) {
+    if (imb_exr_split_channel_name(echan, layname, passname)) {
+
+      const char *view = echan->m->view.c_str();
+      char internal_name[EXR_PASS_MAXNAME];
+
+      BLI_strncpy(internal_name, passname, EXR_PASS_MAXNAME);
+
+      if (view[0] != '\0') {
+        char tmp_pass[EXR_PASS_MAXNAME];
+        BLI_snprintf(tmp_pass, sizeof(tmp_pass), "%s.%s", passname, view);
+        BLI_strncpy(passname, tmp_pass, sizeof(passname));
+      }
+
+      ExrLayer *lay = imb_exr_get_layer(&data->layers, layname);
+      ExrPass *pass = imb_exr_get_pass(&lay->passes, passname);
+
+      pass->chan[pass->totchan] = echan;
+      pass->totchan++;
+      pass->view_id = echan->view_id;
+      BLI_strncpy(pass->view, view, sizeof(pass->view));
+      BLI_strncpy(pass->internal_name, internal_name, EXR_PASS_MAXNAME);
+
+      if (pass->totchan >= EXR_PASS_MAXCHAN) {
+        break;
+      }
+    }
+  }
+  if (echan) {
+    printf("error, too many channels in one pass: %s\n", echan->m->name.c_str());
+    return false;
+  }
+  return true;
+}
+
+/* with some heuristics, try to merge the channels of a pass in one buffer */
+static void imb_exr_pass_set_rect(ExrPass *pass, float *rect, int width)
+{
+  ExrChannel *echan;
+  int a;
+
+  if (pass->totchan == 1) {
+    echan = pass->chan[0];
+    echan->rect = rect;
+    echan->xstride = 1;
+    echan->ystride = width;
+    pass->chan_id[0] = echan->chan_id;
+  }
+  else {
+    char lookup[256];
+
+    memset(lookup, 0, sizeof(lookup));
+
+    /* we can have RGB(A), XYZ(W), UVA */
+    if (pass->totchan == 3 || pass->totchan == 4) {
+      if (pass->chan[0]->chan_id == 'B' || pass->chan[1]->chan_id == 'B' ||
+          pass->chan[2]->chan_id == 'B') {
+        lookup[(unsigned int)'R'] = 0;
+        lookup[(unsigned int)'G'] = 1;
+        lookup[(unsigned int)'B'] = 2;
+        lookup[(unsigned int)'A'] = 3;
+      }
+      else if (pass->chan[0]->chan_id == 'Y' || pass->chan[1]->chan_id == 'Y' ||
+               pass->chan[2]->chan_id == 'Y') {
+        lookup[(unsigned int)'X'] = 0;
+        lookup[(unsigned int)'Y'] = 1;
+        lookup[(unsigned int)'Z'] = 2;
+        lookup[(unsigned int)'W'] = 3;
+      }
+      else {
+        lookup[(unsigned int)'U'] = 0;
+        lookup[(unsigned int)'V'] = 1;
+        lookup[(unsigned int)'A'] = 2;
+      }
+      for (a = 0; a < pass->totchan; a++) {
+        echan = pass->chan[a];
+        echan->rect = rect + lookup[(unsigned int)echan->chan_id];
+        echan->xstride = pass->totchan;
+        echan->ystride = width * pass->totchan;
+        pass->chan_id[(unsigned int)lookup[(unsigned int)echan->chan_id]] = echan->chan_id;
+      }
+    }
+    else { /* unknown */
+      for (a = 0; a < pass->totchan; a++) {
+        echan = pass->chan[a];
+        echan->rect = rect + a;
+        echan->xstride = pass->totchan;
+        echan->ystride = width * pass->totchan;
+        pass->chan_id[a] = echan->chan_id;
+      }
+    }
+  }
+}
+
 /* creates channels, makes a hierarchy and assigns memory to channels */
 static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream,
                                          MultiPartInputFile &file,
@@ -1537,8 +1650,6 @@ static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream,
   ExrPass *pass;
   ExrChannel *echan;
   ExrHandle *data = (ExrHandle *)IMB_exr_get_handle();
-  int a;
-  char layname[EXR_TOT_MAXNAME], passname[EXR_TOT_MAXNAME];
 
   data->ifile_stream = &file_stream;
   data->ifile = &file;
@@ -1564,97 +1675,17 @@ static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream,
 
   /* now try to sort out how to assign memory to the channels */
   /* first build hierarchical layer list */
-  for (echan = (ExrChannel *)data->channels.first; echan; echan = echan->next) {
-    if (imb_exr_split_channel_name(echan, layname, passname)) {
-
-      const char *view = echan->m->view.c_str();
-      char internal_name[EXR_PASS_MAXNAME];
-
-      BLI_strncpy(internal_name, passname, EXR_PASS_MAXNAME);
-
-      if (view[0] != '\0') {
-        char tmp_pass[EXR_PASS_MAXNAME];
-        BLI_snprintf(tmp_pass, sizeof(tmp_pass), "%s.%s", passname, view);
-        BLI_strncpy(passname, tmp_pass, sizeof(passname));
-      }
-
-      ExrLayer *lay = imb_exr_get_layer(&data->layers, layname);
-      ExrPass *pass = imb_exr_get_pass(&lay->passes, passname);
-
-      pass->chan[pass->totchan] = echan;
-      pass->totchan++;
-      pass->view_id = echan->view_id;
-      BLI_strncpy(pass->view, view, sizeof(pass->view));
-      BLI_strncpy(pass->internal_name, internal_name, EXR_PASS_MAXNAME);
-
-      if (pass->totchan >= EXR_PASS_MAXCHAN) {
-        break;
-      }
-    }
-  }
-  if (echan) {
-    printf("error, too many channels in one pass: %s\n", echan->m->name.c_str());
+  if (!imb_exr_build_layers(data)) {
     IMB_exr_close(data);
     return NULL;
   }
 
-  /* with some heuristics, try to merge the channels in buffers */
   for (lay = (ExrLayer *)data->layers.first; lay; lay = lay->next) {
     for (pass = (ExrPass *)lay->passes.first; pass; pass = pass->next) {
       if (pass->totchan) {
         pass->rect = (float *)MEM_mapallocN(width * height * pass->totchan * sizeof(float),
                                             "pass rect");
-        if (pass->totchan == 1) {
-          echan = pass->chan[0];
-          echan->rect = pass->rect;
-          echan->xstride = 1;
-          echan->ystride = width;
-          pass->chan_id[0] = echan->chan_id;
-        }
-        else {
-          char lookup[256];
-
-          memset(lookup, 0, sizeof(lookup));
-
-          /* we can have RGB(A), XYZ(W), UVA */
-          if (pass->totchan == 3 || pass->totchan == 4) {
-            if (pass->chan[0]->chan_id == 'B' || pass->chan[1]->chan_id == 'B' ||
-                pass->chan[2]->chan_id == 'B') {
-              lookup[(unsigned int)'R'] = 0;
-              lookup[(unsigned int)'G'] = 1;
-              lookup[(unsigned int)'B'] = 2;
-              lookup[(unsigned int)'A'] = 3;
-            }
-            else if (pass->chan[0]->chan_id == 'Y' || pass->chan[1]->chan_id == 'Y' ||
-                     pass->chan[2]->chan_id == 'Y') {
-              lookup[(unsigned int)'X'] = 0;
-              lookup[(unsigned int)'Y'] = 1;
-              lookup[(unsigned int)'Z'] = 2;
-              lookup[(unsigned int)'W'] = 3;
-            }
-            else {
-              lookup[(unsigned int)'U'] = 0;
-              lookup[(unsigned int)'V'] = 1;
-              lookup[(unsigned int)'A'] = 2;
-            }
-            for (a = 0; a < pass->totchan; a++) {
-              echan = pass->chan[a];
-              echan->rect = pass->rect + lookup[(unsigned int)echan->chan_id];
-              echan->xstride = pass->totchan;
-              echan->ystride = width * pass->totchan;
-              pass->chan_id[(unsigned int)lookup[(unsigned int)echan->chan_id]] = echan->chan_id;
-            }
-          }
-          else { /* unknown */
-            for (a = 0; a < pass->totchan; a++) {
-              echan = pass->chan[a];
-              echan->rect = pass->rect + a;
-              echan->xstride = pass->totchan;
-              echan->ystride = width * pass->totchan;
-              pass->chan_id[a] = echan->chan_id;
-            }
-          }
-        }
+        imb_exr_pass_set_rect(pass, pass->rect, width);
       }
     }
   }
@@ -1662,6 +1693,117 @@ static ExrHandle *imb_exr_begin_read_mem(IStream &file_stream,
   return data;
 }
 
+/* ********************************************************* */
+/* Reading single passes of a multilayer file, as far as they are needed. */
+
+int IMB_exr_begin_read_passes(void *handle, const char *filename, int *width, int *height)
+{
+  ExrHandle *data = (ExrHandle *)handle;
+
+  if (!IMB_exr_begin_read(handle, filename, width, height)) {
+    return 0;
+  }
+  return imb_exr_build_layers(data);
+}
+
+const char *IMB_exr_layer_name(void *handle, int layer_index)
+{
+  ExrHandle *data = (ExrHandle *)handle;
+  ExrLayer *lay = (ExrLayer *)BLI_findlink(&data->layers, layer_index);
+  return lay ? lay->name : NULL;
+}
+
+int IMB_exr_views_num(void *handle)
+{
+  ExrHandle *data = (ExrHandle *)handle;
+  return data->multiView->size();
+}
+
+const char *IMB_exr_view_name(void *handle, int view_index)
+{
+  ExrHandle *data = (ExrHandle *)handle;
+  if (view_index < 0 || (size_t)view_index >= data->multiView->size()) {
+    return NULL;
+  }
+  return (*data->multiView)[view_index].c_str();
+}
+
+/* viewname NULL finds the pass of any view */
+static ExrPass *imb_exr_find_pass(ExrHandle *data,
+                                  const char *layname,
+                                  const char *passname,
+                                  const char *viewname)
+{
+  ExrLayer *lay = (ExrLayer *)BLI_findstring(&data->layers, layname, offsetof(ExrLayer, name));
+  if (lay == NULL) {
+    return NULL;
+  }
+  for (ExrPass *pass = (ExrPass *)lay->passes.first; pass; pass = pass->next) {
+    if (STREQ(pass->internal_name, passname) &&
+        (viewname == NULL || STREQ(pass->view, viewname))) {
+      return pass;
+    }
+  }
+  return NULL;
+}
+
+int IMB_exr_pass_channels(void *handle,
+                          const char *layname,
+                          const char *passname,
+                          const char *viewname)
+{
+  ExrPass *pass = imb_exr_find_pass((ExrHandle *)handle, layname, passname, viewname);
+  return pass ? pass->totchan : 0;
+}
+
+/* rect is the full buffer of the pass, only rows ymin to ymax (excluded) are read into it,
+ * counted from the bottom like Blender does */
+bool IMB_exr_read_pass_rows(void *handle,
+                            const char *layname,
+                            const char *passname,
+                            const char *viewname,
+                            float *rect,
+                            int ymin,
+                            int ymax)
+{
+  ExrHandle *data = (ExrHandle *)handle;
+  ExrPass *pass = imb_exr_find_pass(data, layname, passname, viewname);
+
+  if (data->ifile == NULL || pass == NULL || pass->totchan == 0) {
+    return false;
+  }
+
+  imb_exr_pass_set_rect(pass, rect, data->width);
+
+  const bool flip = imb_exr_is_flipped(*data->ifile);
+
+  try {
+    /* All channels of a pass are stored in the same part. */
+    InputPart in(*data->ifile, pass->chan[0]->m->part_number);
+    Box2i dw = in.header().dataWindow();
+
+    FrameBuffer frameBuffer;
+    for (int a = 0; a < pass->totchan; a++) {
+      imb_exr_insert_channel_slice(
+          frameBuffer, pass->chan[a], dw, data->width, data->height, flip);
+    }
+    in.setFrameBuffer(frameBuffer);
+
+    if (!flip) {
+      in.readPixels(dw.min.y + data->height - ymax, dw.min.y + data->height - 1 - ymin);
+    }
+    else {
+      in.readPixels(dw.min.y + ymin, dw.min.y + ymax - 1);
+    }
+  }
+  catch (const std::exception &exc) {
+    std::cerr << "OpenEXR-readPixels: ERROR: " << exc.what() << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
 /* ********************************************************* */
 
 /* debug only */
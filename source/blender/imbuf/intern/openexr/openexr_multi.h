@@ -96,6 +96,23 @@ void IMB_exr_add_view(void *handle, const char *name);
 
 bool IMB_exr_has_multilayer(void *handle);
 
+/* Reading single passes of multilayer files, without loading the other passes. */
+int IMB_exr_begin_read_passes(void *handle, const char *filename, int *width, int *height);
+const char *IMB_exr_layer_name(void *handle, int layer_index);
+int IMB_exr_views_num(void *handle);
+const char *IMB_exr_view_name(void *handle, int view_index);
+int IMB_exr_pass_channels(void *handle,
+                          const char *layname,
+                          const char *passname,
+                          const char *viewname);
+bool IMB_exr_read_pass_rows(void *handle,
+                            const char *layname,
+                            const char *passname,
+                            const char *viewname,
+                            float *rect,
+                            int ymin,
+                            int ymax);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
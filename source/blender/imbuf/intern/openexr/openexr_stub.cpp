@@ -128,3 +128,40 @@ bool IMB_exr_has_multilayer(void * /*handle*/)
 {
   return false;
 }
+
+int IMB_exr_begin_read_passes(void * /*handle*/,
+                              const char * /*filename*/,
+                              int * /*width*/,
+                              int * /*height*/)
+{
+  return 0;
+}
+const char *IMB_exr_layer_name(void * /*handle*/, int /*layer_index*/)
+{
+  return NULL;
+}
+int IMB_exr_views_num(void * /*handle*/)
+{
+  return 0;
+}
+const char *IMB_exr_view_name(void * /*handle*/, int /*view_index*/)
+{
+  return NULL;
+}
+int IMB_exr_pass_channels(void * /*handle*/,
+                          const char * /*layname*/,
+                          const char * /*passname*/,
+                          const char * /*viewname*/)
+{
+  return 0;
+}
+bool IMB_exr_read_pass_rows(void * /*handle*/,
+                            const char * /*layname*/,
+                            const char * /*passname*/,
+                            const char * /*viewname*/,
+                            float * /*rect*/,
+                            int /*ymin*/,
+                            int /*ymax*/)
+{
+  return false;
+}
@@ -134,7 +134,12 @@ typedef struct Image {
 
   int lastused;
   short ok;
-  char _pad4[6];
+  char _pad4[2];
+  /**
+   * Changes when the pixels are reloaded or painted, see #BKE_image_mark_dirty.
+   * Runtime only, a new value is set when reading files.
+   */
+  int update_count;
 
   /* for generated images */
   int gen_x, gen_y;
@@ -272,6 +272,17 @@ typedef struct bNode {
   /** Used at runtime when going through the tree. Initialize before use. */
   short tmp_flag;
   char _pad2[2];
+  /**
+   * Runtime, statistics of the last compositor execution with #NTREE_COM_PROFILE,
+   * summed over all operations of the node.
+   */
+  /** Number of pixels calculated. */
+  int64_t profile_pixels;
+  /** Size of the buffers holding the results of the node, in bytes. */
+  int64_t profile_memory;
+  /** Execution time in seconds. */
+  float profile_time;
+  char _pad3[4];
   /** Runtime during drawing. */
   struct uiBlock *block;
 
@@ -500,6 +511,10 @@ typedef struct bNodeTree {
 
 /* tree is localized copy, free when deleting node groups */
 /* #define NTREE_IS_LOCALIZED           (1 << 5) */
+#define NTREE_COM_BUFFER_EXECUTION (1 << 6) /* evaluate operations on whole areas */
+#define NTREE_COM_HALF_BUFFERS (1 << 7)     /* store intermediate buffers as half floats */
+#define NTREE_COM_PROFILE (1 << 8)          /* record execution time and memory per node */
+#define NTREE_COM_PARALLEL_FRAMES (1 << 9)  /* composite frames at once in background renders */
 
 /* ntree->update */
 typedef enum eNodeTreeUpdate {
@@ -661,7 +661,8 @@ typedef struct UserDef {
   char _pad13[4];
   struct SolidLight light_param[4];
   float light_ambient[3];
-  char _pad3[4];
+  /** Memory limit of the compositor buffer cache, in megabytes. */
+  int compositor_cache_limit;
   short gizmo_flag, gizmo_size;
   short edit_studio_light;
   short lookdev_sphere_size;
@@ -671,7 +672,8 @@ typedef struct UserDef {
   int prefetchframes;
   /** Control the rotation step of the view when PAD2, PAD4, PAD6&PAD8 is use. */
   float pad_rot_angle;
-  char _pad12[4];
+  /** Memory limit of the evaluated mesh cache, in megabytes. */
+  int mesh_eval_cache_limit;
   /** Rotating view icon size. */
   short rvisize;
   /** Rotating view icon brightness. */
@@ -794,149 +794,6 @@ static eSDNA_Type sdna_type_nr(const char *dna_type)
   }
 }
 
-/**
- * Converts a value of one primitive type to another.
- * Note there is no optimization for the case where otype and ctype are the same:
- * assumption is that caller will handle this case.
- *
- * \param ctype: Name of type to convert to
- * \param otype: Name of type to convert from
- * \param name_array_len: Result of #DNA_elem_array_size for this element.
- * \param curdata: Where to put converted data
- * \param olddata: Data of type otype to convert
- */
-static void cast_elem(
-    const char *ctype, const char *otype, int name_array_len, char *curdata, const char *olddata)
-{
-  double val = 0.0;
-  int curlen = 1, oldlen = 1;
-
-  eSDNA_Type ctypenr, otypenr;
-
-  if ((otypenr = sdna_type_nr(otype)) == -1 || (ctypenr = sdna_type_nr(ctype)) == -1) {
-    return;
-  }
-
-  /* define lengths */
-  oldlen = DNA_elem_type_size(otypenr);
-  curlen = DNA_elem_type_size(ctypenr);
-
-  while (name_array_len > 0) {
-    switch (otypenr) {
-      case SDNA_TYPE_CHAR:
-        val = *olddata;
-        break;
-      case SDNA_TYPE_UCHAR:
-        val = *((unsigned char *)olddata);
-        break;
-      case SDNA_TYPE_SHORT:
-        val = *((short *)olddata);
-        break;
-      case SDNA_TYPE_USHORT:
-        val = *((unsigned short *)olddata);
-        break;
-      case SDNA_TYPE_INT:
-        val = *((int *)olddata);
-        break;
-      case SDNA_TYPE_FLOAT:
-        val = *((float *)olddata);
-        break;
-      case SDNA_TYPE_DOUBLE:
-        val = *((double *)olddata);
-        break;
-      case SDNA_TYPE_INT64:
-        val = *((int64_t *)olddata);
-        break;
-      case SDNA_TYPE_UINT64:
-        val = *((uint64_t *)olddata);
-        break;
-    }
-
-    switch (ctypenr) {
-      case SDNA_TYPE_CHAR:
-        *curdata = val;
-        break;
-      case SDNA_TYPE_UCHAR:
-        *((unsigned char *)curdata) = val;
-        break;
-      case SDNA_TYPE_SHORT:
-        *((short *)curdata) = val;
-        break;
-      case SDNA_TYPE_USHORT:
-        *((unsigned short *)curdata) = val;
-        break;
-      case SDNA_TYPE_INT:
-        *((int *)curdata) = val;
-        break;
-      case SDNA_TYPE_FLOAT:
-        if (otypenr < 2) {
-          val /= 255;
-        }
-        *((float *)curdata) = val;
-        break;
-      case SDNA_TYPE_DOUBLE:
-        if (otypenr < 2) {
-          val /= 255;
-        }
-        *((double *)curdata) = val;
-        break;
-      case SDNA_TYPE_INT64:
-        *((int64_t *)curdata) = val;
-        break;
-      case SDNA_TYPE_UINT64:
-        *((uint64_t *)curdata) = val;
-        break;
-    }
-
-    olddata += oldlen;
-    curdata += curlen;
-    name_array_len--;
-  }
-}
-
-/**
- * Converts pointer values between different sizes. These are only used
- * as lookup keys to identify data blocks in the saved .blend file, not
- * as actual in-memory pointers.
- *
- * \param curlen: Pointer length to conver to
- * \param oldlen: Length of pointers in olddata
- * \param name_array_len: Result of #DNA_elem_array_size for this element.
- * \param curdata: Where to put converted data
- * \param olddata: Data to convert
- */
-static void cast_pointer(
-    int curlen, int oldlen, int name_array_len, char *curdata, const char *olddata)
-{
-  int64_t lval;
-
-  while (name_array_len > 0) {
-
-    if (curlen == oldlen) {
-      memcpy(curdata, olddata, curlen);
-    }
-    else if (curlen == 4 && oldlen == 8) {
-      lval = *((int64_t *)olddata);
-
-      /* WARNING: 32-bit Blender trying to load file saved by 64-bit Blender,
-       * pointers may lose uniqueness on truncation! (Hopefully this wont
-       * happen unless/until we ever get to multi-gigabyte .blend files...) */
-      *((int *)curdata) = lval >> 3;
-    }
-    else if (curlen == 8 && oldlen == 4) {
-      *((int64_t *)curdata) = *((int *)olddata);
-    }
-    else {
-      /* for debug */
-      printf("errpr: illegal pointersize!\n");
-    }
-
-    olddata += oldlen;
-    curdata += curlen;
-    name_array_len--;
-  }
-}
-
 /**
  * Equality test on name and oname excluding any array-size suffix.
  */
@@ -1077,25 +934,258 @@ static const char *find_elem(const SDNA *sdna,
   return NULL;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Struct Reconstruction
+ *
+ * Converting a struct from the SDNA of a file to the current SDNA is compiled once per struct
+ * type into a list of steps (copies, casts and nested structs), instead of matching every member
+ * by name for every struct instance which is read.
+ * Consecutive members which didn't change are copied with a single #memcpy.
+ * \{ */
+
+typedef enum eReconstructStepType {
+  /** Copy bytes unchanged. */
+  RECONSTRUCT_STEP_MEMCPY,
+  /** Convert an array of primitive values to another primitive type. */
+  RECONSTRUCT_STEP_CAST_PRIMITIVE,
+  /** Convert an array of pointers to another pointer size. */
+  RECONSTRUCT_STEP_CAST_POINTER,
+  /** Reconstruct an array of structs with their own steps. */
+  RECONSTRUCT_STEP_SUBSTRUCT,
+} eReconstructStepType;
+
+typedef struct ReconstructStep {
+  eReconstructStepType type;
+  /** Offset of the data in the old and the new struct. */
+  int old_offset;
+  int new_offset;
+  union {
+    struct {
+      int size;
+    } memcpy;
+    struct {
+      eSDNA_Type old_type;
+      eSDNA_Type new_type;
+      int array_len;
+    } cast_primitive;
+    struct {
+      int array_len;
+    } cast_pointer;
+    struct {
+      int old_struct_nr;
+      int array_len;
+      int old_stride;
+      int new_stride;
+    } substruct;
+  } data;
+} ReconstructStep;
+
+typedef struct DNA_ReconstructInfo {
+  const SDNA *oldsdna;
+  const SDNA *newsdna;
+  const char *compare_flags;
+
+  /** Steps by struct number of #oldsdna, NULL for structs which are not in #newsdna. */
+  ReconstructStep **steps;
+  int *steps_len;
+} DNA_ReconstructInfo;
+
+/**
+ * Converts an array of values of one primitive type to another.
+ * Note there is no optimization for the case where both types are the same,
+ * such members are copied with #RECONSTRUCT_STEP_MEMCPY.
+ */
+static void cast_primitive_type(const eSDNA_Type old_type,
+                                const eSDNA_Type new_type,
+                                int array_len,
+                                const char *olddata,
+                                char *curdata)
+{
+  const int oldlen = DNA_elem_type_size(old_type);
+  const int curlen = DNA_elem_type_size(new_type);
+  double val = 0.0;
+
+  while (array_len > 0) {
+    switch (old_type) {
+      case SDNA_TYPE_CHAR:
+        val = *olddata;
+        break;
+      case SDNA_TYPE_UCHAR:
+        val = *((unsigned char *)olddata);
+        break;
+      case SDNA_TYPE_SHORT:
+        val = *((short *)olddata);
+        break;
+      case SDNA_TYPE_USHORT:
+        val = *((unsigned short *)olddata);
+        break;
+      case SDNA_TYPE_INT:
+        val = *((int *)olddata);
+        break;
+      case SDNA_TYPE_FLOAT:
+        val = *((float *)olddata);
+        break;
+      case SDNA_TYPE_DOUBLE:
+        val = *((double *)olddata);
+        break;
+      case SDNA_TYPE_INT64:
+        val = *((int64_t *)olddata);
+        break;
+      case SDNA_TYPE_UINT64:
+        val = *((uint64_t *)olddata);
+        break;
+    }
+
+    switch (new_type) {
+      case SDNA_TYPE_CHAR:
+        *curdata = val;
+        break;
+      case SDNA_TYPE_UCHAR:
+        *((unsigned char *)curdata) = val;
+        break;
+      case SDNA_TYPE_SHORT:
+        *((short *)curdata) = val;
+        break;
+      case SDNA_TYPE_USHORT:
+        *((unsigned short *)curdata) = val;
+        break;
+      case SDNA_TYPE_INT:
+        *((int *)curdata) = val;
+        break;
+      case SDNA_TYPE_FLOAT:
+        if (old_type < 2) {
+          val /= 255;
+        }
+        *((float *)curdata) = val;
+        break;
+      case SDNA_TYPE_DOUBLE:
+        if (old_type < 2) {
+          val /= 255;
+        }
+        *((double *)curdata) = val;
+        break;
+      case SDNA_TYPE_INT64:
+        *((int64_t *)curdata) = val;
+        break;
+      case SDNA_TYPE_UINT64:
+        *((uint64_t *)curdata) = val;
+        break;
+    }
+
+    olddata += oldlen;
+    curdata += curlen;
+    array_len--;
+  }
+}
+
 /**
- * Converts the contents of a single field of a struct, of a non-struct type,
- * from oldsdna to newsdna format.
+ * Converts pointer values between different sizes. These are only used
+ * as lookup keys to identify data blocks in the saved .blend file, not
+ * as actual in-memory pointers.
  *
- * \param newsdna: SDNA of current Blender
- * \param oldsdna: SDNA of Blender that saved file
- * \param type: current field type name
- * \param new_name_nr: current field name number.
- * \param curdata: put field data converted to newsdna here
- * \param old: pointer to struct info in oldsdna
- * \param olddata: struct contents laid out according to oldsdna
+ * \param curlen: Pointer length to conver to
+ * \param oldlen: Length of pointers in olddata
+ * \param name_array_len: Result of #DNA_elem_array_size for this element.
+ * \param curdata: Where to put converted data
+ * \param olddata: Data to convert
  */
-static void reconstruct_elem(const SDNA *newsdna,
-                             const SDNA *oldsdna,
-                             const char *type,
-                             const int new_name_nr,
-                             char *curdata,
-                             const short *old,
-                             const char *olddata)
+static void cast_pointer(
+    int curlen, int oldlen, int name_array_len, char *curdata, const char *olddata)
+{
+  int64_t lval;
+
+  while (name_array_len > 0) {
+
+    if (curlen == oldlen) {
+      memcpy(curdata, olddata, curlen);
+    }
+    else if (curlen == 4 && oldlen == 8) {
+      lval = *((int64_t *)olddata);
+
+      /* WARNING: 32-bit Blender trying to load file saved by 64-bit Blender,
+       * pointers may lose uniqueness on truncation! (Hopefully this wont
+       * happen unless/until we ever get to multi-gigabyte .blend files...) */
+      *((int *)curdata) = lval >> 3;
+    }
+    else if (curlen == 8 && oldlen == 4) {
+      *((int64_t *)curdata) = *((int *)olddata);
+    }
+    else {
+      /* for debug */
+      printf("errpr: illegal pointersize!\n");
+    }
+
+    olddata += oldlen;
+    curdata += curlen;
+    name_array_len--;
+  }
+}
+
+static void reconstruct_step_init_memcpy(ReconstructStep *step,
+                                         const int old_offset,
+                                         const int new_offset,
+                                         const int size)
+{
+  step->type = RECONSTRUCT_STEP_MEMCPY;
+  step->old_offset = old_offset;
+  step->new_offset = new_offset;
+  step->data.memcpy.size = size;
+}
+
+static void reconstruct_step_init_pointer(const SDNA *oldsdna,
+                                          const SDNA *newsdna,
+                                          ReconstructStep *step,
+                                          const int old_offset,
+                                          const int new_offset,
+                                          const int array_len)
+{
+  if (oldsdna->pointer_size == newsdna->pointer_size) {
+    reconstruct_step_init_memcpy(step, old_offset, new_offset, newsdna->pointer_size * array_len);
+  }
+  else {
+    step->type = RECONSTRUCT_STEP_CAST_POINTER;
+    step->old_offset = old_offset;
+    step->new_offset = new_offset;
+    step->data.cast_pointer.array_len = array_len;
+  }
+}
+
+static bool reconstruct_step_init_cast(ReconstructStep *step,
+                                       const char *otype,
+                                       const char *type,
+                                       const int old_offset,
+                                       const int new_offset,
+                                       const int array_len)
+{
+  const eSDNA_Type old_type = sdna_type_nr(otype);
+  const eSDNA_Type new_type = sdna_type_nr(type);
+  if (old_type == -1 || new_type == -1) {
+    return false;
+  }
+  step->type = RECONSTRUCT_STEP_CAST_PRIMITIVE;
+  step->old_offset = old_offset;
+  step->new_offset = new_offset;
+  step->data.cast_primitive.old_type = old_type;
+  step->data.cast_primitive.new_type = new_type;
+  step->data.cast_primitive.array_len = array_len;
+  return true;
+}
+
+/**
+ * Step converting a single member of a non-struct type from oldsdna to newsdna format.
+ *
+ * \param old_struct: pointer to struct info in oldsdna
+ * \param new_type_nr: current member type number.
+ * \param new_name_nr: current member name number.
+ * \return false when there is no matching member in the old struct.
+ */
+static bool reconstruct_step_init_member(const SDNA *oldsdna,
+                                         const SDNA *newsdna,
+                                         const short *old_struct,
+                                         const int new_type_nr,
+                                         const int new_name_nr,
+                                         const int new_offset,
+                                         ReconstructStep *r_step)
 {
   /* rules: test for NAME:
    *      - name equal:
@@ -1106,10 +1196,12 @@ static void reconstruct_elem(const SDNA *newsdna,
    * (nzc 2-4-2001 I want the 'unsigned' bit to be parsed as well. Where
    * can I force this?)
    */
-  int a, elemcount, len, countpos, mul;
+  int a, elemcount, len, countpos;
   const char *otype, *oname, *cp;
+  int old_offset = 0;
 
   /* is 'name' an array? */
+  const char *type = newsdna->types[new_type_nr];
   const char *name = newsdna->names[new_name_nr];
   cp = name;
   countpos = 0;
@@ -1122,31 +1214,28 @@ static void reconstruct_elem(const SDNA *newsdna,
   }
 
   /* in old is the old struct */
-  elemcount = old[1];
-  old += 2;
-  for (a = 0; a < elemcount; a++, old += 2) {
-    const int old_name_nr = old[1];
-    otype = oldsdna->types[old[0]];
-    oname = oldsdna->names[old[1]];
-    len = elementsize(oldsdna, old[0], old[1]);
+  elemcount = old_struct[1];
+  old_struct += 2;
+  for (a = 0; a < elemcount; a++, old_struct += 2) {
+    const int old_name_nr = old_struct[1];
+    otype = oldsdna->types[old_struct[0]];
+    oname = oldsdna->names[old_struct[1]];
+    len = elementsize(oldsdna, old_struct[0], old_struct[1]);
 
     if (strcmp(name, oname) == 0) { /* name equal */
+      const int new_name_array_len = newsdna->names_array_len[new_name_nr];
 
       if (ispointer(name)) { /* pointer of functionpointer afhandelen */
-        cast_pointer(newsdna->pointer_size,
-                     oldsdna->pointer_size,
-                     newsdna->names_array_len[new_name_nr],
-                     curdata,
-                     olddata);
+        reconstruct_step_init_pointer(
+            oldsdna, newsdna, r_step, old_offset, new_offset, new_name_array_len);
+        return true;
       }
       else if (strcmp(type, otype) == 0) { /* type equal */
-        memcpy(curdata, olddata, len);
+        reconstruct_step_init_memcpy(r_step, old_offset, new_offset, len);
+        return true;
       }
-      else {
-        cast_elem(type, otype, newsdna->names_array_len[new_name_nr], curdata, olddata);
-      }
-
-      return;
+      return reconstruct_step_init_cast(
+          r_step, otype, type, old_offset, new_offset, new_name_array_len);
     }
     else if (countpos != 0) { /* name is an array */
 
@@ -1156,148 +1245,273 @@ static void reconstruct_elem(const SDNA *newsdna,
         const int min_name_array_len = MIN2(new_name_array_len, old_name_array_len);
 
         if (ispointer(name)) { /* handle pointer or functionpointer */
-          cast_pointer(
-              newsdna->pointer_size, oldsdna->pointer_size, min_name_array_len, curdata, olddata);
+          reconstruct_step_init_pointer(
+              oldsdna, newsdna, r_step, old_offset, new_offset, min_name_array_len);
+          return true;
         }
         else if (strcmp(type, otype) == 0) { /* type equal */
-          /* size of single old array element */
-          mul = len / old_name_array_len;
-          /* smaller of sizes of old and new arrays */
-          mul *= min_name_array_len;
-
-          memcpy(curdata, olddata, mul);
+          /* size of single old array element, times the smaller of sizes of old and new arrays */
+          int size = (len / old_name_array_len) * min_name_array_len;
 
           if (old_name_array_len > new_name_array_len && strcmp(type, "char") == 0) {
-            /* string had to be truncated, ensure it's still null-terminated */
-            curdata[mul - 1] = '\0';
+            /* string had to be truncated, leave the last (zeroed) byte as terminator */
+            size -= 1;
           }
+          reconstruct_step_init_memcpy(r_step, old_offset, new_offset, size);
+          return true;
         }
-        else {
-          cast_elem(type, otype, min_name_array_len, curdata, olddata);
-        }
-        return;
+        return reconstruct_step_init_cast(
+            r_step, otype, type, old_offset, new_offset, min_name_array_len);
       }
     }
-    olddata += len;
+    old_offset += len;
   }
+  return false;
 }
 
 /**
- * Converts the contents of an entire struct from oldsdna to newsdna format.
- *
- * \param newsdna: SDNA of current Blender
- * \param oldsdna: SDNA of Blender that saved file
- * \param compflags:
+ * Step converting a member of a struct type (or an array of them).
  *
- * Result from DNA_struct_get_compareflags to avoid needless conversions.
- * \param oldSDNAnr: Index of old struct definition in oldsdna
- * \param data: Struct contents laid out according to oldsdna
- * \param curSDNAnr: Index of current struct definition in newsdna
- * \param cur: Where to put converted struct contents
+ * \return false when there is no matching member in the old struct.
  */
-static void reconstruct_struct(const SDNA *newsdna,
-                               const SDNA *oldsdna,
-                               const char *compflags,
-
-                               int oldSDNAnr,
-                               const char *data,
-                               int curSDNAnr,
-                               char *cur)
+static bool reconstruct_step_init_substruct(const SDNA *oldsdna,
+                                            const SDNA *newsdna,
+                                            const char *compare_flags,
+                                            const short *old_struct,
+                                            const int new_type_nr,
+                                            const int new_name_nr,
+                                            const int new_offset,
+                                            ReconstructStep *r_step)
 {
-  /* Recursive!
-   * Per element from cur_struct, read data from old_struct.
-   * If element is a struct, call recursive.
-   */
-  int a, elemcount, elen, eleno, mul, mulo, firststructtypenr;
-  const short *spo, *spc, *sppo;
-  const char *type;
-  const char *cpo;
-  char *cpc;
-  const char *name;
-
-  unsigned int oldsdna_index_last = UINT_MAX;
-  unsigned int cursdna_index_last = UINT_MAX;
-
-  if (oldSDNAnr == -1) {
-    return;
+  const char *type = newsdna->types[new_type_nr];
+  const char *name = newsdna->names[new_name_nr];
+  int old_offset = 0;
+  const short *old_member = NULL;
+
+  /* where does the old struct data start (and is there an old one?) */
+  const int elemcount = old_struct[1];
+  const short *sp = old_struct + 2;
+  for (int a = 0; a < elemcount; a++, sp += 2) {
+    if (elem_strcmp(name, oldsdna->names[sp[1]]) == 0) { /* name equal */
+      if (strcmp(type, oldsdna->types[sp[0]]) == 0) {    /* type equal */
+        old_member = sp;
+      }
+      break;
+    }
+    old_offset += elementsize(oldsdna, sp[0], sp[1]);
   }
-  if (curSDNAnr == -1) {
-    return;
+  if (old_member == NULL) {
+    return false;
   }
 
-  if (compflags[oldSDNAnr] == SDNA_CMP_EQUAL) {
-    /* if recursive: test for equal */
-    spo = oldsdna->structs[oldSDNAnr];
-    elen = oldsdna->types_size[spo[0]];
-    memcpy(cur, data, elen);
-
-    return;
+  const int old_struct_nr = DNA_struct_find_nr(oldsdna, type);
+  const int new_struct_nr = DNA_struct_find_nr(newsdna, type);
+  if (old_struct_nr == -1 || new_struct_nr == -1) {
+    return false;
   }
 
-  firststructtypenr = *(newsdna->structs[0]);
-
-  spo = oldsdna->structs[oldSDNAnr];
-  spc = newsdna->structs[curSDNAnr];
+  /* array! */
+  const int new_array_len = newsdna->names_array_len[new_name_nr];
+  const int old_array_len = oldsdna->names_array_len[old_member[1]];
+  const int array_len = MIN2(new_array_len, old_array_len);
+  const int new_stride = elementsize(newsdna, new_type_nr, new_name_nr) / new_array_len;
+  const int old_stride = elementsize(oldsdna, old_member[0], old_member[1]) / old_array_len;
 
-  elemcount = spc[1];
+  if (compare_flags[old_struct_nr] == SDNA_CMP_EQUAL) {
+    reconstruct_step_init_memcpy(r_step, old_offset, new_offset, old_stride * array_len);
+  }
+  else {
+    r_step->type = RECONSTRUCT_STEP_SUBSTRUCT;
+    r_step->old_offset = old_offset;
+    r_step->new_offset = new_offset;
+    r_step->data.substruct.old_struct_nr = old_struct_nr;
+    r_step->data.substruct.array_len = array_len;
+    r_step->data.substruct.old_stride = old_stride;
+    r_step->data.substruct.new_stride = new_stride;
+  }
+  return true;
+}
 
-  spc += 2;
-  cpc = cur;
-  for (a = 0; a < elemcount; a++, spc += 2) { /* convert each field */
-    type = newsdna->types[spc[0]];
-    name = newsdna->names[spc[1]];
+/* Add a step, merged with the previous one when both copy adjacent memory. */
+static void reconstruct_steps_append(ReconstructStep *steps,
+                                     int *steps_len,
+                                     const ReconstructStep *step)
+{
+  if (*steps_len != 0 && step->type == RECONSTRUCT_STEP_MEMCPY) {
+    ReconstructStep *step_prev = &steps[*steps_len - 1];
+    if (step_prev->type == RECONSTRUCT_STEP_MEMCPY &&
+        step_prev->old_offset + step_prev->data.memcpy.size == step->old_offset &&
+        step_prev->new_offset + step_prev->data.memcpy.size == step->new_offset) {
+      step_prev->data.memcpy.size += step->data.memcpy.size;
+      return;
+    }
+  }
+  steps[(*steps_len)++] = *step;
+}
 
-    elen = elementsize(newsdna, spc[0], spc[1]);
+static ReconstructStep *create_reconstruct_steps_for_struct(const SDNA *oldsdna,
+                                                            const SDNA *newsdna,
+                                                            const char *compare_flags,
+                                                            const int old_struct_nr,
+                                                            const int new_struct_nr,
+                                                            int *r_steps_len)
+{
+  const short *old_struct = oldsdna->structs[old_struct_nr];
+  const short *new_struct = newsdna->structs[new_struct_nr];
+  const int firststructtypenr = *(newsdna->structs[0]);
+  const int elemcount = new_struct[1];
+
+  /* Every member results in one step at most. */
+  ReconstructStep *steps = MEM_malloc_arrayN(MAX2(elemcount, 1), sizeof(*steps), __func__);
+  int steps_len = 0;
+
+  if (compare_flags[old_struct_nr] == SDNA_CMP_EQUAL) {
+    ReconstructStep step;
+    reconstruct_step_init_memcpy(&step, 0, 0, oldsdna->types_size[old_struct[0]]);
+    reconstruct_steps_append(steps, &steps_len, &step);
+    *r_steps_len = steps_len;
+    return steps;
+  }
+
+  int new_offset = 0;
+  const short *spc = new_struct + 2;
+  for (int a = 0; a < elemcount; a++, spc += 2) {
+    const char *name = newsdna->names[spc[1]];
+    const int elen = elementsize(newsdna, spc[0], spc[1]);
+    ReconstructStep step;
 
     /* Skip pad bytes which must start with '_pad', see makesdna.c 'is_name_legal'.
      * for exact rules. Note that if we fail to skip a pad byte it's harmless,
      * this just avoids unnecessary reconstruction. */
     if (name[0] == '_' || (name[0] == '*' && name[1] == '_')) {
-      cpc += elen;
+      /* pass */
     }
     else if (spc[0] >= firststructtypenr && !ispointer(name)) {
       /* struct field type */
+      if (reconstruct_step_init_substruct(
+              oldsdna, newsdna, compare_flags, old_struct, spc[0], spc[1], new_offset, &step)) {
+        reconstruct_steps_append(steps, &steps_len, &step);
+      }
+    }
+    else {
+      /* non-struct field type */
+      if (reconstruct_step_init_member(
+              oldsdna, newsdna, old_struct, spc[0], spc[1], new_offset, &step)) {
+        reconstruct_steps_append(steps, &steps_len, &step);
+      }
+    }
+    /* Members which are not in the old struct are left zeroed. */
+    new_offset += elen;
+  }
 
-      /* where does the old struct data start (and is there an old one?) */
-      cpo = (char *)find_elem(oldsdna, type, name, spo, data, &sppo);
+  *r_steps_len = steps_len;
+  return steps;
+}
 
-      if (cpo) {
-        oldSDNAnr = DNA_struct_find_nr_ex(oldsdna, type, &oldsdna_index_last);
-        curSDNAnr = DNA_struct_find_nr_ex(newsdna, type, &cursdna_index_last);
+/**
+ * Prepare the conversion of all structs from \a oldsdna to \a newsdna.
+ *
+ * \param compare_flags: Result from #DNA_struct_get_compareflags.
+ */
+DNA_ReconstructInfo *DNA_reconstruct_info_create(const SDNA *oldsdna,
+                                                 const SDNA *newsdna,
+                                                 const char *compare_flags)
+{
+  DNA_ReconstructInfo *reconstruct_info = MEM_callocN(sizeof(*reconstruct_info), __func__);
+  reconstruct_info->oldsdna = oldsdna;
+  reconstruct_info->newsdna = newsdna;
+  reconstruct_info->compare_flags = compare_flags;
+  reconstruct_info->steps = MEM_calloc_arrayN(
+      oldsdna->structs_len, sizeof(*reconstruct_info->steps), __func__);
+  reconstruct_info->steps_len = MEM_calloc_arrayN(
+      oldsdna->structs_len, sizeof(*reconstruct_info->steps_len), __func__);
+
+  for (int old_struct_nr = 0; old_struct_nr < oldsdna->structs_len; old_struct_nr++) {
+    if (compare_flags[old_struct_nr] == SDNA_CMP_REMOVED) {
+      continue;
+    }
+    const short *old_struct = oldsdna->structs[old_struct_nr];
+    const int new_struct_nr = DNA_struct_find_nr(newsdna, oldsdna->types[old_struct[0]]);
+    if (new_struct_nr == -1) {
+      continue;
+    }
+    reconstruct_info->steps[old_struct_nr] = create_reconstruct_steps_for_struct(
+        oldsdna,
+        newsdna,
+        compare_flags,
+        old_struct_nr,
+        new_struct_nr,
+        &reconstruct_info->steps_len[old_struct_nr]);
+  }
 
-        /* array! */
-        mul = newsdna->names_array_len[spc[1]];
-        mulo = oldsdna->names_array_len[sppo[1]];
+  return reconstruct_info;
+}
 
-        eleno = elementsize(oldsdna, sppo[0], sppo[1]);
+void DNA_reconstruct_info_free(DNA_ReconstructInfo *reconstruct_info)
+{
+  for (int old_struct_nr = 0; old_struct_nr < reconstruct_info->oldsdna->structs_len;
+       old_struct_nr++) {
+    if (reconstruct_info->steps[old_struct_nr]) {
+      MEM_freeN(reconstruct_info->steps[old_struct_nr]);
+    }
+  }
+  MEM_freeN(reconstruct_info->steps);
+  MEM_freeN(reconstruct_info->steps_len);
+  MEM_freeN(reconstruct_info);
+}
+
+/**
+ * Converts the contents of an entire struct from oldsdna to newsdna format.
+ *
+ * \param old_struct_nr: Index of old struct definition in oldsdna
+ * \param olddata: Struct contents laid out according to oldsdna
+ * \param curdata: Where to put converted struct contents (zeroed)
+ */
+static void reconstruct_struct(const DNA_ReconstructInfo *reconstruct_info,
+                               const int old_struct_nr,
+                               const char *olddata,
+                               char *curdata)
+{
+  const ReconstructStep *steps = reconstruct_info->steps[old_struct_nr];
+  const int steps_len = reconstruct_info->steps_len[old_struct_nr];
 
-        elen /= mul;
-        eleno /= mulo;
+  for (int a = 0; a < steps_len; a++) {
+    const ReconstructStep *step = &steps[a];
+    const char *old = olddata + step->old_offset;
+    char *cur = curdata + step->new_offset;
 
-        while (mul--) {
-          reconstruct_struct(newsdna, oldsdna, compflags, oldSDNAnr, cpo, curSDNAnr, cpc);
-          cpo += eleno;
-          cpc += elen;
-
-          /* new struct array larger than old */
-          mulo--;
-          if (mulo <= 0) {
-            break;
-          }
+    switch (step->type) {
+      case RECONSTRUCT_STEP_MEMCPY:
+        memcpy(cur, old, step->data.memcpy.size);
+        break;
+      case RECONSTRUCT_STEP_CAST_PRIMITIVE:
+        cast_primitive_type(step->data.cast_primitive.old_type,
+                            step->data.cast_primitive.new_type,
+                            step->data.cast_primitive.array_len,
+                            old,
+                            cur);
+        break;
+      case RECONSTRUCT_STEP_CAST_POINTER:
+        cast_pointer(reconstruct_info->newsdna->pointer_size,
+                     reconstruct_info->oldsdna->pointer_size,
+                     step->data.cast_pointer.array_len,
+                     cur,
+                     old);
+        break;
+      case RECONSTRUCT_STEP_SUBSTRUCT:
+        /* Recursive! */
+        for (int i = 0; i < step->data.substruct.array_len; i++) {
+          reconstruct_struct(reconstruct_info, step->data.substruct.old_struct_nr, old, cur);
+          old += step->data.substruct.old_stride;
+          cur += step->data.substruct.new_stride;
         }
-      }
-      else {
-        cpc += elen; /* skip field no longer present */
-      }
-    }
-    else {
-      /* non-struct field type */
-      reconstruct_elem(newsdna, oldsdna, type, spc[1], cpc, spo, data);
-      cpc += elen;
+        break;
     }
   }
 }
 
+/** \} */
+
 /**
  * Does endian swapping on the fields of a struct value.
  *
@@ -1392,54 +1606,46 @@ void DNA_struct_switch_endian(const SDNA *oldsdna, int oldSDNAnr, char *data)
 }
 
 /**
- * \param newsdna: SDNA of current Blender
- * \param oldsdna: SDNA of Blender that saved file
- * \param compflags:
- *
- * Result from DNA_struct_get_compareflags to avoid needless conversions
- * \param oldSDNAnr: Index of struct info within oldsdna
+ * \param reconstruct_info: Result from #DNA_reconstruct_info_create.
+ * \param old_struct_nr: Index of struct info within oldsdna
  * \param blocks: The number of array elements
- * \param data: Array of struct data
+ * \param old_blocks: Array of struct data
  * \return An allocated reconstructed struct
  */
-void *DNA_struct_reconstruct(const SDNA *newsdna,
-                             const SDNA *oldsdna,
-                             const char *compflags,
-                             int oldSDNAnr,
+void *DNA_struct_reconstruct(const DNA_ReconstructInfo *reconstruct_info,
+                             int old_struct_nr,
                              int blocks,
-                             const void *data)
+                             const void *old_blocks)
 {
-  int a, curSDNAnr, curlen = 0, oldlen;
-  const short *spo, *spc;
-  char *cur, *cpc;
-  const char *cpo;
-  const char *type;
+  const SDNA *oldsdna = reconstruct_info->oldsdna;
+  const SDNA *newsdna = reconstruct_info->newsdna;
 
-  /* oldSDNAnr == structnr, we're looking for the corresponding 'cur' number */
-  spo = oldsdna->structs[oldSDNAnr];
-  type = oldsdna->types[spo[0]];
-  oldlen = oldsdna->types_size[spo[0]];
-  curSDNAnr = DNA_struct_find_nr(newsdna, type);
+  /* old_struct_nr == structnr, we're looking for the corresponding 'cur' number */
+  const short *old_struct = oldsdna->structs[old_struct_nr];
+  const char *type = oldsdna->types[old_struct[0]];
+  const int oldlen = oldsdna->types_size[old_struct[0]];
+  const int new_struct_nr = DNA_struct_find_nr(newsdna, type);
+  int curlen = 0;
 
   /* init data and alloc */
-  if (curSDNAnr != -1) {
-    spc = newsdna->structs[curSDNAnr];
-    curlen = newsdna->types_size[spc[0]];
+  if (new_struct_nr != -1) {
+    const short *new_struct = newsdna->structs[new_struct_nr];
+    curlen = newsdna->types_size[new_struct[0]];
   }
-  if (curlen == 0) {
+  if (curlen == 0 || reconstruct_info->steps[old_struct_nr] == NULL) {
     return NULL;
   }
 
-  cur = MEM_callocN(blocks * curlen, "reconstruct");
-  cpc = cur;
-  cpo = data;
-  for (a = 0; a < blocks; a++) {
-    reconstruct_struct(newsdna, oldsdna, compflags, oldSDNAnr, cpo, curSDNAnr, cpc);
+  char *new_blocks = MEM_callocN(blocks * curlen, "reconstruct");
+  char *cpc = new_blocks;
+  const char *cpo = old_blocks;
+  for (int a = 0; a < blocks; a++) {
+    reconstruct_struct(reconstruct_info, old_struct_nr, cpo, cpc);
     cpc += curlen;
     cpo += oldlen;
   }
 
-  return cur;
+  return new_blocks;
 }
 
 /**
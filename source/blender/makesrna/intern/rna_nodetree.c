@@ -1930,6 +1930,18 @@ static void rna_Node_dimensions_get(PointerRNA *ptr, float *value)
   value[1] = node->totr.ymax - node->totr.ymin;
 }
 
+static int rna_Node_profile_pixels_get(PointerRNA *ptr)
+{
+  bNode *node = ptr->data;
+  return (int)MIN2(node->profile_pixels, (int64_t)INT_MAX);
+}
+
+static float rna_Node_profile_memory_get(PointerRNA *ptr)
+{
+  bNode *node = ptr->data;
+  return (float)node->profile_memory / (1024.0f * 1024.0f);
+}
+
 /* ******** Node Socket ******** */
 
 static void rna_NodeSocket_draw(
@@ -8559,6 +8571,30 @@ static void rna_def_node(BlenderRNA *brna)
   RNA_def_property_ui_text(prop, "Dimensions", "Absolute bounding box dimensions of the node");
   RNA_def_property_clear_flag(prop, PROP_EDITABLE);
 
+  prop = RNA_def_property(srna, "profile_time", PROP_FLOAT, PROP_NONE);
+  RNA_def_property_float_sdna(prop, NULL, "profile_time");
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "Profile Time",
+                           "Time in seconds the compositor spent on the node in the last "
+                           "execution with profiling, summed over all threads");
+
+  prop = RNA_def_property(srna, "profile_pixels", PROP_INT, PROP_NONE);
+  RNA_def_property_int_funcs(prop, "rna_Node_profile_pixels_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "Profile Pixels",
+                           "Number of pixels the compositor calculated for the node in the last "
+                           "execution with profiling");
+
+  prop = RNA_def_property(srna, "profile_memory", PROP_FLOAT, PROP_NONE);
+  RNA_def_property_float_funcs(prop, "rna_Node_profile_memory_get", NULL, NULL);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "Profile Memory",
+                           "Memory in megabytes of the buffers holding the results of the node in "
+                           "the last execution of the compositor with profiling");
+
   prop = RNA_def_property(srna, "name", PROP_STRING, PROP_NONE);
   RNA_def_property_ui_text(prop, "Name", "Unique node identifier");
   RNA_def_struct_name_property(srna, prop);
@@ -9162,6 +9198,37 @@ static void rna_def_composite_nodetree(BlenderRNA *brna)
                            "Use two pass execution during editing: first calculate fast nodes, "
                            "second pass calculate all nodes");
 
+  prop = RNA_def_property(srna, "use_buffer_execution", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_BUFFER_EXECUTION);
+  RNA_def_property_ui_text(prop,
+                           "Buffer Execution",
+                           "Evaluate operations which support it on whole areas at once, "
+                           "instead of pixel by pixel");
+
+  prop = RNA_def_property(srna, "use_half_buffers", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_HALF_BUFFERS);
+  RNA_def_property_ui_text(prop,
+                           "Half Float Buffers",
+                           "Store intermediate buffers with half float precision, using half the "
+                           "memory at the cost of precision");
+
+  prop = RNA_def_property(srna, "use_profile", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_PROFILE);
+  RNA_def_property_ui_text(prop,
+                           "Profile",
+                           "Record the execution time and buffer memory of every node, and show "
+                           "them above the nodes");
+  RNA_def_property_update(prop, NC_NODE | ND_DISPLAY, "rna_NodeTree_update");
+
+  prop = RNA_def_property(srna, "use_parallel_frames", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_PARALLEL_FRAMES);
+  RNA_def_property_ui_text(prop,
+                           "Parallel Frames",
+                           "Composite several frames at once when rendering animations from the "
+                           "command line, as many as fit in half of the system memory. Render "
+                           "post and write handlers of a frame run after the render pre handlers "
+                           "of the following frames, with the scene at a later frame");
+
   prop = RNA_def_property(srna, "use_viewer_border", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_VIEWER_BORDER);
   RNA_def_property_ui_text(
@@ -144,6 +144,34 @@ static void local_sync(bNodeTree *localtree, bNodeTree *ntree)
   BKE_node_preview_sync_tree(ntree, localtree);
 }
 
+/* Copy the profiling statistics back to the nodes of the real tree. The local tree is a copy of
+ * the evaluated tree, so nodes are matched by name. Nodes of a group used more than once get the
+ * sum of all instances. */
+static void local_merge_profile(bNodeTree *localtree, bNodeTree *ntree, bool clear)
+{
+  for (bNode *lnode = localtree->nodes.first; lnode; lnode = lnode->next) {
+    bNode *node = nodeFindNodebyName(ntree, lnode->name);
+    if (node == NULL || node->type != lnode->type) {
+      continue;
+    }
+
+    if (clear) {
+      node->profile_time = 0.0f;
+      node->profile_pixels = 0;
+      node->profile_memory = 0;
+    }
+    else {
+      node->profile_time += lnode->profile_time;
+      node->profile_pixels += lnode->profile_pixels;
+      node->profile_memory += lnode->profile_memory;
+    }
+
+    if (ELEM(lnode->type, NODE_GROUP, NODE_CUSTOM_GROUP) && lnode->id && node->id) {
+      local_merge_profile((bNodeTree *)lnode->id, (bNodeTree *)node->id, clear);
+    }
+  }
+}
+
 static void local_merge(Main *bmain, bNodeTree *localtree, bNodeTree *ntree)
 {
   bNode *lnode;
@@ -152,6 +180,11 @@ static void local_merge(Main *bmain, bNodeTree *localtree, bNodeTree *ntree)
   /* move over the compbufs and previews */
   BKE_node_preview_merge_tree(ntree, localtree, true);
 
+  if (localtree->flag & NTREE_COM_PROFILE) {
+    local_merge_profile(localtree, ntree, true);
+    local_merge_profile(localtree, ntree, false);
+  }
+
   for (lnode = localtree->nodes.first; lnode; lnode = lnode->next) {
     if (ntreeNodeExists(ntree, lnode->new_node)) {
       if (ELEM(lnode->type, CMP_NODE_VIEWER, CMP_NODE_SPLITVIEWER)) {
@@ -237,7 +270,8 @@ void register_node_tree_type_cmp(void)
 extern void *COM_linker_hack; /* Quiet warning. */
 void *COM_linker_hack = NULL;
 
-void ntreeCompositExecTree(Scene *scene,
+void ntreeCompositExecTree(Render *render,
+                           Scene *scene,
                            bNodeTree *ntree,
                            RenderData *rd,
                            int rendering,
@@ -247,9 +281,9 @@ void ntreeCompositExecTree(Scene *scene,
                            const char *view_name)
 {
 #ifdef WITH_COMPOSITOR
-  COM_execute(rd, scene, ntree, rendering, view_settings, display_settings, view_name);
+  COM_execute(render, rd, scene, ntree, rendering, view_settings, display_settings, view_name);
 #else
-  UNUSED_VARS(scene, ntree, rd, rendering, view_settings, display_settings, view_name);
+  UNUSED_VARS(render, scene, ntree, rd, rendering, view_settings, display_settings, view_name);
 #endif
 
   UNUSED_VARS(do_preview);
@@ -44,6 +44,7 @@
 #include "BLI_rect.h"
 #include "BLI_listbase.h"
 #include "BLI_string.h"
+#include "BLI_system.h"
 #include "BLI_path_util.h"
 #include "BLI_timecode.h"
 #include "BLI_fileops.h"
@@ -1495,7 +1496,8 @@ static void do_render_composite(Render *re)
 
         RenderView *rv;
         for (rv = re->result->views.first; rv; rv = rv->next) {
-          ntreeCompositExecTree(re->pipeline_scene_eval,
+          ntreeCompositExecTree(re,
+                                re->pipeline_scene_eval,
                                 ntree,
                                 &re->r,
                                 true,
@@ -2144,6 +2146,8 @@ void RE_RenderFrame(Render *re,
     }
 
     /* keep after file save */
+    /* The pre handlers of the following frames already ran, see the description of
+     * use_parallel_frames. */
     BLI_callback_exec(re->main, (ID *)scene, BLI_CB_EVT_RENDER_POST);
     if (write_still) {
       BLI_callback_exec(re->main, (ID *)scene, BLI_CB_EVT_RENDER_WRITE);
@@ -2489,6 +2493,407 @@ static void re_movie_free_all(Render *re, bMovieHandle *mh, int totvideos)
   MEM_SAFE_FREE(re->movie_ctx_arr);
 }
 
+/* Remove the files touched for a frame which was not written. */
+static void touched_file_remove(Scene *scene, const char *name, const bool is_multiview_name)
+{
+  if (!is_multiview_name) {
+    if ((BLI_file_size(name) == 0)) {
+      /* BLI_exists(name) is implicit */
+      BLI_delete(name, false, false);
+    }
+  }
+  else {
+    SceneRenderView *srv;
+    char filepath[FILE_MAX];
+
+    for (srv = scene->r.views.first; srv; srv = srv->next) {
+      if (!BKE_scene_multiview_is_render_view_active(&scene->r, srv)) {
+        continue;
+      }
+
+      BKE_scene_multiview_filepath_get(srv, name, filepath);
+
+      if ((BLI_file_size(filepath) == 0)) {
+        /* BLI_exists(filepath) is implicit */
+        BLI_delete(filepath, false, false);
+      }
+    }
+  }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Compositing frames at once.
+ *
+ * Background animation renders of scenes which only composite run the compositor of several
+ * frames at the same time. Single threaded operations and reading files leave most threads idle
+ * while compositing a single frame. The main thread evaluates the frames, every frame in flight
+ * is composited and written by a thread of its own. Frames are started as long as the memory the
+ * first frame took fits in half of the system memory. */
+
+typedef struct CompositeFrame {
+  struct CompositeFrames *frames;
+  /** Render the frame is composited to, not in the list of renders. */
+  Render *re;
+  /** Local copy of the evaluated tree at the frame. */
+  bNodeTree *ntree;
+  /** Copies of the settings at the frame, the scene is animated to the next frames meanwhile.
+   * The data the scene points to is shared. */
+  RenderData rd;
+  Scene scene;
+  char name[FILE_MAX];
+  double starttime, time;
+  bool in_use, done, ok;
+} CompositeFrame;
+
+typedef struct CompositeFrames {
+  ListBase threads;
+  CompositeFrame *slots;
+  int num_slots;
+  /** Protects #CompositeFrame.done. */
+  ThreadMutex mutex;
+  ThreadCondition cond;
+  /** Memory a frame takes, measured while compositing the first frame alone. */
+  size_t frame_memory, base_memory;
+  size_t memory_budget;
+} CompositeFrames;
+
+static bool composite_frames_tree_supported(const bNodeTree *ntree)
+{
+  const bNode *node;
+
+  for (node = ntree->nodes.first; node; node = node->next) {
+    if (node->flag & NODE_MUTED) {
+      continue;
+    }
+    if (ELEM(node->type, NODE_GROUP, NODE_CUSTOM_GROUP)) {
+      if (node->id && !composite_frames_tree_supported((const bNodeTree *)node->id)) {
+        return false;
+      }
+    }
+    /* Nodes reading data which is evaluated for the next frames meanwhile (Defocus reads the
+     * scene camera), or keeping state per thread of the task scheduler. */
+    else if (ELEM(node->type,
+                  CMP_NODE_R_LAYERS,
+                  CMP_NODE_DEFOCUS,
+                  CMP_NODE_MASK,
+                  CMP_NODE_MOVIECLIP,
+                  CMP_NODE_MOVIEDISTORTION,
+                  CMP_NODE_STABILIZE2D,
+                  CMP_NODE_KEYINGSCREEN,
+                  CMP_NODE_TRACKPOS,
+                  CMP_NODE_PLANETRACKDEFORM,
+                  CMP_NODE_TEXTURE)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool composite_frames_supported(Render *re, Scene *scene, const bool is_movie)
+{
+  RenderEngineType *type = RE_engines_find(re->r.engine);
+
+  if (!G.background || is_movie) {
+    return false;
+  }
+  if (scene->nodetree == NULL || (scene->nodetree->flag & NTREE_COM_PARALLEL_FRAMES) == 0) {
+    return false;
+  }
+  /* Only scenes which composite without rendering anything. */
+  if (composite_needs_render(scene, 0) || RE_seq_render_active(scene, &re->r)) {
+    return false;
+  }
+  if (type->render && (type->flag & RE_USE_POSTPROCESS)) {
+    return false;
+  }
+  /* Stamps are drawn for the scene at its current frame. */
+  if ((re->r.stamp & R_STAMP_ALL) && (re->r.stamp & R_STAMP_DRAW)) {
+    return false;
+  }
+  /* OpenCL devices are shared by all executions. */
+  if (scene->nodetree->flag & NTREE_COM_OPENCL) {
+    return false;
+  }
+  return composite_frames_tree_supported(scene->nodetree);
+}
+
+static void composite_frame_stats(void *UNUSED(arg), const char *UNUSED(str))
+{
+}
+
+/* Viewers all write to the same image, which is not used by background renders. */
+static void composite_frame_disable_viewers(bNodeTree *ntree)
+{
+  bNode *node;
+
+  for (node = ntree->nodes.first; node; node = node->next) {
+    if (ELEM(node->type, CMP_NODE_VIEWER, CMP_NODE_SPLITVIEWER)) {
+      node->flag &= ~NODE_DO_OUTPUT;
+    }
+    else if (ELEM(node->type, NODE_GROUP, NODE_CUSTOM_GROUP) && node->id) {
+      composite_frame_disable_viewers((bNodeTree *)node->id);
+    }
+  }
+}
+
+static void *do_composite_frame_thread(void *arg)
+{
+  CompositeFrame *frame = arg;
+  CompositeFrames *frames = frame->frames;
+  Render *re = frame->re;
+  RenderView *rv;
+
+  for (rv = re->result->views.first; rv; rv = rv->next) {
+    ntreeCompositExecTree(re,
+                          &frame->scene,
+                          frame->ntree,
+                          &frame->rd,
+                          true,
+                          false,
+                          &frame->scene.view_settings,
+                          &frame->scene.display_settings,
+                          rv->name);
+  }
+
+  if (!frame->ntree->test_break(frame->ntree->tbh)) {
+    RenderResult rres;
+
+    RE_AcquireResultImageViews(re, &rres);
+    frame->ok = RE_WriteRenderViewsImage(NULL, &rres, &frame->scene, true, frame->name);
+    RE_ReleaseResultImageViews(re, &rres);
+  }
+  frame->time = PIL_check_seconds_timer() - frame->starttime;
+
+  BLI_mutex_lock(&frames->mutex);
+  frame->done = true;
+  BLI_condition_notify_all(&frames->cond);
+  BLI_mutex_unlock(&frames->mutex);
+
+  return NULL;
+}
+
+static CompositeFrames *composite_frames_begin(Render *re)
+{
+  CompositeFrames *frames = MEM_callocN(sizeof(CompositeFrames), "composite frames");
+  int i;
+
+  /* Every frame is composited by all threads of the task scheduler already, a few frames at
+   * once are enough to use the threads left idle. */
+  frames->num_slots = max_ii(2, BKE_render_num_threads(&re->r) / 4);
+  frames->slots = MEM_callocN(sizeof(CompositeFrame) * frames->num_slots, "composite frame");
+  frames->memory_budget = BLI_system_memory_max_in_megabytes() * 1024 * 1024 / 2;
+
+  for (i = 0; i < frames->num_slots; i++) {
+    CompositeFrame *frame = &frames->slots[i];
+    frame->frames = frames;
+    frame->re = MEM_callocN(sizeof(Render), "composite frame render");
+    BLI_rw_mutex_init(&frame->re->resultmutex);
+  }
+
+  BLI_threadpool_init(&frames->threads, do_composite_frame_thread, frames->num_slots);
+  BLI_mutex_init(&frames->mutex);
+  BLI_condition_init(&frames->cond);
+
+  return frames;
+}
+
+/* Runs in the main thread after the frame is written, like the end of a frame in
+ * RE_RenderAnim. */
+static void composite_frame_end(Render *re, CompositeFrame *frame, Scene *scene)
+{
+  CompositeFrames *frames = frame->frames;
+  const bool is_multiview_name = ((frame->rd.scemode & R_MULTIVIEW) != 0 &&
+                                  (frame->rd.im_format.views_format == R_IMF_VIEWS_INDIVIDUAL));
+
+  BLI_threadpool_remove(&frames->threads, frame);
+
+  if (frames->frame_memory == 0) {
+    const size_t peak_memory = MEM_get_peak_memory();
+    frames->frame_memory = (peak_memory > frames->base_memory) ?
+                               peak_memory - frames->base_memory :
+                               1;
+  }
+
+  if (frame->ok) {
+    char str[32];
+    BLI_timecode_string_from_time_simple(str, sizeof(str), frame->time);
+    printf("Fra:%d Time: %s\n", frame->rd.cfra, str);
+    fflush(stdout);
+
+    /* The pre handlers of the following frames already ran, see the description of
+     * use_parallel_frames. */
+    BLI_callback_exec(re->main, (ID *)scene, BLI_CB_EVT_RENDER_POST);
+    BLI_callback_exec(re->main, (ID *)scene, BLI_CB_EVT_RENDER_WRITE);
+  }
+  else {
+    G.is_break = true;
+
+    if (frame->rd.mode & R_TOUCH) {
+      touched_file_remove(&frame->scene, frame->name, is_multiview_name);
+    }
+  }
+
+  ntreeFreeLocalTree(frame->ntree);
+  MEM_freeN(frame->ntree);
+  frame->ntree = NULL;
+  render_result_free(frame->re->result);
+  frame->re->result = NULL;
+  frame->in_use = false;
+}
+
+/* Ends the frames which are done, and waits until fewer than max_in_flight frames are in flight
+ * and the memory of another frame fits the budget. Pass 0 to wait for all frames. */
+static void composite_frames_wait(Render *re,
+                                  CompositeFrames *frames,
+                                  Scene *scene,
+                                  const int max_in_flight)
+{
+  while (true) {
+    int in_flight = 0;
+    int i;
+
+    for (i = 0; i < frames->num_slots; i++) {
+      CompositeFrame *frame = &frames->slots[i];
+      bool done;
+
+      if (!frame->in_use) {
+        continue;
+      }
+      BLI_mutex_lock(&frames->mutex);
+      done = frame->done;
+      BLI_mutex_unlock(&frames->mutex);
+
+      if (done) {
+        composite_frame_end(re, frame, scene);
+      }
+      else {
+        in_flight++;
+      }
+    }
+
+    if (in_flight == 0) {
+      break;
+    }
+    /* The first frame is composited alone, to measure its memory. */
+    if (in_flight < max_in_flight && frames->frame_memory != 0 &&
+        MEM_get_memory_in_use() + frames->frame_memory <= frames->memory_budget) {
+      break;
+    }
+
+    BLI_mutex_lock(&frames->mutex);
+    while (true) {
+      bool any_done = false;
+      for (i = 0; i < frames->num_slots; i++) {
+        if (frames->slots[i].in_use && frames->slots[i].done) {
+          any_done = true;
+        }
+      }
+      if (any_done) {
+        break;
+      }
+      BLI_condition_wait(&frames->cond, &frames->mutex);
+    }
+    BLI_mutex_unlock(&frames->mutex);
+  }
+}
+
+static void composite_frames_end(Render *re, CompositeFrames *frames, Scene *scene)
+{
+  int i;
+
+  composite_frames_wait(re, frames, scene, 0);
+
+  BLI_threadpool_end(&frames->threads);
+  BLI_condition_end(&frames->cond);
+  BLI_mutex_end(&frames->mutex);
+
+  for (i = 0; i < frames->num_slots; i++) {
+    BLI_rw_mutex_end(&frames->slots[i].re->resultmutex);
+    MEM_freeN(frames->slots[i].re);
+  }
+  MEM_freeN(frames->slots);
+  MEM_freeN(frames);
+}
+
+/* Like do_render_all_options and do_render_composite, but the frame is composited and written
+ * in a thread of its own. */
+static void do_render_composite_frame(Render *re,
+                                      CompositeFrames *frames,
+                                      Main *bmain,
+                                      Scene *scene)
+{
+  CompositeFrame *frame = NULL;
+  bNodeTree *ntree;
+  int i;
+
+  re->current_scene_update(re->suh, re->scene);
+
+  BKE_scene_camera_switch_update(re->scene);
+
+  re->i.starttime = PIL_check_seconds_timer();
+  re->i.cfra = re->r.cfra;
+
+  /* ensure no images are in memory from previous animated sequences */
+  BKE_image_all_free_anim_ibufs(re->main, re->r.cfra);
+
+  /* Update for compositing animation, see do_render_all_options. */
+  BKE_animsys_evaluate_all_animation(re->main, NULL, re->scene, (float)re->r.cfra);
+
+  composite_frames_wait(re, frames, scene, frames->num_slots);
+  if (G.is_break) {
+    return;
+  }
+
+  for (i = 0; i < frames->num_slots; i++) {
+    if (!frames->slots[i].in_use) {
+      frame = &frames->slots[i];
+      break;
+    }
+  }
+
+  frame->rd = re->r;
+  frame->scene = *scene;
+  frame->starttime = re->i.starttime;
+  frame->done = false;
+  frame->ok = false;
+  frame->in_use = true;
+
+  BKE_image_path_from_imformat(frame->name,
+                               scene->r.pic,
+                               BKE_main_blendfile_path(bmain),
+                               scene->r.cfra,
+                               &scene->r.im_format,
+                               (scene->r.scemode & R_EXTENSION) != 0,
+                               true,
+                               NULL);
+
+  ntree = ntreeLocalize(re->pipeline_scene_eval->nodetree);
+  composite_frame_disable_viewers(ntree);
+  ntree->stats_draw = composite_frame_stats;
+  ntree->test_break = re->test_break;
+  ntree->progress = float_nothing;
+  ntree->sdh = frame;
+  ntree->tbh = re->tbh;
+  ntree->prh = frame;
+  frame->ntree = ntree;
+
+  if ((re->r.mode & R_CROP) == 0) {
+    render_result_disprect_to_full_resolution(re);
+  }
+  frame->re->disprect = re->disprect;
+  frame->re->result = render_result_new(
+      re, &re->disprect, 0, RR_USE_MEM, RR_ALL_LAYERS, RR_ALL_VIEWS);
+  BKE_render_result_stamp_info(re->scene, RE_GetCamera(re), frame->re->result, false);
+
+  if (frames->frame_memory == 0) {
+    MEM_reset_peak_memory();
+    frames->base_memory = MEM_get_memory_in_use();
+  }
+
+  BLI_threadpool_insert(&frames->threads, frame);
+}
+
 /* saves images to disk */
 void RE_RenderAnim(Render *re,
                    Main *bmain,
@@ -2501,6 +2906,7 @@ void RE_RenderAnim(Render *re,
 {
   const RenderData rd = scene->r;
   bMovieHandle *mh = NULL;
+  CompositeFrames *frames = NULL;
   const int cfrao = rd.cfra;
   int nfra, totrendered = 0, totskipped = 0;
   const int totvideos = BKE_scene_multiview_num_videos_get(&rd);
@@ -2517,6 +2923,10 @@ void RE_RenderAnim(Render *re,
 
   render_init_depsgraph(re);
 
+  if (composite_frames_supported(re, scene, is_movie)) {
+    frames = composite_frames_begin(re);
+  }
+
   if (is_movie) {
     size_t width, height;
     int i;
@@ -2680,6 +3090,20 @@ void RE_RenderAnim(Render *re,
       /* run callbacs before rendering, before the scene is updated */
       BLI_callback_exec(re->main, (ID *)scene, BLI_CB_EVT_RENDER_PRE);
 
+      if (frames) {
+        /* Written and followed by the post render callbacks once composited. */
+        do_render_composite_frame(re, frames, bmain, scene);
+        totrendered++;
+
+        if (G.is_break) {
+          if (rd.mode & R_TOUCH) {
+            touched_file_remove(scene, name, is_multiview_name);
+          }
+          break;
+        }
+        continue;
+      }
+
       do_render_all_options(re);
       totrendered++;
 
@@ -2698,29 +3122,7 @@ void RE_RenderAnim(Render *re,
         /* remove touched file */
         if (is_movie == false) {
           if ((rd.mode & R_TOUCH)) {
-            if (!is_multiview_name) {
-              if ((BLI_file_size(name) == 0)) {
-                /* BLI_exists(name) is implicit */
-                BLI_delete(name, false, false);
-              }
-            }
-            else {
-              SceneRenderView *srv;
-              char filepath[FILE_MAX];
-
-              for (srv = scene->r.views.first; srv; srv = srv->next) {
-                if (!BKE_scene_multiview_is_render_view_active(&scene->r, srv)) {
-                  continue;
-                }
-
-                BKE_scene_multiview_filepath_get(srv, name, filepath);
-
-                if ((BLI_file_size(filepath) == 0)) {
-                  /* BLI_exists(filepath) is implicit */
-                  BLI_delete(filepath, false, false);
-                }
-              }
-            }
+            touched_file_remove(scene, name, is_multiview_name);
           }
         }
 
@@ -2729,12 +3131,18 @@ void RE_RenderAnim(Render *re,
 
       if (G.is_break == false) {
         /* keep after file save */
-        BLI_callback_exec(re->main, (ID *)scene, BLI_CB_EVT_RENDER_POST);
+        /* The pre handlers of the following frames already ran, see the description of
+     * use_parallel_frames. */
+    BLI_callback_exec(re->main, (ID *)scene, BLI_CB_EVT_RENDER_POST);
         BLI_callback_exec(re->main, (ID *)scene, BLI_CB_EVT_RENDER_WRITE);
       }
     }
   }
 
+  if (frames) {
+    composite_frames_end(re, frames, scene);
+  }
+
   /* end movie */
   if (is_movie) {
     re_movie_free_all(re, mh, totvideos);
@@ -1483,12 +1483,74 @@ void WM_autosave_init(wmWindowManager *wm)
   }
 }
 
+/* Auto-save takes a snapshot of the file in memory on the main thread, which is fast,
+ * writing (and compressing) it to disk happens in a job. */
+typedef struct AutosaveJob {
+  struct MemFile *memfile;
+  char filepath[FILE_MAX];
+  bool use_compress;
+} AutosaveJob;
+
+static void wm_autosave_job_startjob(void *customdata,
+                                     short *stop,
+                                     short *do_update,
+                                     float *progress)
+{
+  AutosaveJob *autosave_job = customdata;
+
+  BLO_memfile_write_file_ex(autosave_job->memfile,
+                            autosave_job->filepath,
+                            autosave_job->use_compress,
+                            progress,
+                            stop);
+  *do_update = true;
+}
+
+static void wm_autosave_job_free(void *customdata)
+{
+  AutosaveJob *autosave_job = customdata;
+
+  BLO_memfile_free(autosave_job->memfile);
+  MEM_freeN(autosave_job->memfile);
+  MEM_freeN(autosave_job);
+}
+
+/* Takes ownership of the memfile. */
+static void wm_autosave_job_start(wmWindowManager *wm,
+                                  struct MemFile *memfile,
+                                  const char *filepath,
+                                  const bool use_compress)
+{
+  AutosaveJob *autosave_job = MEM_callocN(sizeof(AutosaveJob), __func__);
+  autosave_job->memfile = memfile;
+  BLI_strncpy(autosave_job->filepath, filepath, sizeof(autosave_job->filepath));
+  autosave_job->use_compress = use_compress;
+
+  wmJob *wm_job = WM_jobs_get(
+      wm, wm->winactive, wm, "Auto-Saving...", WM_JOB_PROGRESS, WM_JOB_TYPE_AUTOSAVE);
+  WM_jobs_customdata_set(wm_job, autosave_job, wm_autosave_job_free);
+  WM_jobs_timer(wm_job, 0.1, 0, 0);
+  WM_jobs_callbacks(wm_job, wm_autosave_job_startjob, NULL, NULL, NULL);
+
+  WM_jobs_start(wm, wm_job);
+}
+
 void wm_autosave_timer(const bContext *C, wmWindowManager *wm, wmTimer *UNUSED(wt))
 {
   char filepath[FILE_MAX];
+  struct MemFile *memfile = NULL;
 
   WM_event_remove_timer(wm, NULL, wm->autosavetimer);
 
+  /* if the previous auto-save is still being written, try again in 10 seconds */
+  if (WM_jobs_test(wm, wm, WM_JOB_TYPE_AUTOSAVE)) {
+    wm->autosavetimer = WM_event_add_timer(wm, NULL, TIMERAUTOSAVE, 10.0);
+    if (G.debug) {
+      printf("Skipping auto-save, previous auto-save running, retrying in ten seconds...\n");
+    }
+    return;
+  }
+
   /* if a modal operator is running, don't autosave, but try again in 10 seconds */
   for (wmWindow *win = wm->windows.first; win; win = win->next) {
     LISTBASE_FOREACH (wmEventHandler *, handler_base, &win->modalhandlers) {
@@ -1509,22 +1571,30 @@ void wm_autosave_timer(const bContext *C, wmWindowManager *wm, wmTimer *UNUSED(w
 
   if (U.uiflag & USER_GLOBALUNDO) {
     /* fast save of last undobuffer, now with UI */
-    struct MemFile *memfile = ED_undosys_stack_memfile_get_active(wm->undo_stack);
-    if (memfile) {
-      BLO_memfile_write_file(memfile, filepath);
+    struct MemFile *memfile_undo = ED_undosys_stack_memfile_get_active(wm->undo_stack);
+    if (memfile_undo) {
+      /* The undo step can be freed while the job is writing, so it needs a copy. */
+      memfile = BLO_memfile_copy(memfile_undo);
     }
   }
   else {
-    /*  save as regular blend file */
+    /* save current state into memory, only writing to disk happens in the job */
     Main *bmain = CTX_data_main(C);
     int fileflags = G.fileflags & ~(G_FILE_COMPRESS | G_FILE_HISTORY);
 
     ED_editors_flush_edits(bmain, false);
 
-    /* Error reporting into console */
-    BLO_write_file(bmain, filepath, fileflags, NULL, NULL);
+    memfile = MEM_callocN(sizeof(*memfile), __func__);
+    BLO_write_file_mem(bmain, NULL, memfile, fileflags);
   }
-  /* do timer after file write, just in case file write takes a long time */
+
+  if (memfile) {
+    /* Compression doesn't hold up the interface anymore, so follow the user setting. */
+    wm_autosave_job_start(wm, memfile, filepath, (G.fileflags & G_FILE_COMPRESS) != 0);
+  }
+
+  /* do timer after starting the file write,
+   * the next auto-save is delayed when the write takes a long time */
   wm->autosavetimer = WM_event_add_timer(wm, NULL, TIMERAUTOSAVE, U.savetime * 60.0);
 }
 
@@ -59,6 +59,7 @@
 #include "BKE_font.h"
 #include "BKE_global.h"
 #include "BKE_icons.h"
+#include "BKE_image.h"
 #include "BKE_library_remap.h"
 #include "BKE_main.h"
 #include "BKE_mball_tessellate.h"
@@ -256,6 +257,9 @@ void WM_init(bContext *C, int argc, const char **argv)
   BKE_library_callback_remap_editor_id_reference_set(
       WM_main_remap_editor_id_reference);                     /* library.c */
   BKE_spacedata_callback_id_remap_set(ED_spacedata_id_remap); /* screen.c */
+#ifdef WITH_COMPOSITOR
+  BKE_image_callback_reload_set(COM_clearCaches); /* image.c */
+#endif
   DEG_editors_set_update_cb(ED_render_id_flush_update, ED_render_scene_update);
 
   ED_spacetypes_init(); /* editors/space_api/spacetype.c */
@@ -0,0 +1,299 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_fileops.h"
+#include "BLI_linklist.h"
+#include "BLI_listbase.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_genfile.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_appdir.h"
+#include "BKE_blender.h"
+#include "BKE_collection.h"
+#include "BKE_customdata.h"
+#include "BKE_global.h"
+#include "BKE_gpencil_modifier.h"
+#include "BKE_image.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_eval_cache.h"
+#include "BKE_modifier.h"
+#include "BKE_node.h"
+#include "BKE_object.h"
+#include "BKE_scene.h"
+#include "BKE_shader_fx.h"
+
+#include "BLO_readfile.h"
+#include "BLO_writefile.h"
+
+#include "DEG_depsgraph.h"
+
+#include "IMB_imbuf.h"
+
+#include "RNA_define.h"
+
+#include "CLG_log.h"
+
+#include "MEM_guardedalloc.h"
+}
+
+#define THUMB_SIZE 4
+#define FRAMES_MESH_VERTS 200000
+
+/* Writing files with the index written at their end (see #BlendFileIndexHeader) and reading them
+ * back, with the index and through the fallbacks used for files which have none. */
+
+class BlendfileIndexTest : public testing::Test {
+ protected:
+  Main *bmain;
+  BlendThumbnail *thumb;
+  char filepath[FILE_MAX];
+
+  static void SetUpTestCase()
+  {
+    /* Same initialization as the blendfile performance test. */
+    CLG_init();
+    BLI_threadapi_init();
+    DNA_sdna_current_init();
+    BKE_blender_globals_init();
+    G.background = true;
+    BKE_tempdir_init(NULL);
+    IMB_init();
+    BKE_images_init();
+    BKE_modifier_init();
+    BKE_gpencil_modifier_init();
+    BKE_shaderfx_init();
+    DEG_register_node_types();
+    RNA_init();
+    init_nodesystem();
+  }
+
+  static void TearDownTestCase()
+  {
+    BKE_main_free(G_MAIN);
+    G_MAIN = NULL;
+    free_nodesystem();
+    RNA_exit();
+    DEG_free_node_types();
+    BKE_mesh_eval_cache_free();
+    BKE_images_exit();
+    IMB_exit();
+    BKE_tempdir_session_purge();
+    DNA_sdna_current_free();
+    BLI_threadapi_exit();
+    CLG_exit();
+  }
+
+  void SetUp() override
+  {
+    BLI_join_dirfile(filepath, sizeof(filepath), BKE_tempdir_session(), "index.blend");
+
+    bmain = BKE_main_new();
+    BLI_strncpy(bmain->name, filepath, sizeof(bmain->name));
+    Scene *scene = BKE_scene_add(bmain, "Scene");
+    for (int i = 0; i < 2; i++) {
+      char name[MAX_ID_NAME - 2];
+      BLI_snprintf(name, sizeof(name), "Empty.%d", i);
+      Object *ob = BKE_object_add_only_object(bmain, OB_EMPTY, name);
+      BKE_collection_object_add(bmain, scene->master_collection, ob);
+    }
+
+    thumb = (BlendThumbnail *)MEM_callocN(BLEN_THUMB_MEMSIZE(THUMB_SIZE, THUMB_SIZE), __func__);
+    thumb->width = THUMB_SIZE;
+    thumb->height = THUMB_SIZE;
+    for (int i = 0; i < THUMB_SIZE * THUMB_SIZE; i++) {
+      thumb->rect[i] = (unsigned int)i;
+    }
+  }
+
+  void TearDown() override
+  {
+    MEM_freeN(thumb);
+    BKE_main_free(bmain);
+    BLI_delete(filepath, false, false);
+  }
+
+  void write_file(const int write_flags)
+  {
+    ASSERT_TRUE(BLO_write_file(bmain, filepath, write_flags, NULL, thumb));
+  }
+
+  /* Remove the trailer locating the index, as in files written by older versions. */
+  void remove_index_trailer()
+  {
+    const size_t size = BLI_file_size(filepath);
+    /* #BlendFileIndexTrailer: offset and magic. */
+    const size_t trailer_size = 16;
+    ASSERT_GT(size, trailer_size);
+
+    FILE *file = BLI_fopen(filepath, "rb");
+    ASSERT_NE(file, (FILE *)NULL);
+    char *data = (char *)MEM_mallocN(size, __func__);
+    EXPECT_EQ(fread(data, 1, size, file), size);
+    fclose(file);
+
+    EXPECT_EQ(memcmp(data + size - 8, "BLENDIDX", 8), 0);
+
+    file = BLI_fopen(filepath, "wb");
+    ASSERT_NE(file, (FILE *)NULL);
+    EXPECT_EQ(fwrite(data, 1, size - trailer_size, file), size - trailer_size);
+    fclose(file);
+    MEM_freeN(data);
+  }
+
+  void expect_thumbnail()
+  {
+    BlendThumbnail *thumb_read = BLO_thumbnail_from_file(filepath);
+    ASSERT_NE(thumb_read, (BlendThumbnail *)NULL);
+    EXPECT_EQ(thumb_read->width, THUMB_SIZE);
+    EXPECT_EQ(thumb_read->height, THUMB_SIZE);
+    EXPECT_EQ(memcmp(thumb_read->rect, thumb->rect, sizeof(int) * THUMB_SIZE * THUMB_SIZE), 0);
+    MEM_freeN(thumb_read);
+  }
+
+  void expect_object_names()
+  {
+    BlendHandle *bh = BLO_blendhandle_from_file(filepath, NULL);
+    ASSERT_NE(bh, (BlendHandle *)NULL);
+    int names_len;
+    LinkNode *names = BLO_blendhandle_get_datablock_names(bh, ID_OB, &names_len);
+    EXPECT_EQ(names_len, 2);
+    EXPECT_EQ(BLI_linklist_count(names), 2);
+    for (LinkNode *link = names; link; link = link->next) {
+      const char *name = (const char *)link->link;
+      EXPECT_TRUE(STREQ(name, "Empty.0") || STREQ(name, "Empty.1")) << name;
+    }
+    BLI_linklist_free(names, free);
+    BLO_blendhandle_close(bh);
+  }
+
+  void expect_read()
+  {
+    BlendFileData *bfd = BLO_read_from_file(filepath, BLO_READ_SKIP_USERDEF, NULL);
+    ASSERT_NE(bfd, (BlendFileData *)NULL);
+    EXPECT_EQ(BLI_listbase_count(&bfd->main->objects), 2);
+    EXPECT_EQ(BLI_listbase_count(&bfd->main->scenes), 1);
+    BLO_blendfiledata_free(bfd);
+  }
+};
+
+TEST_F(BlendfileIndexTest, RoundTrip)
+{
+  write_file(0);
+
+  BlendFileIndex *index = BLO_blendfile_index_from_file(filepath);
+  ASSERT_NE(index, (BlendFileIndex *)NULL);
+  EXPECT_TRUE(index->has_thumbnail);
+
+  int objects_len = 0, scenes_len = 0;
+  for (int i = 0; i < index->items_len; i++) {
+    const BlendFileIndexItem *item = &index->items[i];
+    EXPECT_EQ(item->library, -1);
+    EXPECT_EQ(item->filepath, (const char *)NULL);
+    if (item->code == ID_OB) {
+      EXPECT_TRUE(STREQ(item->name, "OBEmpty.0") || STREQ(item->name, "OBEmpty.1"))
+          << item->name;
+      objects_len++;
+    }
+    else if (item->code == ID_SCE) {
+      EXPECT_STREQ(item->name, "SCScene");
+      scenes_len++;
+    }
+  }
+  EXPECT_EQ(objects_len, 2);
+  EXPECT_EQ(scenes_len, 1);
+  BLO_blendfile_index_free(index);
+
+  expect_thumbnail();
+  expect_object_names();
+  expect_read();
+}
+
+TEST_F(BlendfileIndexTest, FallbackWithoutIndex)
+{
+  write_file(0);
+  remove_index_trailer();
+
+  EXPECT_EQ(BLO_blendfile_index_from_file(filepath), (BlendFileIndex *)NULL);
+  expect_thumbnail();
+  expect_object_names();
+  expect_read();
+}
+
+TEST_F(BlendfileIndexTest, CompressedWithoutIndex)
+{
+  write_file(G_FILE_COMPRESS);
+
+  EXPECT_EQ(BLO_blendfile_index_from_file(filepath), (BlendFileIndex *)NULL);
+  expect_thumbnail();
+  expect_object_names();
+  expect_read();
+}
+
+/* Compressing on multiple threads writes independent gzip members with their sizes in the header,
+ * reading seeks between them. Uses a mesh large enough for multiple members. */
+TEST_F(BlendfileIndexTest, CompressedFrames)
+{
+  Mesh *me = BKE_mesh_add(bmain, "Mesh");
+  id_fake_user_set(&me->id);
+  me->totvert = FRAMES_MESH_VERTS;
+  CustomData_add_layer(&me->vdata, CD_MVERT, CD_CALLOC, NULL, me->totvert);
+  BKE_mesh_update_customdata_pointers(me, false);
+  for (int i = 0; i < me->totvert; i++) {
+    me->mvert[i].co[0] = (float)i;
+  }
+
+  const int threads_override = BLI_system_num_threads_override_get();
+  BLI_system_num_threads_override_set(4);
+  write_file(G_FILE_COMPRESS);
+  BLI_system_num_threads_override_set(threads_override);
+
+  /* Walk the members through the sizes stored in their headers. */
+  FILE *file = BLI_fopen(filepath, "rb");
+  ASSERT_NE(file, (FILE *)NULL);
+  const size_t size = BLI_file_size(filepath);
+  size_t offset = 0;
+  int members_len = 0;
+  while (offset < size) {
+    unsigned char header[24];
+    ASSERT_EQ(fseek(file, (long)offset, SEEK_SET), 0);
+    ASSERT_EQ(fread(header, 1, sizeof(header), file), sizeof(header));
+    ASSERT_EQ(header[0], 0x1f);
+    ASSERT_EQ(header[1], 0x8b);
+    ASSERT_EQ(header[3], 4) << "no extra field in member " << members_len;
+    ASSERT_EQ(memcmp(&header[12], "BL", 2), 0);
+    const size_t member_len = (size_t)header[16] | ((size_t)header[17] << 8) |
+                              ((size_t)header[18] << 16) | ((size_t)header[19] << 24);
+    ASSERT_GT(member_len, sizeof(header));
+    offset += member_len;
+    members_len++;
+  }
+  fclose(file);
+  EXPECT_EQ(offset, size);
+  EXPECT_GT(members_len, 1);
+
+  expect_thumbnail();
+  expect_object_names();
+
+  BlendFileData *bfd = BLO_read_from_file(filepath, BLO_READ_SKIP_USERDEF, NULL);
+  ASSERT_NE(bfd, (BlendFileData *)NULL);
+  EXPECT_EQ(BLI_listbase_count(&bfd->main->objects), 2);
+  const Mesh *me_read = (const Mesh *)bfd->main->meshes.first;
+  ASSERT_NE(me_read, (const Mesh *)NULL);
+  ASSERT_EQ(me_read->totvert, FRAMES_MESH_VERTS);
+  for (int i = 0; i < me_read->totvert; i++) {
+    ASSERT_EQ(me_read->mvert[i].co[0], (float)i) << "vertex " << i;
+  }
+  BLO_blendfiledata_free(bfd);
+}
@@ -0,0 +1,414 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_fileops.h"
+#include "BLI_linklist.h"
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_genfile.h"
+#include "DNA_image_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_node_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_appdir.h"
+#include "BKE_blender.h"
+#include "BKE_collection.h"
+#include "BKE_customdata.h"
+#include "BKE_global.h"
+#include "BKE_gpencil_modifier.h"
+#include "BKE_image.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_eval_cache.h"
+#include "BKE_modifier.h"
+#include "BKE_node.h"
+#include "BKE_object.h"
+#include "BKE_scene.h"
+#include "BKE_shader_fx.h"
+
+#include "BLO_readfile.h"
+#include "BLO_undofile.h"
+#include "BLO_writefile.h"
+
+#include "DEG_depsgraph.h"
+
+#include "IMB_imbuf.h"
+
+#include "RNA_define.h"
+
+#include "PIL_time.h"
+
+#include "CLG_log.h"
+
+#include "MEM_guardedalloc.h"
+}
+
+DEFINE_int32(objects, 2000, "Number of objects with a small mesh of their own.");
+DEFINE_int32(large_meshes, 4, "Number of objects with a large mesh.");
+DEFINE_int32(large_mesh_size, 500, "Vertices along each side of the large mesh grids.");
+DEFINE_int32(node_trees, 20, "Number of shader node groups.");
+DEFINE_int32(node_tree_depth, 500, "Number of chained nodes in every node group.");
+DEFINE_int32(images, 2, "Number of packed images.");
+DEFINE_int32(image_size, 2048, "Width and height of the packed images.");
+DEFINE_int32(repeat, 3, "Number of times every file operation is timed.");
+DEFINE_int32(undo_steps, 10, "Number of undo pushes and pops.");
+
+/* Benchmark of reading and writing .blend files, on a scene generated from the settings above.
+ *
+ * Not run as part of the regular tests since it takes a while, the defaults give a file of about
+ * 100 MB. Run it as:
+ *
+ *   blendfile_performance_test --objects=10000 --large_mesh_size=2000 --repeat=5
+ *
+ * Load times include versioning, so the results can be compared across versions and DNA changes
+ * for the same settings. */
+
+class BlendfilePerformanceTest : public testing::Test {
+ protected:
+  static void SetUpTestCase()
+  {
+    /* Same order of initialization as in creator.c, minus everything which needs a window. */
+    CLG_init();
+    BLI_threadapi_init();
+    DNA_sdna_current_init();
+    BKE_blender_globals_init();
+    G.background = true;
+    BKE_tempdir_init(NULL);
+    IMB_init();
+    BKE_images_init();
+    BKE_modifier_init();
+    BKE_gpencil_modifier_init();
+    BKE_shaderfx_init();
+    DEG_register_node_types();
+    RNA_init();
+    init_nodesystem();
+  }
+
+  static void TearDownTestCase()
+  {
+    BKE_main_free(G_MAIN);
+    G_MAIN = NULL;
+    free_nodesystem();
+    RNA_exit();
+    DEG_free_node_types();
+    BKE_mesh_eval_cache_free();
+    BKE_images_exit();
+    IMB_exit();
+    BKE_tempdir_session_purge();
+    DNA_sdna_current_free();
+    BLI_threadapi_exit();
+    CLG_exit();
+  }
+};
+
+static double megabytes(const size_t size)
+{
+  return (double)size / (1024.0 * 1024.0);
+}
+
+static void print_timing(const char *name, const double time, const size_t size)
+{
+  printf("%-12s %8.4fs %8.2f MB %8.1f MB/s %8.2f MB peak\n",
+         name,
+         time,
+         megabytes(size),
+         (time > 0.0) ? megabytes(size) / time : 0.0,
+         megabytes(MEM_get_peak_memory()));
+}
+
+/* Grid of quads, \a size vertices along each side. */
+static Mesh *mesh_grid_add(Main *bmain, const char *name, const int size)
+{
+  Mesh *me = BKE_mesh_add(bmain, name);
+  const int quads = (size - 1) * (size - 1);
+
+  me->totvert = size * size;
+  me->totpoly = quads;
+  me->totloop = quads * 4;
+  CustomData_add_layer(&me->vdata, CD_MVERT, CD_CALLOC, NULL, me->totvert);
+  CustomData_add_layer(&me->pdata, CD_MPOLY, CD_CALLOC, NULL, me->totpoly);
+  CustomData_add_layer(&me->ldata, CD_MLOOP, CD_CALLOC, NULL, me->totloop);
+  BKE_mesh_update_customdata_pointers(me, false);
+
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      MVert *mv = &me->mvert[y * size + x];
+      mv->co[0] = (float)x / (float)size;
+      mv->co[1] = (float)y / (float)size;
+      mv->co[2] = 0.0f;
+    }
+  }
+  for (int y = 0, poly = 0; y < size - 1; y++) {
+    for (int x = 0; x < size - 1; x++, poly++) {
+      MPoly *mp = &me->mpoly[poly];
+      MLoop *ml = &me->mloop[poly * 4];
+      mp->loopstart = poly * 4;
+      mp->totloop = 4;
+      ml[0].v = y * size + x;
+      ml[1].v = y * size + x + 1;
+      ml[2].v = (y + 1) * size + x + 1;
+      ml[3].v = (y + 1) * size + x;
+    }
+  }
+  BKE_mesh_calc_edges(me, false, false);
+
+  return me;
+}
+
+static void object_add(Main *bmain, Scene *scene, const char *name, Mesh *me)
+{
+  Object *ob = BKE_object_add_only_object(bmain, OB_MESH, name);
+  /* The mesh is created with one user. */
+  ob->data = me;
+  BKE_collection_object_add(bmain, scene->master_collection, ob);
+}
+
+/* Chain of math nodes, each using the result of the previous one. */
+static void node_tree_add(Main *bmain, const char *name, const int depth)
+{
+  bNodeTree *ntree = ntreeAddTree(bmain, name, "ShaderNodeTree");
+  bNode *node_prev = NULL;
+
+  for (int i = 0; i < depth; i++) {
+    bNode *node = nodeAddStaticNode(NULL, ntree, SH_NODE_MATH);
+    node->locx = 200.0f * i;
+    if (node_prev) {
+      nodeAddLink(ntree,
+                  node_prev,
+                  (bNodeSocket *)node_prev->outputs.first,
+                  node,
+                  (bNodeSocket *)node->inputs.first);
+    }
+    node_prev = node;
+  }
+  ntreeUpdateTree(bmain, ntree);
+}
+
+static Main *scene_generate(const char *filepath)
+{
+  Main *bmain = BKE_main_new();
+  BLI_strncpy(bmain->name, filepath, sizeof(bmain->name));
+  Scene *scene = BKE_scene_add(bmain, "Scene");
+  char name[MAX_ID_NAME - 2];
+
+  for (int i = 0; i < FLAGS_objects; i++) {
+    BLI_snprintf(name, sizeof(name), "Small.%d", i);
+    object_add(bmain, scene, name, mesh_grid_add(bmain, name, 10));
+  }
+  for (int i = 0; i < FLAGS_large_meshes; i++) {
+    BLI_snprintf(name, sizeof(name), "Large.%d", i);
+    object_add(bmain, scene, name, mesh_grid_add(bmain, name, max_ii(FLAGS_large_mesh_size, 2)));
+  }
+  for (int i = 0; i < FLAGS_node_trees; i++) {
+    BLI_snprintf(name, sizeof(name), "Nodes.%d", i);
+    node_tree_add(bmain, name, FLAGS_node_tree_depth);
+  }
+  for (int i = 0; i < FLAGS_images; i++) {
+    const float color[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+    BLI_snprintf(name, sizeof(name), "Image.%d", i);
+    Image *ima = BKE_image_add_generated(
+        bmain, FLAGS_image_size, FLAGS_image_size, name, 32, false, IMA_GENTYPE_GRID, color, false);
+    /* Generated pixels aren't saved, packing them gives the file a large binary blob. */
+    BKE_image_memorypack(ima);
+  }
+
+  return bmain;
+}
+
+static size_t memfile_size_total(const MemFile *memfile)
+{
+  size_t size = 0;
+  LISTBASE_FOREACH (const MemFileChunk *, chunk, &memfile->chunks) {
+    size += chunk->size;
+  }
+  return size;
+}
+
+static void benchmark_save_load(Main *bmain, const char *filepath)
+{
+  for (int i = 0; i < FLAGS_repeat; i++) {
+    MEM_reset_peak_memory();
+    double time_start = PIL_check_seconds_timer();
+    const bool ok = BLO_write_file(bmain, filepath, G.fileflags, NULL, NULL);
+    EXPECT_TRUE(ok);
+    print_timing("Save", PIL_check_seconds_timer() - time_start, BLI_file_size(filepath));
+  }
+
+  for (int i = 0; i < FLAGS_repeat; i++) {
+    MEM_reset_peak_memory();
+    double time_start = PIL_check_seconds_timer();
+    BlendFileData *bfd = BLO_read_from_file(filepath, BLO_READ_SKIP_USERDEF, NULL);
+    const double time = PIL_check_seconds_timer() - time_start;
+    ASSERT_NE(bfd, (BlendFileData *)NULL);
+    EXPECT_EQ(BLI_listbase_count(&bfd->main->objects), BLI_listbase_count(&bmain->objects));
+    print_timing("Load", time, BLI_file_size(filepath));
+    BLO_blendfiledata_free(bfd);
+  }
+}
+
+/* Compressed saving on a single thread (gzwrite) and on all threads (frames compressed by
+ * workers), with the size relative to the uncompressed file. */
+static void benchmark_save_load_compressed(Main *bmain, const char *filepath)
+{
+  const size_t size_uncompressed = BLI_file_size(filepath);
+  const int threads_override = BLI_system_num_threads_override_get();
+  const int threads_num[2] = {1, BLI_system_thread_count()};
+
+  for (int t = 0; t < ARRAY_SIZE(threads_num); t++) {
+    if (t > 0 && threads_num[t] == threads_num[0]) {
+      /* Single core, the parallel writer is not used. */
+      break;
+    }
+    BLI_system_num_threads_override_set(threads_num[t]);
+    printf("Compressed, %d thread(s):\n", threads_num[t]);
+
+    for (int i = 0; i < FLAGS_repeat; i++) {
+      MEM_reset_peak_memory();
+      double time_start = PIL_check_seconds_timer();
+      const bool ok = BLO_write_file(bmain, filepath, G.fileflags | G_FILE_COMPRESS, NULL, NULL);
+      EXPECT_TRUE(ok);
+      const size_t size = BLI_file_size(filepath);
+      print_timing("Save", PIL_check_seconds_timer() - time_start, size);
+      printf("             %8.1f%% of the uncompressed size\n",
+             size_uncompressed ? 100.0 * (double)size / (double)size_uncompressed : 0.0);
+    }
+
+    for (int i = 0; i < FLAGS_repeat; i++) {
+      MEM_reset_peak_memory();
+      double time_start = PIL_check_seconds_timer();
+      BlendFileData *bfd = BLO_read_from_file(filepath, BLO_READ_SKIP_USERDEF, NULL);
+      const double time = PIL_check_seconds_timer() - time_start;
+      ASSERT_NE(bfd, (BlendFileData *)NULL);
+      EXPECT_EQ(BLI_listbase_count(&bfd->main->objects), BLI_listbase_count(&bmain->objects));
+      print_timing("Load", time, BLI_file_size(filepath));
+      BLO_blendfiledata_free(bfd);
+    }
+  }
+
+  BLI_system_num_threads_override_set(threads_override);
+}
+
+static void benchmark_link(const char *filepath, const char *filepath_target)
+{
+  for (int i = 0; i < FLAGS_repeat; i++) {
+    Main *bmain = BKE_main_new();
+    BLI_strncpy(bmain->name, filepath_target, sizeof(bmain->name));
+
+    MEM_reset_peak_memory();
+    double time_start = PIL_check_seconds_timer();
+    BlendHandle *bh = BLO_blendhandle_from_file(filepath, NULL);
+    ASSERT_NE(bh, (BlendHandle *)NULL);
+    int names_len;
+    LinkNode *names = BLO_blendhandle_get_datablock_names(bh, ID_OB, &names_len);
+    Main *mainl = BLO_library_link_begin(bmain, &bh, filepath);
+    for (LinkNode *link = names; link; link = link->next) {
+      BLO_library_link_named_part(mainl, &bh, ID_OB, (const char *)link->link);
+    }
+    BLO_library_link_end(mainl, &bh, 0, bmain, NULL, NULL, NULL);
+    BLO_blendhandle_close(bh);
+    const double time = PIL_check_seconds_timer() - time_start;
+
+    EXPECT_EQ(BLI_listbase_count(&bmain->objects), names_len);
+    print_timing("Link", time, BLI_file_size(filepath));
+    BLI_linklist_free(names, free);
+    BKE_main_free(bmain);
+  }
+}
+
+/* Same as memfile undo: every push is compared with the previous one, every pop reads the step
+ * into a new main, reusing data-blocks from the current one. */
+static Main *benchmark_undo(Main *bmain)
+{
+  MemFile **memfiles = (MemFile **)MEM_callocN(sizeof(*memfiles) * FLAGS_undo_steps, __func__);
+  const char *filepath = BKE_main_blendfile_path(bmain);
+
+  Object *ob = (Object *)bmain->objects.first;
+  for (int i = 0; i < FLAGS_undo_steps; i++) {
+    /* Small change between steps, as for a transform. */
+    ob->loc[2] += 1.0f;
+
+    memfiles[i] = (MemFile *)MEM_callocN(sizeof(MemFile), __func__);
+    MEM_reset_peak_memory();
+    const double time_start = PIL_check_seconds_timer();
+    BLO_write_file_mem(bmain, (i > 0) ? memfiles[i - 1] : NULL, memfiles[i], G.fileflags);
+    const double time = PIL_check_seconds_timer() - time_start;
+    print_timing("Undo push", time, memfile_size_total(memfiles[i]));
+    printf("             %8.2f MB not shared with the previous step\n",
+           megabytes(memfiles[i]->size));
+  }
+
+  for (int i = FLAGS_undo_steps - 1; i >= 0; i--) {
+    MEM_reset_peak_memory();
+    const double time_start = PIL_check_seconds_timer();
+    BlendFileData *bfd = BLO_read_from_memfile(
+        bmain, filepath, memfiles[i], BLO_READ_SKIP_USERDEF, NULL);
+    const double time = PIL_check_seconds_timer() - time_start;
+    EXPECT_NE(bfd, (BlendFileData *)NULL);
+    if (bfd == NULL) {
+      break;
+    }
+    print_timing("Undo pop", time, memfile_size_total(memfiles[i]));
+
+    /* The undone state replaces the current one, as in #BKE_memfile_undo_decode. */
+    BKE_main_free(bmain);
+    bmain = bfd->main;
+    bfd->main = NULL;
+    BLO_blendfiledata_free(bfd);
+  }
+
+  for (int i = 0; i < FLAGS_undo_steps; i++) {
+    BLO_memfile_free(memfiles[i]);
+    MEM_freeN(memfiles[i]);
+  }
+  MEM_freeN(memfiles);
+  return bmain;
+}
+
+TEST_F(BlendfilePerformanceTest, SaveLoadLinkUndo)
+{
+  char filepath[FILE_MAX], filepath_target[FILE_MAX];
+  BLI_join_dirfile(filepath, sizeof(filepath), BKE_tempdir_session(), "benchmark.blend");
+  BLI_join_dirfile(
+      filepath_target, sizeof(filepath_target), BKE_tempdir_session(), "benchmark_link.blend");
+
+  double time_start = PIL_check_seconds_timer();
+  Main *bmain = scene_generate(filepath);
+  printf("Generated %d objects, %d meshes, %d node trees, %d images in %.2fs\n",
+         BLI_listbase_count(&bmain->objects),
+         BLI_listbase_count(&bmain->meshes),
+         BLI_listbase_count(&bmain->nodetrees),
+         BLI_listbase_count(&bmain->images),
+         PIL_check_seconds_timer() - time_start);
+
+  benchmark_save_load(bmain, filepath);
+  benchmark_link(filepath, filepath_target);
+  bmain = benchmark_undo(bmain);
+
+  BKE_main_free(bmain);
+  BLI_delete(filepath, false, false);
+}
+
+TEST_F(BlendfilePerformanceTest, SaveLoadCompressed)
+{
+  char filepath[FILE_MAX];
+  BLI_join_dirfile(filepath, sizeof(filepath), BKE_tempdir_session(), "benchmark.blend");
+
+  Main *bmain = scene_generate(filepath);
+  /* Uncompressed file to compare the size with. */
+  EXPECT_TRUE(BLO_write_file(bmain, filepath, G.fileflags & ~G_FILE_COMPRESS, NULL, NULL));
+
+  benchmark_save_load_compressed(bmain, filepath);
+
+  BKE_main_free(bmain);
+  BLI_delete(filepath, false, false);
+}
@@ -0,0 +1,262 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "COM_BokehBlurOperation.h"
+#include "COM_FastGaussianBlurOperation.h"
+#include "COM_GaussianBokehBlurOperation.h"
+#include "COM_GaussianXBlurOperation.h"
+#include "COM_GaussianYBlurOperation.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_SetValueOperation.h"
+
+extern "C" {
+#include "BLI_math_base.h"
+#include "BLI_rand.h"
+#include "BLI_rect.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_node_types.h"
+#include "DNA_scene_types.h"
+
+#include "PIL_time.h"
+
+#include "MEM_guardedalloc.h"
+}
+
+DEFINE_int32(width, 512, "Width of the blurred image.");
+DEFINE_int32(height, 512, "Height of the blurred image.");
+
+/* Benchmark of the blur operations of the compositor, on a generated image.
+ *
+ * Every operation is executed on a single thread, so the numbers compare the filters and not the
+ * scheduling. Not run as part of the regular tests, since large radii take a while. Run it as:
+ *
+ *   compositor_blur_performance_test --width=1920 --height=1080
+ */
+
+static const int blur_radii[] = {4, 8, 16, 32, 64};
+
+/* Image held in a buffer, in place of the read buffer operation in front of a blur. */
+class BufferInputOperation : public NodeOperation {
+ private:
+  MemoryBuffer *m_buffer;
+
+ public:
+  BufferInputOperation(MemoryBuffer *buffer) : m_buffer(buffer)
+  {
+    this->addOutputSocket(COM_DT_COLOR);
+    unsigned int resolution[2] = {(unsigned int)buffer->getWidth(),
+                                 (unsigned int)buffer->getHeight()};
+    this->setResolution(resolution);
+  }
+
+  void *initializeTileData(rcti * /*rect*/)
+  {
+    return this->m_buffer;
+  }
+
+  void executePixelSampled(float output[4], float x, float y, PixelSampler /*sampler*/)
+  {
+    this->m_buffer->read(output, (int)x, (int)y);
+  }
+};
+
+class CompositorBlurPerformanceTest : public testing::Test {
+ protected:
+  MemoryBuffer *m_image;
+  MemoryBuffer *m_bokeh;
+
+  static void SetUpTestCase()
+  {
+    /* Task scheduler for the FFT convolution. */
+    BLI_threadapi_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BLI_threadapi_exit();
+  }
+
+  void SetUp()
+  {
+    rcti rect;
+    BLI_rcti_init(&rect, 0, FLAGS_width, 0, FLAGS_height);
+    m_image = new MemoryBuffer(COM_DT_COLOR, &rect);
+    RNG *rng = BLI_rng_new(0);
+    float *color = m_image->getBuffer();
+    for (int i = 0; i < FLAGS_width * FLAGS_height * COM_NUM_CHANNELS_COLOR; i++) {
+      color[i] = BLI_rng_get_float(rng);
+    }
+    BLI_rng_free(rng);
+
+    /* Disk shaped bokeh, as the bokeh image node makes. */
+    const int bokeh_size = 512;
+    BLI_rcti_init(&rect, 0, bokeh_size, 0, bokeh_size);
+    m_bokeh = new MemoryBuffer(COM_DT_COLOR, &rect);
+    for (int y = 0; y < bokeh_size; y++) {
+      for (int x = 0; x < bokeh_size; x++) {
+        const float u = x - bokeh_size / 2.0f, v = y - bokeh_size / 2.0f;
+        const float value = (u * u + v * v < bokeh_size * bokeh_size / 4.0f) ? 1.0f : 0.0f;
+        const float bokeh[4] = {value, value, value, 1.0f};
+        m_bokeh->writePixel(x, y, bokeh);
+      }
+    }
+  }
+
+  void TearDown()
+  {
+    delete m_image;
+    delete m_bokeh;
+  }
+};
+
+static void link_input(NodeOperation *operation, int index, NodeOperation *input)
+{
+  operation->getInputSocket(index)->setLink(input->getOutputSocket());
+}
+
+static void set_resolution(NodeOperation *operation, MemoryBuffer *buffer)
+{
+  unsigned int resolution[2] = {(unsigned int)buffer->getWidth(),
+                                 (unsigned int)buffer->getHeight()};
+  operation->setResolution(resolution);
+}
+
+/* Execute an operation for every pixel of the output, returns the time it took. */
+static double execute_operation(NodeOperation *operation, MemoryBuffer *output)
+{
+  rcti rect;
+  BLI_rcti_init(&rect, 0, output->getWidth(), 0, output->getHeight());
+
+  const double time_start = PIL_check_seconds_timer();
+  operation->initExecution();
+  void *data = operation->initializeTileData(&rect);
+  float *color = output->getBuffer();
+  for (int y = 0; y < rect.ymax; y++) {
+    for (int x = 0; x < rect.xmax; x++, color += COM_NUM_CHANNELS_COLOR) {
+      operation->read(color, x, y, data);
+    }
+  }
+  operation->deinitializeTileData(&rect, data);
+  operation->deinitExecution();
+  return PIL_check_seconds_timer() - time_start;
+}
+
+static NodeBlurData blur_data(int radius)
+{
+  NodeBlurData data = {0};
+  data.sizex = data.sizey = radius;
+  data.filtertype = R_FILTER_GAUSS;
+  return data;
+}
+
+TEST_F(CompositorBlurPerformanceTest, Gaussian)
+{
+  printf("\nGaussian blur of %dx%d pixels, separable and recursive (fast gaussian)\n",
+         FLAGS_width,
+         FLAGS_height);
+
+  MemoryBuffer *blur_x = new MemoryBuffer(COM_DT_COLOR, m_image->getRect());
+  MemoryBuffer *output = new MemoryBuffer(COM_DT_COLOR, m_image->getRect());
+  BufferInputOperation input(m_image);
+  BufferInputOperation input_y(blur_x);
+
+  for (int i = 0; i < ARRAY_SIZE(blur_radii); i++) {
+    const NodeBlurData data = blur_data(blur_radii[i]);
+
+    GaussianXBlurOperation operation_x;
+    operation_x.setData(&data);
+    operation_x.setSize(1.0f);
+    operation_x.setQuality(COM_QUALITY_HIGH);
+    link_input(&operation_x, 0, &input);
+    set_resolution(&operation_x, m_image);
+
+    GaussianYBlurOperation operation_y;
+    operation_y.setData(&data);
+    operation_y.setSize(1.0f);
+    operation_y.setQuality(COM_QUALITY_HIGH);
+    link_input(&operation_y, 0, &input_y);
+    set_resolution(&operation_y, m_image);
+
+    const double separable_time = execute_operation(&operation_x, blur_x) +
+                                  execute_operation(&operation_y, output);
+
+    FastGaussianBlurOperation operation_fast;
+    operation_fast.setData(&data);
+    operation_fast.setSize(1.0f);
+    link_input(&operation_fast, 0, &input);
+    set_resolution(&operation_fast, m_image);
+
+    const double recursive_time = execute_operation(&operation_fast, output);
+
+    printf("  Radius %3d: %8.4fs separable, %8.4fs recursive\n",
+           blur_radii[i],
+           separable_time,
+           recursive_time);
+  }
+
+  delete blur_x;
+  delete output;
+}
+
+TEST_F(CompositorBlurPerformanceTest, GaussianBokeh)
+{
+  printf("\nGaussian bokeh blur of %dx%d pixels, FFT from radius 8\n", FLAGS_width, FLAGS_height);
+
+  MemoryBuffer *output = new MemoryBuffer(COM_DT_COLOR, m_image->getRect());
+  BufferInputOperation input(m_image);
+
+  for (int i = 0; i < ARRAY_SIZE(blur_radii); i++) {
+    const NodeBlurData data = blur_data(blur_radii[i]);
+
+    GaussianBokehBlurOperation operation;
+    operation.setData(&data);
+    operation.setSize(1.0f);
+    operation.setQuality(COM_QUALITY_HIGH);
+    link_input(&operation, 0, &input);
+    set_resolution(&operation, m_image);
+
+    printf("  Radius %3d: %8.4fs\n", blur_radii[i], execute_operation(&operation, output));
+  }
+
+  delete output;
+}
+
+TEST_F(CompositorBlurPerformanceTest, Bokeh)
+{
+  printf("\nBokeh blur of %dx%d pixels, per pixel and FFT\n", FLAGS_width, FLAGS_height);
+
+  MemoryBuffer *output_pixel = new MemoryBuffer(COM_DT_COLOR, m_image->getRect());
+  MemoryBuffer *output_fft = new MemoryBuffer(COM_DT_COLOR, m_image->getRect());
+  BufferInputOperation input(m_image);
+  BufferInputOperation bokeh(m_bokeh);
+  SetValueOperation bounding_box;
+  bounding_box.setValue(1.0f);
+
+  const float max_dim = max_ii(FLAGS_width, FLAGS_height);
+  for (int i = 0; i < ARRAY_SIZE(blur_radii); i++) {
+    double time[2];
+    for (int use_fft = 0; use_fft < 2; use_fft++) {
+      BokehBlurOperation operation;
+      /* Size is a percentage of the image, half a pixel more to not round down the radius. */
+      operation.setSize((blur_radii[i] + 0.5f) * 100.0f / max_dim);
+      operation.setQuality(COM_QUALITY_HIGH);
+      operation.setUseFFT(use_fft);
+      link_input(&operation, 0, &input);
+      link_input(&operation, 1, &bokeh);
+      link_input(&operation, 2, &bounding_box);
+      set_resolution(&operation, m_image);
+
+      time[use_fft] = execute_operation(&operation, use_fft ? output_fft : output_pixel);
+    }
+
+    /* Radii below the threshold are filtered per pixel either way. The results are compared in
+     * compositor_fht_test. */
+    printf("  Radius %3d: %8.4fs per pixel, %8.4fs FFT\n", blur_radii[i], time[0], time[1]);
+  }
+
+  delete output_pixel;
+  delete output_fft;
+}
@@ -0,0 +1,255 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "COM_BokehBlurOperation.h"
+#include "COM_FHTConvolution.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_SetValueOperation.h"
+
+extern "C" {
+#include "BLI_math_base.h"
+#include "BLI_rand.h"
+#include "BLI_rect.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "MEM_guardedalloc.h"
+}
+
+/* FFT convolution compared with brute force filters on small images, with sizes which are not
+ * powers of two and kernels which are not centered. */
+
+#define IMAGE_WIDTH 45
+#define IMAGE_HEIGHT 31
+
+/* Image held in a buffer, in place of the read buffer operation in front of a blur. */
+class BufferInputOperation : public NodeOperation {
+ private:
+  MemoryBuffer *m_buffer;
+
+ public:
+  BufferInputOperation(MemoryBuffer *buffer) : m_buffer(buffer)
+  {
+    this->addOutputSocket(COM_DT_COLOR);
+    unsigned int resolution[2] = {(unsigned int)buffer->getWidth(),
+                                 (unsigned int)buffer->getHeight()};
+    this->setResolution(resolution);
+  }
+
+  void *initializeTileData(rcti * /*rect*/)
+  {
+    return this->m_buffer;
+  }
+
+  void executePixelSampled(float output[4], float x, float y, PixelSampler /*sampler*/)
+  {
+    this->m_buffer->read(output, (int)x, (int)y);
+  }
+};
+
+class CompositorFHTTest : public testing::Test {
+ protected:
+  MemoryBuffer *m_image;
+
+  static void SetUpTestCase()
+  {
+    /* Task scheduler for filtering the channels in parallel. */
+    BLI_threadapi_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    BLI_threadapi_exit();
+  }
+
+  void SetUp()
+  {
+    rcti rect;
+    BLI_rcti_init(&rect, 0, IMAGE_WIDTH, 0, IMAGE_HEIGHT);
+    m_image = new MemoryBuffer(COM_DT_COLOR, &rect);
+    RNG *rng = BLI_rng_new(0);
+    float *color = m_image->getBuffer();
+    for (int i = 0; i < IMAGE_WIDTH * IMAGE_HEIGHT * COM_NUM_CHANNELS_COLOR; i++) {
+      color[i] = BLI_rng_get_float(rng);
+    }
+    BLI_rng_free(rng);
+  }
+
+  void TearDown()
+  {
+    delete m_image;
+  }
+};
+
+static float *random_kernel(int len, unsigned int seed)
+{
+  float *kernel = (float *)MEM_mallocN(sizeof(float) * len, __func__);
+  RNG *rng = BLI_rng_new(seed);
+  for (int i = 0; i < len; i++) {
+    kernel[i] = BLI_rng_get_float(rng);
+  }
+  BLI_rng_free(rng);
+  return kernel;
+}
+
+TEST_F(CompositorFHTTest, FilterChannel)
+{
+  const int kernel_width = 9, kernel_height = 6;
+  const int center_x = 3, center_y = 4;
+  float *kernel = random_kernel(kernel_width * kernel_height, 1);
+  float *dst = (float *)MEM_callocN(sizeof(float) * IMAGE_WIDTH * IMAGE_HEIGHT, __func__);
+
+  /* Green channel of the image, to test the strides. */
+  const float *src = m_image->getBuffer() + 1;
+  fht_filter_channel(dst,
+                     1,
+                     src,
+                     COM_NUM_CHANNELS_COLOR,
+                     IMAGE_WIDTH,
+                     IMAGE_HEIGHT,
+                     kernel,
+                     1,
+                     kernel_width,
+                     kernel_height,
+                     center_x,
+                     center_y);
+
+  for (int y = 0; y < IMAGE_HEIGHT; y++) {
+    for (int x = 0; x < IMAGE_WIDTH; x++) {
+      float expected = 0.0f;
+      for (int j = 0; j < kernel_height; j++) {
+        for (int i = 0; i < kernel_width; i++) {
+          const int sx = x + i - center_x, sy = y + j - center_y;
+          if (sx >= 0 && sx < IMAGE_WIDTH && sy >= 0 && sy < IMAGE_HEIGHT) {
+            expected += src[(sy * IMAGE_WIDTH + sx) * COM_NUM_CHANNELS_COLOR] *
+                        kernel[j * kernel_width + i];
+          }
+        }
+      }
+      ASSERT_NEAR(dst[y * IMAGE_WIDTH + x], expected, 1e-3f) << "pixel " << x << ", " << y;
+    }
+  }
+
+  MEM_freeN(kernel);
+  MEM_freeN(dst);
+}
+
+TEST_F(CompositorFHTTest, FilterNormalized)
+{
+  const int kernel_width = 12, kernel_height = 7;
+  const int center_x = 6, center_y = 2;
+  float *kernel = random_kernel(kernel_width * kernel_height * COM_NUM_CHANNELS_COLOR, 2);
+
+  MemoryBuffer *output = fht_filter_normalized(
+      m_image, kernel, COM_NUM_CHANNELS_COLOR, kernel_width, kernel_height, center_x, center_y);
+  ASSERT_NE(output, (MemoryBuffer *)NULL);
+  EXPECT_EQ(output->getWidth(), IMAGE_WIDTH);
+  EXPECT_EQ(output->getHeight(), IMAGE_HEIGHT);
+
+  for (int y = 0; y < IMAGE_HEIGHT; y++) {
+    for (int x = 0; x < IMAGE_WIDTH; x++) {
+      float color[4] = {0.0f}, weight[4] = {0.0f};
+      for (int j = 0; j < kernel_height; j++) {
+        for (int i = 0; i < kernel_width; i++) {
+          const int sx = x + i - center_x, sy = y + j - center_y;
+          if (sx >= 0 && sx < IMAGE_WIDTH && sy >= 0 && sy < IMAGE_HEIGHT) {
+            const float *k = &kernel[(j * kernel_width + i) * COM_NUM_CHANNELS_COLOR];
+            const float *src = &m_image->getBuffer()[(sy * IMAGE_WIDTH + sx) *
+                                                     COM_NUM_CHANNELS_COLOR];
+            for (int c = 0; c < COM_NUM_CHANNELS_COLOR; c++) {
+              color[c] += src[c] * k[c];
+              weight[c] += k[c];
+            }
+          }
+        }
+      }
+      const float *result = &output->getBuffer()[(y * IMAGE_WIDTH + x) * COM_NUM_CHANNELS_COLOR];
+      for (int c = 0; c < COM_NUM_CHANNELS_COLOR; c++) {
+        ASSERT_NEAR(result[c], color[c] / weight[c], 1e-3f)
+            << "pixel " << x << ", " << y << ", channel " << c;
+      }
+    }
+  }
+
+  delete output;
+  MEM_freeN(kernel);
+}
+
+static void link_input(NodeOperation *operation, int index, NodeOperation *input)
+{
+  operation->getInputSocket(index)->setLink(input->getOutputSocket());
+}
+
+/* Execute an operation for every pixel of the output. */
+static void execute_operation(NodeOperation *operation, MemoryBuffer *output)
+{
+  rcti rect;
+  BLI_rcti_init(&rect, 0, output->getWidth(), 0, output->getHeight());
+
+  operation->initExecution();
+  void *data = operation->initializeTileData(&rect);
+  float *color = output->getBuffer();
+  for (int y = 0; y < rect.ymax; y++) {
+    for (int x = 0; x < rect.xmax; x++, color += COM_NUM_CHANNELS_COLOR) {
+      operation->read(color, x, y, data);
+    }
+  }
+  operation->deinitializeTileData(&rect, data);
+  operation->deinitExecution();
+}
+
+/* The bokeh blur switches to FFT convolution for large sizes, the result has to match the per
+ * pixel filter. */
+TEST_F(CompositorFHTTest, BokehBlur)
+{
+  /* Disk shaped bokeh, as the bokeh image node makes. */
+  const int bokeh_size = 64;
+  rcti rect;
+  BLI_rcti_init(&rect, 0, bokeh_size, 0, bokeh_size);
+  MemoryBuffer *bokeh_image = new MemoryBuffer(COM_DT_COLOR, &rect);
+  for (int y = 0; y < bokeh_size; y++) {
+    for (int x = 0; x < bokeh_size; x++) {
+      const float u = x - bokeh_size / 2.0f, v = y - bokeh_size / 2.0f;
+      const float value = (u * u + v * v < bokeh_size * bokeh_size / 4.0f) ? 1.0f : 0.0f;
+      const float color[4] = {value, value, value, 1.0f};
+      bokeh_image->writePixel(x, y, color);
+    }
+  }
+
+  MemoryBuffer *output_pixel = new MemoryBuffer(COM_DT_COLOR, m_image->getRect());
+  MemoryBuffer *output_fft = new MemoryBuffer(COM_DT_COLOR, m_image->getRect());
+  BufferInputOperation input(m_image);
+  BufferInputOperation bokeh(bokeh_image);
+  SetValueOperation bounding_box;
+  bounding_box.setValue(1.0f);
+
+  /* Below and above the size of the image. */
+  const int blur_radii[] = {16, 24, 40};
+  for (int i = 0; i < ARRAY_SIZE(blur_radii); i++) {
+    for (int use_fft = 0; use_fft < 2; use_fft++) {
+      BokehBlurOperation operation;
+      /* Size is a percentage of the image, half a pixel more to not round down the radius. */
+      operation.setSize((blur_radii[i] + 0.5f) * 100.0f / IMAGE_WIDTH);
+      operation.setQuality(COM_QUALITY_HIGH);
+      operation.setUseFFT(use_fft);
+      link_input(&operation, 0, &input);
+      link_input(&operation, 1, &bokeh);
+      link_input(&operation, 2, &bounding_box);
+      unsigned int resolution[2] = {IMAGE_WIDTH, IMAGE_HEIGHT};
+      operation.setResolution(resolution);
+
+      execute_operation(&operation, use_fft ? output_fft : output_pixel);
+    }
+
+    const int len = IMAGE_WIDTH * IMAGE_HEIGHT * COM_NUM_CHANNELS_COLOR;
+    for (int j = 0; j < len; j++) {
+      ASSERT_NEAR(output_fft->getBuffer()[j], output_pixel->getBuffer()[j], 1e-3f)
+          << "radius " << blur_radii[i] << ", float " << j;
+    }
+  }
+
+  delete output_pixel;
+  delete output_fft;
+  delete bokeh_image;
+}
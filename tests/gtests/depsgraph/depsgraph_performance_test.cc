@@ -0,0 +1,231 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <sstream>
+#include <string>
+
+extern "C" {
+#include "BLI_math_base.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_genfile.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_blender.h"
+#include "BKE_global.h"
+#include "BKE_gpencil.h"
+#include "BKE_gpencil_modifier.h"
+#include "BKE_image.h"
+#include "BKE_layer.h"
+#include "BKE_main.h"
+#include "BKE_mesh_eval_cache.h"
+#include "BKE_modifier.h"
+#include "BKE_node.h"
+#include "BKE_scene.h"
+#include "BKE_shader_fx.h"
+
+#include "BLO_readfile.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_debug.h"
+
+#include "IMB_imbuf.h"
+
+#include "RNA_define.h"
+
+#include "PIL_time.h"
+
+#include "CLG_log.h"
+
+#include "MEM_guardedalloc.h"
+}
+
+DEFINE_string(blend_files, "", "Comma separated list of .blend files to benchmark.");
+DEFINE_int32(frames, 100, "Number of frame changes to evaluate for every file.");
+DEFINE_int32(rebuilds, 10, "Number of relations rebuilds for every file.");
+
+/* Benchmark of the dependency graph on real files.
+ *
+ * Not run as part of the regular tests, since there are no benchmark files in the repository.
+ * Run it as:
+ *
+ *   depsgraph_performance_test --blend_files=/path/a.blend,/path/b.blend --frames=250
+ */
+
+/* Grease pencil calls into the draw manager without checking for a batch cache first, there is no
+ * draw manager to register its callbacks here. */
+static void gpencil_batch_cache_noop(bGPdata * /*gpd*/)
+{
+}
+
+class DepsgraphPerformanceTest : public testing::Test {
+ protected:
+  static void SetUpTestCase()
+  {
+    /* Same order of initialization as in creator.c, minus everything which needs a window. */
+    CLG_init();
+    BLI_threadapi_init();
+    DNA_sdna_current_init();
+    BKE_blender_globals_init();
+    G.background = true;
+    IMB_init();
+    BKE_images_init();
+    BKE_modifier_init();
+    BKE_gpencil_modifier_init();
+    BKE_shaderfx_init();
+    DEG_register_node_types();
+    RNA_init();
+    init_nodesystem();
+    BKE_gpencil_batch_cache_dirty_tag_cb = gpencil_batch_cache_noop;
+    BKE_gpencil_batch_cache_free_cb = gpencil_batch_cache_noop;
+  }
+
+  static void TearDownTestCase()
+  {
+    BKE_main_free(G_MAIN);
+    G_MAIN = NULL;
+    free_nodesystem();
+    RNA_exit();
+    DEG_free_node_types();
+    BKE_mesh_eval_cache_free();
+    BKE_images_exit();
+    IMB_exit();
+    DNA_sdna_current_free();
+    BLI_threadapi_exit();
+    CLG_exit();
+  }
+};
+
+static void benchmark_blend_file(const char *filepath)
+{
+  printf("\n========== %s ==========\n", filepath);
+
+  const uint blocks_start = MEM_get_memory_blocks_in_use();
+  double time_start = PIL_check_seconds_timer();
+  BlendFileData *bfd = BLO_read_from_file(filepath, BLO_READ_SKIP_USERDEF, NULL);
+  if (bfd == NULL || bfd->curscene == NULL) {
+    printf("Failed to read the file, skipping.\n");
+    if (bfd != NULL) {
+      BLO_blendfiledata_free(bfd);
+    }
+    return;
+  }
+  printf("Load: %.4fs\n", PIL_check_seconds_timer() - time_start);
+
+  Main *bmain = bfd->main;
+  Scene *scene = bfd->curscene;
+  ViewLayer *view_layer = bfd->cur_view_layer ? bfd->cur_view_layer :
+                                                BKE_view_layer_default_view(scene);
+
+  /* Graph is owned by the scene, so DEG_relations_tag_update() can find it. */
+  MEM_reset_peak_memory();
+  const size_t memory_start = MEM_get_memory_in_use();
+  Depsgraph *depsgraph = BKE_scene_get_depsgraph(scene, view_layer, true);
+
+  time_start = PIL_check_seconds_timer();
+  DEG_graph_build_from_view_layer(depsgraph, bmain, scene, view_layer);
+  const double build_time = PIL_check_seconds_timer() - time_start;
+
+  size_t outer, operations, relations;
+  DEG_stats_simple(depsgraph, &outer, &operations, &relations);
+  printf("Build: %.4fs (%d ID and component nodes, %d operations, %d relations)\n",
+         build_time,
+         (int)outer,
+         (int)operations,
+         (int)relations);
+  printf("Graph memory: %.2f MB\n",
+         (double)(MEM_get_memory_in_use() - memory_start) / (1024.0 * 1024.0));
+  size_t relations_nodes_memory, relations_arrays_memory;
+  DEG_stats_relations_memory(depsgraph, &relations_nodes_memory, &relations_arrays_memory);
+  printf("Relations memory: %.2f MB as nodes, %.2f MB as arrays\n",
+         (double)relations_nodes_memory / (1024.0 * 1024.0),
+         (double)relations_arrays_memory / (1024.0 * 1024.0));
+
+  /* First evaluation expands all copy-on-write data-blocks, keep it apart from the frames. */
+  time_start = PIL_check_seconds_timer();
+  DEG_evaluate_on_refresh(depsgraph);
+  printf("Initial evaluation: %.4fs\n", PIL_check_seconds_timer() - time_start);
+
+  /* Relations rebuild, as happens after adding or removing objects or modifiers. */
+  double rebuild_time = 0.0;
+  for (int i = 0; i < FLAGS_rebuilds; i++) {
+    DEG_relations_tag_update(bmain);
+    time_start = PIL_check_seconds_timer();
+    DEG_graph_relations_update(depsgraph, bmain, scene, view_layer);
+    rebuild_time += PIL_check_seconds_timer() - time_start;
+    DEG_evaluate_on_refresh(depsgraph);
+  }
+  if (FLAGS_rebuilds > 0) {
+    printf("Relations rebuild: %.4fs average over %d rebuilds\n",
+           rebuild_time / FLAGS_rebuilds,
+           FLAGS_rebuilds);
+  }
+
+  /* Frame changes. Per-thread busy time is only gathered with depsgraph time debugging. */
+  double thread_busy_time[BLENDER_MAX_THREADS + 1] = {0.0};
+  int num_threads = 0;
+  double eval_time = 0.0, eval_time_min = 0.0, eval_time_max = 0.0;
+  const int frame_range = max_ii(scene->r.efra - scene->r.sfra + 1, 1);
+  const uint blocks_frames_start = MEM_get_memory_blocks_in_use();
+
+  G.debug |= G_DEBUG_DEPSGRAPH_TIME;
+  for (int i = 0; i < FLAGS_frames; i++) {
+    const float frame = (float)(scene->r.sfra + (i % frame_range));
+    time_start = PIL_check_seconds_timer();
+    DEG_evaluate_on_framechange(bmain, depsgraph, frame);
+    const double frame_time = PIL_check_seconds_timer() - time_start;
+
+    eval_time += frame_time;
+    eval_time_min = (i == 0) ? frame_time : MIN2(eval_time_min, frame_time);
+    eval_time_max = MAX2(eval_time_max, frame_time);
+
+    double frame_busy_time[BLENDER_MAX_THREADS + 1];
+    const int frame_num_threads = DEG_debug_eval_thread_busy_time_get(
+        depsgraph, frame_busy_time, ARRAY_SIZE(frame_busy_time));
+    for (int thread = 0; thread < frame_num_threads; thread++) {
+      thread_busy_time[thread] += frame_busy_time[thread];
+    }
+    num_threads = max_ii(num_threads, frame_num_threads);
+  }
+  G.debug &= ~G_DEBUG_DEPSGRAPH_TIME;
+
+  if (FLAGS_frames > 0) {
+    printf("Frame evaluation: %.4fs average, %.4fs min, %.4fs max over %d frames\n",
+           eval_time / FLAGS_frames,
+           eval_time_min,
+           eval_time_max,
+           FLAGS_frames);
+    /* Time spent in the callbacks of operations, relative to the total evaluation time. */
+    for (int thread = 0; thread < num_threads; thread++) {
+      printf("  Thread %2d: %5.1f%% busy\n",
+             thread,
+             (eval_time > 0.0) ? 100.0 * thread_busy_time[thread] / eval_time : 0.0);
+    }
+    printf("Memory blocks added during frames: %d\n",
+           (int)MEM_get_memory_blocks_in_use() - (int)blocks_frames_start);
+  }
+  printf("Peak memory: %.2f MB\n", (double)MEM_get_peak_memory() / (1024.0 * 1024.0));
+
+  BLO_blendfiledata_free(bfd);
+
+  printf("Memory blocks left after freeing the file: %d\n",
+         (int)MEM_get_memory_blocks_in_use() - (int)blocks_start);
+}
+
+TEST_F(DepsgraphPerformanceTest, EvaluateFiles)
+{
+  if (FLAGS_blend_files.empty()) {
+    printf("No files given, pass --blend_files to run the benchmark.\n");
+    return;
+  }
+  std::stringstream files(FLAGS_blend_files);
+  std::string filepath;
+  while (std::getline(files, filepath, ',')) {
+    if (!filepath.empty()) {
+      benchmark_blend_file(filepath.c_str());
+    }
+  }
+}
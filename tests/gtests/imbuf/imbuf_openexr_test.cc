@@ -0,0 +1,302 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <ImfChannelList.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfOutputFile.h>
+#include <ImfStringAttribute.h>
+
+#include "openexr_multi.h"
+
+extern "C" {
+#include "BLI_fileops.h"
+#include "BLI_path_util.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_scene_types.h"
+
+#include "BKE_appdir.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+#include "MEM_guardedalloc.h"
+}
+
+/* Passes of multilayer files read row by row, as the compositor streams them, compared with the
+ * passes read all at once for render results. */
+
+#define IMAGE_WIDTH 37
+/* More than the 16 rows of a ZIP compressed chunk, and not a multiple of it. */
+#define IMAGE_HEIGHT 45
+
+struct TestPass {
+  std::string layer, pass, view;
+  float *rect;
+  int channels;
+};
+
+/* Passes read by #IMB_exr_read_channels, gathered through #IMB_exr_multilayer_convert. */
+struct TestPasses {
+  std::list<std::string> layers;
+  std::vector<TestPass> passes;
+};
+
+static void *test_passes_add_view(void * /*base*/, const char * /*name*/)
+{
+  return NULL;
+}
+
+static void *test_passes_add_layer(void *base, const char *name)
+{
+  TestPasses *passes = (TestPasses *)base;
+  passes->layers.push_back(name);
+  return &passes->layers.back();
+}
+
+static void test_passes_add_pass(void *base,
+                                 void *lay,
+                                 const char *name,
+                                 float *rect,
+                                 int totchan,
+                                 const char * /*chan_id*/,
+                                 const char *view)
+{
+  TestPasses *passes = (TestPasses *)base;
+  TestPass pass = {*(std::string *)lay, name, view, rect, totchan};
+  passes->passes.push_back(pass);
+}
+
+/* Value of a pixel, different for every layer, pass, view, channel and position. */
+static float test_pixel(int seed, int x, int y, int channel)
+{
+  return seed * 1000.0f + (y * IMAGE_WIDTH + x) + channel * 0.25f;
+}
+
+class ImbufOpenEXRTest : public testing::Test {
+ protected:
+  char filepath[FILE_MAX];
+  std::vector<float *> rects;
+
+  static void SetUpTestCase()
+  {
+    BKE_tempdir_init(NULL);
+    IMB_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    IMB_exit();
+    BKE_tempdir_session_purge();
+  }
+
+  void SetUp() override
+  {
+    BLI_join_dirfile(filepath, sizeof(filepath), BKE_tempdir_session(), "passes.exr");
+  }
+
+  void TearDown() override
+  {
+    for (float *rect : rects) {
+      MEM_freeN(rect);
+    }
+    BLI_delete(filepath, false, false);
+  }
+
+  /* Pixels of a pass, rows from the bottom as Blender stores them. */
+  float *pass_rect(int seed, int channels)
+  {
+    float *rect = (float *)MEM_mallocN(sizeof(float) * IMAGE_WIDTH * IMAGE_HEIGHT * channels,
+                                       __func__);
+    for (int y = 0; y < IMAGE_HEIGHT; y++) {
+      for (int x = 0; x < IMAGE_WIDTH; x++) {
+        for (int c = 0; c < channels; c++) {
+          rect[(y * IMAGE_WIDTH + x) * channels + c] = test_pixel(seed, x, y, c);
+        }
+      }
+    }
+    rects.push_back(rect);
+    return rect;
+  }
+
+  /* Write the passes of a render result with two layers and two views, as Blender saves
+   * multilayer images. */
+  void write_multilayer_multiview()
+  {
+    void *handle = IMB_exr_get_handle();
+    const char *views[] = {"left", "right"};
+    for (int v = 0; v < ARRAY_SIZE(views); v++) {
+      IMB_exr_add_view(handle, views[v]);
+    }
+
+    for (int v = 0; v < ARRAY_SIZE(views); v++) {
+      const int seed = v * 10;
+      float *combined = pass_rect(seed + 1, 4);
+      const char *combined_channels[] = {"Combined.R", "Combined.G", "Combined.B", "Combined.A"};
+      for (int c = 0; c < 4; c++) {
+        IMB_exr_add_channel(handle,
+                            "RenderLayer",
+                            combined_channels[c],
+                            views[v],
+                            4,
+                            4 * IMAGE_WIDTH,
+                            combined + c,
+                            false);
+      }
+      float *depth = pass_rect(seed + 2, 1);
+      IMB_exr_add_channel(
+          handle, "RenderLayer", "Depth.Z", views[v], 1, IMAGE_WIDTH, depth, false);
+
+      float *normal = pass_rect(seed + 3, 3);
+      const char *normal_channels[] = {"Normal.X", "Normal.Y", "Normal.Z"};
+      for (int c = 0; c < 3; c++) {
+        IMB_exr_add_channel(handle,
+                            "Background",
+                            normal_channels[c],
+                            views[v],
+                            3,
+                            3 * IMAGE_WIDTH,
+                            normal + c,
+                            false);
+      }
+    }
+
+    ASSERT_TRUE(
+        IMB_exr_begin_write(handle, filepath, IMAGE_WIDTH, IMAGE_HEIGHT, R_IMF_EXR_CODEC_ZIP, NULL));
+    IMB_exr_write_channels(handle);
+    IMB_exr_close(handle);
+  }
+
+  /* Write a multilayer file as Blender 2.43 did, with the rows in the order they are in memory,
+   * starting at the bottom. */
+  void write_multilayer_flipped()
+  {
+    Imf::Header header(IMAGE_WIDTH, IMAGE_HEIGHT);
+    header.compression() = Imf::ZIP_COMPRESSION;
+    header.insert("BlenderMultiChannel", Imf::StringAttribute("Blender V2.43"));
+
+    Imf::FrameBuffer frame_buffer;
+    float *combined = pass_rect(1, 4);
+    const char *combined_channels[] = {"R", "G", "B", "A"};
+    for (int c = 0; c < 4; c++) {
+      const std::string name = std::string("RenderLayer.Combined.") + combined_channels[c];
+      header.channels().insert(name, Imf::Channel(Imf::FLOAT));
+      frame_buffer.insert(name,
+                          Imf::Slice(Imf::FLOAT,
+                                     (char *)(combined + c),
+                                     sizeof(float) * 4,
+                                     sizeof(float) * 4 * IMAGE_WIDTH));
+    }
+    float *depth = pass_rect(2, 1);
+    header.channels().insert("RenderLayer.Depth.Z", Imf::Channel(Imf::FLOAT));
+    frame_buffer.insert(
+        "RenderLayer.Depth.Z",
+        Imf::Slice(Imf::FLOAT, (char *)depth, sizeof(float), sizeof(float) * IMAGE_WIDTH));
+
+    Imf::OutputFile file(filepath, header);
+    file.setFrameBuffer(frame_buffer);
+    file.writePixels(IMAGE_HEIGHT);
+  }
+
+  /* Read every pass of the file in blocks of rows, out of order, and compare with the passes read
+   * at once. Returns the number of passes. */
+  int expect_streamed_passes_match()
+  {
+    ImBuf *ibuf = IMB_loadiffname(filepath, IB_rect | IB_multilayer, NULL);
+    EXPECT_NE(ibuf, (ImBuf *)NULL);
+    if (ibuf == NULL) {
+      return 0;
+    }
+    EXPECT_NE(ibuf->userdata, (void *)NULL);
+    TestPasses passes;
+    if (ibuf->userdata) {
+      IMB_exr_multilayer_convert(ibuf->userdata,
+                                 &passes,
+                                 test_passes_add_view,
+                                 test_passes_add_layer,
+                                 test_passes_add_pass);
+      IMB_exr_close(ibuf->userdata);
+      ibuf->userdata = NULL;
+    }
+    IMB_freeImBuf(ibuf);
+
+    void *handle = IMB_exr_get_handle();
+    int width, height;
+    EXPECT_TRUE(IMB_exr_begin_read_passes(handle, filepath, &width, &height));
+    EXPECT_EQ(width, IMAGE_WIDTH);
+    EXPECT_EQ(height, IMAGE_HEIGHT);
+
+    /* Blocks crossing chunk borders, the top first. */
+    const int blocks[][2] = {{30, IMAGE_HEIGHT}, {0, 7}, {7, 8}, {8, 30}};
+
+    for (const TestPass &pass : passes.passes) {
+      const char *view = pass.view.empty() ? NULL : pass.view.c_str();
+      EXPECT_EQ(IMB_exr_pass_channels(handle, pass.layer.c_str(), pass.pass.c_str(), view),
+                pass.channels)
+          << pass.layer << " " << pass.pass << " " << pass.view;
+
+      const size_t rect_len = (size_t)IMAGE_WIDTH * IMAGE_HEIGHT * pass.channels;
+      float *rect = (float *)MEM_callocN(sizeof(float) * rect_len, __func__);
+      for (int b = 0; b < ARRAY_SIZE(blocks); b++) {
+        EXPECT_TRUE(IMB_exr_read_pass_rows(handle,
+                                           pass.layer.c_str(),
+                                           pass.pass.c_str(),
+                                           view,
+                                           rect,
+                                           blocks[b][0],
+                                           blocks[b][1]));
+      }
+      for (size_t i = 0; i < rect_len; i++) {
+        if (rect[i] != pass.rect[i]) {
+          ADD_FAILURE() << pass.layer << " " << pass.pass << " " << pass.view << ": float " << i
+                        << " is " << rect[i] << " instead of " << pass.rect[i];
+          break;
+        }
+      }
+      MEM_freeN(rect);
+      MEM_freeN(pass.rect);
+    }
+
+    IMB_exr_close(handle);
+    return (int)passes.passes.size();
+  }
+};
+
+TEST_F(ImbufOpenEXRTest, MultilayerMultiview)
+{
+  write_multilayer_multiview();
+  /* Combined, depth and normal for both views. */
+  EXPECT_EQ(expect_streamed_passes_match(), 6);
+}
+
+TEST_F(ImbufOpenEXRTest, MultilayerFlipped)
+{
+  write_multilayer_flipped();
+  EXPECT_EQ(expect_streamed_passes_match(), 2);
+}
+
+TEST_F(ImbufOpenEXRTest, PassesMatchWrittenPixels)
+{
+  write_multilayer_multiview();
+
+  /* The reference read itself, to make sure the comparison is not between two wrong results. */
+  void *handle = IMB_exr_get_handle();
+  int width, height;
+  ASSERT_TRUE(IMB_exr_begin_read_passes(handle, filepath, &width, &height));
+  float *rect = (float *)MEM_mallocN(sizeof(float) * IMAGE_WIDTH * IMAGE_HEIGHT, __func__);
+  ASSERT_TRUE(
+      IMB_exr_read_pass_rows(handle, "RenderLayer", "Depth", "right", rect, 0, IMAGE_HEIGHT));
+  for (int y = 0; y < IMAGE_HEIGHT; y++) {
+    for (int x = 0; x < IMAGE_WIDTH; x++) {
+      ASSERT_EQ(rect[y * IMAGE_WIDTH + x], test_pixel(12, x, y, 0)) << x << ", " << y;
+    }
+  }
+  MEM_freeN(rect);
+  IMB_exr_close(handle);
+}